@@ -48,6 +48,11 @@ static char _id[] = "$Id: base64.c 1.3 2009/02/18 10:06:29 saturn Sav $";
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__)) && !defined(BASE64_NO_SIMD)
+#define BASE64_SSSE3					/* SSSE3 when the CPU supports it */
+#include <tmmintrin.h>
+#endif
+
 
 /*  -----------  defines  --------------------------------------------------
  */
@@ -70,12 +75,36 @@ static char _id[] = "$Id: base64.c 1.3 2009/02/18 10:06:29 saturn Sav $";
 /*  -----------  prototypes  -----------------------------------------------
  */
 
+#ifdef BASE64_SSSE3
+static void encode_ssse3(unsigned char *input, unsigned char *output);
+static int decode_ssse3(unsigned char *input, unsigned char *output);
+static int valid_ssse3(__m128i in);
+#endif
 
 /*  -----------  variables  ------------------------------------------------
  */
 
 static const char base64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
+static const signed char decode[256] = {	/* character to 6-bit value, or -1 */
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 62, -1, -1, -1, 63,
+	52, 53, 54, 55, 56, 57, 58, 59, 60, 61, -1, -1, -1, -1, -1, -1,
+	-1,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
+	15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, -1, -1, -1, -1, -1,
+	-1, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+	41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+};
+
 
 /*  -----------  functions  ------------------------------------------------
  */
@@ -122,6 +151,164 @@ int base64_decode(unsigned char *input, int length, unsigned char *output, int n
 	return n;
 }
 
+int base64_encode_buffer(unsigned char *input, int length, unsigned char *output, int nbyte)
+{
+	unsigned char quantum[3], *p;
+	int L, q;
+#ifdef BASE64_SSSE3
+	int simd = __builtin_cpu_supports("ssse3");
+#endif
+
+	if(length <= 0 || nbyte <= 0)
+		return 0;
+	L = ((length + 2) / 3) * 4;
+	if(L > nbyte)
+		L = nbyte;
+	/* the quanta are encoded from the last to the first, so that the output
+	 * may be written over the input (it is 4/3 of the input length) */
+	q = (L + 3) / 4;
+	if((3 * q > length) || (4 * q > L)) {
+		q--;							/* incomplete (or truncated) quantum */
+		memset(quantum, 0, 3);
+		memcpy(quantum, &input[3 * q], (length - 3 * q) < 3 ? (length - 3 * q) : 3);
+		base64_encode(quantum, (length - 3 * q) < 3 ? (length - 3 * q) : 3, &output[4 * q], L - 4 * q);
+	}
+	for(; q > 0; q--) {
+#ifdef BASE64_SSSE3
+		if(simd && (q >= 4) && (3 * q + 4 <= length)) {
+			encode_ssse3(&input[3 * (q - 4)], &output[4 * (q - 4)]);
+			q -= 3;						/* 4 quanta at once */
+			continue;
+		}
+#endif
+		p = &input[3 * (q - 1)];
+		quantum[0] = p[0]; quantum[1] = p[1]; quantum[2] = p[2];
+		p = &output[4 * (q - 1)];
+		p[0] = (unsigned char)base64[quantum[0] >> 2];
+		p[1] = (unsigned char)base64[((quantum[0] & 0x03) << 4) | (quantum[1] >> 4)];
+		p[2] = (unsigned char)base64[((quantum[1] & 0x0F) << 2) | (quantum[2] >> 6)];
+		p[3] = (unsigned char)base64[quantum[2] & 0x3F];
+	}
+	return L;
+}
+
+int base64_decode_buffer(unsigned char *input, int length, unsigned char *output, int nbyte)
+{
+	int i = 0, n = 0, k;
+	int a, b, c, d;
+
+	if(length <= 0 || nbyte <= 0)
+		return 0;
+#ifdef BASE64_SSSE3
+	if(__builtin_cpu_supports("ssse3")) {
+		for(; (i + 16 <= length) && (n + 16 <= nbyte); i += 16, n += 12) {
+			if(!decode_ssse3(&input[i], &output[n]))
+				break;					/* not a base64 character */
+		}
+	}
+#endif
+	for(; (i + 4 <= length) && (n + 3 <= nbyte); i += 4, n += 3) {
+		a = decode[input[i]];
+		b = decode[input[i + 1]];
+		c = decode[input[i + 2]];
+		d = decode[input[i + 3]];
+		if((a | b | c | d) < 0)
+			break;						/* not a base64 character */
+		output[n] = (unsigned char)((a << 2) | (b >> 4));
+		output[n + 1] = (unsigned char)((b << 4) | (c >> 2));
+		output[n + 2] = (unsigned char)((c << 6) | d);
+	}
+	/* the rest: an incomplete quantum, or less than 3 bytes left in the output
+	 * (base64_decode counts the bytes by the characters up to nbyte) */
+	for(k = 0; (k < 4) && (i + k < length) && (decode[input[i + k]] >= 0); k++)
+		;
+	if((k > 0) && (n < nbyte))
+		n += base64_decode(&input[i], k, &output[n], (nbyte - n) < (k < 3 ? k : 3) ? (nbyte - n) : (k < 3 ? k : 3));
+	return n;
+}
+
+int base64_length(unsigned char *string, int length)
+{
+	int n = 0;
+#ifdef BASE64_SSSE3
+	int mask;
+
+	/* blocks of 16 characters, none of them behind the string */
+	if(__builtin_cpu_supports("ssse3")) {
+		for(; n + 16 <= length; n += 16) {
+			if((mask = valid_ssse3(_mm_loadu_si128((__m128i*)&string[n]))) != 0xFFFF)
+				return n + __builtin_ctz(~mask);
+		}
+	}
+#endif
+	while((n < length) && (decode[string[n]] >= 0))
+		n++;
+	return n;
+}
+
+/*  -----------  local functions  ------------------------------------------
+ */
+
+#ifdef BASE64_SSSE3
+__attribute__((target("ssse3")))
+static void encode_ssse3(unsigned char *input, unsigned char *output)
+{
+	/* 12 bytes to 16 characters (the 4 bytes behind the input are read, but not used) */
+	__m128i in = _mm_loadu_si128((__m128i*)input);
+	__m128i t0, t1, index, offset;
+
+	in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+	t0 = _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0FC0FC00)), _mm_set1_epi32(0x04000040));
+	t1 = _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003F03F0)), _mm_set1_epi32(0x01000010));
+	index = _mm_or_si128(t0, t1);
+	/* the offset from the 6-bit value to its character: 0..25 'A', 26..51 'a', 52..61 '0', 62 '+', 63 '/' */
+	offset = _mm_subs_epu8(index, _mm_set1_epi8(51));
+	offset = _mm_or_si128(offset, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), index), _mm_set1_epi8(13)));
+	offset = _mm_shuffle_epi8(_mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+	                                        '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0), offset);
+	_mm_storeu_si128((__m128i*)output, _mm_add_epi8(index, offset));
+}
+
+__attribute__((target("ssse3")))
+static int decode_ssse3(unsigned char *input, unsigned char *output)
+{
+	/* 16 characters to 12 bytes (16 bytes are written) */
+	__m128i in = _mm_loadu_si128((__m128i*)input);
+	__m128i hi = _mm_and_si128(_mm_srli_epi32(in, 4), _mm_set1_epi8(0x0F));
+	__m128i slash, shift, out;
+
+	if(valid_ssse3(in) != 0xFFFF)
+		return 0;
+	/* the offset from the character to its 6-bit value (per high nibble, '/' apart) */
+	slash = _mm_cmpeq_epi8(in, _mm_set1_epi8('/'));
+	shift = _mm_shuffle_epi8(_mm_setr_epi8(0, 0, 62 - '+', 52 - '0', 0 - 'A', 15 - 'P', 26 - 'a', 41 - 'p',
+	                                       0, 0, 0, 0, 0, 0, 0, 0), hi);
+	shift = _mm_or_si128(_mm_andnot_si128(slash, shift), _mm_and_si128(slash, _mm_set1_epi8(63 - '/')));
+	in = _mm_add_epi8(in, shift);
+	/* 4 x 6 bits to 3 bytes (big-endian) */
+	out = _mm_madd_epi16(_mm_maddubs_epi16(in, _mm_set1_epi32(0x01400140)), _mm_set1_epi32(0x00011000));
+	out = _mm_shuffle_epi8(out, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+	_mm_storeu_si128((__m128i*)output, out);
+	return 1;
+}
+
+__attribute__((target("ssse3")))
+static int valid_ssse3(__m128i in)
+{
+	__m128i hi = _mm_and_si128(_mm_srli_epi32(in, 4), _mm_set1_epi8(0x0F));
+	__m128i lo = _mm_and_si128(in, _mm_set1_epi8(0x0F));
+	__m128i valid;
+
+	/* the valid high nibbles of each low nibble (as a bit mask) */
+	valid = _mm_and_si128(_mm_shuffle_epi8(_mm_setr_epi8(0xA8, 0xF8, 0xF8, 0xF8, 0xF8, 0xF8, 0xF8, 0xF8,
+	                                                     0xF8, 0xF8, 0xF0, 0x54, 0x50, 0x50, 0x50, 0x54), lo),
+	                      _mm_shuffle_epi8(_mm_setr_epi8(0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80,
+	                                                     0, 0, 0, 0, 0, 0, 0, 0), hi));
+	/* one bit per base64 character */
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(valid, _mm_setzero_si128())) ^ 0xFFFF;
+}
+#endif
+
 /*  -----------  revision control  -----------------------------------------
  */
 
@@ -10,6 +10,9 @@
  *
  *	export    :  void base64_encode(unsigned char *input, int length, unsigned char *output, int nbyte);
  *	             void base64_decode(unsigned char *input, int length, unsigned char *output, int nbyte);
+ *	             int base64_encode_buffer(unsigned char *input, int length, unsigned char *output, int nbyte);
+ *	             int base64_decode_buffer(unsigned char *input, int length, unsigned char *output, int nbyte);
+ *	             int base64_length(unsigned char *string, int length);
  *
  *	includes  :  (none)
  *
@@ -81,6 +84,44 @@
 int base64_encode(unsigned char *input, int length, unsigned char *output, int nbyte);
 int base64_decode(unsigned char *input, int length, unsigned char *output, int nbyte);
 
+int base64_encode_buffer(unsigned char *input, int length, unsigned char *output, int nbyte);
+/*
+ *	function  :  encodes a buffer at once (with '=' padding, no terminating
+ *	             zero). The output may be written over the input.
+ *
+ *	parameter :  input  - the data
+ *	             length - number of bytes
+ *	             output - buffer for the characters
+ *	             nbyte  - size of the buffer (the output is truncated)
+ *
+ *	result    :  number of characters in the output buffer
+ */
+
+int base64_decode_buffer(unsigned char *input, int length, unsigned char *output, int nbyte);
+/*
+ *	function  :  decodes a buffer at once, up to the first character that is
+ *	             not a base64 character (e.g. the '=' padding). The output
+ *	             may be written over the input.
+ *
+ *	parameter :  input  - the characters
+ *	             length - number of characters
+ *	             output - buffer for the data
+ *	             nbyte  - size of the buffer (the output is truncated)
+ *
+ *	result    :  number of bytes in the output buffer
+ */
+
+int base64_length(unsigned char *string, int length);
+/*
+ *	function  :  counts the base64 characters at the beginning of a string.
+ *	             No character behind the given length is read.
+ *
+ *	parameter :  string - the characters
+ *	             length - number of characters (e.g. strlen(string))
+ *
+ *	result    :  number of base64 characters
+ */
+
 char* base64_version();
 /*
  *	function  :  retrieve RCS info of this module as a string.
@@ -0,0 +1,198 @@
+/*	-- $Header$ --
+ *
+ *	projekt   :  CAN - Controller Area Network.
+ *
+ *	purpose   :  Benchmark of the base64 coding of domains.
+ *
+ *	copyright :  (C) 2009, UV Software, Friedrichshafen.
+ *
+ *	compiler  :  GCC - GNU C Compiler (Linux Kernel 2.6)
+ *
+ *	author    :  Uwe Vogt, UV Software, Friedrichshafen
+ *
+ *	e-mail    :  uwe.vogt@uv-software.de
+ *
+ *
+ *	-----------  description  -----------------------------------------------
+ *
+ *	Measures the encoding and decoding throughput (MB/s) of a domain with
+ *	the buffer functions of base64.c against the former loops over the
+ *	quanta (one call of base64_encode/base64_decode per quantum). Before
+ *	the measurement both are checked to give the same result for random
+ *	data of all lengths up to a DS-309/3 line, for truncated output, in
+ *	place, and for input with a character that is not a base64 character.
+ *
+ *	usage: bench_base64 [<loops>]
+ *
+ *
+ *	-----------  history  ---------------------------------------------------
+ *
+ *	$Log$
+ */
+
+#include "../base64.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+
+/*  -----------  defines  --------------------------------------------------
+ */
+
+#define LOOPS				100000
+#define DOMAIN_SIZE			1024
+#define BUFFER_SIZE			1400
+#define BASE64(x)			('0' <= (x) && (x) <= '9')||('a' <= (x) && (x) <= 'z')||('A' <= (x) && (x) <= 'Z')||((x) == '+')||((x) == '/')
+
+
+/*  -----------  former loops over the quanta (cop_tcp.c)  -----------------
+ */
+
+static int encode_quanta(unsigned char *buffer, int length, int nbyte)
+{
+	int i, j, l, L;
+
+	l = length;
+	L = (((l + 2) / 3) * 4);
+	if(L > nbyte)
+		L = nbyte;
+	for(j = (((L - 1) / 4) * 4), i = ((j / 4) * 3); j >= 0 && i >= 0; j -= 4, i -=3) {
+		base64_encode(&buffer[i], ((l - i) < 3 ? (l - i) : 3), &buffer[j], ((L - j) < 4 ? (L - j) : 4));
+	}
+	return L;
+}
+
+static int decode_quanta(unsigned char *line, unsigned char *buffer, int nbyte)
+{
+	int n, pos, length;
+
+	for(n = 0, pos = 0, length = 0; BASE64(line[pos]); pos++, n++) {
+		if(n == 4) {
+			length += base64_decode(&line[pos-4], 4, &buffer[length], (length + 3) < nbyte ? 3 : nbyte - length);
+			n = 0;
+		}
+	}
+	if(n == 4)
+		length += base64_decode(&line[pos-4], 4, &buffer[length], (length + 3) < nbyte ? 3 : nbyte - length);
+	if(n == 3)
+		length += base64_decode(&line[pos-3], 3, &buffer[length], (length + 3) < nbyte ? 3 : nbyte - length);
+	if(n == 2)
+		length += base64_decode(&line[pos-2], 2, &buffer[length], (length + 2) < nbyte ? 2 : nbyte - length);
+	if(n == 1)
+		length += base64_decode(&line[pos-1], 1, &buffer[length], (length + 1) < nbyte ? 1 : nbyte - length);
+	return length;
+}
+
+static int decode_buffer(unsigned char *line, unsigned char *buffer, int nbyte)
+{
+	return base64_decode_buffer(line, base64_length(line, (int)strlen((char*)line)), buffer, nbyte);
+}
+
+
+/*  -----------  functions  ------------------------------------------------
+ */
+
+static int verify(void)
+{
+	unsigned char data[BUFFER_SIZE], old[BUFFER_SIZE], new[BUFFER_SIZE];
+	unsigned char out1[BUFFER_SIZE], out2[BUFFER_SIZE];
+	int length, nbyte, l1, l2, n1, n2, i, errors = 0;
+
+	srand(1);
+	for(length = 0; length <= DOMAIN_SIZE; length++) {
+		for(i = 0; i < length; i++)
+			data[i] = (unsigned char)rand();
+		/* the full output, and truncated output */
+		for(nbyte = ((length + 2) / 3) * 4; nbyte >= 0; nbyte -= (nbyte > 8)? (rand() % 97) + 1 : 1) {
+			/* in place (the former loop reads one byte behind an incomplete quantum) */
+			memset(old, 0, BUFFER_SIZE); memcpy(old, data, length);
+			memset(new, 0, BUFFER_SIZE); memcpy(new, data, length);
+			l1 = encode_quanta(old, length, nbyte);
+			l2 = base64_encode_buffer(new, length, new, nbyte);
+			if(l1 != l2 || memcmp(old, new, l1)) {
+				fprintf(stderr, "+++ error: encoding of %i bytes (%i chars) differs\n", length, nbyte);
+				errors++;
+			}
+			/* decode it again (zero-terminated), into a buffer of nbyte */
+			old[l1] = '\0';
+			n1 = decode_quanta(old, out1, nbyte);
+			n2 = decode_buffer(old, out2, nbyte);
+			if(n1 != n2 || memcmp(out1, out2, n1)) {
+				fprintf(stderr, "+++ error: decoding of %i chars (%i bytes) differs\n", l1, nbyte);
+				errors++;
+			}
+			/* with a character that is not a base64 character */
+			if(l1 > 0) {
+				old[rand() % l1] = " =!\x80"[rand() % 4];
+				n1 = decode_quanta(old, out1, BUFFER_SIZE);
+				n2 = decode_buffer(old, out2, BUFFER_SIZE);
+				if(n1 != n2 || memcmp(out1, out2, n1)) {
+					fprintf(stderr, "+++ error: decoding of \"%s\" differs\n", old);
+					errors++;
+				}
+			}
+		}
+		/* out of place: the input is not changed */
+		memcpy(old, data, length);
+		l2 = base64_encode_buffer(old, length, new, BUFFER_SIZE);
+		if(memcmp(old, data, length) || decode_buffer((new[l2] = '\0', new), out2, BUFFER_SIZE) != length || memcmp(out2, data, length)) {
+			fprintf(stderr, "+++ error: round trip of %i bytes failed\n", length);
+			errors++;
+		}
+	}
+	return errors;
+}
+
+static double elapsed(struct timeval *t0)
+{
+	struct timeval t1;
+
+	gettimeofday(&t1, NULL);
+	return (double)(t1.tv_sec - t0->tv_sec) + (double)(t1.tv_usec - t0->tv_usec) / 1000000.0;
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned char data[DOMAIN_SIZE], buffer[BUFFER_SIZE], line[BUFFER_SIZE];
+	long loops = (argc > 1)? atol(argv[1]) : LOOPS;
+	double t[4], mb;
+	struct timeval t0;
+	long i, sum = 0;
+	int n;
+
+	if(verify() != 0)
+		return 1;
+	printf("base64 buffer functions: verified against the loops over the quanta\n");
+
+	for(i = 0; i < DOMAIN_SIZE; i++)
+		data[i] = (unsigned char)(i * 7 + 3);
+	n = base64_encode_buffer(data, DOMAIN_SIZE, line, BUFFER_SIZE);
+	line[n] = '\0';
+	gettimeofday(&t0, NULL);
+	for(i = 0; i < loops; i++) {
+		memcpy(buffer, data, DOMAIN_SIZE);	/* in place, as make_base64() */
+		sum += encode_quanta(buffer, DOMAIN_SIZE, BUFFER_SIZE) + buffer[i % n];
+	}
+	t[0] = elapsed(&t0);
+	gettimeofday(&t0, NULL);
+	for(i = 0; i < loops; i++) {
+		memcpy(buffer, data, DOMAIN_SIZE);
+		sum += base64_encode_buffer(buffer, DOMAIN_SIZE, buffer, BUFFER_SIZE) + buffer[i % n];
+	}
+	t[1] = elapsed(&t0);
+	gettimeofday(&t0, NULL);
+	for(i = 0; i < loops; i++)
+		sum += decode_quanta(line, buffer, BUFFER_SIZE) + buffer[i % DOMAIN_SIZE];
+	t[2] = elapsed(&t0);
+	gettimeofday(&t0, NULL);
+	for(i = 0; i < loops; i++)
+		sum += decode_buffer(line, buffer, BUFFER_SIZE) + buffer[i % DOMAIN_SIZE];
+	t[3] = elapsed(&t0);
+
+	mb = (double)loops * DOMAIN_SIZE / 1000000.0;
+	printf("encode %i bytes:  quanta %8.1f MB/s, buffer %8.1f MB/s, speed-up %6.2f\n", DOMAIN_SIZE, mb / t[0], mb / t[1], t[0] / t[1]);
+	printf("decode %i bytes:  quanta %8.1f MB/s, buffer %8.1f MB/s, speed-up %6.2f\n", DOMAIN_SIZE, mb / t[2], mb / t[3], t[2] / t[3]);
+	return (sum == 0);
+}
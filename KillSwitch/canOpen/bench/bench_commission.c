@@ -0,0 +1,176 @@
+/*	-- $Header$ --
+ *
+ *	projekt   :  CAN - Controller Area Network.
+ *
+ *	purpose   :  Benchmark of the batch commissioning by LSS.
+ *
+ *	copyright :  (C) 2009, UV Software, Friedrichshafen.
+ *
+ *	compiler  :  GCC - GNU C Compiler (Linux Kernel 2.6)
+ *
+ *	author    :  Uwe Vogt, UV Software, Friedrichshafen
+ *
+ *	e-mail    :  uwe.vogt@uv-software.de
+ *
+ *
+ *	-----------  description  -----------------------------------------------
+ *
+ *	Commissions the responder nodes of can_stub.c (LSS slaves with the LSS
+ *	address of their identity object) one after the other: by a list for
+ *	cfg_commission(), and by the "commission" command of the gateway
+ *	(cop_tcp_parse), with a new node-id, bit-timing and store for each
+ *	node. The result, the failed step and the time of each node are
+ *	printed, and the total time of the list. The last node of the list
+ *	for cfg_commission() has a serial-number of no node, so its switch
+ *	mode selective times out (step 1 failed).
+ *
+ *	Since the simulated bus does not take time, the times are those of the
+ *	CANopen Master; on a CAN bus every step takes about two frame times in
+ *	addition (at 250 kbit/s less than 1 ms).
+ *
+ *	usage: bench_commission [<nodes>]
+ *
+ *
+ *	-----------  history  ---------------------------------------------------
+ *
+ *	$Log$
+ */
+
+#include "can_stub.c"
+
+#include "../cop_tcp.h"
+#include "../cop_api.h"
+
+#include <stdlib.h>
+
+
+/*  -----------  defines  --------------------------------------------------
+ */
+
+#define NODES				30			/* nodes to be commissioned */
+#define VENDOR_ID			0x0000031A	/* LSS address of the responders */
+#define PRODUCT_CODE		0x00010001
+#define REVISION_NUMBER		0x00010000
+#define SERIAL_NUMBER		0x10000000	/*   (plus the node-id) */
+#define UNKNOWN				0x1FFFFFFF	/* serial-number of no node */
+#define TIMEOUT				10			/* time-out of the confirmations [ms] */
+#define BAUDRATE			3			/* bit-timing: 250 kbit/s */
+#define REQUEST_SIZE		1025		/* as a line of the server */
+
+
+/*  -----------  variables  ------------------------------------------------
+ */
+
+static COP_TCP_SETTINGS settings = {1, 1, 127, 0, -1, NULL, -1};
+
+
+/*  -----------  functions  ------------------------------------------------
+ */
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec * 1e6 + (double)ts.tv_nsec / 1e3;
+}
+
+static int by_table(int count)
+{
+	CFG_NODE table[NODES + 1];
+	double t0, usec;
+	LONG n;
+	int i;
+
+	memset(table, 0, sizeof(table));
+	for(i = 0; i <= count; i++) {
+		table[i].protocol = CFG_LSS;
+		table[i].vendor_id = VENDOR_ID;
+		table[i].product_code = PRODUCT_CODE;
+		table[i].revision_number = REVISION_NUMBER;
+		table[i].serial_number = (i < count)? SERIAL_NUMBER + (DWORD)(i + 1) : UNKNOWN;
+		table[i].node_id = (BYTE)(64 + i);
+		table[i].baudrate = BAUDRATE;
+		table[i].store = TRUE;
+	}
+	t0 = now();
+	n = cfg_commission(table, (SHORT)(count + 1), TIMEOUT);
+	usec = now() - t0;
+	printf("cfg_commission: %li of %i nodes commissioned in %.0f usec\n", (long)n, count + 1, usec);
+	printf("  node  serial-number  node-id  result  step      usec\n");
+	for(i = 0; i <= count; i++)
+		printf("  %4i  0x%08lX  %7u  %6li  %4u  %8lu\n", i + 1, (unsigned long)table[i].serial_number,
+		       table[i].node_id, (long)table[i].result, table[i].step, (unsigned long)table[i].duration);
+	/* the responders have got their node-id, the unknown node timed out */
+	for(i = 0; i < count; i++) {
+		if(table[i].result != COPERR_NOERROR || nodes[i + 1].lss_node_id != table[i].node_id)
+			return -1;
+	}
+	return (n == count && table[count].step == CFG_STEP_SELECT)? 0 : -1;
+}
+
+static int by_request(int count)
+{
+	char request[REQUEST_SIZE];
+	char *token, *node_id, *step, *field;
+	double t0, usec;
+	int i, len;
+
+	/* the nodes of one product in one request (new node-ids 96, 97, ...) */
+	len = snprintf(request, sizeof(request), "[1] commission 0x%08X 0x%08X 0x%08X",
+	               VENDOR_ID, PRODUCT_CODE, REVISION_NUMBER);
+	for(i = 0; i < count && len < (int)sizeof(request); i++)
+		len += snprintf(&request[len], sizeof(request) - len, " 0x%08X %i", SERIAL_NUMBER + i + 1, 96 + i);
+	if(len < (int)sizeof(request))
+		len += snprintf(&request[len], sizeof(request) - len, " rate %i store", BAUDRATE);
+	if(len >= (int)sizeof(request)) {
+		fprintf(stderr, "+++ error: request too long\n");
+		return -1;
+	}
+	printf("commission request: %i bytes\n", len);
+	t0 = now();
+	cop_tcp_parse(request, &settings, request, sizeof(request));
+	usec = now() - t0;
+	/* [1] <count> {<node-id> <step> <microseconds>}+ */
+	if(!(token = strtok(request, " \r\n")) || !(token = strtok(NULL, " \r\n")) || token[0] == 'E') {
+		fprintf(stderr, "+++ error: commission failed\n");
+		return -1;
+	}
+	printf("commission command: %s of %i nodes commissioned in %.0f usec\n", token, count, usec);
+	printf("  node-id  step      usec\n");
+	for(i = 0; i < count; i++) {
+		node_id = strtok(NULL, " \r\n");
+		step = strtok(NULL, " \r\n");
+		field = strtok(NULL, " \r\n");
+		if(!node_id || !step || !field)
+			return -1;
+		printf("  %7s  %4s  %8s\n", node_id, step, field);
+		if(atoi(node_id) != 96 + i || atoi(step) != CFG_STEP_NONE || nodes[i + 1].lss_node_id != 96 + i)
+			return -1;
+	}
+	return (atoi(token) == count)? 0 : -1;
+}
+
+int main(int argc, char *argv[])
+{
+	struct _can_param param = {"stub", 0, 0, 0};
+	int count = (argc > 1)? atoi(argv[1]) : NODES;
+
+	if(count < 1 || NODES < count)
+		return 1;
+	if(cop_init(CAN_NETDEV, &param, CANBDR_250) != COPERR_NOERROR) {
+		fprintf(stderr, "+++ error: cop_init failed\n");
+		return 1;
+	}
+	stub_nodes(count);
+	if(by_table(count) < 0) {
+		fprintf(stderr, "+++ error: commissioning by table failed\n");
+		return 1;
+	}
+	if(by_request(count) < 0) {
+		fprintf(stderr, "+++ error: commissioning by request failed\n");
+		return 1;
+	}
+	cop_exit();
+	return 0;
+}
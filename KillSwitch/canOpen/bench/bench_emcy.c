@@ -0,0 +1,233 @@
+/*	-- $Header$ --
+ *
+ *	projekt   :  CAN - Controller Area Network.
+ *
+ *	purpose   :  Benchmark of the EMCY events of the gateway.
+ *
+ *	copyright :  (C) 2009, UV Software, Friedrichshafen.
+ *
+ *	compiler  :  GCC - GNU C Compiler (Linux Kernel 2.6)
+ *
+ *	author    :  Uwe Vogt, UV Software, Friedrichshafen
+ *
+ *	e-mail    :  uwe.vogt@uv-software.de
+ *
+ *
+ *	-----------  description  -----------------------------------------------
+ *
+ *	Measures the latency (usec) of an emergency message of a responder of
+ *	can_stub.c until its EMCY event reaches a client of the gateway server
+ *	(cop_srv_loop, in a thread of its own), which has sent "enable emcy"
+ *	and nothing else: no other request reads the simulated bus, so the
+ *	events are only delivered when the server reads it for the subscriber
+ *	(at the latest every poll cycle of the server, 100 ms).
+ *
+ *	Before the subscription an emergency message is received by "recv"
+ *	(as any CAN message), while there is a subscriber it is consumed.
+ *
+ *	usage: bench_emcy [<messages>]
+ *
+ *
+ *	-----------  history  ---------------------------------------------------
+ *
+ *	$Log$
+ */
+
+#include "can_stub.c"
+
+#include "../cop_srv.h"
+#include "../cop_api.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+
+/*  -----------  defines  --------------------------------------------------
+ */
+
+#define MESSAGES			20			/* emergency messages */
+#define NODES				8			/* responder nodes */
+#define ERROR_CODE			0x8130		/* life guard error or heartbeat error */
+#define ERROR_REGISTER		0x11		/* generic error, communication error */
+#define TIMEOUT				1000		/* time-out of an event [ms] */
+#define BUFFER_SIZE			1025
+
+
+/*  -----------  variables  ------------------------------------------------
+ */
+
+static COP_TCP_SETTINGS settings = {1, 1, 127, 0, -1, NULL, -1};
+static int server = -1;
+static int running = 1;
+static struct sockaddr_in tcp_addr;
+static char input[BUFFER_SIZE];			/* received from the gateway */
+static int in_length = 0;
+
+
+/*  -----------  functions  ------------------------------------------------
+ */
+
+static void *gateway(void *arg)
+{
+	arg = arg;
+	cop_srv_loop(server, -1, NULL, &settings, 0, &running);
+	return NULL;
+}
+
+static int connect_to(void)
+{
+	socklen_t len = sizeof(tcp_addr);
+	int fd, on = 1;
+
+	/* TCP/IP loopback (any port) */
+	memset(&tcp_addr, 0, sizeof(tcp_addr));
+	tcp_addr.sin_family = AF_INET;
+	tcp_addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if((server = socket(AF_INET, SOCK_STREAM, 0)) < 0 ||
+	   bind(server, (struct sockaddr*)&tcp_addr, sizeof(tcp_addr)) < 0 ||
+	   listen(server, COP_SRV_CLIENTS) < 0 ||
+	   getsockname(server, (struct sockaddr*)&tcp_addr, &len) < 0) {
+		perror("+++ error(tcp)");
+		return -1;
+	}
+	if((fd = socket(AF_INET, SOCK_STREAM, 0)) < 0)
+		return -1;
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+	if(connect(fd, (struct sockaddr*)&tcp_addr, sizeof(tcp_addr)) < 0) {
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+static int read_line(int fd, char *line, int nbyte)
+{
+	struct timeval timeo = {TIMEOUT / 1000, (TIMEOUT % 1000) * 1000};
+	char *end;
+	ssize_t res;
+	int n;
+
+	/* one line (a response or an event), or time-out */
+	setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeo, sizeof(timeo));
+	while(!(end = memchr(input, '\n', in_length))) {
+		if(in_length == BUFFER_SIZE - 1 ||
+		  (res = read(fd, &input[in_length], BUFFER_SIZE - 1 - in_length)) <= 0)
+			return -1;
+		in_length += (int)res;
+	}
+	n = (int)(end - input) + 1;
+	if(n >= nbyte)
+		return -1;
+	memcpy(line, input, n);
+	line[n] = '\0';
+	memmove(input, &input[n], in_length - n);
+	in_length -= n;
+	return n;
+}
+
+static int request(int fd, char *text, char *response, int nbyte)
+{
+	char line[BUFFER_SIZE];
+
+	if(write(fd, text, strlen(text)) < 0)
+		return -1;
+	/* the response (events are skipped) */
+	while(read_line(fd, line, BUFFER_SIZE) > 0) {
+		if(line[0] == '[') {
+			strncpy(response, line, nbyte - 1);
+			response[nbyte - 1] = '\0';
+			return 0;
+		}
+	}
+	return -1;
+}
+
+static int wait_event(int fd, int id)
+{
+	char line[BUFFER_SIZE], expected[64];
+
+	snprintf(expected, sizeof(expected), "1 %i EMCY 0x%04X 0x%02X", id, ERROR_CODE, ERROR_REGISTER);
+	while(read_line(fd, line, BUFFER_SIZE) > 0) {
+		if(!strncmp(line, expected, strlen(expected)))
+			return 0;
+	}
+	return -1;
+}
+
+static double elapsed(struct timespec *t0, struct timespec *t1)
+{
+	return (double)(t1->tv_sec - t0->tv_sec) * 1e6 + (double)(t1->tv_nsec - t0->tv_nsec) / 1e3;
+}
+
+int main(int argc, char *argv[])
+{
+	struct _can_param param = {"stub", 0, 0, 0};
+	int count = (argc > 1)? atoi(argv[1]) : MESSAGES;
+	char response[BUFFER_SIZE];
+	struct timespec t0, t1;
+	double usec, sum = 0.0, max = 0.0;
+	pthread_t thread;
+	int fd, i, rc = 0;
+
+	if(count < 1)
+		return 1;
+	if(cop_init(CAN_NETDEV, &param, CANBDR_250) != COPERR_NOERROR) {
+		fprintf(stderr, "+++ error: cop_init failed\n");
+		return 1;
+	}
+	stub_nodes(NODES);
+	if((fd = connect_to()) < 0)
+		return 1;
+	if(pthread_create(&thread, NULL, gateway, NULL) != 0) {
+		perror("+++ error(pthread_create)");
+		return 1;
+	}
+	/* without a subscriber the message is received as any CAN message */
+	stub_emcy(1, ERROR_CODE, ERROR_REGISTER);
+	if(request(fd, "[1] recv\n", response, BUFFER_SIZE) < 0 || strncmp(response, "[1] 0x081 8 0x30 0x81 0x11", 26)) {
+		fprintf(stderr, "+++ error: emergency message not received (%s)\n", response);
+		rc = 1;
+	}
+	if(request(fd, "[2] enable emcy\n", response, BUFFER_SIZE) < 0 || strncmp(response, "[2] OK", 6)) {
+		fprintf(stderr, "+++ error: enable emcy failed\n");
+		rc = 1;
+	}
+	/* the events with no other traffic */
+	for(i = 0; i < count && !rc; i++) {
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+		stub_emcy(1 + i % NODES, ERROR_CODE, ERROR_REGISTER);
+		if(wait_event(fd, 1 + i % NODES) < 0) {
+			fprintf(stderr, "+++ error: no EMCY event from node %i\n", 1 + i % NODES);
+			rc = 1;
+			break;
+		}
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+		usec = elapsed(&t0, &t1);
+		sum += usec;
+		if(usec > max)
+			max = usec;
+	}
+	if(!rc)
+		printf("emcy events: %i messages, latency avg %.1f, max %.1f usec\n", count, sum / (double)count, max);
+	/* while there is a subscriber the message is consumed */
+	if(!rc) {
+		stub_emcy(2, ERROR_CODE, ERROR_REGISTER);
+		if(wait_event(fd, 2) < 0 ||
+		   request(fd, "[3] recv\n", response, BUFFER_SIZE) < 0 || strncmp(response, "[3] OK", 6)) {
+			fprintf(stderr, "+++ error: emergency message not consumed (%s)\n", response);
+			rc = 1;
+		}
+	}
+	close(fd);
+	running = 0;
+	pthread_join(thread, NULL);
+	close(server);
+	cop_exit();
+	return rc;
+}
@@ -0,0 +1,299 @@
+/*	-- $Header$ --
+ *
+ *	projekt   :  CAN - Controller Area Network.
+ *
+ *	purpose   :  Benchmark of the binary framing against the ASCII Mapping.
+ *
+ *	copyright :  (C) 2009, UV Software, Friedrichshafen.
+ *
+ *	compiler  :  GCC - GNU C Compiler (Linux Kernel 2.6)
+ *
+ *	author    :  Uwe Vogt, UV Software, Friedrichshafen
+ *
+ *	e-mail    :  uwe.vogt@uv-software.de
+ *
+ *
+ *	-----------  description  -----------------------------------------------
+ *
+ *	Measures the cost per request (ns) of the gateway protocol itself, in
+ *	the ASCII Mapping (DS-309/3) and in the binary framing: the client
+ *	encodes the request, the gateway parses it, executes it and formats
+ *	the response, and the client decodes the response. The SDO transfers
+ *	are replaced by an object dictionary in memory (the functions of
+ *	cop_sdo.c are defined here), so only the protocol is measured.
+ *
+ *	Before the measurement both encodings are checked to transfer the
+ *	same values.
+ *
+ *	usage: bench_frame [<loops>]
+ *
+ *
+ *	-----------  history  ---------------------------------------------------
+ *
+ *	$Log$
+ */
+
+#include "../cop_bin.h"
+#include "../can_defs.h"
+#include "../cop_api.h"
+#include "../base64.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+
+/*  -----------  defines  --------------------------------------------------
+ */
+
+#define LOOPS				200000
+#define NODE				1
+#define DOMAIN_SIZE			256
+#define BUFFER_SIZE			1025
+
+
+/*  -----------  variables  ------------------------------------------------
+ */
+
+static DWORD serial = 0x12345678;		/* object 1018h:4 */
+static DWORD counter = 0;				/* object 2001h:0 */
+static BYTE domain[DOMAIN_SIZE];		/* object 2002h:0 */
+
+
+/*  -----------  object dictionary (instead of cop_sdo.c)  ------------------
+ */
+
+static BYTE *object(WORD index, BYTE subindex, SHORT *length)
+{
+	if(index == 0x1018 && subindex == 4) { *length = 4; return (BYTE*)&serial; }
+	if(index == 0x2001 && subindex == 0) { *length = 4; return (BYTE*)&counter; }
+	if(index == 0x2002 && subindex == 0) { *length = DOMAIN_SIZE; return domain; }
+	return NULL;
+}
+
+LONG sdo_write(BYTE node_id, WORD index, BYTE subindex, SHORT length, BYTE *data)
+{
+	SHORT size;
+	BYTE *p = object(index, subindex, &size);
+
+	if(!p)
+		return 0x06020000;				/* object does not exist */
+	if(length != size)
+		return 0x06070010;				/* length does not match */
+	memcpy(p, data, length);
+	return COPERR_NOERROR;
+}
+
+LONG sdo_read(BYTE node_id, WORD index, BYTE subindex, SHORT *length, BYTE *data, SHORT max)
+{
+	SHORT size;
+	BYTE *p = object(index, subindex, &size);
+
+	if(!p)
+		return 0x06020000;				/* object does not exist */
+	if(size > max)
+		return COPERR_LENGTH;
+	memcpy(data, p, size);
+	*length = size;
+	return COPERR_NOERROR;
+}
+
+WORD sdo_timeout(WORD milliseconds) { return milliseconds; }
+LONG sdo_channel(BYTE channel) { return COPERR_NOERROR; }
+
+LONG sdo_write_8bit(BYTE node_id, WORD index, BYTE subindex, BYTE value) { return sdo_write(node_id, index, subindex, 1, &value); }
+LONG sdo_write_16bit(BYTE node_id, WORD index, BYTE subindex, WORD value) { return sdo_write(node_id, index, subindex, 2, (BYTE*)&value); }
+LONG sdo_write_32bit(BYTE node_id, WORD index, BYTE subindex, DWORD value) { return sdo_write(node_id, index, subindex, 4, (BYTE*)&value); }
+LONG sdo_read_8bit(BYTE node_id, WORD index, BYTE subindex, BYTE *value) { SHORT n; return sdo_read(node_id, index, subindex, &n, value, 1); }
+LONG sdo_read_16bit(BYTE node_id, WORD index, BYTE subindex, WORD *value) { SHORT n; return sdo_read(node_id, index, subindex, &n, (BYTE*)value, 2); }
+LONG sdo_read_32bit(BYTE node_id, WORD index, BYTE subindex, DWORD *value) { SHORT n; return sdo_read(node_id, index, subindex, &n, (BYTE*)value, 4); }
+LPSTR sdo_version(void) { return "bench_frame"; }
+
+
+/*  -----------  client side of the ASCII Mapping  -------------------------
+ */
+
+static COP_TCP_SETTINGS settings = {1, NODE, 0, 0, -1, NULL, -1};
+static unsigned long sequence = 0;
+
+static long ascii_read32(WORD index, BYTE subindex, DWORD *value)
+{
+	char buffer[BUFFER_SIZE];
+	char *p;
+
+	snprintf(buffer, BUFFER_SIZE, "[%lu] %u read 0x%04X %u u32\n", ++sequence, NODE, index, subindex);
+	cop_tcp_parse(buffer, &settings, buffer, BUFFER_SIZE);
+	if(!(p = strchr(buffer, ']')) || p[2] == 'E')
+		return -1;
+	*value = (DWORD)strtoul(p + 2, NULL, 0);
+	return 0;
+}
+
+static long ascii_write32(WORD index, BYTE subindex, DWORD value)
+{
+	char buffer[BUFFER_SIZE];
+	char *p;
+
+	snprintf(buffer, BUFFER_SIZE, "[%lu] %u write 0x%04X %u u32 %lu\n", ++sequence, NODE, index, subindex, (unsigned long)value);
+	cop_tcp_parse(buffer, &settings, buffer, BUFFER_SIZE);
+	if(!(p = strchr(buffer, ']')) || strncmp(p + 2, "OK", 2))
+		return -1;
+	return 0;
+}
+
+static long ascii_read_domain(WORD index, BYTE subindex, BYTE *data, int nbyte)
+{
+	char buffer[BUFFER_SIZE];
+	char *p;
+	int i, l, n = 0;
+
+	snprintf(buffer, BUFFER_SIZE, "[%lu] %u read 0x%04X %u d\n", ++sequence, NODE, index, subindex);
+	cop_tcp_parse(buffer, &settings, buffer, BUFFER_SIZE);
+	if(!(p = strchr(buffer, ']')) || p[2] == 'E')
+		return -1;
+	p += 2;
+	/* base64 is decoded in groups of 4 characters (as the gateway does) */
+	for(l = (int)strcspn(p, "=\r\n"), i = 0; i < l && n < nbyte; i += 4)
+		n += base64_decode((unsigned char*)&p[i], (l - i < 4)? l - i : 4, &data[n], (nbyte - n < 3)? nbyte - n : 3);
+	return n;
+}
+
+
+/*  -----------  client side of the binary framing  ------------------------
+ */
+
+static BYTE *frame(BYTE *buffer, BYTE opcode, WORD index, BYTE subindex, BYTE datatype)
+{
+	++sequence;
+	buffer[2] = (BYTE)sequence; buffer[3] = (BYTE)(sequence >> 8);
+	buffer[4] = (BYTE)(sequence >> 16); buffer[5] = (BYTE)(sequence >> 24);
+	buffer[6] = COP_BIN_DEFAULT;
+	buffer[7] = NODE;
+	buffer[8] = opcode;
+	buffer[9] = (BYTE)index; buffer[10] = (BYTE)(index >> 8);
+	buffer[11] = subindex;
+	buffer[12] = datatype;
+	return &buffer[13];
+}
+
+static int request(BYTE *buffer, int length)
+{
+	buffer[0] = (BYTE)(length - 2); buffer[1] = (BYTE)((length - 2) >> 8);
+	return cop_bin_parse(buffer, length, &settings, buffer, BUFFER_SIZE);
+}
+
+static long binary_read32(WORD index, BYTE subindex, DWORD *value)
+{
+	BYTE buffer[BUFFER_SIZE];
+	BYTE *p;
+
+	frame(buffer, COP_BIN_UPLOAD, index, subindex, COP_BIN_UNSIGNED32);
+	if(request(buffer, COP_BIN_REQUEST + 4) != COP_BIN_RESPONSE + 4 || buffer[7] != COP_BIN_OK)
+		return -1;
+	p = &buffer[COP_BIN_RESPONSE];
+	*value = (DWORD)p[0] | ((DWORD)p[1] << 8) | ((DWORD)p[2] << 16) | ((DWORD)p[3] << 24);
+	return 0;
+}
+
+static long binary_write32(WORD index, BYTE subindex, DWORD value)
+{
+	BYTE buffer[BUFFER_SIZE];
+	BYTE *p = frame(buffer, COP_BIN_DOWNLOAD, index, subindex, COP_BIN_UNSIGNED32);
+
+	p[0] = (BYTE)value; p[1] = (BYTE)(value >> 8); p[2] = (BYTE)(value >> 16); p[3] = (BYTE)(value >> 24);
+	if(request(buffer, COP_BIN_REQUEST + 8) != COP_BIN_RESPONSE || buffer[7] != COP_BIN_OK)
+		return -1;
+	return 0;
+}
+
+static long binary_read_domain(WORD index, BYTE subindex, BYTE *data, int nbyte)
+{
+	BYTE buffer[BUFFER_SIZE];
+	int n;
+
+	frame(buffer, COP_BIN_UPLOAD, index, subindex, COP_BIN_DOMAIN);
+	if((n = request(buffer, COP_BIN_REQUEST + 4) - COP_BIN_RESPONSE) < 0 || buffer[7] != COP_BIN_OK || n > nbyte)
+		return -1;
+	memcpy(data, &buffer[COP_BIN_RESPONSE], n);
+	return n;
+}
+
+
+/*  -----------  functions  ------------------------------------------------
+ */
+
+typedef struct {
+	long (*read32)(WORD, BYTE, DWORD*);
+	long (*write32)(WORD, BYTE, DWORD);
+	long (*read_domain)(WORD, BYTE, BYTE*, int);
+}	CLIENT;
+
+static CLIENT ascii = {ascii_read32, ascii_write32, ascii_read_domain};
+static CLIENT binary = {binary_read32, binary_write32, binary_read_domain};
+
+static int verify(CLIENT *client, char *name)
+{
+	BYTE data[DOMAIN_SIZE];
+	DWORD value;
+	int errors = 0;
+
+	errors += (client->read32(0x1018, 4, &value) != 0 || value != serial);
+	errors += (client->write32(0x2001, 0, 0xCAFE0001) != 0 || counter != 0xCAFE0001);
+	errors += (client->read32(0x2001, 0, &value) != 0 || value != 0xCAFE0001);
+	errors += (client->read32(0x2003, 0, &value) == 0);		/* SDO abort */
+	errors += (client->read_domain(0x2002, 0, data, DOMAIN_SIZE) != DOMAIN_SIZE || memcmp(data, domain, DOMAIN_SIZE));
+	if(errors)
+		fprintf(stderr, "+++ error: %s transfers %i wrong value(s)\n", name, errors);
+	return errors;
+}
+
+static double elapsed(struct timeval *t0)
+{
+	struct timeval t1;
+
+	gettimeofday(&t1, NULL);
+	return (double)(t1.tv_sec - t0->tv_sec) + (double)(t1.tv_usec - t0->tv_usec) / 1000000.0;
+}
+
+static double measure(CLIENT *client, int operation, long loops)
+{
+	BYTE data[DOMAIN_SIZE];
+	struct timeval t0;
+	DWORD value, sum = 0;
+	long i;
+
+	gettimeofday(&t0, NULL);
+	for(i = 0; i < loops; i++) {
+		switch(operation) {
+		case 0: client->read32(0x1018, 4, &value); sum += value; break;
+		case 1: client->write32(0x2001, 0, (DWORD)i); break;
+		case 2: client->read_domain(0x2002, 0, data, DOMAIN_SIZE); sum += data[i % DOMAIN_SIZE]; break;
+		}
+	}
+	if(sum == 1)						/* keep the results */
+		putchar(' ');
+	return elapsed(&t0) * 1000000000.0 / (double)loops;
+}
+
+int main(int argc, char *argv[])
+{
+	static char *operations[] = {"read u32", "write u32", "read domain (256 bytes)"};
+	long loops = (argc > 1)? atol(argv[1]) : LOOPS;
+	double t1, t2;
+	int i;
+
+	for(i = 0; i < DOMAIN_SIZE; i++)
+		domain[i] = (BYTE)(i * 7 + 3);
+	if(verify(&ascii, "ASCII Mapping") || verify(&binary, "binary framing"))
+		return 1;
+	printf("binary framing: verified against the ASCII Mapping\n");
+
+	printf("%-24s %12s %12s %9s\n", "operation", "ASCII [ns]", "binary [ns]", "speed-up");
+	for(i = 0; i < 3; i++) {
+		t1 = measure(&ascii, i, loops);
+		t2 = measure(&binary, i, loops);
+		printf("%-24s %12.1f %12.1f %9.2f\n", operations[i], t1, t2, t1 / t2);
+	}
+	return 0;
+}
@@ -0,0 +1,149 @@
+/*	-- $Header$ --
+ *
+ *	projekt   :  CAN - Controller Area Network.
+ *
+ *	purpose   :  Benchmark of the throughput and latency of the gateway.
+ *
+ *	copyright :  (C) 2009, UV Software, Friedrichshafen.
+ *
+ *	compiler  :  GCC - GNU C Compiler (Linux Kernel 2.6)
+ *
+ *	author    :  Uwe Vogt, UV Software, Friedrichshafen
+ *
+ *	e-mail    :  uwe.vogt@uv-software.de
+ *
+ *
+ *	-----------  description  -----------------------------------------------
+ *
+ *	Measures the throughput (requests/s) and the latency percentiles (usec)
+ *	of the gateway: a corpus of recorded requests (one request per line) is
+ *	replayed through cop_tcp_parse(), which executes them on the simulated
+ *	CAN bus of can_stub.c with the responder nodes 1,..,<nodes>. So all of
+ *	the stack above can_ctrl.c is measured (cop_tcp.c, cop_sdo.c, cop_nms.c,
+ *	...), but no time is spent on the bus. The requests are executed in
+ *	place, as the server does.
+ *
+ *	Before the measurement each request is executed once, and a request
+ *	with an error response is reported. The metrics of the gateway (see
+ *	cop_tcp_report) show which commands make the tail.
+ *
+ *	usage: bench_gateway [<corpus> [<loops> [<nodes>]]]
+ *
+ *
+ *	-----------  history  ---------------------------------------------------
+ *
+ *	$Log$
+ */
+
+#include "can_stub.c"
+
+#include "../cop_tcp.h"
+#include "../cop_api.h"
+
+#include <stdlib.h>
+
+
+/*  -----------  defines  --------------------------------------------------
+ */
+
+#define CORPUS				"bench/requests.txt"
+#define LOOPS				100
+#define NODES				127
+#define MAX_REQUESTS		1024
+#define BUFFER_SIZE			1025
+
+
+/*  -----------  variables  ------------------------------------------------
+ */
+
+static char *requests[MAX_REQUESTS];
+static int count = 0;
+
+
+/*  -----------  functions  ------------------------------------------------
+ */
+
+static int load(char *filename)
+{
+	char line[BUFFER_SIZE];
+	FILE *fp;
+
+	if(!(fp = fopen(filename, "r"))) {
+		perror(filename);
+		return 0;
+	}
+	while(count < MAX_REQUESTS && fgets(line, sizeof(line), fp)) {
+		line[strcspn(line, "\r\n")] = '\0';
+		if(line[0] == '[')
+			requests[count++] = strdup(line);
+	}
+	fclose(fp);
+	return count;
+}
+
+static int ascending(const void *a, const void *b)
+{
+	double x = *(const double*)a, y = *(const double*)b;
+
+	return (x > y) - (x < y);
+}
+
+static double percentile(double *sorted, long n, double p)
+{
+	return sorted[(long)((double)(n - 1) * p / 100.0 + 0.5)];
+}
+
+int main(int argc, char *argv[])
+{
+	struct _can_param param = {"stub", 0, 0, 0};
+	COP_TCP_SETTINGS settings = {1, 1, 127, 0, -1, NULL, -1};
+	char buffer[BUFFER_SIZE];
+	long loops = (argc > 2)? atol(argv[2]) : LOOPS;
+	int nodes = (argc > 3)? atoi(argv[3]) : NODES;
+	struct timespec t0, t1, start;
+	double *latency, total, sum = 0.0;
+	long i, n = 0, errors = 0;
+	int r;
+
+	if(!load((argc > 1)? argv[1] : CORPUS))
+		return 1;
+	if(loops < 1 || !(latency = (double*)malloc(sizeof(double) * loops * count)))
+		return 1;
+	if(cop_init(CAN_NETDEV, &param, CANBDR_250) != COPERR_NOERROR) {
+		fprintf(stderr, "+++ error: cop_init failed\n");
+		return 1;
+	}
+	stub_nodes(nodes);
+	/* each request once: the corpus shall be executable */
+	for(r = 0; r < count; r++) {
+		strcpy(buffer, requests[r]);
+		if(cop_tcp_parse(buffer, &settings, buffer, BUFFER_SIZE) != 0) {
+			buffer[strcspn(buffer, "\r\n")] = '\0';
+			fprintf(stderr, "+++ warning: \"%s\" answered \"%s\"\n", requests[r], buffer);
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(i = 0; i < loops; i++) {
+		for(r = 0; r < count; r++) {
+			strcpy(buffer, requests[r]);
+			clock_gettime(CLOCK_MONOTONIC, &t0);
+			errors += (cop_tcp_parse(buffer, &settings, buffer, BUFFER_SIZE) != 0);
+			clock_gettime(CLOCK_MONOTONIC, &t1);
+			latency[n] = (double)(t1.tv_sec - t0.tv_sec) * 1e6 + (double)(t1.tv_nsec - t0.tv_nsec) / 1e3;
+			sum += latency[n++];
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	total = (double)(t1.tv_sec - start.tv_sec) + (double)(t1.tv_nsec - start.tv_nsec) / 1e9;
+	qsort(latency, n, sizeof(double), ascending);
+
+	printf("gateway: %i requests x %li loops, %i responder nodes, %li errors\n", count, loops, nodes, errors);
+	printf("throughput: %.0f requests/s\n", (double)n / total);
+	printf("latency [usec]: avg %.1f, 50%% %.1f, 90%% %.1f, 99%% %.1f, 99.9%% %.1f, max %.1f\n",
+	       sum / (double)n, percentile(latency, n, 50.0), percentile(latency, n, 90.0),
+	       percentile(latency, n, 99.0), percentile(latency, n, 99.9), latency[n-1]);
+	cop_tcp_report(stdout);
+	cop_exit();
+	free(latency);
+	return 0;
+}
@@ -0,0 +1,175 @@
+/*	-- $Header$ --
+ *
+ *	projekt   :  CAN - Controller Area Network.
+ *
+ *	purpose   :  Benchmark of the I/O access of the IOX1 service.
+ *
+ *	copyright :  (C) 2009, UV Software, Friedrichshafen.
+ *
+ *	compiler  :  GCC - GNU C Compiler (Linux Kernel 2.6)
+ *
+ *	author    :  Uwe Vogt, UV Software, Friedrichshafen
+ *
+ *	e-mail    :  uwe.vogt@uv-software.de
+ *
+ *
+ *	-----------  description  -----------------------------------------------
+ *
+ *	Measures the latency (usec per call) of the digital inputs and outputs
+ *	of the IOX1 module as the service (mangoh_canOpen_iox1.c) accesses them:
+ *	formerly as text, i.e. a DS-309/3 request formatted by snprintf(),
+ *	executed by cop_tcp_parse() and its response taken apart by strtok()
+ *	and strtol(), now by the typed SDO functions of the CANopen Master
+ *	(sdo_read_8bit, sdo_write_8bit, ...). The transfers are executed on the
+ *	simulated CAN bus of can_stub.c (responder node 1 has the objects 6000h,
+ *	6100h, 6200h and 6300h), so the difference is the text processing.
+ *
+ *	usage: bench_iox1 [<calls>]
+ *
+ *
+ *	-----------  history  ---------------------------------------------------
+ *
+ *	$Log$
+ */
+
+#include "can_stub.c"
+
+#include "../cop_tcp.h"
+#include "../cop_api.h"
+
+#include <stdlib.h>
+
+
+/*  -----------  defines  --------------------------------------------------
+ */
+
+#define CALLS				100000
+#define NODE				1
+#define BUFFER_SIZE			64
+
+
+/*  -----------  variables  ------------------------------------------------
+ */
+
+static COP_TCP_SETTINGS settings = {1, NODE, 255, 0, -1, NULL, -1};
+static int cnt = 1;
+
+
+/*  -----------  text access (as the former service)  ---------------------
+ */
+
+static int text_read8(BYTE subindex, BYTE *value)
+{
+	char buf[BUFFER_SIZE];
+	char *token;
+
+	snprintf(buf, sizeof(buf), "[%d] 1 r 0x6000 %u u8", cnt++, subindex);
+	cop_tcp_parse(&buf[0], &settings, &buf[0], sizeof(buf));
+	token = strtok(buf, " ");
+	token = strtok(NULL, " ");
+	if(!token || token[0] == 'E')
+		return -1;
+	*value = (BYTE)strtol(token, NULL, 0);
+	return 0;
+}
+
+static int text_write8(BYTE subindex, BYTE value)
+{
+	char buf[BUFFER_SIZE];
+
+	snprintf(buf, sizeof(buf), "[%d] 1 w 0x6200 %u u8 0x%x", cnt++, subindex, value);
+	cop_tcp_parse(&buf[0], &settings, &buf[0], sizeof(buf));
+	return strstr(buf, "OK")? 0 : -1;
+}
+
+
+/*  -----------  typed access (as the service)  ----------------------------
+ */
+
+static int typed_read8(BYTE subindex, BYTE *value)
+{
+	return (sdo_read_8bit(NODE, 0x6000, subindex, value) == COPERR_NOERROR)? 0 : -1;
+}
+
+static int typed_write8(BYTE subindex, BYTE value)
+{
+	return (sdo_write_8bit(NODE, 0x6200, subindex, value) == COPERR_NOERROR)? 0 : -1;
+}
+
+static int typed_read16(BYTE subindex, WORD *value)
+{
+	return (sdo_read_16bit(NODE, 0x6100, subindex, value) == COPERR_NOERROR)? 0 : -1;
+}
+
+
+/*  -----------  functions  ------------------------------------------------
+ */
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec * 1e6 + (double)ts.tv_nsec / 1e3;
+}
+
+static double measure(char *name, int kind, long calls)
+{
+	BYTE value8 = 0; WORD value16 = 0;
+	double t0, usec;
+	long i, errors = 0;
+
+	t0 = now();
+	for(i = 0; i < calls; i++) {
+		switch(kind) {
+		case 0: errors += (text_read8(1, &value8) != 0); break;
+		case 1: errors += (typed_read8(1, &value8) != 0); break;
+		case 2: errors += (text_write8(1, (BYTE)i) != 0); break;
+		case 3: errors += (typed_write8(1, (BYTE)i) != 0); break;
+		case 4: errors += (text_read8(1, &value8) != 0);
+		        errors += (text_read8(2, &value8) != 0); break;
+		case 5: errors += (typed_read16(1, &value16) != 0); break;
+		}
+	}
+	usec = (now() - t0) / (double)calls;
+	printf("%-26s %7.2f", name, usec);
+	if(errors)
+		printf(" (%li errors)", errors);
+	putchar('\n');
+	return usec;
+}
+
+int main(int argc, char *argv[])
+{
+	struct _can_param param = {"stub", 0, 0, 0};
+	long calls = (argc > 1)? atol(argv[1]) : CALLS;
+	double text, typed;
+
+	if(calls < 1)
+		return 1;
+	if(cop_init(CAN_NETDEV, &param, CANBDR_250) != COPERR_NOERROR) {
+		fprintf(stderr, "+++ error: cop_init failed\n");
+		return 1;
+	}
+	stub_nodes(NODE);
+	/* the I/O objects of the module (created by their first download) */
+	if(sdo_write_8bit(NODE, 0x6000, 1, 0x5A) != COPERR_NOERROR ||
+	   sdo_write_8bit(NODE, 0x6000, 2, 0xA5) != COPERR_NOERROR ||
+	   sdo_write_16bit(NODE, 0x6100, 1, 0xA55A) != COPERR_NOERROR ||
+	   sdo_write_8bit(NODE, 0x6200, 1, 0x00) != COPERR_NOERROR) {
+		fprintf(stderr, "+++ error: objects of the module not created\n");
+		return 1;
+	}
+	printf("IOX1 access: %li calls each, usec per call\n", calls);
+	text = measure("read DI0-DI7 (text)", 0, calls);
+	typed = measure("read DI0-DI7 (typed)", 1, calls);
+	printf("%-26s %7.2f\n", "speed-up", text / typed);
+	text = measure("write DO0-DO7 (text)", 2, calls);
+	typed = measure("write DO0-DO7 (typed)", 3, calls);
+	printf("%-26s %7.2f\n", "speed-up", text / typed);
+	text = measure("read DI0-DI15 (text, 2x8)", 4, calls);
+	typed = measure("read DI0-DI15 (typed, 16)", 5, calls);
+	printf("%-26s %7.2f\n", "speed-up", text / typed);
+	cop_exit();
+	return 0;
+}
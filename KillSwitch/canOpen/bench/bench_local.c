@@ -0,0 +1,251 @@
+/*	-- $Header$ --
+ *
+ *	projekt   :  CAN - Controller Area Network.
+ *
+ *	purpose   :  Benchmark of the transports for local gateway clients.
+ *
+ *	copyright :  (C) 2009, UV Software, Friedrichshafen.
+ *
+ *	compiler  :  GCC - GNU C Compiler (Linux Kernel 2.6)
+ *
+ *	author    :  Uwe Vogt, UV Software, Friedrichshafen
+ *
+ *	e-mail    :  uwe.vogt@uv-software.de
+ *
+ *
+ *	-----------  description  -----------------------------------------------
+ *
+ *	Measures the round-trip latency (usec) of a request to the gateway
+ *	server (cop_srv_loop, in a thread of its own) from a client on the same
+ *	board: over TCP/IP loopback, over the local socket (AF_UNIX) and through
+ *	the shared-memory ring (cop_shm.h). The requests are executed on the
+ *	simulated CAN bus of can_stub.c; the same request executed in place
+ *	by cop_tcp_parse() shows the time which is not spent on the transport.
+ *
+ *	usage: bench_local [<requests> [<request>]]
+ *
+ *
+ *	-----------  history  ---------------------------------------------------
+ *
+ *	$Log$
+ */
+
+#include "can_stub.c"
+
+#include "../cop_srv.h"
+#include "../cop_shm.h"
+#include "../cop_api.h"
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+
+/*  -----------  defines  --------------------------------------------------
+ */
+
+#define REQUESTS			20000
+#define REQUEST				"1 r 0x1000 0 u32"
+#define NODES				8
+#define BUFFER_SIZE			1025
+
+
+/*  -----------  variables  ------------------------------------------------
+ */
+
+static COP_TCP_SETTINGS settings = {1, 1, 127, 0, -1, NULL, -1};
+static int server = -1, local = -1;
+static COP_SHM *ring = NULL;
+static int running = 1;
+static char ring_name[64];
+static struct sockaddr_in tcp_addr;
+static struct sockaddr_un local_addr;
+static socklen_t local_len;
+
+
+/*  -----------  functions  ------------------------------------------------
+ */
+
+static void *gateway(void *arg)
+{
+	arg = arg;
+	cop_srv_loop(server, local, ring, &settings, 0, &running);
+	return NULL;
+}
+
+static int listeners(void)
+{
+	socklen_t len = sizeof(tcp_addr);
+
+	/* TCP/IP loopback (any port) */
+	memset(&tcp_addr, 0, sizeof(tcp_addr));
+	tcp_addr.sin_family = AF_INET;
+	tcp_addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if((server = socket(AF_INET, SOCK_STREAM, 0)) < 0 ||
+	   bind(server, (struct sockaddr*)&tcp_addr, sizeof(tcp_addr)) < 0 ||
+	   listen(server, COP_SRV_CLIENTS) < 0 ||
+	   getsockname(server, (struct sockaddr*)&tcp_addr, &len) < 0) {
+		perror("+++ error(tcp)");
+		return -1;
+	}
+	/* local socket (abstract name) */
+	memset(&local_addr, 0, sizeof(local_addr));
+	local_addr.sun_family = AF_UNIX;
+	snprintf(&local_addr.sun_path[1], sizeof(local_addr.sun_path) - 1, "can_open.bench.%i", (int)getpid());
+	local_len = (socklen_t)(offsetof(struct sockaddr_un, sun_path) + 1 + strlen(&local_addr.sun_path[1]));
+	if((local = socket(AF_UNIX, SOCK_STREAM, 0)) < 0 ||
+	   bind(local, (struct sockaddr*)&local_addr, local_len) < 0 ||
+	   listen(local, COP_SRV_CLIENTS) < 0) {
+		perror("+++ error(unix)");
+		return -1;
+	}
+	/* shared-memory ring */
+	snprintf(ring_name, sizeof(ring_name), "/can_open.bench.%i", (int)getpid());
+	if(!(ring = cop_shm_create(ring_name)))
+		return -1;
+	return 0;
+}
+
+static int connect_to(int family)
+{
+	int fd, on = 1;
+
+	if((fd = socket(family, SOCK_STREAM, 0)) < 0)
+		return -1;
+	if(family == AF_INET) {
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+		if(connect(fd, (struct sockaddr*)&tcp_addr, sizeof(tcp_addr)) < 0) {
+			close(fd);
+			return -1;
+		}
+	}
+	else if(connect(fd, (struct sockaddr*)&local_addr, local_len) < 0) {
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+static int socket_request(int fd, char *request, char *response, int nbyte)
+{
+	int n = 0;
+	ssize_t res;
+
+	if(write(fd, request, strlen(request)) < 0)
+		return -1;
+	/* one response line */
+	while(n < nbyte - 1) {
+		if((res = read(fd, &response[n], nbyte - 1 - n)) <= 0)
+			return -1;
+		n += (int)res;
+		if(response[n - 1] == '\n')
+			break;
+	}
+	response[n] = '\0';
+	return n;
+}
+
+static int ascending(const void *a, const void *b)
+{
+	double x = *(const double*)a, y = *(const double*)b;
+
+	return (x > y) - (x < y);
+}
+
+static double percentile(double *sorted, long n, double p)
+{
+	return sorted[(long)((double)(n - 1) * p / 100.0 + 0.5)];
+}
+
+static double elapsed(struct timespec *t0, struct timespec *t1)
+{
+	return (double)(t1->tv_sec - t0->tv_sec) * 1e6 + (double)(t1->tv_nsec - t0->tv_nsec) / 1e3;
+}
+
+static void measure(char *transport, int fd, COP_SHM *shm, char *command, long count, double *latency)
+{
+	COP_TCP_SETTINGS inplace = {1, 1, 127, 0, -1, NULL, -1};
+	char request[BUFFER_SIZE], response[BUFFER_SIZE];
+	struct timespec t0, t1;
+	double sum = 0.0;
+	long i, errors = 0;
+	int n;
+
+	for(i = 0; i < count; i++) {
+		snprintf(request, sizeof(request), "[%li] %s\n", i + 1, command);
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+		if(fd >= 0)
+			n = socket_request(fd, request, response, BUFFER_SIZE);
+		else if(shm)
+			n = cop_shm_request(shm, request, response, BUFFER_SIZE);
+		else
+			n = cop_tcp_parse(request, &inplace, response, BUFFER_SIZE)? 0 : (int)strlen(response);
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+		if(n <= 0 || strstr(response, "Error") || strtol(&response[1], NULL, 10) != i + 1)
+			errors++;
+		latency[i] = elapsed(&t0, &t1);
+		sum += latency[i];
+	}
+	qsort(latency, count, sizeof(double), ascending);
+	printf("%-10s avg %6.1f, 50%% %6.1f, 90%% %6.1f, 99%% %6.1f, max %7.1f usec", transport,
+	       sum / (double)count, percentile(latency, count, 50.0), percentile(latency, count, 90.0),
+	       percentile(latency, count, 99.0), latency[count - 1]);
+	if(errors)
+		printf(" (%li errors)", errors);
+	putchar('\n');
+}
+
+int main(int argc, char *argv[])
+{
+	struct _can_param param = {"stub", 0, 0, 0};
+	long count = (argc > 1)? atol(argv[1]) : REQUESTS;
+	char *command = (argc > 2)? argv[2] : REQUEST;
+	COP_SHM *client;
+	pthread_t thread;
+	double *latency;
+	int fd;
+
+	if(count < 1 || !(latency = (double*)malloc(sizeof(double) * count)))
+		return 1;
+	if(cop_init(CAN_NETDEV, &param, CANBDR_250) != COPERR_NOERROR) {
+		fprintf(stderr, "+++ error: cop_init failed\n");
+		return 1;
+	}
+	stub_nodes(NODES);
+	if(listeners() < 0)
+		return 1;
+	if(pthread_create(&thread, NULL, gateway, NULL) != 0) {
+		perror("+++ error(pthread_create)");
+		return 1;
+	}
+	printf("local clients: %li requests \"%s\", one at a time\n", count, command);
+	measure("in place", -1, NULL, command, count, latency);
+	if((fd = connect_to(AF_INET)) >= 0) {
+		measure("tcp", fd, NULL, command, count, latency);
+		close(fd);
+	}
+	if((fd = connect_to(AF_UNIX)) >= 0) {
+		measure("unix", fd, NULL, command, count, latency);
+		close(fd);
+	}
+	if((client = cop_shm_open(ring_name)) != NULL) {
+		measure("shm", -1, client, command, count, latency);
+		cop_shm_close(client);
+	}
+	fflush(stdout);
+	running = 0;
+	pthread_join(thread, NULL);
+	close(server);
+	close(local);
+	cop_exit();
+	cop_shm_destroy(ring, ring_name);
+	free(latency);
+	return 0;
+}
@@ -0,0 +1,150 @@
+/*	-- $Header$ --
+ *
+ *	projekt   :  CAN - Controller Area Network.
+ *
+ *	purpose   :  Benchmark of the number parsing of the TCP/IP gateway.
+ *
+ *	copyright :  (C) 2009, UV Software, Friedrichshafen.
+ *
+ *	compiler  :  GCC - GNU C Compiler (Linux Kernel 2.6)
+ *
+ *	author    :  Uwe Vogt, UV Software, Friedrichshafen
+ *
+ *	e-mail    :  uwe.vogt@uv-software.de
+ *
+ *
+ *	-----------  description  -----------------------------------------------
+ *
+ *	Measures the parsing cost per request (ns) of a corpus of recorded
+ *	gateway requests (one request per line). Each request is scanned as
+ *	cop_tcp_parse() does: the <sequence>, the [[<net>] <node>], and the
+ *	keywords, indexes, sub-indexes and values of the command, each with
+ *	the parser of its data type. No request is executed.
+ *
+ *	The static functions of cop_tcp.c are reached by including the file.
+ *
+ *	usage: bench_parse [<corpus> [<loops>]]
+ *
+ *
+ *	-----------  history  ---------------------------------------------------
+ *
+ *	$Log$
+ */
+
+#include "../cop_tcp.c"
+
+#include <sys/time.h>
+
+
+/*  -----------  defines  --------------------------------------------------
+ */
+
+#define CORPUS				"bench/requests.txt"
+#define LOOPS				100000
+#define MAX_REQUESTS		1024
+
+
+/*  -----------  variables  ------------------------------------------------
+ */
+
+static char *requests[MAX_REQUESTS];
+static int count = 0;
+
+
+/*  -----------  functions  ------------------------------------------------
+ */
+
+static int load(char *filename)
+{
+	char line[256];
+	FILE *fp;
+	
+	if(!(fp = fopen(filename, "r"))) {
+		perror(filename);
+		return 0;
+	}
+	while(count < MAX_REQUESTS && fgets(line, sizeof(line), fp)) {
+		line[strcspn(line, "\r\n")] = '\0';
+		if(line[0] == '[')
+			requests[count++] = strdup(line);
+	}
+	fclose(fp);
+	return count;
+}
+
+static int value(char *line, int *pos, int type)
+{
+	unsigned char u8; unsigned short u16; unsigned long u32;
+	char i8; short i16; long i32;
+	
+	switch(type) {
+	case INTEGER8:	 return ascii2integer8(line, pos, &i8);
+	case INTEGER16:	 return ascii2integer16(line, pos, &i16);
+	case INTEGER32:	 return ascii2integer32(line, pos, &i32);
+	case UNSIGNED8:	 return ascii2unsigned8(line, pos, &u8);
+	case UNSIGNED16: return ascii2unsigned16(line, pos, &u16);
+	case UNSIGNED32: return ascii2unsigned32(line, pos, &u32);
+	}
+	return 1;
+}
+
+static int scan(char *line)
+{
+	unsigned long sequence;
+	unsigned short number;
+	unsigned char node;
+	int pos = 0, cmd, type;
+	
+	/* '['<sequence>']' [[<net>] <node>] */
+	pos++;
+	if(!ascii2unsigned32(line, &pos, &sequence))
+		return 0;
+	pos++;
+	while(lookahead(line, &pos) != -1 && DECIMAL(line[pos])) {
+		if(!ascii2unsigned8(line, &pos, &node))
+			return 0;
+	}
+	/* <command> ... */
+	cmd = token(line, &pos);
+	if((cmd == READ || cmd == WRITE) && (lookahead(line, &pos) != -1) && DECIMAL(line[pos])) {
+		if(!ascii2unsigned16(line, &pos, &number) || !ascii2unsigned8(line, &pos, &node))
+			return 0;
+		type = token(line, &pos);
+		return (cmd == WRITE)? value(line, &pos, type) : 1;
+	}
+	while(lookahead(line, &pos) != -1) {
+		if(DECIMAL(line[pos])) {
+			if(!ascii2unsigned32(line, &pos, &sequence))
+				return 0;
+		}
+		else if(token(line, &pos) == -1)
+			return 0;
+	}
+	return 1;
+}
+
+int main(int argc, char *argv[])
+{
+	long loops = (argc > 2)? atol(argv[2]) : LOOPS;
+	struct timeval t0, t1;
+	double t;
+	long i, n = 0;
+	int r;
+	
+	if(!load((argc > 1)? argv[1] : CORPUS))
+		return 1;
+	for(r = 0; r < count; r++) {
+		if(!scan(requests[r]))
+			fprintf(stderr, "+++ warning: syntax error in \"%s\"\n", requests[r]);
+	}
+	gettimeofday(&t0, NULL);
+	for(i = 0; i < loops; i++) {
+		for(r = 0; r < count; r++)
+			n += scan(requests[r]);
+	}
+	gettimeofday(&t1, NULL);
+	t = (double)(t1.tv_sec - t0.tv_sec) + (double)(t1.tv_usec - t0.tv_usec) / 1000000.0;
+	printf("number parsing: %i requests, %.1f ns/request, %.0f requests/s (%li ok)\n",
+	       count, t * 1e9 / (loops * count), (loops * count) / t, n);
+	return 0;
+}
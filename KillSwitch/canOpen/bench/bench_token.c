@@ -0,0 +1,272 @@
+/*	-- $Header$ --
+ *
+ *	projekt   :  CAN - Controller Area Network.
+ *
+ *	purpose   :  Benchmark of the keyword lookup of the TCP/IP gateway.
+ *
+ *	copyright :  (C) 2009, UV Software, Friedrichshafen.
+ *
+ *	compiler  :  GCC - GNU C Compiler (Linux Kernel 2.6)
+ *
+ *	author    :  Uwe Vogt, UV Software, Friedrichshafen
+ *
+ *	e-mail    :  uwe.vogt@uv-software.de
+ *
+ *
+ *	-----------  description  -----------------------------------------------
+ *
+ *	Measures the parser throughput (requests/s) of the keyword lookup in
+ *	cop_tcp.c against the former linear lookup, which tried all keywords
+ *	one after the other. Before the measurement both lookups are checked
+ *	to return the same token and position for every keyword, all of its
+ *	prefixes and extensions, and for random input.
+ *
+ *	The static functions of cop_tcp.c are reached by including the file.
+ *
+ *	usage: bench_token [<loops>]
+ *
+ *
+ *	-----------  history  ---------------------------------------------------
+ *
+ *	$Log$
+ */
+
+#include "../cop_tcp.c"
+
+#include <sys/time.h>
+
+
+/*  -----------  defines  --------------------------------------------------
+ */
+
+#define LOOPS				200000
+
+
+/*  -----------  variables  ------------------------------------------------
+ */
+
+/* keywords of the former linear lookup, in their order of precedence */
+static struct {
+	char *string;
+	int token;
+}	reference[] = {
+	{"b", BOOLEAN},
+	{"communication", COMMUNICATION},
+	{"commission", COMMISSION},
+	{"comm", COMMUNICATION},
+	{"copyright", COPYRIGHT},
+	{"disable", DISABLE},
+	{"d", DOMAIN},
+	{"emcy", EMCY},
+	{"enable", ENABLE},
+	{"error", ERROR},
+	{"event", EVENT},
+	{"execute", EXECUTE},
+	{"exec", EXECUTE},
+	{"exit", EXIT},
+	{"e", ERROR},
+	{"firmware", FIRMWARE},
+	{"guarding", GUARDING},
+	{"hardware", HARDWARE},
+	{"heartbeat", HEARTBEAT},
+	{"i8", INTEGER8},
+	{"i16", INTEGER16},
+	{"i24", INTEGER24},
+	{"i32", INTEGER32},
+	{"i40", INTEGER40},
+	{"i48", INTEGER48},
+	{"i56", INTEGER56},
+	{"i64", INTEGER64},
+	{"identity", IDENTITY},
+	{"id", ID},
+	{"info", INFO},
+	{"init", INIT},
+	{"mask", MASK},
+	{"network", NETWORK},
+	{"node", NODE},
+	{"ok", OK},
+	{"os", OCTET_STRING},
+	{"pdo", PDO},
+	{"preoperational", PREOPERATIONAL},
+	{"preop", PREOPERATIONAL},
+	{"p", PDO},
+	{"r32", REAL32},
+	{"r64", REAL64},
+	{"rate", RATE},
+	{"read", READ},
+	{"receive", RECEIVE},
+	{"recv", RECEIVE},
+	{"restore", RESTORE},
+	{"reset", RESET},
+	{"rpdo", RPDO},
+	{"rtr", RTR},
+	{"r", READ},
+	{"scan", SCAN},
+	{"sdo_timeout", SDO_TIME_OUT},
+	{"set", SET},
+	{"send", SEND},
+	{"software", SOFTWARE},
+	{"start", START},
+	{"stop", STOP},
+	{"store", STORE},
+	{"sync", SYNC},
+	{"td", TIME_DIFFERENCE},
+	{"tpdo", TPDO},
+	{"t", TIME_OF_DAY},
+	{"u8", UNSIGNED8},
+	{"u16", UNSIGNED16},
+	{"u24", UNSIGNED24},
+	{"u32", UNSIGNED32},
+	{"u40", UNSIGNED40},
+	{"u48", UNSIGNED48},
+	{"u56", UNSIGNED56},
+	{"u64", UNSIGNED64},
+	{"user", USER},
+	{"us", UNICODE_STRING},
+	{"version", VERSION},
+	{"vs", VISIBLE_STRING},
+	{"wait", WAIT},
+	{"write", WRITE},
+	{"w", WRITE},
+	{NULL, -1}
+};
+
+/* typical requests (cf. README) */
+static char *requests[] = {
+	"[1] 1 read 0x1018 1 u32",
+	"[2] 1 2 write 0x6200 1 u8 0xFF",
+	"[3] 1 r 0x1000 0 u32",
+	"[4] 1 w 0x1017 0 u16 1000",
+	"[5] 1 start",
+	"[6] 1 stop",
+	"[7] 1 preop",
+	"[8] 1 reset node",
+	"[9] 1 reset comm",
+	"[10] set sdo_timeout 500",
+	"[11] 1 enable guarding 100 3",
+	"[12] 1 disable heartbeat",
+	"[13] enable sync 10000 0 50",
+	"[14] read sync",
+	"[15] scan",
+	"[16] 5 read identity",
+	"[17] 1 read 0x1008 0 vs",
+	"[18] 1 read error",
+	"[19] info version",
+	"[20] 1 write 0x2000 0 os SGVsbG8=",
+	NULL
+};
+
+
+/*  -----------  functions  ------------------------------------------------
+ */
+
+static int token_linear(char *line, int *pos)
+{
+	int i;
+	
+	for(; WHITESPACE(line[*pos]); *pos += 1)
+		;
+	for(i = 0; reference[i].string; i++) {
+		if(compare(&line[*pos], reference[i].string)) {
+			*pos += strlen(reference[i].string);
+			return reference[i].token;
+		}
+	}
+	return -1;
+}
+
+static int check(char *line)
+{
+	int pos1 = 0, pos2 = 0;
+	
+	if(token(line, &pos1) != token_linear(line, &pos2) || pos1 != pos2) {
+		fprintf(stderr, "+++ error: lookup of \"%s\" differs\n", line);
+		return 0;
+	}
+	return 1;
+}
+
+static int verify(void)
+{
+	char line[64];
+	int i, n, len, errors = 0;
+	
+	for(i = 0; reference[i].string; i++) {
+		len = strlen(reference[i].string);
+		for(n = 0; n <= len; n++) {			/* all prefixes */
+			strncpy(line, reference[i].string, n);
+			line[n] = '\0';
+			errors += !check(line);
+			line[n] = 'x';					/* with one more character */
+			line[n + 1] = '\0';
+			errors += !check(line);
+		}
+		strcpy(line, reference[i].string);	/* in upper case */
+		for(n = 0; n < len; n++)
+			line[n] = toupper(line[n]);
+		errors += !check(line);
+	}
+	srand(1);
+	for(i = 0; i < 1000000; i++) {			/* random input */
+		len = rand() % 8;
+		for(n = 0; n < len; n++)
+			line[n] = "abcdeinoprstuvw0123 _"[rand() % 21];
+		line[len] = '\0';
+		errors += !check(line);
+	}
+	return errors;
+}
+
+static double measure(int (*lookup)(char *, int *), long loops, long *count)
+{
+	struct timeval t0, t1;
+	long i, n = 0;
+	int r, pos;
+	
+	gettimeofday(&t0, NULL);
+	for(i = 0; i < loops; i++) {
+		for(r = 0; requests[r]; r++) {
+			/* skip the '['<sequence>']' and the [[<net>] <node>] */
+			for(pos = 0; requests[r][pos] && requests[r][pos] != ']'; pos++)
+				;
+			/* look up every word of the request */
+			while(requests[r][pos]) {
+				for(pos++; WHITESPACE(requests[r][pos]); pos++)
+					;
+				if(isalpha(requests[r][pos]))
+					n += lookup(requests[r], &pos) != -1;
+				for(; requests[r][pos] && !WHITESPACE(requests[r][pos]); pos++)
+					;
+			}
+		}
+	}
+	gettimeofday(&t1, NULL);
+	*count = n;
+	return (double)(t1.tv_sec - t0.tv_sec) + (double)(t1.tv_usec - t0.tv_usec) / 1000000.0;
+}
+
+int main(int argc, char *argv[])
+{
+	long loops = (argc > 1)? atol(argv[1]) : LOOPS;
+	long requests_count, n1, n2;
+	double t1, t2;
+	int r;
+	
+	if(verify() != 0)
+		return 1;
+	printf("keyword lookup: verified against the linear lookup\n");
+	
+	for(r = 0; requests[r]; r++)
+		;
+	requests_count = loops * r;
+	t1 = measure(token_linear, loops, &n1);
+	t2 = measure(token, loops, &n2);
+	if(n1 != n2) {
+		fprintf(stderr, "+++ error: %li tokens vs. %li tokens\n", n1, n2);
+		return 1;
+	}
+	printf("linear lookup:  %10.0f requests/s (%li tokens in %.3f s)\n", requests_count / t1, n1, t1);
+	printf("switch lookup:  %10.0f requests/s (%li tokens in %.3f s)\n", requests_count / t2, n2, t2);
+	printf("speed-up:       %10.2f\n", t1 / t2);
+	return 0;
+}
@@ -0,0 +1,699 @@
+/*	-- $Header$ --
+ *
+ *	projekt   :  CAN - Controller Area Network.
+ *
+ *	purpose   :  CAN Controller Interface with simulated CANopen nodes.
+ *
+ *	copyright :  (C) 2009, UV Software, Friedrichshafen.
+ *
+ *	compiler  :  GCC - GNU C Compiler (Linux Kernel 2.6)
+ *
+ *	export    :  (see can_ctrl.h), stub_nodes(), stub_emcy()
+ *
+ *	author    :  Uwe Vogt, UV Software, Friedrichshafen
+ *
+ *	e-mail    :  uwe.vogt@uv-software.de
+ *
+ *
+ *	-----------  description  -----------------------------------------------
+ *
+ *	The functions of can_ctrl.c without a CAN interface, for the benchmarks
+ *	and the fuzz harness: a transmitted frame is answered by the responder
+ *	nodes 1,..,stub_nodes() as a CANopen slave would, and the answers are
+ *	received (through the hook, the message buffers or the event queue) as
+ *	can_ctrl.c receives the frames of the socket. So the whole stack above
+ *	can_ctrl.c runs unchanged, but no time is spent on the bus.
+ *
+ *	A responder node is a SDO server (expedited and segmented transfers)
+ *	with a small object dictionary: the objects below are scripted, any
+ *	other object is created by its first download. It follows the NMT
+ *	commands, sends its boot-up message after a reset, and answers the
+ *	node guarding requests. It is also a LSS slave (CiA DSP-305) with the
+ *	LSS address of its identity object: it is switched to configuration
+ *	mode (globally, or selectively by its LSS address), and confirms the
+ *	configuration of its node-id and bit-timing and the store command
+ *	(the configured values are kept, but never activated). An emergency
+ *	message of a responder is put on the bus by stub_emcy(); as any frame
+ *	it is received only when the stack reads the bus.
+ *
+ *	The file is included by the benchmark (as bench_parse includes
+ *	cop_tcp.c), and is linked instead of can_ctrl.o.
+ *
+ *
+ *	-----------  history  ---------------------------------------------------
+ *
+ *	$Log$
+ */
+
+#include "../can_ctrl.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+
+/*  -----------  defines  --------------------------------------------------
+ */
+
+#define STUB_NODES			127			/* max. number of responder nodes */
+#define STUB_OBJECTS		32			/* objects of a node */
+#define STUB_DATA			256			/* max. size of an object */
+#define STUB_FRAMES			1024		/* frames on the simulated bus */
+#define STUB_QUEUE			256			/* event queue (message object 15) */
+
+#define NMT_OPERATIONAL		0x05		/* NMT states of a node */
+#define NMT_STOPPED			0x04
+#define NMT_PREOPERATIONAL	0x7F
+
+#define LSS_MASTER			0x7E5		/* LSS messages */
+#define LSS_SLAVE			0x7E4
+
+#define SDO_ABORT_COMMAND	0x05040001	/* SDO abort codes */
+#define SDO_ABORT_TOGGLE	0x05030000
+#define SDO_ABORT_OBJECT	0x06020000
+#define SDO_ABORT_LENGTH	0x06070010
+#define SDO_ABORT_MEMORY	0x05040005
+
+#define NEXT(index, size)	(((index) + 1) % (size))
+
+
+/*  -----------  types  ----------------------------------------------------
+ */
+
+typedef struct _frame {					/* frame on the bus: */
+	long cob_id;						/*   identifier */
+	short length;						/*   data length code */
+	BYTE data[8];						/*   data */
+}	FRAME;
+
+typedef struct _object {				/* object of a responder: */
+	WORD index;							/*   index (0: entry free) */
+	BYTE subindex;						/*   sub-index */
+	short length;						/*   size of the value */
+	BYTE data[STUB_DATA];				/*   value */
+}	OBJECT;
+
+typedef struct _node {					/* responder node: */
+	BYTE state;							/*   NMT state */
+	BYTE toggle;						/*   node guarding toggle bit */
+	OBJECT objects[STUB_OBJECTS];		/*   object dictionary */
+	OBJECT transfer;					/*   segmented transfer in progress */
+	short offset;						/*   bytes transferred */
+	BYTE upload;						/*   direction of the transfer */
+	BYTE t;								/*   toggle bit of the transfer */
+	BYTE lss_mode;						/*   LSS configuration mode */
+	BYTE lss_match;						/*   LSS address parts matched */
+	BYTE lss_node_id;					/*   configured node-id */
+	BYTE lss_bit_timing;				/*   configured bit-timing */
+}	NODE;
+
+typedef struct _buffer {				/* message object: */
+	BYTE control;						/*   transmit, receive or remote */
+	long cob_id;						/*   identifier */
+	short count;						/*   number of received messages */
+	short length;						/*   number of received data bytes */
+	BYTE data[8];						/*   received data bytes */
+}	BUFFER;
+
+
+/*  -----------  variables  ------------------------------------------------
+ */
+
+static NODE nodes[STUB_NODES + 1];		/* responder nodes 1,..,STUB_NODES */
+static int present = 8;					/* number of responders */
+static BUFFER msg_buf[15];				/* message objects (as can_ctrl.c) */
+static FRAME bus[STUB_FRAMES];			/* frames sent by the responders */
+static int bus_head = 0, bus_tail = 0;
+static FRAME queue[STUB_QUEUE];			/* event queue */
+static int que_head = 0, que_tail = 0;
+static int started = 0;					/* controller started */
+static CAN_HOOK hook = NULL;			/* receive hook (or NULL) */
+static pthread_mutex_t stub_mutex = PTHREAD_MUTEX_INITIALIZER;
+static __thread unsigned long long until = 0;	/* time-out (per thread) */
+
+static struct {							/* scripted objects: */
+	WORD index; BYTE subindex; short length; char *data;
+}	script[] = {
+	{0x1000, 0, 4, "\x91\x01\x0F\x00"},	/*   device type: DS-401 */
+	{0x1001, 0, 1, "\x00"},				/*   error register */
+	{0x1008, 0, 18, "CANopen I/O (stub)"},	/*   device name */
+	{0x1009, 0, 3, "1.0"},				/*   hardware version */
+	{0x100A, 0, 3, "1.1"},				/*   software version */
+	{0x1017, 0, 2, "\x00\x00"},			/*   producer heartbeat time */
+	{0x1018, 0, 1, "\x04"},				/*   identity object */
+	{0x1018, 1, 4, "\x1A\x03\x00\x00"},	/*     vendor-id */
+	{0x1018, 2, 4, "\x01\x00\x01\x00"},	/*     product code */
+	{0x1018, 3, 4, "\x00\x00\x01\x00"},	/*     revision number */
+	{0x1018, 4, 4, "\x00\x00\x00\x10"},	/*     serial number (plus node-id) */
+	{0x2002, 0, 4, "\x00\x00\x00\x00"},	/*   manufacturer specific */
+	{0x6000, 1, 1, "\x5A"},				/*   digital inputs */
+	{0x6200, 1, 1, "\x00"},				/*   digital outputs */
+	{0x6401, 1, 2, "\x30\xF8"},			/*   analog inputs */
+	{0x6401, 2, 2, "\xFF\x7F"},
+	{0x6411, 1, 2, "\x00\x00"}			/*   analog output */
+};
+
+
+/*  -----------  responder nodes  ------------------------------------------
+ */
+
+static OBJECT *object(NODE *node, WORD index, BYTE subindex, int create)
+{
+	int i;
+
+	for(i = 0; i < STUB_OBJECTS && node->objects[i].index; i++) {
+		if(node->objects[i].index == index && node->objects[i].subindex == subindex)
+			return &node->objects[i];
+	}
+	if(!create || i == STUB_OBJECTS || !index)
+		return NULL;
+	node->objects[i].index = index;
+	node->objects[i].subindex = subindex;
+	node->objects[i].length = 0;
+	return &node->objects[i];
+}
+
+static void bus_send(long cob_id, short length, BYTE *data)
+{
+	/* a frame is lost when the bus is full (as by a full receive queue) */
+	if(NEXT(bus_head, STUB_FRAMES) != bus_tail) {
+		bus[bus_head].cob_id = cob_id;
+		bus[bus_head].length = length;
+		memcpy(bus[bus_head].data, data, length);
+		bus_head = NEXT(bus_head, STUB_FRAMES);
+	}
+}
+
+static void boot(int id)
+{
+	BYTE data[1] = {0x00};
+	int i;
+
+	memset(&nodes[id], 0, sizeof(NODE));
+	for(i = 0; i < (int)(sizeof(script) / sizeof(script[0])); i++) {
+		nodes[id].objects[i].index = script[i].index;
+		nodes[id].objects[i].subindex = script[i].subindex;
+		nodes[id].objects[i].length = script[i].length;
+		memcpy(nodes[id].objects[i].data, script[i].data, script[i].length);
+		if(script[i].index == 0x1018 && script[i].subindex == 4)
+			nodes[id].objects[i].data[0] = (BYTE)id;
+	}
+	nodes[id].state = NMT_PREOPERATIONAL;
+	bus_send(0x700 + id, 1, data);
+}
+
+static void abort_transfer(int id, BYTE *request, DWORD code)
+{
+	BYTE data[8];
+
+	data[0] = 0x80;
+	data[1] = request[1]; data[2] = request[2]; data[3] = request[3];
+	data[4] = (BYTE)code; data[5] = (BYTE)(code >> 8);
+	data[6] = (BYTE)(code >> 16); data[7] = (BYTE)(code >> 24);
+	nodes[id].transfer.index = 0;
+	bus_send(0x580 + id, 8, data);
+}
+
+static void sdo_server(int id, short length, BYTE *request)
+{
+	NODE *node = &nodes[id];
+	OBJECT *obj;
+	BYTE data[8];
+	WORD index = (WORD)request[1] | ((WORD)request[2] << 8);
+	int n;
+
+	if(length != 8)
+		return;
+	memset(data, 0, 8);
+	data[1] = request[1]; data[2] = request[2]; data[3] = request[3];
+	switch(request[0] & 0xE0) {
+	case 0x20:							/* initiate download */
+		if(!(obj = object(node, index, request[3], 1)))
+			{ abort_transfer(id, request, SDO_ABORT_MEMORY); return; }
+		if(request[0] & 0x02) {			/*   expedited */
+			n = (request[0] & 0x01)? 4 - ((request[0] >> 2) & 0x03) : 4;
+			memcpy(obj->data, &request[4], n);
+			obj->length = (short)n;
+		}
+		else {							/*   segmented */
+			node->transfer = *obj;
+			node->transfer.length = 0;
+			node->offset = 0;
+			node->upload = 0;
+			node->t = 0;
+		}
+		data[0] = 0x60;
+		break;
+	case 0x00:							/* download segment */
+		if(!node->transfer.index || node->upload)
+			{ abort_transfer(id, request, SDO_ABORT_COMMAND); return; }
+		if((request[0] & 0x10) != node->t)
+			{ abort_transfer(id, request, SDO_ABORT_TOGGLE); return; }
+		n = 7 - ((request[0] >> 1) & 0x07);
+		if(node->offset + n > STUB_DATA)
+			{ abort_transfer(id, request, SDO_ABORT_LENGTH); return; }
+		memcpy(&node->transfer.data[node->offset], &request[1], n);
+		node->offset += n;
+		if(request[0] & 0x01) {			/*   last segment */
+			if((obj = object(node, node->transfer.index, node->transfer.subindex, 1)) != NULL) {
+				memcpy(obj->data, node->transfer.data, node->offset);
+				obj->length = node->offset;
+			}
+			node->transfer.index = 0;
+		}
+		data[0] = 0x20 | node->t;
+		data[1] = data[2] = data[3] = 0x00;
+		node->t ^= 0x10;
+		break;
+	case 0x40:							/* initiate upload */
+		if(!(obj = object(node, index, request[3], 0)))
+			{ abort_transfer(id, request, SDO_ABORT_OBJECT); return; }
+		if(obj->length <= 4) {			/*   expedited */
+			data[0] = 0x43 | ((4 - obj->length) << 2);
+			memcpy(&data[4], obj->data, obj->length);
+		}
+		else {							/*   segmented */
+			node->transfer = *obj;
+			node->offset = 0;
+			node->upload = 1;
+			node->t = 0;
+			data[0] = 0x41;
+			data[4] = (BYTE)obj->length; data[5] = (BYTE)(obj->length >> 8);
+		}
+		break;
+	case 0x60:							/* upload segment */
+		if(!node->transfer.index || !node->upload)
+			{ abort_transfer(id, request, SDO_ABORT_COMMAND); return; }
+		if((request[0] & 0x10) != node->t)
+			{ abort_transfer(id, request, SDO_ABORT_TOGGLE); return; }
+		n = node->transfer.length - node->offset;
+		if(n > 7)
+			n = 7;
+		data[0] = node->t | ((7 - n) << 1);
+		memset(&data[1], 0, 7);
+		memcpy(&data[1], &node->transfer.data[node->offset], n);
+		node->offset += n;
+		if(node->offset >= node->transfer.length) {
+			data[0] |= 0x01;			/*   last segment */
+			node->transfer.index = 0;
+		}
+		node->t ^= 0x10;
+		break;
+	case 0x80:							/* abort */
+		node->transfer.index = 0;
+		return;
+	default:
+		{ abort_transfer(id, request, SDO_ABORT_COMMAND); return; }
+	}
+	bus_send(0x580 + id, 8, data);
+}
+
+static void nmt_slave(BYTE command, BYTE id)
+{
+	int i;
+
+	for(i = 1; i <= present; i++) {
+		if(id && id != i)
+			continue;
+		switch(command) {
+		case 0x01: nodes[i].state = NMT_OPERATIONAL; break;
+		case 0x02: nodes[i].state = NMT_STOPPED; break;
+		case 0x80: nodes[i].state = NMT_PREOPERATIONAL; break;
+		case 0x81:
+		case 0x82: boot(i); break;
+		}
+	}
+}
+
+static DWORD identity(NODE *node, BYTE subindex)
+{
+	OBJECT *obj = object(node, 0x1018, subindex, 0);
+
+	if(!obj || obj->length != 4)
+		return 0;
+	return (DWORD)obj->data[0] | ((DWORD)obj->data[1] << 8) |
+	       ((DWORD)obj->data[2] << 16) | ((DWORD)obj->data[3] << 24);
+}
+
+static void lss_slave(BYTE *request)
+{
+	NODE *node;
+	BYTE data[8];
+	DWORD value = (DWORD)request[1] | ((DWORD)request[2] << 8) |
+	              ((DWORD)request[3] << 16) | ((DWORD)request[4] << 24);
+	int i, n;
+
+	for(i = 1; i <= present; i++) {
+		node = &nodes[i];
+		memset(data, 0, 8);
+		data[0] = request[0];
+		switch(request[0]) {
+		case 0x04:						/* switch mode global */
+			node->lss_mode = (request[1] == 0x01);
+			node->lss_match = 0;
+			continue;
+		case 0x40:						/* switch mode selective: */
+		case 0x41:						/*   vendor-id, product-code, */
+		case 0x42:						/*   revision-number and */
+		case 0x43:						/*   serial-number in this order */
+			n = request[0] - 0x40;
+			node->lss_match = (n == node->lss_match && value == identity(node, (BYTE)(n + 1)))? n + 1 : 0;
+			if(node->lss_match < 4)
+				continue;
+			node->lss_mode = 1;
+			node->lss_match = 0;
+			data[0] = 0x44;
+			break;
+		case 0x11:						/* configure node-id */
+			if(!node->lss_mode)
+				continue;
+			if((1 <= request[1] && request[1] <= 127) || request[1] == 0xFF)
+				node->lss_node_id = request[1];
+			else
+				data[1] = 0x01;			/*   node-id out of range */
+			break;
+		case 0x13:						/* configure bit-timing */
+			if(!node->lss_mode)
+				continue;
+			if(request[1] == 0x00 && request[2] <= 8)
+				node->lss_bit_timing = request[2];
+			else
+				data[1] = 0x01;			/*   bit-timing not supported */
+			break;
+		case 0x17:						/* store configuration */
+			if(!node->lss_mode)
+				continue;
+			break;
+		default:						/* activate bit-timing, inquire, ... */
+			continue;
+		}
+		bus_send(LSS_SLAVE, 8, data);
+	}
+}
+
+static void respond(long cob_id, short length, BYTE *data, int rtr)
+{
+	BYTE state;
+	int id = (int)(cob_id & 0x7F);
+
+	/* called with the lock held */
+	if(cob_id == 0x000 && !rtr && length == 2)
+		nmt_slave(data[0], data[1]);
+	else if((cob_id & 0x780) == 0x600 && id && id <= present && !rtr)
+		sdo_server(id, length, data);
+	else if((cob_id & 0x780) == 0x700 && id && id <= present && rtr) {
+		state = nodes[id].state | nodes[id].toggle;
+		nodes[id].toggle ^= 0x80;
+		bus_send(cob_id, 1, &state);
+	}
+	else if(cob_id == LSS_MASTER && !rtr && length == 8)
+		lss_slave(data);
+}
+
+static int receive(void)
+{
+	FRAME frame;
+	int i, n = 0;
+
+	/* called with the lock held (released for the hook, as it may transmit) */
+	while(bus_tail != bus_head) {
+		frame = bus[bus_tail];
+		bus_tail = NEXT(bus_tail, STUB_FRAMES);
+		n++;
+		if(hook) {
+			pthread_mutex_unlock(&stub_mutex);
+			i = hook(frame.cob_id, frame.length, frame.data, can_timestamp());
+			pthread_mutex_lock(&stub_mutex);
+			if(i)
+				continue;
+		}
+		for(i = 0; i < 14; i++) {
+			if((msg_buf[i].control == CANMSG_RECEIVE || msg_buf[i].control == CANMSG_REQUEST) &&
+			   msg_buf[i].cob_id == frame.cob_id) {
+				memcpy(msg_buf[i].data, frame.data, frame.length);
+				msg_buf[i].length = frame.length;
+				msg_buf[i].count++;
+				break;
+			}
+		}
+		if(i == 14 && NEXT(que_head, STUB_QUEUE) != que_tail) {
+			queue[que_head] = frame;
+			que_head = NEXT(que_head, STUB_QUEUE);
+		}
+	}
+	return n;
+}
+
+void stub_nodes(int count)
+{
+	int i;
+
+	pthread_mutex_lock(&stub_mutex);
+	present = (count < 0)? 0 : (count > STUB_NODES)? STUB_NODES : count;
+	for(i = 1; i <= present; i++)
+		boot(i);
+	bus_head = bus_tail = 0;			/* the boot-up messages are not received */
+	pthread_mutex_unlock(&stub_mutex);
+}
+
+void stub_emcy(int id, WORD error_code, BYTE error_register)
+{
+	BYTE data[8] = {0,0,0,0,0,0,0,0};
+
+	data[0] = (BYTE)error_code;
+	data[1] = (BYTE)(error_code >> 8);
+	data[2] = error_register;
+	pthread_mutex_lock(&stub_mutex);
+	if(1 <= id && id <= present)
+		bus_send(0x080 + id, 8, data);
+	pthread_mutex_unlock(&stub_mutex);
+}
+
+
+/*  -----------  CAN Controller Interface (can_ctrl.h)  ---------------------
+ */
+
+short can_init(long board, void *param)
+{
+	memset(msg_buf, 0, sizeof(msg_buf));
+	que_head = que_tail = 0;
+	started = 0;
+	board = board; param = param;
+	return CANERR_NOERROR;
+}
+
+short can_exit(void)
+{
+	started = 0;
+	return CANERR_NOERROR;
+}
+
+short can_start(BYTE baudrate)
+{
+	if(CANBDR_10 < baudrate || CANBDR_800 == baudrate)
+		return CANERR_BAUDRATE;
+	started = 1;
+	return CANERR_NOERROR;
+}
+
+short can_reset(void)
+{
+	started = 0;
+	return CANERR_NOERROR;
+}
+
+short can_status(BYTE *status)
+{
+	if(status)
+		*status = started? 0x00 : 0x80;
+	return CANERR_NOERROR;
+}
+
+short can_busload(BYTE *load, BYTE *status)
+{
+	if(load)
+		*load = 0;
+	return can_status(status);
+}
+
+short can_config(short index, long cob_id, WORD service)
+{
+	if(index < 0 || 14 < index || cob_id < 0 || 0x7FF < cob_id)
+		return CANERR_ILLPARA;
+	if((service & 0x00FF) < CANMSG_TRANSMIT || CANMSG_REQUEST < (service & 0x00FF))
+		return CANERR_ILLPARA;
+	pthread_mutex_lock(&stub_mutex);
+	receive();
+	msg_buf[index].control = (BYTE)(service & 0x00FF);
+	msg_buf[index].length = (short)((service & 0xFF00) >> 8);
+	msg_buf[index].cob_id = cob_id;
+	msg_buf[index].count = 0;
+	if(msg_buf[index].control == CANMSG_REQUEST && started)
+		respond(cob_id, msg_buf[index].length, msg_buf[index].data, 1);
+	pthread_mutex_unlock(&stub_mutex);
+	return CANERR_NOERROR;
+}
+
+short can_delete(short index)
+{
+	if(index < 0 || 14 < index)
+		return CANERR_ILLPARA;
+	pthread_mutex_lock(&stub_mutex);
+	msg_buf[index].control = 0;
+	msg_buf[index].count = 0;
+	pthread_mutex_unlock(&stub_mutex);
+	return CANERR_NOERROR;
+}
+
+short can_transmit(short index, short length, BYTE *data)
+{
+	if(!started)
+		return CANERR_OFFLINE;
+	if(index < 0 || 13 < index || length < 0 || 8 < length)
+		return CANERR_ILLPARA;
+	pthread_mutex_lock(&stub_mutex);
+	if(msg_buf[index].control != CANMSG_TRANSMIT && msg_buf[index].control != CANMSG_UPDATE) {
+		pthread_mutex_unlock(&stub_mutex);
+		return CANERR_ILLPARA;
+	}
+	respond(msg_buf[index].cob_id, length, data? data : msg_buf[index].data, 0);
+	pthread_mutex_unlock(&stub_mutex);
+	return CANERR_NOERROR;
+}
+
+short can_update(short index, int length, BYTE *data)
+{
+	index = index; length = length; data = data;
+	return CANERR_NOTSUPP;
+}
+
+short can_busy(short index)
+{
+	index = index;
+	return FALSE;
+}
+
+short can_receive_id(short index, short *length, BYTE *data, long *cob_id)
+{
+	if(!started)
+		return CANERR_OFFLINE;
+	if(index < 0 || 14 < index)
+		return CANERR_ILLPARA;
+	if(!length || !data)
+		return CANERR_NULLPTR;
+	pthread_mutex_lock(&stub_mutex);
+	if(msg_buf[index].control != CANMSG_RECEIVE && msg_buf[index].control != CANMSG_REQUEST) {
+		pthread_mutex_unlock(&stub_mutex);
+		return CANERR_ILLPARA;
+	}
+	receive();
+	if(!msg_buf[index].count) {
+		pthread_mutex_unlock(&stub_mutex);
+		return CANERR_RX_EMPTY;
+	}
+	*length = msg_buf[index].length;
+	memcpy(data, msg_buf[index].data, msg_buf[index].length);
+	if(cob_id)
+		*cob_id = msg_buf[index].cob_id;
+	msg_buf[index].count = 0;
+	pthread_mutex_unlock(&stub_mutex);
+	return CANERR_NOERROR;
+}
+
+short can_receive(short index, short *length, BYTE *data)
+{
+	return can_receive_id(index, length, data, NULL);
+}
+
+short can_data(short index)
+{
+	short count;
+
+	if(index < 0 || 14 < index)
+		return FALSE;
+	pthread_mutex_lock(&stub_mutex);
+	receive();
+	count = msg_buf[index].count;
+	pthread_mutex_unlock(&stub_mutex);
+	return count? TRUE : FALSE;
+}
+
+short can_queue_get_message(long *cob_id, short *length, BYTE *data)
+{
+	if(!cob_id || !length || !data)
+		return CANERR_NULLPTR;
+	pthread_mutex_lock(&stub_mutex);
+	receive();
+	if(que_tail == que_head) {
+		pthread_mutex_unlock(&stub_mutex);
+		return CANQUE_EMPTY;
+	}
+	*cob_id = queue[que_tail].cob_id;
+	*length = queue[que_tail].length;
+	memcpy(data, queue[que_tail].data, queue[que_tail].length);
+	que_tail = NEXT(que_tail, STUB_QUEUE);
+	pthread_mutex_unlock(&stub_mutex);
+	return CANQUE_NOERROR;
+}
+
+short can_queue_enable(void) { return CANERR_NOERROR; }
+short can_queue_disable(void) { return CANERR_NOERROR; }
+short can_queue_empty(void) { return (que_tail == que_head); }
+
+short can_queue_clear(void)
+{
+	pthread_mutex_lock(&stub_mutex);
+	que_head = que_tail = 0;
+	pthread_mutex_unlock(&stub_mutex);
+	return CANQUE_NOERROR;
+}
+
+short can_queue_status(void) { return CANQUE_NOERROR; }
+
+short can_poll(void)
+{
+	int n;
+
+	pthread_mutex_lock(&stub_mutex);
+	n = receive();
+	pthread_mutex_unlock(&stub_mutex);
+	return (short)((n < 0x7FFF)? n : 0x7FFF);
+}
+
+short can_hook(CAN_HOOK callback)
+{
+	pthread_mutex_lock(&stub_mutex);
+	hook = callback;
+	pthread_mutex_unlock(&stub_mutex);
+	return CANERR_NOERROR;
+}
+
+short can_start_timer(WORD timeout)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	until = (unsigned long long)ts.tv_sec * 1000000ULL + (unsigned long long)(ts.tv_nsec / 1000) + (unsigned long long)timeout * 1000ULL;
+	return CANERR_NOERROR;
+}
+
+short can_is_timeout(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((unsigned long long)ts.tv_sec * 1000000ULL + (unsigned long long)(ts.tv_nsec / 1000)) >= until;
+}
+
+DWORD can_timestamp(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (DWORD)((unsigned long long)ts.tv_sec * 1000ULL + (unsigned long long)(ts.tv_nsec / 1000000));
+}
+
+LPSTR can_hardware(void) { return "simulated CAN bus (bench/can_stub.c)"; }
+LPSTR can_software(void) { return "responder nodes (bench/can_stub.c)"; }
+LPSTR can_version(void) { return "$Id: can_stub.c $"; }
@@ -0,0 +1,277 @@
+/*	-- $Header$ --
+ *
+ *	projekt   :  CAN - Controller Area Network.
+ *
+ *	purpose   :  Fuzz harness for the DS-309/3 parser of the gateway.
+ *
+ *	copyright :  (C) 2009, UV Software, Friedrichshafen.
+ *
+ *	compiler  :  GCC - GNU C Compiler (Linux Kernel 2.6)
+ *
+ *	author    :  Uwe Vogt, UV Software, Friedrichshafen
+ *
+ *	e-mail    :  uwe.vogt@uv-software.de
+ *
+ *
+ *	-----------  description  -----------------------------------------------
+ *
+ *	A libFuzzer-style harness (LLVMFuzzerTestOneInput) for the front end
+ *	of the gateway. Each input is taken as a request line, and
+ *	- parsed in check mode (cop_tcp_check), i.e. by all of the parser but
+ *	  without access to the bus, into a full and into a short buffer;
+ *	- executed by cop_tcp_parse() in place, as the server does, if it is
+ *	  an SDO command (on the simulated CAN bus of can_stub.c).
+ *	A response must be terminated within its buffer, and the guard bytes
+ *	behind the buffer must not be written; so an overrun is found without
+ *	a sanitizer, too.
+ *
+ *	Built with -DLIBFUZZER the harness is linked with libFuzzer ("make fuzz",
+ *	with clang). Otherwise main() runs the given files, or the lines of the
+ *	corpus and <inputs> random mutations of them (bits, bytes, keywords,
+ *	numbers and splices of other lines), e.g. by "make bench".
+ *
+ *	usage: fuzz_parse [<inputs> [<seed>]]
+ *	       fuzz_parse <file>...
+ *
+ *
+ *	-----------  history  ---------------------------------------------------
+ *
+ *	$Log$
+ */
+
+#include "can_stub.c"
+
+#include "../cop_tcp.h"
+#include "../cop_api.h"
+
+#include <stdlib.h>
+#include <ctype.h>
+
+
+/*  -----------  defines  --------------------------------------------------
+ */
+
+#define CORPUS				"bench/requests.txt"
+#define INPUTS				200000
+#define MAX_REQUESTS		1024
+#define REQUEST_SIZE		1025		/* as a line of the server */
+#define SHORT_SIZE			24			/* a short response buffer */
+#define GUARD_SIZE			16			/* guard bytes behind a buffer */
+#define GUARD_BYTE			0xA5
+
+
+/*  -----------  variables  ------------------------------------------------
+ */
+
+static COP_TCP_SETTINGS defaults = {1, 1, 127, 0, -1, NULL, -1};
+static int initialized = 0;
+
+
+/*  -----------  harness  --------------------------------------------------
+ */
+
+static void verify(char *buffer, int nbyte, char *request, char *what)
+{
+	int i;
+
+	for(i = 0; i < GUARD_SIZE; i++) {
+		if((unsigned char)buffer[nbyte + i] != GUARD_BYTE) {
+			fprintf(stderr, "+++ fault: %s wrote behind its buffer of %i bytes: \"%s\"\n", what, nbyte, request);
+			abort();
+		}
+	}
+	if(!memchr(buffer, '\0', nbyte)) {
+		fprintf(stderr, "+++ fault: %s left its response unterminated: \"%s\"\n", what, request);
+		abort();
+	}
+}
+
+int LLVMFuzzerTestOneInput(const unsigned char *data, size_t size)
+{
+	static char request[REQUEST_SIZE];
+	static char response[REQUEST_SIZE + GUARD_SIZE];
+	struct _can_param param = {"stub", 0, 0, 0};
+	COP_TCP_SETTINGS settings;
+	unsigned long sequence;
+	size_t n = (size < REQUEST_SIZE - 1)? size : REQUEST_SIZE - 1;
+	int node;
+
+	if(!initialized) {
+		cop_init(CAN_NETDEV, &param, CANBDR_250);
+		stub_nodes(127);
+		initialized = 1;
+	}
+	memcpy(request, data, n);
+	request[n] = '\0';
+	cop_tcp_sequence(request, &sequence);
+	node = cop_tcp_node(request, &defaults);
+
+	/* the parser, into a full and into a short buffer */
+	memcpy(&settings, &defaults, sizeof(COP_TCP_SETTINGS));
+	memset(response, GUARD_BYTE, sizeof(response));
+	cop_tcp_check(request, &settings, response, REQUEST_SIZE);
+	verify(response, REQUEST_SIZE, request, "cop_tcp_check");
+	memcpy(&settings, &defaults, sizeof(COP_TCP_SETTINGS));
+	memset(response, GUARD_BYTE, sizeof(response));
+	cop_tcp_check(request, &settings, response, SHORT_SIZE);
+	verify(response, SHORT_SIZE, request, "cop_tcp_check");
+
+	/* an SDO command is executed, in place */
+	if(node) {
+		memcpy(&settings, &defaults, sizeof(COP_TCP_SETTINGS));
+		memset(response, GUARD_BYTE, sizeof(response));
+		memcpy(response, request, n + 1);
+		cop_tcp_parse(response, &settings, response, REQUEST_SIZE);
+		verify(response, REQUEST_SIZE, request, "cop_tcp_parse");
+	}
+	return 0;
+}
+
+
+/*  -----------  driver (without libFuzzer)  -------------------------------
+ */
+
+#ifndef LIBFUZZER
+
+static char *requests[MAX_REQUESTS];
+static int count = 0;
+
+static char *tokens[] = {
+	"read", "write", "r", "w", "start", "stop", "preop", "reset", "node", "comm",
+	"enable", "disable", "guarding", "heartbeat", "sync", "emcy", "event", "set",
+	"sdo_timeout", "network", "id", "info", "version", "firmware", "init", "scan",
+	"send", "recv", "rtr", "wait", "status", "error", "identity", "exec", "check", "mask", "rate",
+	"commission", "store",
+	"b", "i8", "i16", "i32", "u8", "u16", "u32", "r32", "vs", "os", "d", "t", "td",
+	"0", "1", "127", "128", "255", "256", "65535", "65536", "4294967295", "4294967296",
+	"-1", "-128", "-129", "-2147483648", "-2147483649", "0x", "0xFFFFFFFF", "0x100000000",
+	"017", "09", "+", "\"", "\"\"", "[", "]", " ", "\t", "\r", "\n", "=", "/", "#"
+};
+
+static int load(char *filename)
+{
+	char line[REQUEST_SIZE];
+	FILE *fp;
+
+	if(!(fp = fopen(filename, "r"))) {
+		perror(filename);
+		return 0;
+	}
+	while(count < MAX_REQUESTS && fgets(line, sizeof(line), fp)) {
+		line[strcspn(line, "\r\n")] = '\0';
+		if(line[0] == '[')
+			requests[count++] = strdup(line);
+	}
+	fclose(fp);
+	return count;
+}
+
+static int insert(char *line, int length, int pos, const char *string, int n)
+{
+	if(length + n >= REQUEST_SIZE)
+		n = REQUEST_SIZE - 1 - length;
+	memmove(&line[pos + n], &line[pos], length - pos);
+	memcpy(&line[pos], string, n);
+	return length + n;
+}
+
+static int mutate(char *line, int length)
+{
+	char *other;
+	int i, pos, n, ops = 1 + rand() % 4;
+
+	for(i = 0; i < ops; i++) {
+		pos = length? rand() % (length + 1) : 0;
+		switch(rand() % 6) {
+		case 0:							/* flip a bit */
+			if(pos < length)
+				line[pos] ^= (char)(1 << (rand() % 8));
+			break;
+		case 1:							/* replace a byte */
+			if(pos < length)
+				line[pos] = (char)(rand() % 256);
+			break;
+		case 2:							/* insert a keyword or number */
+			n = rand() % (int)(sizeof(tokens) / sizeof(tokens[0]));
+			length = insert(line, length, pos, tokens[n], (int)strlen(tokens[n]));
+			break;
+		case 3:							/* delete some bytes */
+			n = 1 + rand() % 8;
+			if(pos + n > length)
+				n = length - pos;
+			memmove(&line[pos], &line[pos + n], length - pos - n);
+			length -= n;
+			break;
+		case 4:							/* splice the end of another line */
+			other = requests[rand() % count];
+			n = (int)strlen(other);
+			n = n? rand() % n : 0;
+			length = insert(line, pos, pos, &other[n], (int)strlen(&other[n]));
+			break;
+		case 5:							/* repeat a part (long lines) */
+			n = (length - pos > 0)? 1 + rand() % (length - pos) : 0;
+			while(n > 0 && length + n < REQUEST_SIZE - 1 && rand() % 4)
+				length = insert(line, length, pos, &line[pos], n);
+			break;
+		}
+	}
+	line[length] = '\0';
+	return length;
+}
+
+static int run_file(char *filename)
+{
+	static unsigned char data[65536];
+	size_t size;
+	FILE *fp;
+
+	if(!(fp = fopen(filename, "rb"))) {
+		perror(filename);
+		return 0;
+	}
+	size = fread(data, 1, sizeof(data), fp);
+	fclose(fp);
+	LLVMFuzzerTestOneInput(data, size);
+	return 1;
+}
+
+int main(int argc, char *argv[])
+{
+	char line[REQUEST_SIZE + 8];
+	struct timespec t0, t1;
+	long inputs = INPUTS, i;
+	unsigned long seed = 1;
+	int r, length;
+	double t;
+
+	if(argc > 1 && !isdigit((unsigned char)argv[1][0])) {
+		for(r = 1; r < argc; r++) {
+			if(!run_file(argv[r]))
+				return 1;
+		}
+		printf("parser fuzzing: %i file(s), no fault\n", argc - 1);
+		return 0;
+	}
+	if(argc > 1)
+		inputs = atol(argv[1]);
+	if(argc > 2)
+		seed = strtoul(argv[2], NULL, 0);
+	if(!load(CORPUS))
+		return 1;
+	srand((unsigned)seed);
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for(r = 0; r < count; r++)
+		LLVMFuzzerTestOneInput((unsigned char*)requests[r], strlen(requests[r]));
+	for(i = 0; i < inputs; i++) {
+		strcpy(line, requests[rand() % count]);
+		length = mutate(line, (int)strlen(line));
+		LLVMFuzzerTestOneInput((unsigned char*)line, length);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	t = (double)(t1.tv_sec - t0.tv_sec) + (double)(t1.tv_nsec - t0.tv_nsec) / 1e9;
+	printf("parser fuzzing: %i requests and %li mutations (seed %lu), %.0f inputs/s, no fault\n",
+	       count, inputs, seed, (double)(count + inputs) / t);
+	return 0;
+}
+
+#endif
@@ -24,6 +24,15 @@
  *	For berliOS socketCAN (v2.17) over PEAK PCAN-USB Dongle. For information
  *	about socketCAN see "http://socketcan.berlios.de/".
  *
+ *	The message objects and the event-queue are protected by a mutex, so
+ *	a message object can be served from another thread (e.g. the SYNC
+ *	producer). The time-out timer is kept per thread.
+ *
+ *	Received messages are time-stamped in milliseconds (CLOCK_MONOTONIC).
+ *	An optional hook is called for every received data frame before it
+ *	is stored in a message object or the event-queue, so a protocol can
+ *	consume messages of a whole COB-Id. range (e.g. NMT error control).
+ *
  *
  *
  *	-----------  history  ---------------------------------------------------
@@ -45,6 +54,7 @@ static char _id[] = "$Id: can_ctrl.c 29 2009-02-11 10:27:50Z saturn $";
 #include <string.h>
 #include <errno.h>
 #include <time.h>
+#include <pthread.h>
 
 #include <sys/time.h>
 #include <sys/types.h>
@@ -76,6 +86,8 @@ static char _id[] = "$Id: can_ctrl.c 29 2009-02-11 10:27:50Z saturn $";
 #define EMPTY()					 (head == tail)
 #define OVERRUN()				 (NEXT(head) == tail)
 #endif
+#define LOCK()					  pthread_mutex_lock(&can_mutex)
+#define UNLOCK()				  pthread_mutex_unlock(&can_mutex)
 
 /*  -----------  types  ----------------------------------------------------
  */
@@ -103,6 +115,7 @@ typedef struct _can_que					// queue item:
 
 static int can_read_queue(int count);	// read RCV queue
 static int can_read_socket(struct can_frame *msg);
+static int can_read_hook(struct can_frame *msg, DWORD time_stamp);
 
 
 /*  -----------  variables  ------------------------------------------------
@@ -131,7 +144,9 @@ static const WORD bit_timing[9] = {		// bit-timing table:
 	10									//     10 Kbps
 };
 static  CAN_STATE can_state = {0x80};	// 8-bit status register
-static  __u64 llUntilStop = 0;			// variable for time-out
+static  __thread __u64 llUntilStop = 0;	// variable for time-out (per thread)
+static  pthread_mutex_t can_mutex = PTHREAD_MUTEX_INITIALIZER;
+static  CAN_HOOK can_hook_func = NULL;	// receive hook (or NULL)
 
 static  MSG_OBJ msg_buf[15];			// message buffer (15x)
 #ifdef _CAN_EVENT_QUEUE
@@ -282,6 +297,8 @@ return CANERR_NOTSUPP;
 
 short can_config(short index, long cob_id, WORD service)
 {
+	struct can_frame frame;
+
 	if(!init)							// must be initialized!
 		return CANERR_NOTINIT;
 	if(index < 0 || 14 < index)			// message object 1 .. 15
@@ -298,6 +315,7 @@ short can_config(short index, long cob_id, WORD service)
 	#endif
 	if((service & 0xFF00) > 0x0800)		// max. 8 data bytes
 		return CANERR_ILLPARA;
+	LOCK();								// enter critical section
 	can_read_queue(CAN_RCV_QUEUE_READ);	//read CAN messages(!)
 
 	msg_buf[index].control = (BYTE)(service & 0x00FF);
@@ -306,32 +324,21 @@ short can_config(short index, long cob_id, WORD service)
 	msg_buf[index].count  = (short)(0);
 	memset(msg_buf[index].data, 0x00, 8);
 
-#ifdef __TO_DO__
 	if((msg_buf[index].control == CANMSG_REQUEST) &&
 	   !can_state.b.can_stopped)
 	{
-		can_msg.MSGTYPE = MSGTYPE_RTR;	// request remote frame
-		can_msg.ID = (DWORD)(msg_buf[index].cob_id);
-		can_msg.LEN = (BYTE)(msg_buf[index].length);
-							 msg_buf[index].count++;
-							 msg_buf[index].time_stamp = -1;
-		if((rc = PCAN_Write(&can_msg)) != CAN_ERR_OK)
+		frame.can_id = (DWORD)(msg_buf[index].cob_id) | CAN_RTR_FLAG;
+		frame.can_dlc = (BYTE)(msg_buf[index].length);
+		memset(frame.data, 0x00, 8);	// request remote frame
+		if(write(fd, &frame, sizeof(struct can_frame)) != sizeof(struct can_frame))
 		{
-			if((rc & CAN_ERR_QXMTFULL)){//   transmit queue full?
-				can_state.b.transmitter_busy = 1;
-				return CANERR_TX_BUSY;	//     transmitter busy!
-			}
-			else if((rc & CAN_ERR_XMTFULL)){//transmission pending?
-				can_state.b.transmitter_busy = 1;
-				return CANERR_TX_BUSY;	//     transmitter busy!
-			}
-			if(rc > 255)				//   PCAN specific error?
-				return pcan_error(rc);
+			can_state.b.transmitter_busy = 1;//transmitter busy!
+			UNLOCK();
+			return CANERR_TX_BUSY;
 		}
 		can_state.b.transmitter_busy = 0;//message transmitted!
-		msg_buf[index].count = 0;
 	}
-#endif
+	UNLOCK();							// leave critical section
 	return CANERR_NOERROR;				// OK!
 }
 
@@ -339,8 +346,10 @@ short can_delete(short index)
 {
 	if(index < 0 || 14 < index)			// message object 1 .. 15
 		return CANERR_ILLPARA;
+	LOCK();								// enter critical section
 	msg_buf[index].control = 0;			// reset the message object
 	msg_buf[index].count = 0;
+	UNLOCK();							// leave critical section
 	return CANERR_NOERROR;				// OK!
 }
 
@@ -359,24 +368,28 @@ short can_transmit(short index, short length, BYTE *data)
 		return CANERR_ILLPARA;
 	if(data == NULL)					// null-pointer assignment!
 		data = msg_buf[index].data;
+	LOCK();								// enter critical section
 	if((msg_buf[index].control != CANMSG_TRANSMIT) &&
-	   (msg_buf[index].control != CANMSG_UPDATE))
+	   (msg_buf[index].control != CANMSG_UPDATE)) {
+		UNLOCK();
 		return CANERR_ILLPARA;
-
+	}
 	frame.can_id = (DWORD)(msg_buf[index].cob_id);
 	frame.can_dlc = (BYTE)(msg_buf[index].length = length);
 						   msg_buf[index].count++;
-						   msg_buf[index].time_stamp = -1;
+						   msg_buf[index].time_stamp = can_timestamp();
 	memcpy(frame.data, data, length);
 
 	if((nbytes = write(fd, &frame, sizeof(struct can_frame))) != sizeof(struct can_frame))
 	{
 		//@ToDo: evaluate result
 		can_state.b.transmitter_busy = 1;//   transmitter busy!
+		UNLOCK();
 		return CANERR_TX_BUSY;
 	}
 	can_state.b.transmitter_busy = 0;	// message transmitted!
 	msg_buf[index].count = 0;
+	UNLOCK();							// leave critical section
 	return CANERR_NOERROR;				// OK!
 }
 
@@ -425,13 +438,17 @@ short can_receive(short index, short *length, BYTE *data)
 	 if(queue_enabled && index >= 14)	// 15 used as FIFO?
 		return CANERR_ILLPARA;
 	#endif
+	LOCK();								// enter critical section
 	if((msg_buf[index].control != CANMSG_RECEIVE) &&
-	   (msg_buf[index].control != CANMSG_REQUEST))
+	   (msg_buf[index].control != CANMSG_REQUEST)) {
+		UNLOCK();
 		return CANERR_ILLPARA;
+	}
 	can_read_queue(CAN_RCV_QUEUE_READ);//read CAN messages
 
 	if(!msg_buf[index].count) {			// no message read?
 		can_state.b.receiver_empty = 1;		
+		UNLOCK();
 		return CANERR_RX_EMPTY;			//   receiver empty!
 	}
    *length =     msg_buf[index].length;	// data length code
@@ -439,6 +456,7 @@ short can_receive(short index, short *length, BYTE *data)
 	can_state.b.receiver_empty = 0;		// message read!
 	can_state.b.message_lost |= (msg_buf[index].count > 1);
 	msg_buf[index].count = 0;
+	UNLOCK();							// leave critical section
 	return CANERR_NOERROR;				// OK!
 }
 
@@ -456,13 +474,17 @@ short can_receive_id(short index, short *length, BYTE *data, long *cob_id)
 	 if(queue_enabled && index >= 14)	// 15 used as FIFO?
 		return CANERR_ILLPARA;
 	#endif
+	LOCK();								// enter critical section
 	if((msg_buf[index].control != CANMSG_RECEIVE) &&
-	   (msg_buf[index].control != CANMSG_REQUEST))
+	   (msg_buf[index].control != CANMSG_REQUEST)) {
+		UNLOCK();
 		return CANERR_ILLPARA;
+	}
 	can_read_queue(CAN_RCV_QUEUE_READ);//read CAN messages
 
 	if(!msg_buf[index].count) {			// no message read?
 		can_state.b.receiver_empty = 1;		
+		UNLOCK();
 		return CANERR_RX_EMPTY;			//   receiver empty!
 	}
    *cob_id = (long)msg_que[tail].cob_id;// COB-identifier ($error: 06-10-04)
@@ -472,6 +494,7 @@ short can_receive_id(short index, short *length, BYTE *data, long *cob_id)
 	can_state.b.receiver_empty = 0;		// message read!
 	can_state.b.message_lost |= (msg_buf[index].count > 1);
 	msg_buf[index].count = 0;
+	UNLOCK();							// leave critical section
 	return CANERR_NOERROR;				// OK!
 }
 
@@ -487,15 +510,22 @@ short can_data(short index)
 	 if(queue_enabled && index >= 14)	// 15 used as FIFO?
 		return FALSE;
 	#endif
+	LOCK();								// enter critical section
 	if((msg_buf[index].control != CANMSG_RECEIVE) &&
-	   (msg_buf[index].control != CANMSG_REQUEST))
+	   (msg_buf[index].control != CANMSG_REQUEST)) {
+		UNLOCK();
 		return FALSE;
+	}
 	can_read_queue(CAN_RCV_QUEUE_READ);	//read CAN messages
 
-	if(msg_buf[index].count)			// new data received?
+	if(msg_buf[index].count) {			// new data received?
+		UNLOCK();
 		return TRUE;
-	else								// receiver still empty!
+	}
+	else {								// receiver still empty!
+		UNLOCK();
 		return FALSE;
+	}
 }
 
 short can_queue_get_message(long *cob_id, short *length, BYTE *data)
@@ -507,14 +537,18 @@ short can_queue_get_message(long *cob_id, short *length, BYTE *data)
 		return CANERR_OFFLINE;
 	 if(!cob_id || !length || !data)	// null-pointer assignment!
 		return CANERR_NULLPTR;
+	 LOCK();							// enter critical section
 	 can_read_queue(CAN_RCV_QUEUE_READ);//read CAN messages
 
-	 if(EMPTY())						// queue empty?
+	 if(EMPTY()) {						// queue empty?
+		UNLOCK();
 		return queue_error = CANQUE_EMPTY;
+	 }
 	*cob_id = (long)msg_que[tail].cob_id;// COB-identifier
 	*length =       msg_que[tail].length;// data length code
 	 memcpy(data, msg_que[tail].data, msg_que[tail].length);
 	 tail = NEXT(tail);
+	 UNLOCK();							// leave critical section
 	 return queue_error = CANQUE_NOERROR;// message de-queued!
 	#else
 	 if(!cob_id || !length || !data)	// null-pointer assignment!
@@ -560,9 +594,13 @@ short can_queue_empty(void)
 short can_queue_clear(void)
 {
 	#ifdef _CAN_EVENT_QUEUE
-	 if(EMPTY())						// queue empty?
+	 LOCK();							// enter critical section
+	 if(EMPTY()) {						// queue empty?
+		UNLOCK();
 		return CANQUE_EMPTY;
+	 }
 	 CLEAR();							// clear queue
+	 UNLOCK();							// leave critical section
 	 return CANQUE_NOERROR;
 	#else
 	 return CANQUE_EMPTY;
@@ -583,10 +621,10 @@ short can_queue_status(void)
 
 short can_start_timer(WORD timeout)
 {
-	struct timeval tv;					// timer value
-	gettimeofday(&tv, NULL);			// current time
+	struct timespec ts;					// timer value
+	clock_gettime(CLOCK_MONOTONIC, &ts);// current time (not affected by settimeofday)
 	
-	llUntilStop = ((__u64)tv.tv_sec * (__u64)1000000) + (__u64)tv.tv_usec \
+	llUntilStop = ((__u64)ts.tv_sec * (__u64)1000000) + (__u64)(ts.tv_nsec / 1000) \
 	            + ((__u64)timeout   * (__u64)1000);
 	
 	return OK;
@@ -595,10 +633,10 @@ short can_start_timer(WORD timeout)
 short can_is_timeout(void)
 {
 	__u64 llNow;						// 64-bit value
-	struct timeval tv;					// timer value
-	gettimeofday(&tv, NULL);			// current time
+	struct timespec ts;					// timer value
+	clock_gettime(CLOCK_MONOTONIC, &ts);// current time (not affected by settimeofday)
 	
-	llNow = ((__u64)tv.tv_sec * (__u64)1000000) + (__u64)tv.tv_usec;
+	llNow = ((__u64)ts.tv_sec * (__u64)1000000) + (__u64)(ts.tv_nsec / 1000);
 
 	if(llNow < llUntilStop)
 		return FALSE;
@@ -606,6 +644,36 @@ short can_is_timeout(void)
 		return TRUE;
 }
 
+short can_poll(void)
+{
+	int n;								// number of messages
+
+	if(!init)							// must be initialized!
+		return CANERR_NOTINIT;
+	if(can_state.b.can_stopped)			// must be running!
+		return CANERR_OFFLINE;
+	LOCK();								// enter critical section
+	n = can_read_queue(0);				// read all CAN messages
+	UNLOCK();							// leave critical section
+	return (short)((n < 0x7FFF)? n : 0x7FFF);
+}
+
+short can_hook(CAN_HOOK callback)
+{
+	LOCK();								// enter critical section
+	can_hook_func = callback;			// receive hook (or NULL)
+	UNLOCK();							// leave critical section
+	return CANERR_NOERROR;
+}
+
+DWORD can_timestamp(void)
+{
+	struct timespec ts;					// timer value
+	clock_gettime(CLOCK_MONOTONIC, &ts);// current time (not affected by settimeofday)
+
+	return (DWORD)(((__u64)ts.tv_sec * (__u64)1000) + (__u64)(ts.tv_nsec / 1000000));
+}
+
 LPSTR can_hardware(void)
 {
 	sprintf(hardware, "interface=\"%s\", family=%d, type=%d, protocol=%d", ifname, family, type, protocol);
@@ -652,9 +720,19 @@ static int can_read_socket(struct can_frame *msg)
 	return 1;
 }
 
+static int can_read_hook(struct can_frame *msg, DWORD time_stamp)
+{
+	if(!can_hook_func)					// no hook installed
+		return 0;
+	if(msg->can_id & CAN_RTR_FLAG)		// data frames only
+		return 0;
+	return can_hook_func((long)(msg->can_id & CAN_SFF_MASK), (short)msg->can_dlc, msg->data, time_stamp);
+}
+
 static int can_read_queue(int count)
 {
 	struct can_frame can_msg;			// the message
+	DWORD time_stamp;					// time-stamp in [ms]
 	int   i, n = 0;						// buffer index
 
 	if(!init)							// must be initialized!
@@ -662,7 +740,10 @@ static int can_read_queue(int count)
 	if(count) {							// read n messages
 		for(n = 0; n < count; n++) {
 			if(can_read_socket(&can_msg)) {
+				time_stamp = can_timestamp();
 				if((can_msg.can_id & (CAN_EFF_FLAG | CAN_ERR_FLAG)) == 0x00000000) {
+					if(can_read_hook(&can_msg, time_stamp))
+						continue;		//   consumed by the hook
 					#ifdef _CAN_EVENT_QUEUE
 					 for(i = 0; i <= 13; i++) {
 					#else
@@ -674,7 +755,7 @@ static int can_read_queue(int count)
 							memcpy(msg_buf[i].data, can_msg.data, can_msg.can_dlc);
 							msg_buf[i].length = can_msg.can_dlc;
 							msg_buf[i].count++;
-							msg_buf[i].time_stamp = -1;
+							msg_buf[i].time_stamp = time_stamp;
 							break;
 						}
 		
@@ -684,7 +765,7 @@ static int can_read_queue(int count)
 						memcpy(msg_que[head].data, can_msg.data, can_msg.can_dlc);
 						msg_que[head].length = can_msg.can_dlc;
 						msg_que[head].cob_id = (can_msg.can_id & CAN_SFF_MASK);
-						msg_que[head].time_stamp = -1;
+						msg_que[head].time_stamp = time_stamp;
 						head = NEXT(head);		//     message enqueued
 						if(OVERRUN()) {			//     on queue overrun:
 							tail = NEXT(tail);	//       delet oldest message
@@ -713,7 +794,12 @@ static int can_read_queue(int count)
 	}
 	else {							// read all messages
 		while(can_read_socket(&can_msg)) {
+			time_stamp = can_timestamp();
 			if((can_msg.can_id & (CAN_EFF_FLAG | CAN_ERR_FLAG)) == 0x00000000) {
+				if(can_read_hook(&can_msg, time_stamp)) {
+					n++;				//   consumed by the hook
+					continue;
+				}
 				#ifdef _CAN_EVENT_QUEUE
 				 for(i = 0; i <= 13; i++) {
 				#else
@@ -725,7 +811,7 @@ static int can_read_queue(int count)
 						memcpy(msg_buf[i].data, can_msg.data, can_msg.can_dlc);
 						msg_buf[i].length = can_msg.can_dlc;
 						msg_buf[i].count++;
-						msg_buf[i].time_stamp = -1;
+						msg_buf[i].time_stamp = time_stamp;
 						break;
 					}
 	
@@ -735,7 +821,7 @@ static int can_read_queue(int count)
 					memcpy(msg_que[head].data, can_msg.data, can_msg.can_dlc);
 					msg_que[head].length = can_msg.can_dlc;
 					msg_que[head].cob_id = (can_msg.can_id & CAN_SFF_MASK);
-					msg_que[head].time_stamp = -1;
+					msg_que[head].time_stamp = time_stamp;
 					head = NEXT(head);		//     message enqueued
 					if(OVERRUN()) {			//     on queue overrun:
 						tail = NEXT(tail);	//       delet oldest message
@@ -35,8 +35,12 @@
  *	             short can_queue_clear(void);
  *	             short can_queue_status(void);
  *
+ *	             short can_poll(void);
+ *	             short can_hook(CAN_HOOK callback);
+ *
  *	             short can_start_timer(WORD timeout);
  *	             short can_is_timeout(void);
+ *	             DWORD can_timestamp(void);
  *
  *	             LPSTR can_hardware(void);
  *	             LPSTR can_software(void);
@@ -162,6 +166,8 @@
  } CAN_STATE;
 #endif
 
+typedef int (*CAN_HOOK)(long cob_id, short length, BYTE *data, DWORD time_stamp);
+
 /*  -----------  variables  ------------------------------------------------
  */
 
@@ -462,9 +468,39 @@ short can_queue_status(void);
  *                                  CANQUE_OVERRUN  - queue overrun
  */
 
+short can_poll(void);
+/*
+ *	function  :  reads all pending messages from the CAN controller into
+ *	             the message objects and the event-queue (or passes them
+ *	             to the receive hook).
+ *
+ *	             The function can be called by a thread which has no own
+ *	             message object to serve the receive hook.
+ *
+ *	parameter :  (none)
+ *
+ *	result    :  number of read messages, or a negative value on error.
+ */
+
+short can_hook(CAN_HOOK callback);
+/*
+ *	function  :  installs a receive hook which is called for every received
+ *	             data frame with an 11-bit identifier before it is stored in
+ *	             a message object or the event-queue. If the hook returns a
+ *	             non-zero value the message is consumed and not stored.
+ *
+ *	             The hook is called within the critical section of the CAN
+ *	             Controller interface and must not call any of its functions!
+ *
+ *	parameter :  callback	- pointer to the hook function, or NULL to remove.
+ *
+ *	result    :  0 if successful, or a negative value on error.
+ */
+
 short can_start_timer(WORD timeout);
 /*
  *	function  :  starts a software timer for time-out supervision.
+ *	             The timer runs on CLOCK_MONOTONIC and is kept per thread.
  *
  *	parameter :  timeout	- time interval in milliseconds.
  *
@@ -480,6 +516,16 @@ short can_is_timeout(void);
  *	result    :  none-zero if a time-out has occurred, or 0 otherwise.
  */
 
+DWORD can_timestamp(void);
+/*
+ *	function  :  retrieves the time-stamp clock (CLOCK_MONOTONIC) which is
+ *	             used for the time-stamps of the message objects.
+ *
+ *	parameter :  (none)
+ *
+ *	result    :  current time in milliseconds (with 32-bit wrap-around).
+ */
+
 LPSTR can_hardware(void);
 /*
  *	function  :  retrieves the hardware version of the CAN Controller
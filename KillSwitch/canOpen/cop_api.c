@@ -71,12 +71,22 @@
 /*	-----------  Prototypen  -------------------------------------------------
  */
 
+static int cop_dispatch(long cob_id, short length, BYTE *data, DWORD time_stamp);
+
+extern int  nmt_dispatch(long cob_id, short length, BYTE *data, DWORD time_stamp);
+extern void nmt_reset(void);
+extern int  emcy_dispatch(long cob_id, short length, BYTE *data, DWORD time_stamp);
+extern void emcy_reset(void);
+extern int  scan_dispatch(long cob_id, short length, BYTE *data, DWORD time_stamp);
+extern void scan_reset(void);
+extern int  mon_dispatch(long cob_id, short length, BYTE *data, DWORD time_stamp);
+extern void mon_reset(void);
 
 /*	-----------  Variablen  --------------------------------------------------
  */
 
 BYTE cop_baudrate = CANBDR_20;			// actual baudrate
-LONG cop_error = CANERR_NOERROR;		// last error code
+__thread LONG cop_error = CANERR_NOERROR;// last error code (per thread)
 BYTE cop_buffer[8] = {0,0,0,0,0,0,0};	// data buffer (8)
 
 
@@ -104,11 +114,22 @@ LONG cop_init(LONG board, LPVOID param, BYTE baudrate)
 		return cop_error;
 	}
 	cop_baudrate = baudrate;			// actual baudrate
+	// 4. Install the receive hook (error control, emergency, scan, monitor)
+	nmt_reset();
+	emcy_reset();
+	scan_reset();
+	mon_reset();
+	can_hook(cop_dispatch);
 	return cop_error;
 }
 
 LONG cop_exit()
 {
+	// Stop the SYNC producer, the error control and the scan (if running)
+	sync_stop();
+	nmt_reset();
+	scan_reset();
+	can_hook(NULL);
 	// Exit CAN, operation status = stopped
 	return cop_error = can_exit();
 }
@@ -230,6 +251,26 @@ LPSTR cop_version(void)
 	return (LPSTR)_id;
 }
 
+/*	-----------  Lokale Funktionen  ------------------------------------------
+ */
+
+static int cop_dispatch(long cob_id, short length, BYTE *data, DWORD time_stamp)
+{
+	// Subscribed messages (never consumed)
+	mon_dispatch(cob_id, length, data, time_stamp);
+	// SDO responses and boot-up messages of the network scan
+	if(scan_dispatch(cob_id, length, data, time_stamp))
+		return 1;
+	// Error control messages (heartbeat, node guarding, boot-up)
+	if(nmt_dispatch(cob_id, length, data, time_stamp))
+		return 1;
+	// Emergency messages
+	if(emcy_dispatch(cob_id, length, data, time_stamp))
+		return 1;
+	// Message not consumed
+	return 0;
+}
+
 /*	--------------------------------------------------------------------------
  *	Uwe Vogt,  UV Software,  Steinaecker 28,  88048 Friedrichshafen,  Germany
  *	Fon: +49-7541-6041530, Fax. +49-1803-551809359, Cell fon: +49-170-3801903
@@ -16,6 +16,7 @@
  *	             LONG sdo_write(BYTE node_id, WORD index, BYTE subindex, SHORT length, BYTE *data);
  *	             LONG sdo_read(BYTE node_id, WORD index, BYTE subindex, SHORT *length, BYTE *data, SHORT max);
  *	             WORD sdo_timeout(WORD milliseconds);
+ *	             LONG sdo_channel(BYTE channel);
  *	             LONG sdo_write_8bit(BYTE node_id, WORD index, BYTE subindex, BYTE value);
  *	             LONG sdo_read_8bit(BYTE node_id, WORD index, BYTE subindex, BYTE *value);
  *	             LONG sdo_write_16bit(BYTE node_id, WORD index, BYTE subindex, WORD value);
@@ -28,6 +29,29 @@
  *	             LONG nmt_enter_preoperational(BYTE node_id);
  *	             LONG nmt_reset_node(BYTE node_id);
  *	             LONG nmt_reset_communication(BYTE node_id);
+ *	             LONG nmt_heartbeat_consumer(BYTE node_id, WORD heartbeat_time);
+ *	             LONG nmt_heartbeat_producer(BYTE node_id, WORD heartbeat_time);
+ *	             LONG nmt_node_guarding(BYTE node_id, WORD guard_time, BYTE life_time_factor);
+ *	             LONG nmt_node_state(BYTE node_id, BYTE *state);
+ *	             LONG nmt_event(NMT_EVENT *event);
+ *
+ *	             LONG emcy_subscribe(BYTE node_id);
+ *	             LONG emcy_unsubscribe(LONG handle);
+ *	             LONG emcy_receive(LONG handle, EMCY_MESSAGE *emcy);
+ *	             LONG emcy_history(BYTE node_id, EMCY_MESSAGE *history, SHORT *count);
+ *
+ *	             LONG sync_start(DWORD cycle_period, BYTE counter_overflow, LONG priority);
+ *	             LONG sync_stop(void);
+ *	             LONG sync_statistics(SYNC_STATISTICS *statistics, BOOL reset);
+ *
+ *	             LONG scan_network(BYTE first_node, BYTE last_node);
+ *	             LONG scan_start(void);
+ *	             LONG scan_stop(void);
+ *	             LONG scan_node(BYTE node_id, SCAN_NODE *node);
+ *	             LONG scan_table(SCAN_NODE *table, SHORT *count);
+ *	             WORD scan_timeout(WORD milliseconds);
+ *
+ *	             LONG cfg_commission(CFG_NODE *table, SHORT count, WORD timeout);
  *
  *	             LONG lss_switch_mode_global(BYTE lss_mode);
  *	             LONG lss_switch_mode_selective(DWORD vendor_id, DWORD product_code, \
@@ -45,6 +69,9 @@
  *	                                             DWORD revision_number_low, DWORD revision_number_high, \
  *	                                             DWORD serial_number_low, DWORD serial_number_high);
  *	             LONG lss_identify_non_configured_remote_slaves(void);
+ *	             LONG lss_fastscan(DWORD *vendor_id, DWORD *product_code, \
+ *	                               DWORD *revision_number, DWORD *serial_number, \
+ *	                               BYTE known, WORD timeout);
  *	             WORD lss_timeout(WORD milliseconds);
  *
  *	             LONG lmt_switch_mode_global(BYTE lmt_mode);
@@ -68,12 +95,22 @@
  *	             LONG cop_queue_clear(void);
  *	             LONG cop_queue_status(BYTE *status, BYTE *load);
  *
+ *	             LONG mon_subscribe(MON_FILTER *filter);
+ *	             LONG mon_unsubscribe(LONG handle);
+ *	             LONG mon_receive(LONG handle, MON_MESSAGE *message);
+ *	             LONG mon_statistics(LONG handle, MON_STATISTICS *statistics, BOOL reset);
+ *
  *	             LPSTR cop_hardware(void);
  *	             LPSTR cop_software(void);
  *	             LPSTR cop_version(void);
  *	             LPSTR sdo_version(void);
  *	             LPSTR lss_version(void);
  *	             LPSTR lmt_version(void);
+ *	             LPSTR sync_version(void);
+ *	             LPSTR emcy_version(void);
+ *	             LPSTR scan_version(void);
+ *	             LPSTR cfg_version(void);
+ *	             LPSTR mon_version(void);
  *
  *	Include   :  can_defs.h, windows.h or default.h
  *
@@ -112,6 +149,7 @@
  *		- Read/Write an 8-bit value (expedited transfer)
  *		- Read/Write a 16-bit value (expedited transfer)
  *		- Read/Write a 32-bit value (expedited transfer)
+ *		- SDO channels for concurrent transfers to different nodes
  *
  *	CANopen Master NMS - Network Management Services.
  *
@@ -125,6 +163,58 @@
  *		- Reset Node (Application)
  *		- Reset Communication
  *
+ *		Error Control Services:
+ *		- Heartbeat Consumer (up to 127 nodes)
+ *		- Heartbeat Producer
+ *		- Node Guarding
+ *		- Boot-up, node state and node lost events
+ *
+ *	CANopen Master EMCY - Emergency Object.
+ *
+ *		Implements the EMCY consumer according to CiA DS-301 (Version 4.02
+ *		of February 13, 2002).
+ *
+ *		- Decoding of error code, error register and manufacturer field
+ *		- Ring log of the last messages of each node
+ *		- Subscriptions with independent read positions
+ *
+ *	CANopen Master SYNC - Synchronization Object.
+ *
+ *		Implements the SYNC producer according to CiA DS-301 (Version 4.02
+ *		of February 13, 2002).
+ *
+ *		- Cyclic SYNC message with or without synchronous counter
+ *		- Dedicated thread with absolute timing on CLOCK_MONOTONIC
+ *		- Period jitter statistics (histogram)
+ *
+ *	CANopen Master SCAN - Network Scan.
+ *
+ *		Discovers the nodes of the network by reading the device type and
+ *		the identity object of each node (SDO Upload Protocol, expedited).
+ *
+ *		- Concurrent SDO transfers to all nodes (about one SDO time-out)
+ *		- Identity of nodes read on boot-up (optional)
+ *		- Node table with device type, vendor-id, product code, revision
+ *		  number and serial number
+ *
+ *	CANopen Master CFG - Commissioning.
+ *
+ *		Assigns node-ids and baudrates to a list of nodes by means of the
+ *		Layer Setting Services (LSS) or Layer Management Services (LMT).
+ *
+ *		- Node identified by LSS address or LMT address
+ *		- Steps sequenced without idle time, skipped on the first error
+ *		- Result, failed step and duration reported for each node
+ *
+ *	CANopen Master MON - Message Monitor.
+ *
+ *		Passes the received CAN messages to subscribers as they arrive,
+ *		besides the message buffers and the event-queue.
+ *
+ *		- Filter by COB-Id. range and/or COB-Id. mask
+ *		- Rate limit per COB-Id. (minimal interval)
+ *		- Receive ring of each subscriber, counters of dropped messages
+ *
  *	CANopen Master LSS - Layer Setting Services.
  *
  *		Implements the Layer Setting Services and Protocols (LSS) according
@@ -147,6 +237,7 @@
  *		IDENTIFICATION PROTOCOLS
  *		- Identify Remote Slaves
  *		- Identify Non-configured Remote Slaves
+ *		- LSS Fastscan (CiA 305 Version 2.2)
  *
  *	CANopen Master LMT - Layer Management Services.
  *
@@ -306,31 +397,156 @@ extern "C" {
 #define  SDO_CLIENT				0x600	// COB-Id of Default Client-SDO
 #define  SDO_SERVER				0x580	// COB-Id of Default Server-SDO
 #define  SDO_TIMEOUT			500		// Time-out value for SDO protocol
+#define  SDO_CHANNELS			4		// Number of SDO channels (1,..,4)
 										// ---	NMT Definitions  ---
 #define  NMT_MASTER				0x000	// COB-Id of NMT-Master
 #define  NMT_SLAVE				0x700	// COB-Id of NMT-Slave
 #define  NMT_ALL				0x0		// All NMT-Slave devices
+#define  NMT_BOOTUP				0x00	// NMT state: Boot-up
+#define  NMT_STOPPED			0x04	// NMT state: Stopped
+#define  NMT_OPERATIONAL		0x05	// NMT state: Operational
+#define  NMT_PREOPERATIONAL		0x7F	// NMT state: Pre-operational
+#define  NMT_UNKNOWN			0xFF	// NMT state: Unknown (not alive)
+#define  NMT_EVENT_BOOTUP		1		// Event: Boot-up message received
+#define  NMT_EVENT_STATE		2		// Event: NMT state changed
+#define  NMT_EVENT_HEARTBEAT	3		// Event: Heartbeat lost
+#define  NMT_EVENT_GUARDING		4		// Event: Node guarding lost
+										// ---	EMCY Definitions  ---
+#define  EMCY_COB_ID			0x080	// COB-Id of EMCY message (+ node-id)
+#define  EMCY_HISTORY			8		// Number of logged messages per node
+										// ---	SYNC Definitions  ---
+#define  SYNC_COB_ID			0x080	// COB-Id of SYNC message
+#define  SYNC_HISTOGRAM			20		// Number of jitter classes
+										// ---	SCAN Definitions  ---
+#define  SCAN_ABSENT			0		// Node state: not present
+#define  SCAN_PENDING			1		// Node state: scan in progress
+#define  SCAN_PRESENT			2		// Node state: present
 										// ---	LSS Definitions  ---
 #define  LSS_MASTER				0x7E5	// COB-Id of LSS-Master
 #define  LSS_SLAVE				0x7E4	// COB-Id of LSS-Slave
 #define  LSS_TIMEOUT			500		// Time-out value for LSS protocol
 #define  LSS_OPERATION			0		// LSS operation mode
 #define  LSS_CONFIGURATION		1		// LSS configuration mode
+#define  LSS_FASTSCAN_TIMEOUT	25		// Time-out value for LSS Fastscan
+#define  LSS_FASTSCAN_VENDOR	0x01	// LSS Fastscan: vendor-id known
+#define  LSS_FASTSCAN_PRODUCT	0x02	// LSS Fastscan: product-code known
+#define  LSS_FASTSCAN_REVISION	0x04	// LSS Fastscan: revision-number known
+#define  LSS_FASTSCAN_SERIAL	0x08	// LSS Fastscan: serial-number known
 										// ---	LMT Definitions  ---
 #define  LMT_MASTER				0x7E5	// COB-Id of LMT-Master
 #define  LMT_SLAVE				0x7E4	// COB-Id of LMT-Slave
 #define  LMT_TIMEOUT			500		// Time-out value for LMT protocol
 #define  LMT_OPERATION			0		// LMT operation mode
 #define  LMT_CONFIGURATION		1		// LMT configuration mode
+										// ---	CFG Definitions  ---
+#define  CFG_LSS				0		// Commissioning by LSS
+#define  CFG_LMT				1		// Commissioning by LMT
+#define  CFG_KEEP				0xFF	// Baudrate: not configured
+#define  CFG_STEP_NONE			0		// Step: none (successful)
+#define  CFG_STEP_SELECT		1		// Step: switch mode selective
+#define  CFG_STEP_NODE_ID		2		// Step: configure node-id
+#define  CFG_STEP_BIT_TIMING	3		// Step: configure bit-timing
+#define  CFG_STEP_STORE			4		// Step: store configuration
+#define  CFG_STEP_RELEASE		5		// Step: switch mode global
+										// ---	MON Definitions  ---
+#define  MON_SUBSCRIBERS		8		// Max. number of subscribers
+#define  MON_QUEUE				512		// Size of the receive ring of a subscriber
 										// ---	CAN Message Buffers  ---
 #define  CANBUF_TX				0		// Message buffer for transmit objects
 #define  CANBUF_RX				1		// Message buffer for receive objects
+#define  CANBUF_SCAN			2		// Message buffer for network scan
+#define  CANBUF_SDO				3		// Message buffers for SDO channels (3,..,10)
+#define  CANBUF_HEARTBEAT		11		// Message buffer for heartbeat producer
+#define  CANBUF_GUARDING		12		// Message buffer for node guarding
+#define  CANBUF_SYNC			13		// Message buffer for SYNC producer
 #define  CANRTR_FACTOR			10		// Increased time-out for RTR-frames
 
 
 /*	-----------  Typen  ------------------------------------------------------
  */
 
+typedef struct _nmt_event				// NMT error control event:
+{
+	BYTE  node_id;						//   node-id of the NMT-Slave
+	BYTE  event;						//   event (NMT_EVENT_xyz)
+	BYTE  state;						//   NMT state of the node
+	DWORD time_stamp;					//   time-stamp in [ms]
+}	NMT_EVENT;
+
+typedef struct _emcy_message			// Emergency message:
+{
+	BYTE  node_id;						//   node-id of the producer
+	WORD  error_code;					//   emergency error code
+	BYTE  error_register;				//   error register (object 1001h)
+	BYTE  manufacturer[5];				//   manufacturer specific error field
+	DWORD time_stamp;					//   time-stamp in [ms]
+}	EMCY_MESSAGE;
+
+typedef struct _sync_statistics			// SYNC producer statistics:
+{
+	DWORD cycle_period;					//   communication cycle period [usec]
+	LONG  priority;						//   SCHED_FIFO priority (0 = none)
+	DWORD count;						//   number of transmitted SYNC messages
+	DWORD errors;						//   number of transmission errors
+	DWORD overruns;						//   number of missed cycles
+	LONG  jitter_min;					//   minimal period jitter [usec]
+	LONG  jitter_max;					//   maximal period jitter [usec]
+	DWORD histogram[SYNC_HISTOGRAM];	//   period jitter: class 0 = below 1 usec,
+}	SYNC_STATISTICS;					//     class n = 2^(n-1) to 2^n-1 usec
+
+typedef struct _scan_node				// Node of the network:
+{
+	BYTE  node_id;						//   node-id of the node
+	BYTE  state;						//   state (SCAN_xyz)
+	DWORD device_type;					//   device type (object 1000h)
+	DWORD vendor_id;					//   vendor-id (object 1018h:1)
+	DWORD product_code;					//   product code (object 1018h:2)
+	DWORD revision_number;				//   revision number (object 1018h:3)
+	DWORD serial_number;				//   serial number (object 1018h:4)
+	DWORD time_stamp;					//   time-stamp of the scan in [ms]
+}	SCAN_NODE;
+
+typedef struct _cfg_node				// Node to be commissioned:
+{
+	BYTE  protocol;						//   CFG_LSS or CFG_LMT
+	DWORD vendor_id;					//   LSS address: vendor-id
+	DWORD product_code;					//   LSS address: product-code
+	DWORD revision_number;				//   LSS address: revision-number
+	DWORD serial_number;				//   LSS address: serial-number
+	CHAR  manufacturer_name[8];			//   LMT address: manufacturer name (7 chars)
+	CHAR  product_name[8];				//   LMT address: product name (7 chars)
+	CHAR  lmt_serial_number[15];		//   LMT address: serial-number (14 digits)
+	BYTE  node_id;						//   node-id to be assigned (1,..,127)
+	BYTE  baudrate;						//   index to the bit-timing table, or CFG_KEEP
+	BOOL  store;						//   store the configuration in the node
+	LONG  result;						//   out: 0, or the error code (see below)
+	BYTE  step;							//   out: step failed (CFG_STEP_xyz)
+	DWORD duration;						//   out: time for the commissioning [usec]
+}	CFG_NODE;
+
+typedef struct _mon_filter				// Message filter:
+{
+	LONG  first;						//   first COB-Id. of the range
+	LONG  last;							//   last COB-Id. of the range
+	LONG  mask;							//   COB-Id. mask (7FFh = all bits)
+	WORD  interval;						//   min. interval per COB-Id. in [ms] (0 = none)
+}	MON_FILTER;
+
+typedef struct _mon_message				// Received message:
+{
+	LONG  cob_id;						//   COB-Id. (11-bit identifier)
+	SHORT length;						//   data length code (0,..,8)
+	BYTE  data[8];						//   message data
+	DWORD time_stamp;					//   time-stamp in [ms]
+}	MON_MESSAGE;
+
+typedef struct _mon_statistics			// Counters of a subscription:
+{
+	DWORD received;						//   number of messages passed to the ring
+	DWORD throttled;					//   number of messages dropped by the rate limit
+	DWORD lost;							//   number of messages lost on ring overrun
+}	MON_STATISTICS;
+
 
 /*	-----------  Variablen  --------------------------------------------------
  */
@@ -432,6 +648,21 @@ COPAPI WORD sdo_timeout(WORD milliseconds);
  *  result:     last time-out value in milliseconds.
  */
 
+COPAPI LONG sdo_channel(BYTE channel);
+/*
+ *  function:   selects the message buffers for the SDO transfers of the
+ *              calling thread. Each channel has its own pair of message
+ *              buffers, so threads with different channels can run SDO
+ *              transfers concurrently (but not to the same node).
+ *
+ *              The error code (cop_error) is kept per thread as well.
+ *
+ *  parameter:  channel: 0 = CANBUF_TX and CANBUF_RX (default), or
+ *                       1,..,SDO_CHANNELS = two buffers from CANBUF_SDO.
+ *
+ *  result:     0 if successful, or a negative value on error.
+ */
+
 COPAPI LONG sdo_write_8bit(BYTE node_id, WORD index, BYTE subindex, BYTE value);
 /*
  *  function:   writes an 8-bit value to the selected node at object index
@@ -597,6 +828,256 @@ COPAPI LONG nmt_reset_communication(BYTE node_id);
  *  result:     0 if successful, or a negative value on error.
  */
 
+COPAPI LONG nmt_heartbeat_consumer(BYTE node_id, WORD heartbeat_time);
+/*
+ *  function:   starts or stops the heartbeat consumer for the selected node.
+ *              The monitoring starts with the first received heartbeat. If
+ *              no heartbeat is received within the heartbeat time, a heart-
+ *              beat event is reported and the node state is set to unknown.
+ *
+ *              The function implements the Heartbeat protocol according to
+ *              the CiA DS-301 Communication Profile (object 1016h).
+ *
+ *  parameter:  node_id (1,..,127) of the node or 0 for all nodes.
+ *              heartbeat_time: consumer heartbeat time in milliseconds,
+ *              or 0 to stop the monitoring.
+ *
+ *  result:     0 if successful, or a negative value on error.
+ */
+
+COPAPI LONG nmt_heartbeat_producer(BYTE node_id, WORD heartbeat_time);
+/*
+ *  function:   starts or stops the heartbeat producer of the CANopen Master.
+ *
+ *              The function implements the Heartbeat protocol according to
+ *              the CiA DS-301 Communication Profile (object 1017h).
+ *
+ *  parameter:  node_id (1,..,127) of the CANopen Master.
+ *              heartbeat_time: producer heartbeat time in milliseconds,
+ *              or 0 to stop the heartbeat.
+ *
+ *  result:     0 if successful, or a negative value on error.
+ */
+
+COPAPI LONG nmt_node_guarding(BYTE node_id, WORD guard_time, BYTE life_time_factor);
+/*
+ *  function:   starts or stops the node guarding for the selected node.
+ *              The node is guarded by a remote frame every guard time. If
+ *              no response is received within the node life time (guard
+ *              time multiplied by the life time factor), a node guarding
+ *              event is reported and the node state is set to unknown;
+ *              also when the node has never responded (e.g. it is absent
+ *              when the guarding is started). The event is reported once,
+ *              until the node responds again.
+ *
+ *              The function implements the Node Guarding protocol according
+ *              to the CiA DS-301 Communication Profile (object 100Ch/100Dh).
+ *
+ *  parameter:  node_id (1,..,127) of the node or 0 for all nodes.
+ *              guard_time in milliseconds, or 0 to stop the guarding.
+ *              life_time_factor (1,..,255).
+ *
+ *  result:     0 if successful, or a negative value on error.
+ */
+
+COPAPI LONG nmt_node_state(BYTE node_id, BYTE *state);
+/*
+ *  function:   retrieves the NMT state of the selected node from the table
+ *              of the error control services (boot-up, heartbeat, or node
+ *              guarding). No message is transmitted.
+ *
+ *  parameter:  node_id (1,..,127) of the node.
+ *              state: NMT state of the node (NMT_UNKNOWN if the node is
+ *              not monitored, or if it has been lost).
+ *
+ *  result:     0 if successful, or a negative value on error.
+ */
+
+COPAPI LONG nmt_event(NMT_EVENT *event);
+/*
+ *  function:   reads the next event of the error control services from the
+ *              event-queue if any (boot-up, node state changed, heartbeat
+ *              event or node guarding event).
+ *
+ *              Boot-up messages are reported for all nodes, the other events
+ *              only for nodes monitored by heartbeat or node guarding.
+ *
+ *  parameter:  event: pointer to a buffer for the event.
+ *
+ *  result:     0 if successful, COPERR_RX_EMPTY if no event is pending,
+ *              or another negative value on error.
+ */
+
+/*	 - - - - -  EMCY - Emergency Object  - - - - - - - - - - - - - - - - - - -
+ */
+COPAPI LONG emcy_subscribe(BYTE node_id);
+/*
+ *  function:   subscribes to the emergency messages of the selected node.
+ *              The subscriber reads the messages by calling emcy_receive,
+ *              starting with the next received message.
+ *
+ *              The function implements the EMCY consumer according to the
+ *              CiA DS-301 Communication Profile.
+ *
+ *  parameter:  node_id (1,..,127) of the node or 0 for all nodes.
+ *
+ *  result:     handle of the subscription (0 or greater) if successful,
+ *              or a negative value on error.
+ */
+
+COPAPI LONG emcy_unsubscribe(LONG handle);
+/*
+ *  function:   cancels a subscription to emergency messages.
+ *
+ *  parameter:  handle of the subscription.
+ *
+ *  result:     0 if successful, or a negative value on error.
+ */
+
+COPAPI LONG emcy_receive(LONG handle, EMCY_MESSAGE *emcy);
+/*
+ *  function:   reads the next emergency message of a subscription if any.
+ *              When none is pending, the CAN messages of the interface are
+ *              read first (so no other traffic is needed). While there are
+ *              subscribers, the emergency messages do not reach the receive
+ *              queue (cop_queue_read).
+ *
+ *  parameter:  handle of the subscription.
+ *              emcy: pointer to a buffer for the message.
+ *
+ *  result:     0 if successful, COPERR_RX_EMPTY if no message is pending,
+ *              COPERR_QUE_OVR once if messages have been lost, or another
+ *              negative value on error.
+ */
+
+COPAPI LONG emcy_history(BYTE node_id, EMCY_MESSAGE *history, SHORT *count);
+/*
+ *  function:   reads the last emergency messages of the selected node from
+ *              the ring log (newest message first). No message is transmitted.
+ *
+ *  parameter:  node_id (1,..,127) of the node.
+ *              history: pointer to a buffer for the messages.
+ *              count: in - size of the buffer (number of messages),
+ *                     out - number of messages read (max. EMCY_HISTORY).
+ *
+ *  result:     0 if successful, or a negative value on error.
+ */
+
+/*	 - - - - -  SYNC - Synchronization Object  - - - - - - - - - - - - - - - -
+ */
+COPAPI LONG sync_start(DWORD cycle_period, BYTE counter_overflow, LONG priority);
+/*
+ *  function:   starts the SYNC producer. The SYNC message is transmitted
+ *              cyclically by a dedicated thread until sync_stop is called.
+ *
+ *              The function implements the SYNC producer according to the
+ *              CiA DS-301 Communication Profile (object 1006h and 1019h).
+ *
+ *  parameter:  cycle_period: communication cycle period in microseconds
+ *              (minimum 100 usec).
+ *              counter_overflow: synchronous counter overflow value (2,..,240),
+ *              or 0 for SYNC messages without counter.
+ *              priority: SCHED_FIFO priority (1,..,99) of the thread, or 0 for
+ *              normal scheduling. If the real-time policy can not be set (e.g.
+ *              missing privileges), the thread runs with normal scheduling.
+ *
+ *  result:     0 if successful, or a negative value on error.
+ */
+
+COPAPI LONG sync_stop(void);
+/*
+ *  function:   stops the SYNC producer.
+ *
+ *  parameter:  (none)
+ *
+ *  result:     0 if successful, or a negative value on error.
+ */
+
+COPAPI LONG sync_statistics(SYNC_STATISTICS *statistics, BOOL reset);
+/*
+ *  function:   retrieves the statistics of the SYNC producer, i.e. the number
+ *              of transmitted messages, missed cycles and the histogram of the
+ *              period jitter (deviation of the time between two consecutive
+ *              SYNC messages from the communication cycle period).
+ *
+ *  parameter:  statistics: pointer to a buffer for the statistics.
+ *              reset: if TRUE, the counters are reset after reading.
+ *
+ *  result:     0 if the SYNC producer is running, COPERR_OFFLINE if it is
+ *              stopped (the statistics of its last run are retrieved), or
+ *              another negative value on error.
+ */
+
+/*	 - - - - -  SCAN - Network Scan  - - - - - - - - - - - - - - - - - - - - -
+ */
+COPAPI LONG scan_network(BYTE first_node, BYTE last_node);
+/*
+ *  function:   scans the selected range of node-ids and updates the node
+ *              table. The device type (object 1000h) and the identity object
+ *              (object 1018h, sub-index 1 to 4) are read from all nodes
+ *              concurrently, so the scan takes about one SDO time-out.
+ *
+ *              A node is present if it answers the first SDO request (an SDO
+ *              abort counts as an answer; the value of the object is then 0).
+ *
+ *  parameter:  first_node: first node-id (1,..,127) of the range.
+ *              last_node: last node-id (1,..,127) of the range.
+ *
+ *  result:     0 if successful, or a negative value on error.
+ */
+
+COPAPI LONG scan_start(void);
+/*
+ *  function:   starts listening for boot-up messages. The identity of each
+ *              node sending a boot-up message is read and entered into the
+ *              node table.
+ *
+ *  parameter:  (none)
+ *
+ *  result:     0 if successful, or a negative value on error.
+ */
+
+COPAPI LONG scan_stop(void);
+/*
+ *  function:   stops listening for boot-up messages.
+ *
+ *  parameter:  (none)
+ *
+ *  result:     0 if successful, or a negative value on error.
+ */
+
+COPAPI LONG scan_node(BYTE node_id, SCAN_NODE *node);
+/*
+ *  function:   reads the entry of the selected node from the node table.
+ *              No message is transmitted.
+ *
+ *  parameter:  node_id (1,..,127) of the node.
+ *              node: pointer to a buffer for the entry.
+ *
+ *  result:     0 if successful, or a negative value on error.
+ */
+
+COPAPI LONG scan_table(SCAN_NODE *table, SHORT *count);
+/*
+ *  function:   reads the entries of all present nodes from the node table
+ *              (in ascending order of the node-id). No message is transmitted.
+ *
+ *  parameter:  table: pointer to a buffer for the entries.
+ *              count: in - size of the buffer (number of entries),
+ *                     out - number of entries read.
+ *
+ *  result:     0 if successful, or a negative value on error.
+ */
+
+COPAPI WORD scan_timeout(WORD milliseconds);
+/*
+ *  function:   sets the SDO time-out value of the network scan.
+ *
+ *  parameter:  milliseconds: new time-out value.
+ *
+ *  result:     old time-out value.
+ */
+
 /*	 - - - - -  LSS - Layer Setting Services   - - - - - - - - - - - - - - - -
  */
 COPAPI LONG lss_switch_mode_global(BYTE lss_mode);
@@ -799,6 +1280,36 @@ COPAPI LONG lss_identify_non_configured_remote_slaves(void);
  *  result:     0 if successful, or a negative value on error.
  */
 
+COPAPI LONG lss_fastscan(DWORD *vendor_id, DWORD *product_code, \
+                         DWORD *revision_number, DWORD *serial_number, \
+                         BYTE known, WORD timeout);
+/*
+ *  function:   identifies one non-configured node (node-id FFh) by a binary
+ *              search over its LSS address. The node is switched to LSS
+ *              configuration mode, so a node-id can be assigned to it.
+ *
+ *              The function implements the LSS Fastscan protocol according
+ *              to CiA 305 Version 2.2 (Layer Setting Services). At most 133
+ *              LSS requests are needed; each request without an answer takes
+ *              the time-out value.
+ *
+ *              To identify all non-configured nodes, repeat the function with
+ *              lss_configure_node_id and lss_switch_mode_global(LSS_OPERATION)
+ *              until it returns COPERR_TIMEOUT.
+ *
+ *  parameter:  vendor_id (as part of the LSS address).
+ *              product_code (as part of the LSS address).
+ *              revision_number (as part of the LSS address).
+ *              serial_number (as part of the LSS address).
+ *              known: parts of the LSS address which are known and must not
+ *              be scanned (LSS_FASTSCAN_xyz), or 0 to scan all parts.
+ *              timeout: time-out in milliseconds for the answer of the nodes,
+ *              or 0 for the default value (LSS_FASTSCAN_TIMEOUT).
+ *
+ *  result:     0 if successful, COPERR_TIMEOUT if no non-configured node is
+ *              present, or another negative value on error.
+ */
+
 COPAPI WORD lss_timeout(WORD milliseconds);
 /*
  *  function:   sets the time-out value in milliseconds for the LSS
@@ -979,6 +1490,33 @@ COPAPI WORD lmt_timeout(WORD milliseconds);
  *  result:     last time-out value in milliseconds.
  */
 
+/*	 - - - - -  CFG - Commissioning  - - - - - - - - - - - - - - - - - - - - -
+ */
+COPAPI LONG cfg_commission(CFG_NODE *table, SHORT count, WORD timeout);
+/*
+ *  function:   commissions the nodes of the list one after the other: the
+ *              node is switched to configuration mode (switch mode selective),
+ *              the node-id and optionally the baudrate are assigned, the
+ *              configuration is optionally stored, and the node is switched
+ *              back to operation mode. The remaining steps of a node are
+ *              skipped on the first error.
+ *
+ *              The new node-id and baudrate become valid after a reset of
+ *              the node, or after lss_activate_bit_timing (baudrate).
+ *
+ *  parameter:  table: list of the nodes. The result of each node is returned
+ *              in the members result (0 if successful, or a negative value on
+ *              a communication error, or the LSS/LMT Error Code from the node
+ *              as a positive value), step (step failed) and duration (in
+ *              microseconds).
+ *              count: number of nodes in the list.
+ *              timeout: time-out in milliseconds for the confirmations of
+ *              the nodes, or 0 for the LSS and LMT time-out values.
+ *
+ *  result:     number of nodes commissioned successfully, or a negative
+ *              value on error (invalid list).
+ */
+
 /*	 - - - - -  CAN - Layer 2 Functions  - - - - - - - - - - - - - - - - - - -
  */
 COPAPI LONG cop_transmit(LONG cob_id, SHORT length, BYTE *data);
@@ -1098,6 +1636,65 @@ COPAPI LONG cop_queue_status(BYTE *status, BYTE *load);
  *                                  CANQUE_OVERRUN  - queue overrun
  */
 
+/*	 - - - - -  MON - Message Monitor  - - - - - - - - - - - - - - - - - - - -
+ */
+COPAPI LONG mon_subscribe(MON_FILTER *filter);
+/*
+ *  function:   subscribes to the received CAN messages which pass the filter.
+ *              The subscriber reads the messages by calling mon_receive,
+ *              starting with the next received message. The messages are
+ *              also taken by the CANopen services, the message buffers and
+ *              the event-queue as before.
+ *
+ *              A message passes if its COB-Id. ANDed with the mask is within
+ *              the range ANDed with the mask (e.g. 180h to 1FFh with mask 7FFh:
+ *              TPDO1 of all nodes, or 181h to 181h with mask 07Fh: all messages
+ *              of node 1). With a minimal interval, a message is dropped when
+ *              the last message of the same COB-Id. passed less than interval
+ *              ms before.
+ *
+ *  parameter:  filter: pointer to the message filter.
+ *
+ *  result:     handle of the subscription (0 or greater) if successful,
+ *              or a negative value on error.
+ */
+
+COPAPI LONG mon_unsubscribe(LONG handle);
+/*
+ *  function:   cancels a subscription to CAN messages.
+ *
+ *  parameter:  handle of the subscription.
+ *
+ *  result:     0 if successful, or a negative value on error.
+ */
+
+COPAPI LONG mon_receive(LONG handle, MON_MESSAGE *message);
+/*
+ *  function:   reads the next message of a subscription if any. When the
+ *              receive ring is empty, the CAN messages of the interface are
+ *              read first (the caller need not poll the interface).
+ *
+ *              A subscriber which does not keep up loses the oldest messages
+ *              of its ring (MON_QUEUE messages); they are counted as lost.
+ *
+ *  parameter:  handle of the subscription.
+ *              message: pointer to a buffer for the message.
+ *
+ *  result:     0 if successful, COPERR_RX_EMPTY if no message is pending,
+ *              or another negative value on error.
+ */
+
+COPAPI LONG mon_statistics(LONG handle, MON_STATISTICS *statistics, BOOL reset);
+/*
+ *  function:   retrieves the counters of a subscription.
+ *
+ *  parameter:  handle of the subscription.
+ *              statistics: pointer to a buffer for the counters.
+ *              reset: TRUE to reset the counters after reading.
+ *
+ *  result:     0 if successful, or a negative value on error.
+ */
+
 /*	 - - - - -  API - Version Information  - - - - - - - - - - - - - - - - - -
  */
 COPAPI LPSTR cop_hardware(void);
@@ -1124,6 +1721,11 @@ COPAPI LPSTR cop_version(void);
 COPAPI LPSTR sdo_version(void);
 COPAPI LPSTR lss_version(void);
 COPAPI LPSTR lmt_version(void);
+COPAPI LPSTR sync_version(void);
+COPAPI LPSTR emcy_version(void);
+COPAPI LPSTR scan_version(void);
+COPAPI LPSTR cfg_version(void);
+COPAPI LPSTR mon_version(void);
 /*
  *	function  :  retrieves version information of the CANopen Master API
  *	             as a zero-terminated string.
@@ -0,0 +1,363 @@
+/*	-- $Header$ --
+ *
+ *	projekt   :  CAN - Controller Area Network.
+ *
+ *	purpose   :  Binary framing for the CANopen Gateway.
+ *
+ *	copyright :  (C) 2009, UV Software, Friedrichshafen.
+ *
+ *	compiler  :  GCC - GNU C Compiler (Linux Kernel 2.6)
+ *
+ *	export    :  (see header file)
+ *
+ *	includes  :  cop_bin.h (cop_tcp.h, default.h), can_defs.h, cop_api.h
+ *
+ *	author    :  Uwe Vogt, UV Software, Friedrichshafen
+ *
+ *	e-mail    :  uwe.vogt@uv-software.de
+ *
+ *
+ *	-----------  description  -----------------------------------------------
+ *
+ *	CANopen Master - Binary Framing for the Gateway.
+ *
+ *	The SDO and NMT commands are executed directly; the value of an SDO
+ *	command is copied between the frame and the SDO transfer as it is.
+ *	Any other command is passed as text to cop_tcp_parse(), so the binary
+ *	framing supports the same operations as the ASCII Mapping. The SDO and
+ *	NMT commands are recorded in the metrics of the gateway here, any other
+ *	command by cop_tcp_parse().
+ *
+ *
+ *	-----------  history  ---------------------------------------------------
+ *
+ *	$Log$
+ */
+
+static char _id[] = "$Id: cop_bin.c $";
+
+
+/*  -----------  includes  -------------------------------------------------
+ */
+
+#include "cop_bin.h"
+
+#include "can_defs.h"
+#include "cop_api.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+/*  -----------  defines  --------------------------------------------------
+ */
+
+#define ERROR_NOT_SUPPORTED	100			/* error codes of DS-309/3 */
+#define ERROR_SYNTAX		101
+#define ERROR_NOT_PROCESSED	102
+#define ERROR_TIMEOUT		103
+#define ERROR_UNSUPPORTED_NET	106
+
+#define TEXT_LENGTH			1025		/* max. length of a DS-309/3 command */
+
+#define GET16(p)			((WORD)(p)[0] | ((WORD)(p)[1] << 8))
+#define GET32(p)			((DWORD)(p)[0] | ((DWORD)(p)[1] << 8) | ((DWORD)(p)[2] << 16) | ((DWORD)(p)[3] << 24))
+
+
+/*  -----------  types  ----------------------------------------------------
+ */
+
+
+/*  -----------  prototypes  -----------------------------------------------
+ */
+
+static int bin_upload(BYTE node, BYTE *request, int length, BYTE *response, int nbyte);
+static int bin_download(BYTE node, BYTE *request, int length, BYTE *response, int nbyte);
+static int bin_nmt(BYTE node, BYTE *request, int length, BYTE *response, int nbyte);
+static int bin_command(DWORD sequence, BYTE net, BYTE node, BYTE *request, int length, COP_TCP_SETTINGS *settings, BYTE *response, int nbyte);
+
+static int bin_class(BYTE opcode, BYTE specifier);
+static int bin_size(BYTE datatype);
+static int bin_result(LONG rc, BYTE *response, int length);
+static int bin_error(WORD code, BYTE *response);
+static int bin_frame(BYTE *response, DWORD sequence, BYTE opcode, BYTE status, int length);
+static void put16(BYTE *buffer, WORD value);
+static void put32(BYTE *buffer, DWORD value);
+
+
+/*  -----------  variables  ------------------------------------------------
+ */
+
+
+/*  -----------  functions  ------------------------------------------------
+ */
+
+int cop_bin_parse(BYTE *request, int length, COP_TCP_SETTINGS *settings, BYTE *response, int nbyte)
+{
+	struct timespec t0, t1;
+	DWORD sequence;
+	BYTE net, node, opcode;
+	int n, command;
+
+	if(!request || !settings || !response || nbyte < COP_BIN_RESPONSE + 4)
+		return 0;
+	if(length < COP_BIN_REQUEST || length != 2 + GET16(request)) {
+		sequence = (length >= 6)? GET32(&request[2]) : 0;
+		cop_tcp_measure(COP_TCP_CMD_OTHER, 0, 0LL, ERROR_SYNTAX);
+		return bin_frame(response, sequence, 0x00, COP_BIN_ERROR, -bin_error(ERROR_SYNTAX, response));
+	}
+	/* the header (the response may be written over the request) */
+	sequence = GET32(&request[2]);
+	net = (request[6] != COP_BIN_DEFAULT)? request[6] : settings->net;
+	node = (request[7] != COP_BIN_DEFAULT)? request[7] : settings->node;
+	opcode = request[8];
+	command = bin_class(opcode, (length > COP_BIN_REQUEST)? request[9] : 0x00);
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	/* a connection is served by the process of its default network */
+	if(net != settings->net)
+		n = bin_error(ERROR_UNSUPPORTED_NET, response);
+	else switch(opcode) {
+	case COP_BIN_UPLOAD:
+		n = bin_upload(node, request, length, response, nbyte);
+		break;
+	case COP_BIN_DOWNLOAD:
+		n = bin_download(node, request, length, response, nbyte);
+		break;
+	case COP_BIN_NMT:
+		n = bin_nmt(node, request, length, response, nbyte);
+		break;
+	case COP_BIN_COMMAND:
+		n = bin_command(sequence, net, node, request, length, settings, response, nbyte);
+		break;
+	default:
+		n = bin_error(ERROR_NOT_SUPPORTED, response);
+		break;
+	}
+	/* the metrics (a DS-309/3 command is recorded by cop_tcp_parse) */
+	if(opcode != COP_BIN_COMMAND) {
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+		cop_tcp_measure(command, (opcode == COP_BIN_UPLOAD || opcode == COP_BIN_DOWNLOAD)? node : 0,
+		                ((long long)(t1.tv_sec - t0.tv_sec) * 1000000LL) + ((long long)(t1.tv_nsec - t0.tv_nsec) / 1000LL),
+		                (n == -4)? (unsigned long)GET32(&response[COP_BIN_RESPONSE]) :
+		                (n < 0)? (unsigned long)GET16(&response[COP_BIN_RESPONSE]) : 0UL);
+	}
+	/* n: length of the data, or -(length) on error */
+	if(n < 0)
+		return bin_frame(response, sequence, opcode, (n == -4)? COP_BIN_ABORT : COP_BIN_ERROR, -n);
+	return bin_frame(response, sequence, opcode, COP_BIN_OK, n);
+}
+
+int cop_bin_node(BYTE *request, int length, COP_TCP_SETTINGS *settings)
+{
+	BYTE node;
+
+	if(!request || !settings || length < COP_BIN_REQUEST)
+		return 0;
+	if(request[8] != COP_BIN_UPLOAD && request[8] != COP_BIN_DOWNLOAD)
+		return 0;
+	node = (request[7] != COP_BIN_DEFAULT)? request[7] : settings->node;
+	return (1 <= node && node <= 127)? node : 0;
+}
+
+int cop_bin_event(char *notification, BYTE *frame, int nbyte)
+{
+	int n;
+
+	if(!notification || !frame)
+		return 0;
+	/* the notification without its line end */
+	n = (int)strcspn(notification, "\r\n");
+	if(COP_BIN_RESPONSE + n > nbyte)
+		return 0;
+	memmove(&frame[COP_BIN_RESPONSE], notification, n);
+	return bin_frame(frame, 0, COP_BIN_EVENT, COP_BIN_OK, n);
+}
+
+char* cop_bin_version()
+{
+	return (char*)_id;
+}
+
+/*  -----------  local functions  ------------------------------------------
+ */
+
+static int bin_upload(BYTE node, BYTE *request, int length, BYTE *response, int nbyte)
+{
+	WORD index;
+	BYTE subindex;
+	SHORT n = 0;
+	LONG rc;
+	int size, fixed;
+
+	/* index:2 sub-index:1 datatype:1 */
+	if(length != COP_BIN_REQUEST + 4)
+		return bin_error(ERROR_SYNTAX, response);
+	index = GET16(&request[9]);
+	subindex = request[11];
+	if((size = bin_size(request[12])) < 0)
+		return bin_error(ERROR_NOT_SUPPORTED, response);
+	/* the value is read into the response (a fixed size must match) */
+	if(!(fixed = size))
+		size = nbyte - COP_BIN_RESPONSE;
+	else if(size > nbyte - COP_BIN_RESPONSE)
+		return bin_error(ERROR_NOT_PROCESSED, response);
+	rc = sdo_read(node, index, subindex, &n, &response[COP_BIN_RESPONSE], (SHORT)size);
+	return bin_result(rc, response, (fixed && n != fixed)? -1 : n);
+}
+
+static int bin_download(BYTE node, BYTE *request, int length, BYTE *response, int nbyte)
+{
+	WORD index;
+	BYTE subindex;
+	int size, n = length - (COP_BIN_REQUEST + 4);
+
+	/* index:2 sub-index:1 datatype:1 value */
+	if(n < 1)
+		return bin_error(ERROR_SYNTAX, response);
+	index = GET16(&request[9]);
+	subindex = request[11];
+	if((size = bin_size(request[12])) < 0)
+		return bin_error(ERROR_NOT_SUPPORTED, response);
+	if(size && n != size)
+		return bin_error(ERROR_SYNTAX, response);
+	nbyte = nbyte;
+	return bin_result(sdo_write(node, index, subindex, (SHORT)n, &request[COP_BIN_REQUEST + 4]), response, 0);
+}
+
+static int bin_nmt(BYTE node, BYTE *request, int length, BYTE *response, int nbyte)
+{
+	LONG rc;
+
+	/* command specifier:1 */
+	if(length != COP_BIN_REQUEST + 1)
+		return bin_error(ERROR_SYNTAX, response);
+	switch(request[9]) {
+	case 0x01: rc = nmt_start_remote_node(node); break;
+	case 0x02: rc = nmt_stop_remote_node(node); break;
+	case 0x80: rc = nmt_enter_preoperational(node); break;
+	case 0x81: rc = nmt_reset_node(node); break;
+	case 0x82: rc = nmt_reset_communication(node); break;
+	default: return bin_error(ERROR_SYNTAX, response);
+	}
+	nbyte = nbyte;
+	return (rc != COPERR_NOERROR)? bin_error(ERROR_NOT_PROCESSED, response) : 0;
+}
+
+static int bin_command(DWORD sequence, BYTE net, BYTE node, BYTE *request, int length, COP_TCP_SETTINGS *settings, BYTE *response, int nbyte)
+{
+	char text[TEXT_LENGTH];
+	char *data;
+	int n = length - COP_BIN_REQUEST;
+
+	/* the DS-309/3 request: '['<sequence>']' <net> <node> <command> */
+	if(n < 1 || n > TEXT_LENGTH - 32)
+		return bin_error(ERROR_SYNTAX, response);
+	snprintf(text, TEXT_LENGTH, "[%lu] %u %u ", (unsigned long)sequence, net, node);
+	strncat(text, (char*)&request[COP_BIN_REQUEST], n);
+	strcat(text, "\n");
+	cop_tcp_parse(text, settings, text, TEXT_LENGTH);
+	/* the DS-309/3 response without the sequence and the line end */
+	data = strchr(text, ']')? strchr(text, ']') + 1 : text;
+	data += (*data == ' ');
+	for(n = (int)strlen(data); n > 0 && (data[n-1] == '\r' || data[n-1] == '\n'); n--)
+		;
+	if(n > nbyte - COP_BIN_RESPONSE)
+		n = nbyte - COP_BIN_RESPONSE;
+	memcpy(&response[COP_BIN_RESPONSE], data, n);
+	return n;
+}
+
+static int bin_class(BYTE opcode, BYTE specifier)
+{
+	switch(opcode) {
+	case COP_BIN_UPLOAD:
+		return COP_TCP_CMD_READ;
+	case COP_BIN_DOWNLOAD:
+		return COP_TCP_CMD_WRITE;
+	case COP_BIN_NMT:
+		switch(specifier) {
+		case 0x01: return COP_TCP_CMD_START;
+		case 0x02: return COP_TCP_CMD_STOP;
+		case 0x80: return COP_TCP_CMD_PREOP;
+		case 0x81: return COP_TCP_CMD_RESET;
+		case 0x82: return COP_TCP_CMD_RESET;
+		}
+		return COP_TCP_CMD_OTHER;
+	default:
+		return COP_TCP_CMD_OTHER;
+	}
+}
+
+static int bin_size(BYTE datatype)
+{
+	switch(datatype) {
+	case COP_BIN_INTEGER8:
+	case COP_BIN_UNSIGNED8:
+		return 1;
+	case COP_BIN_INTEGER16:
+	case COP_BIN_UNSIGNED16:
+		return 2;
+	case COP_BIN_INTEGER32:
+	case COP_BIN_UNSIGNED32:
+		return 4;
+	case COP_BIN_TIME_OF_DAY:
+	case COP_BIN_TIME_DIFFERENCE:
+		return 6;
+	case COP_BIN_VISIBLE_STRING:
+	case COP_BIN_OCTET_STRING:
+	case COP_BIN_DOMAIN:
+		return 0;						/* any length */
+	default:
+		return -1;						/* not supported */
+	}
+}
+
+static int bin_result(LONG rc, BYTE *response, int length)
+{
+	/* length of the data, or -(length of the error data) */
+	if(rc == COPERR_NOERROR && length < 0)
+		rc = COPERR_LENGTH;				/* not the size of the datatype */
+	if(rc == COPERR_NOERROR)
+		return length;
+	if(rc < COPERR_NOERROR)
+		return bin_error((rc == COPERR_TIMEOUT)? ERROR_TIMEOUT : ERROR_NOT_PROCESSED, response);
+	put32(&response[COP_BIN_RESPONSE], (DWORD)rc);
+	return -4;							/* SDO abort code */
+}
+
+static int bin_error(WORD code, BYTE *response)
+{
+	put16(&response[COP_BIN_RESPONSE], code);
+	return -2;							/* error code of DS-309/3 */
+}
+
+static int bin_frame(BYTE *response, DWORD sequence, BYTE opcode, BYTE status, int length)
+{
+	put16(&response[0], (WORD)(COP_BIN_RESPONSE - 2 + length));
+	put32(&response[2], sequence);
+	response[6] = opcode;
+	response[7] = status;
+	return COP_BIN_RESPONSE + length;
+}
+
+static void put16(BYTE *buffer, WORD value)
+{
+	buffer[0] = (BYTE)value;
+	buffer[1] = (BYTE)(value >> 8);
+}
+
+static void put32(BYTE *buffer, DWORD value)
+{
+	buffer[0] = (BYTE)value;
+	buffer[1] = (BYTE)(value >> 8);
+	buffer[2] = (BYTE)(value >> 16);
+	buffer[3] = (BYTE)(value >> 24);
+}
+
+/*  -------------------------------------------------------------------------
+ *	Uwe Vogt,  UV Software,  Steinaecker 28,  88048 Friedrichshafen,  Germany
+ *	Fon: +49-7541-6041530, Fax. +49-1803-551809359, Cell fon: +49-170-3801903
+ *	E-Mail: uwe.vogt@uv-software.de, Internet URL: http://www.uv-software.de/
+ */
@@ -0,0 +1,172 @@
+/*	-- $Header$ --
+ *
+ *	projekt   :  CAN - Controller Area Network.
+ *
+ *	purpose   :  Binary framing for the CANopen Gateway.
+ *
+ *	copyright :  (C) 2009, UV Software, Friedrichshafen.
+ *
+ *	compiler  :  GCC - GNU C Compiler (Linux Kernel 2.6)
+ *
+ *	export    :  <export>
+ *
+ *	includes  :  cop_tcp.h (default.h)
+ *
+ *	author    :  Uwe Vogt, UV Software, Friedrichshafen
+ *
+ *	e-mail    :  uwe.vogt@uv-software.de
+ *
+ *
+ *	-----------  description  -----------------------------------------------
+ *
+ *	CANopen Master - Binary Framing for the Gateway.
+ *
+ *		A compact alternative to the ASCII Mapping (DS-309/3) for clients
+ *		that are programs: the values are transferred as they are encoded
+ *		on the CAN bus, so neither end formats or parses numbers, and a
+ *		domain is not converted to base64. A connection is switched to
+ *		binary framing when its first byte is COP_BIN_MAGIC.
+ *
+ *		All fields are little-endian (as in CANopen). A frame starts with
+ *		its length (the number of bytes after the length field):
+ *
+ *		request:  | length:2 | sequence:4 | net:1 | node:1 | opcode:1 | parameters...
+ *		response: | length:2 | sequence:4 | opcode:1 | status:1 | data...
+ *
+ *		net or node COP_BIN_DEFAULT: the default of the connection. A
+ *		frame to another network is answered with error 106 (with several
+ *		networks the router of cop_net.h passes it to its network).
+ *
+ *		opcode            parameters                          data (status OK)
+ *		COP_BIN_UPLOAD    index:2 sub-index:1 datatype:1      value
+ *		COP_BIN_DOWNLOAD  index:2 sub-index:1 datatype:1 value  -
+ *		COP_BIN_NMT       command specifier:1                 -
+ *		COP_BIN_COMMAND   DS-309/3 command (text)             DS-309/3 response (text)
+ *		COP_BIN_EVENT     (from the gateway, sequence 0)      event notification (text)
+ *
+ *		The datatypes are the index of the data type in the object
+ *		dictionary (CiA DS-301), the NMT command specifiers those of the
+ *		NMT protocol. COP_BIN_COMMAND carries any other DS-309/3 command
+ *		without the sequence and the network and node-id (they are taken
+ *		from the frame header), e.g. "set sdo_timeout 1000"; its response
+ *		is the text of the DS-309/3 response without sequence and line end.
+ *
+ *		On status COP_BIN_ABORT the data is the SDO abort code (4 bytes),
+ *		on status COP_BIN_ERROR the DS-309/3 error code (2 bytes).
+ *
+ *
+ *	-----------  history  ---------------------------------------------------
+ *
+ *	$Log$
+ */
+
+#ifndef __COP_BIN_H
+#define __COP_BIN_H
+
+
+/*  -----------  includes  -------------------------------------------------
+ */
+
+#include "cop_tcp.h"					// Interfacing CANopen with TCP/IP
+
+
+/*  -----------  defines  --------------------------------------------------
+ */
+
+#define COP_BIN_MAGIC		0xB1		/* first byte of a binary connection */
+#define COP_BIN_DEFAULT		0xFF		/* net or node: default of the connection */
+
+#define COP_BIN_REQUEST		9			/* length of a request header */
+#define COP_BIN_RESPONSE	8			/* length of a response header */
+
+#define COP_BIN_UPLOAD		0x01		/* opcode: Upload SDO command */
+#define COP_BIN_DOWNLOAD	0x02		/* opcode: Download SDO command */
+#define COP_BIN_NMT			0x03		/* opcode: NMT command */
+#define COP_BIN_COMMAND		0x7F		/* opcode: any other DS-309/3 command */
+#define COP_BIN_EVENT		0x80		/* opcode: event notification */
+
+#define COP_BIN_OK			0x00		/* status: successful */
+#define COP_BIN_ABORT		0x01		/* status: SDO abort received */
+#define COP_BIN_ERROR		0x02		/* status: DS-309/3 error code */
+
+#define COP_BIN_INTEGER8		0x02	/* datatypes (CiA DS-301): */
+#define COP_BIN_INTEGER16		0x03
+#define COP_BIN_INTEGER32		0x04
+#define COP_BIN_UNSIGNED8		0x05
+#define COP_BIN_UNSIGNED16		0x06
+#define COP_BIN_UNSIGNED32		0x07
+#define COP_BIN_VISIBLE_STRING	0x09
+#define COP_BIN_OCTET_STRING	0x0A
+#define COP_BIN_TIME_OF_DAY		0x0C
+#define COP_BIN_TIME_DIFFERENCE	0x0D
+#define COP_BIN_DOMAIN			0x0F
+
+
+/*  -----------  types  ----------------------------------------------------
+ */
+
+
+/*  -----------  variables  ------------------------------------------------
+ */
+
+
+/*  -----------  prototypes  -----------------------------------------------
+ */
+
+int cop_bin_parse(BYTE *request, int length, COP_TCP_SETTINGS *settings, BYTE *response, int nbyte);
+/*
+ *	function  :  executes a binary request and writes the response frame.
+ *	             The response may be written over the request.
+ *
+ *	parameter :  request  - the request frame
+ *               length   - length of the request frame
+ *               settings - settings of the gateway (as for cop_tcp_parse)
+ *               response - buffer for the response frame
+ *               nbyte    - size of the buffer
+ *
+ *	result    :  length of the response frame, or 0 if the buffer is too
+ *	             small for a response header.
+ */
+
+int cop_bin_node(BYTE *request, int length, COP_TCP_SETTINGS *settings);
+/*
+ *	function  :  retrieves the node-id addressed by an Upload or Download
+ *	             SDO command (as cop_tcp_node for the ASCII Mapping).
+ *
+ *	parameter :  request  - the request frame
+ *               length   - length of the request frame
+ *               settings - settings of the gateway (default node-id)
+ *
+ *	result    :  node-id (1,..,127) of an SDO command, or 0 for any other
+ *	             request.
+ */
+
+int cop_bin_event(char *notification, BYTE *frame, int nbyte);
+/*
+ *	function  :  frames an event notification (e.g. of cop_tcp_notify)
+ *	             for a client with binary framing.
+ *
+ *	parameter :  notification - the event notification (text)
+ *               frame        - buffer for the frame
+ *               nbyte        - size of the buffer
+ *
+ *	result    :  length of the frame, or 0 if the buffer is too small.
+ */
+
+char* cop_bin_version();
+/*
+ *	function  :  retrieve RCS info of this module as a string.
+ *
+ *	parameter :  (none)
+ *
+ *	result    :  pointer to RCS info (zero-terminated string)
+ */
+
+
+#endif	// __COP_BIN_H
+
+/*  -------------------------------------------------------------------------
+ *	Uwe Vogt,  UV Software,  Steinaecker 28,  88048 Friedrichshafen,  Germany
+ *	Fon: +49-7541-6041530, Fax. +49-1803-551809359, Cell fon: +49-170-3801903
+ *	E-Mail: uwe.vogt@uv-software.de, Internet URL: http://www.uv-software.de/
+ */
@@ -0,0 +1,215 @@
+/*	-- $Header$ --
+ *
+ *	Projekt   :  CAN - Controller Area Network.
+ *
+ *	Zweck     :  CANopen Master CFG - Commissioning.
+ *
+ *	Copyright :  (c) 2005-2009 by UV Software, Friedrichshafen.
+ *
+ *	Compiler  :  GCC - GNU C Compiler (Linux Kernel 2.6)
+ *
+ *	Export    :  (siehe Header-Datei)
+ *
+ *	Include   :  cop_api.h (can_defs.h, windows.h), can_ctrl.h
+ *
+ *	Autor     :  Uwe Vogt, UV Software.
+ *
+ *	E-Mail    :  uwe.vogt@uv-software.de
+ *
+ *
+ *	-----------  Modulbeschreibung  ------------------------------------------
+ *
+ *	CANopen Master CFG - Commissioning.
+ *
+ *		Assigns node-ids and baudrates to a list of nodes identified by
+ *		their LSS address (CiA DSP-305) or LMT address (CiA DS-205).
+ *
+ *		Only one node can be in configuration mode at a time, so the
+ *		nodes are commissioned one after the other. The steps of a node
+ *		(switch mode selective, configure node-id, configure bit-timing,
+ *		store configuration) are sequenced without any idle time: each
+ *		step is started as soon as the confirmation of the previous one
+ *		is received, and the remaining steps of a node are skipped on the
+ *		first error. The result of each node is reported in the list.
+ *
+ *
+ *	-----------  nderungshistorie  ------------------------------------------
+ *
+ *	$Log$
+ */
+
+#ifdef _DEBUG
+ static char _id[] = "$Id: cop_cfg.c $ _DEBUG";
+#else
+ static char _id[] = "$Id: cop_cfg.c $";
+#endif
+
+/*	-----------  Include-Dateien  --------------------------------------------
+ */
+
+#include "cop_api.h"					// Interface prototypes
+#include "can_ctrl.h"					// CAN Controller interface
+
+#include <stdio.h>						// Standard I/O routines
+#include <errno.h>						// System wide error numbers
+#include <string.h>						// String manipulation functions
+#include <stdlib.h>						// Commonly used library functions
+#include <time.h>						// Time and date functions
+
+
+/*	-----------  Definitionen  -----------------------------------------------
+ */
+
+
+/*	-----------  Typen  ------------------------------------------------------
+ */
+
+
+/*	-----------  Prototypen  -------------------------------------------------
+ */
+
+static LONG cfg_lss_node(CFG_NODE *node);
+static LONG cfg_lmt_node(CFG_NODE *node);
+static DWORD cfg_clock(void);
+
+
+/*	-----------  Variablen  --------------------------------------------------
+ */
+
+extern __thread LONG cop_error;			// last error code (per thread)
+
+
+/*	-----------  Funktionen  -------------------------------------------------
+ */
+
+LONG cfg_commission(CFG_NODE *table, SHORT count, WORD timeout)
+{
+	WORD lss_last = 0, lmt_last = 0;	// old time-out values
+	DWORD start;						// start time [usec]
+	LONG n = 0;							// nodes commissioned
+	int i;								// table index
+
+	if(table == NULL)					// null pointer assignment?
+		return cop_error = COPERR_NULLPTR;
+	for(i = 0; i < count; i++) {		// check the list
+		if(table[i].node_id < 1 || 127 < table[i].node_id)
+			return cop_error = COPERR_NODE_ID;
+		if(table[i].protocol != CFG_LSS && table[i].protocol != CFG_LMT)
+			return cop_error = COPERR_ILLPARA;
+		if(table[i].baudrate > 8 && table[i].baudrate != CFG_KEEP)
+			return cop_error = COPERR_BAUDRATE;
+	}
+	if(timeout) {						// time-out for the confirmations
+		lss_last = lss_timeout(timeout);
+		lmt_last = lmt_timeout(timeout);
+	}
+	// 1. All nodes in operation mode
+	lss_switch_mode_global(LSS_OPERATION);
+
+	// 2. Commission the nodes one after the other
+	for(i = 0; i < count; i++) {
+		start = cfg_clock();
+		if(table[i].protocol == CFG_LSS)
+			table[i].result = cfg_lss_node(&table[i]);
+		else
+			table[i].result = cfg_lmt_node(&table[i]);
+		table[i].duration = cfg_clock() - start;
+		if(table[i].result == COPERR_NOERROR)
+			n++;
+	}
+	if(timeout) {						// restore the time-out values
+		lss_timeout(lss_last);
+		lmt_timeout(lmt_last);
+	}
+	cop_error = COPERR_NOERROR;
+	return n;
+}
+
+LPSTR cfg_version(void)
+{
+	return (LPSTR)_id;					// Revision number
+}
+
+/*	-----------  Lokale Funktionen  ------------------------------------------
+ */
+
+static LONG cfg_lss_node(CFG_NODE *node)
+{
+	LONG rc;							// return value
+
+	// 1. Switch the node to configuration mode
+	node->step = CFG_STEP_SELECT;
+	if((rc = lss_switch_mode_selective(node->vendor_id, node->product_code,
+	                                   node->revision_number, node->serial_number)) != COPERR_NOERROR)
+		return rc;						//   (no node in configuration mode)
+	// 2. Configure the node-id
+	node->step = CFG_STEP_NODE_ID;
+	if((rc = lss_configure_node_id(node->node_id)) == COPERR_NOERROR) {
+		// 3. Configure the baudrate (if required)
+		if(node->baudrate != CFG_KEEP) {
+			node->step = CFG_STEP_BIT_TIMING;
+			rc = lss_configure_bit_timing(node->baudrate);
+		}
+		// 4. Store the configuration (if required)
+		if(rc == COPERR_NOERROR && node->store) {
+			node->step = CFG_STEP_STORE;
+			rc = lss_store_configuration();
+		}
+	}
+	// 5. Switch the node back to operation mode (also on error)
+	if(lss_switch_mode_global(LSS_OPERATION) != COPERR_NOERROR && rc == COPERR_NOERROR) {
+		node->step = CFG_STEP_RELEASE;
+		rc = cop_error;
+	}
+	if(rc == COPERR_NOERROR)
+		node->step = CFG_STEP_NONE;
+	return rc;
+}
+
+static LONG cfg_lmt_node(CFG_NODE *node)
+{
+	LONG rc;							// return value
+
+	// 1. Switch the node to configuration mode (not confirmed)
+	node->step = CFG_STEP_SELECT;
+	if((rc = lmt_switch_mode_selective(node->manufacturer_name, node->product_name,
+	                                   node->lmt_serial_number)) != COPERR_NOERROR)
+		return rc;
+	// 2. Configure the node-id (first confirmation of the node)
+	node->step = CFG_STEP_NODE_ID;
+	if((rc = lmt_configure_node_id(node->node_id)) == COPERR_NOERROR) {
+		// 3. Configure the baudrate (if required)
+		if(node->baudrate != CFG_KEEP) {
+			node->step = CFG_STEP_BIT_TIMING;
+			rc = lmt_configure_bit_timing(0, node->baudrate);
+		}
+		// 4. Store the configuration (if required)
+		if(rc == COPERR_NOERROR && node->store) {
+			node->step = CFG_STEP_STORE;
+			rc = lmt_store_configuration();
+		}
+	}
+	// 5. Switch the node back to operation mode (also on error)
+	if(lmt_switch_mode_global(LMT_OPERATION) != COPERR_NOERROR && rc == COPERR_NOERROR) {
+		node->step = CFG_STEP_RELEASE;
+		rc = cop_error;
+	}
+	if(rc == COPERR_NOERROR)
+		node->step = CFG_STEP_NONE;
+	return rc;
+}
+
+static DWORD cfg_clock(void)
+{
+	struct timespec ts;					// monotonic time
+
+	// the commissioning of a node takes some milliseconds at most
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (DWORD)((unsigned long long)ts.tv_sec * 1000000ULL + (unsigned long long)(ts.tv_nsec / 1000));
+}
+
+/*	--------------------------------------------------------------------------
+ *	Uwe Vogt,  UV Software,  Steinaecker 28,  88048 Friedrichshafen,  Germany
+ *	Fon: +49-7541-6041530, Fax. +49-1803-551809359, Cell fon: +49-170-3801903
+ *	E-Mail: uwe.vogt@uv-software.de, Internet URL: http://www.uv-software.de/
+ */
@@ -0,0 +1,256 @@
+/*	-- $Header$ --
+ *
+ *	Projekt   :  CAN - Controller Area Network.
+ *
+ *	Zweck     :  CANopen Master EMCY - Emergency Object.
+ *
+ *	Copyright :  (c) 2005-2009 by UV Software, Friedrichshafen.
+ *
+ *	Compiler  :  GCC - GNU C Compiler (Linux Kernel 2.6)
+ *
+ *	Export    :  (siehe Header-Datei)
+ *
+ *	Include   :  cop_api.h (can_defs.h, windows.h), can_ctrl.h
+ *
+ *	Autor     :  Uwe Vogt, UV Software.
+ *
+ *	E-Mail    :  uwe.vogt@uv-software.de
+ *
+ *
+ *	-----------  Modulbeschreibung  ------------------------------------------
+ *
+ *	CANopen Master EMCY - Emergency Object.
+ *
+ *		Implements the EMCY consumer according to CiA DS-301 (Version 4.02
+ *		of February 13, 2002).
+ *
+ *		Emergency messages (COB-Id. 081h to 0FFh) are taken from the receive
+ *		hook of the CAN Controller interface and decoded into error code,
+ *		error register and manufacturer specific error field. The last
+ *		EMCY_HISTORY messages of each node are kept in a ring log.
+ *
+ *		All messages are also written into a notification ring. Every
+ *		subscriber has its own read position into this ring, so any
+ *		number of subscribers can read the messages independently; a
+ *		subscriber which does not keep up loses the oldest messages.
+ *		A subscriber which finds the ring empty reads the CAN messages
+ *		of the interface, so the messages arrive without other traffic.
+ *		While there are subscribers the messages are consumed, otherwise
+ *		they are passed on to the receive queue (as before).
+ *
+ *
+ *	-----------  nderungshistorie  ------------------------------------------
+ *
+ *	$Log$
+ */
+
+#ifdef _DEBUG
+ static char _id[] = "$Id: cop_emc.c $ _DEBUG";
+#else
+ static char _id[] = "$Id: cop_emc.c $";
+#endif
+
+/*	-----------  Include-Dateien  --------------------------------------------
+ */
+
+#include "cop_api.h"					// Interface prototypes
+#include "can_ctrl.h"					// CAN Controller interface
+
+#include <stdio.h>						// Standard I/O routines
+#include <errno.h>						// System wide error numbers
+#include <string.h>						// String manipulation functions
+#include <stdlib.h>						// Commonly used library functions
+#include <pthread.h>					// POSIX threads
+
+
+/*	-----------  Definitionen  -----------------------------------------------
+ */
+
+#define EMCY_NODES				128		// Node-id 1,..,127 (0 not used)
+#define EMCY_QUEUE				256		// Size of the notification ring
+#define EMCY_SUBSCRIBERS		16		// Max. number of subscribers
+
+
+/*	-----------  Typen  ------------------------------------------------------
+ */
+
+typedef struct _emcy_subscriber			// subscriber:
+{
+	BOOL  used;							//   handle is in use
+	BYTE  node_id;						//   node-id (0 = all nodes)
+	BOOL  overrun;						//   messages lost
+	DWORD position;						//   read position (sequence no.)
+}	EMCY_SUBSCRIBER;
+
+
+/*	-----------  Prototypen  -------------------------------------------------
+ */
+
+int  emcy_dispatch(long cob_id, short length, BYTE *data, DWORD time_stamp);
+void emcy_reset(void);
+
+
+/*	-----------  Variablen  --------------------------------------------------
+ */
+
+extern __thread LONG cop_error;			// last error code (per thread)
+static pthread_mutex_t emcy_mutex = PTHREAD_MUTEX_INITIALIZER;
+static EMCY_MESSAGE emcy_log[EMCY_NODES][EMCY_HISTORY];
+static BYTE  emcy_count[EMCY_NODES];	// number of logged messages
+static BYTE  emcy_index[EMCY_NODES];	// next entry of the ring log
+static EMCY_MESSAGE emcy_queue[EMCY_QUEUE];
+static DWORD emcy_sequence = 0;			// sequence no. of the next message
+static EMCY_SUBSCRIBER emcy_subscriber[EMCY_SUBSCRIBERS];
+static int   emcy_subscribers = 0;		// number of subscribers
+
+
+/*	-----------  Funktionen  -------------------------------------------------
+ */
+
+LONG emcy_subscribe(BYTE node_id)
+{
+	int i;								// handle
+
+	if(/*node_id < 0 ||*/ 127 < node_id)	// node-id: 1,..,127
+		return cop_error = COPERR_NODE_ID;	//  0 for all nodes
+
+	pthread_mutex_lock(&emcy_mutex);
+	for(i = 0; i < EMCY_SUBSCRIBERS; i++) {
+		if(!emcy_subscriber[i].used) {
+			emcy_subscriber[i].used = TRUE;
+			emcy_subscriber[i].node_id = node_id;
+			emcy_subscriber[i].overrun = FALSE;
+			emcy_subscriber[i].position = emcy_sequence;
+			emcy_subscribers++;
+			pthread_mutex_unlock(&emcy_mutex);
+			return (LONG)i;
+		}
+	}
+	pthread_mutex_unlock(&emcy_mutex);
+	return cop_error = COPERR_ILLPARA;	// no free handle
+}
+
+LONG emcy_unsubscribe(LONG handle)
+{
+	if(handle < 0 || EMCY_SUBSCRIBERS <= handle)
+		return cop_error = COPERR_ILLPARA;
+
+	pthread_mutex_lock(&emcy_mutex);
+	if(emcy_subscriber[handle].used) {
+		emcy_subscriber[handle].used = FALSE;
+		emcy_subscribers--;
+	}
+	pthread_mutex_unlock(&emcy_mutex);
+	return cop_error = COPERR_NOERROR;
+}
+
+LONG emcy_receive(LONG handle, EMCY_MESSAGE *emcy)
+{
+	EMCY_SUBSCRIBER *subscriber;		// the subscriber
+
+	if(handle < 0 || EMCY_SUBSCRIBERS <= handle)
+		return cop_error = COPERR_ILLPARA;
+	if(emcy == NULL)					// null pointer assignment?
+		return cop_error = COPERR_NULLPTR;
+
+	subscriber = &emcy_subscriber[handle];
+	// Read the CAN messages of the interface when the ring is empty
+	// (not under the lock: it is taken by the receive hook)
+	if(subscriber->used && subscriber->position == emcy_sequence)
+		can_poll();
+	pthread_mutex_lock(&emcy_mutex);
+	if(!subscriber->used) {				// not subscribed?
+		pthread_mutex_unlock(&emcy_mutex);
+		return cop_error = COPERR_ILLPARA;
+	}
+	if((emcy_sequence - subscriber->position) > EMCY_QUEUE) {
+		subscriber->position = emcy_sequence - EMCY_QUEUE;
+		subscriber->overrun = TRUE;		// oldest messages lost
+	}
+	if(subscriber->overrun) {			// report the overrun once
+		subscriber->overrun = FALSE;
+		pthread_mutex_unlock(&emcy_mutex);
+		return COPERR_QUE_OVR;
+	}
+	while(subscriber->position != emcy_sequence) {
+		memcpy(emcy, &emcy_queue[subscriber->position % EMCY_QUEUE], sizeof(EMCY_MESSAGE));
+		subscriber->position++;
+		if(!subscriber->node_id || subscriber->node_id == emcy->node_id) {
+			pthread_mutex_unlock(&emcy_mutex);
+			return COPERR_NOERROR;
+		}
+	}
+	pthread_mutex_unlock(&emcy_mutex);
+	return COPERR_RX_EMPTY;				// no message pending
+}
+
+LONG emcy_history(BYTE node_id, EMCY_MESSAGE *history, SHORT *count)
+{
+	int i, n;							// number of messages
+
+	if(node_id < 1 || 127 < node_id)	// node-id: 1,..,127
+		return cop_error = COPERR_NODE_ID;
+	if(history == NULL || count == NULL)// null pointer assignment?
+		return cop_error = COPERR_NULLPTR;
+
+	pthread_mutex_lock(&emcy_mutex);
+	n = (*count < emcy_count[node_id])? *count : emcy_count[node_id];
+	for(i = 0; i < n; i++)				// newest message first
+		memcpy(&history[i], &emcy_log[node_id][(emcy_index[node_id] + EMCY_HISTORY - 1 - i) % EMCY_HISTORY], sizeof(EMCY_MESSAGE));
+	pthread_mutex_unlock(&emcy_mutex);
+	*count = (SHORT)(n > 0? n : 0);
+	return cop_error = COPERR_NOERROR;
+}
+
+LPSTR emcy_version(void)
+{
+	return (LPSTR)_id;					// Revision number
+}
+
+int emcy_dispatch(long cob_id, short length, BYTE *data, DWORD time_stamp)
+{
+	BYTE node_id = (BYTE)(cob_id - EMCY_COB_ID);
+	EMCY_MESSAGE *emcy;					// the message
+	int consumed;						// there are subscribers
+
+	if(cob_id <= EMCY_COB_ID || (EMCY_COB_ID + 127) < cob_id || length < 3)
+		return 0;						// not an emergency message
+
+	// Called from the receive hook of the CAN Controller interface
+	pthread_mutex_lock(&emcy_mutex);
+	emcy = &emcy_log[node_id][emcy_index[node_id]];
+	emcy->node_id = node_id;
+	emcy->error_code = (WORD)data[0] | ((WORD)data[1] << 8);
+	emcy->error_register = data[2];
+	memset(emcy->manufacturer, 0x00, 5);
+	memcpy(emcy->manufacturer, &data[3], length - 3);
+	emcy->time_stamp = time_stamp;
+	emcy_index[node_id] = (emcy_index[node_id] + 1) % EMCY_HISTORY;
+	if(emcy_count[node_id] < EMCY_HISTORY)
+		emcy_count[node_id]++;
+	// Notify all subscribers
+	memcpy(&emcy_queue[emcy_sequence % EMCY_QUEUE], emcy, sizeof(EMCY_MESSAGE));
+	emcy_sequence++;
+	// Consumed only for the subscribers (as error control messages for
+	// the monitored nodes), otherwise it reaches the receive queue
+	consumed = (emcy_subscribers > 0)? 1 : 0;
+	pthread_mutex_unlock(&emcy_mutex);
+	return consumed;
+}
+
+void emcy_reset(void)
+{
+	// Clear the ring logs and all subscriptions
+	pthread_mutex_lock(&emcy_mutex);
+	memset(emcy_count, 0, sizeof(emcy_count));
+	memset(emcy_index, 0, sizeof(emcy_index));
+	memset(emcy_subscriber, 0, sizeof(emcy_subscriber));
+	emcy_subscribers = 0;
+	pthread_mutex_unlock(&emcy_mutex);
+}
+
+/*	--------------------------------------------------------------------------
+ *	Uwe Vogt,  UV Software,  Steinaecker 28,  88048 Friedrichshafen,  Germany
+ *	Fon: +49-7541-6041530, Fax. +49-1803-551809359, Cell fon: +49-170-3801903
+ *	E-Mail: uwe.vogt@uv-software.de, Internet URL: http://www.uv-software.de/
+ */
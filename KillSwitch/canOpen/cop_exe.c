@@ -0,0 +1,273 @@
+/*	-- $Header$ --
+ *
+ *	projekt   :  CAN - Controller Area Network.
+ *
+ *	purpose   :  Execution of DS-309/3 command files.
+ *
+ *	copyright :  (C) 2009, UV Software, Friedrichshafen.
+ *
+ *	compiler  :  GCC - GNU C Compiler (Linux Kernel 2.6)
+ *
+ *	export    :  (see header file)
+ *
+ *	includes  :  cop_exe.h (cop_tcp.h, default.h), cop_srv.h, can_defs.h, cop_api.h
+ *
+ *	author    :  Uwe Vogt, UV Software, Friedrichshafen
+ *
+ *	e-mail    :  uwe.vogt@uv-software.de
+ *
+ *
+ *	-----------  description  -----------------------------------------------
+ *
+ *	CANopen Master - Batch Mode for the ASCII Mapping (DS-309/3).
+ *
+ *	The commands of the file are scheduled by the gateway server as a batch
+ *	(cop_srv_batch): the lines are read as its queue has room, and the
+ *	responses are taken in the order of the file, with the node-id of each
+ *	command as it was taken when the command was started (so a "set node"
+ *	before it is regarded). The rounds are counted from these node-ids.
+ *
+ *	The workers of the server are started for the file, so a command file
+ *	is executed in local mode only; while the gateway server is running,
+ *	a command file is refused (not even opened), since its path comes from
+ *	a client.
+ *
+ *
+ *	-----------  history  ---------------------------------------------------
+ *
+ *	$Log$
+ */
+
+static char _id[] = "$Id: cop_exe.c $";
+
+
+/*  -----------  includes  -------------------------------------------------
+ */
+
+#include "cop_exe.h"
+#include "cop_srv.h"
+
+#include "can_defs.h"
+#include "cop_api.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+/*  -----------  defines  --------------------------------------------------
+ */
+
+#define COP_EXE_LENGTH		(COP_SRV_LENGTH-1)/* max. length of a command line */
+#define COP_EXE_WORKERS		SDO_CHANNELS/* max. concurrent SDO commands */
+
+#define ERROR_SYNTAX		101			/* error code of DS-309/3 */
+
+#define WHITESPACE(x)		(' ' == (x) || (x) == '\t')
+
+
+/*  -----------  types  ----------------------------------------------------
+ */
+
+typedef struct _batch {					/* command file being executed: */
+	FILE *file;							/*   the file */
+	unsigned long number;				/*   its last line read */
+	FILE *output;						/*   responses (or NULL) */
+	COP_EXE_SUMMARY *summary;			/*   summary of the file */
+}	BATCH;
+
+
+/*  -----------  prototypes  -----------------------------------------------
+ */
+
+static int  exe_read(FILE *file, char *text, int size, unsigned long *number, int *result);
+static int  exe_source(void *context, COP_SRV_REQUEST *request);
+static void exe_sink(void *context, COP_SRV_REQUEST *request);
+static void exe_output(char *text, int result, unsigned long number, FILE *output, COP_EXE_SUMMARY *summary);
+static void exe_round(COP_EXE_SUMMARY *summary, int node);
+static unsigned long exe_steps(void);
+
+
+/*  -----------  variables  ------------------------------------------------
+ */
+
+static int executing = 0;				/* a command file is executed */
+
+static unsigned long steps[128];		/* SDO commands to each node, */
+static unsigned long sdo_count = 0;		/*   all SDO commands, and */
+static unsigned long sdo_max = 0;		/*   the most to one node since the last other command */
+
+
+/*  -----------  functions  ------------------------------------------------
+ */
+
+int cop_exe_file(char *filename, COP_TCP_SETTINGS *settings, int check, COP_EXE_SUMMARY *summary)
+{
+	COP_TCP_SETTINGS copy;
+	struct timespec t0, t1;
+	char text[COP_EXE_LENGTH];
+	unsigned long number = 0;
+	BATCH batch;
+	FILE *file;
+	int result;
+
+	if(!filename || !settings || !summary)
+		return -1;
+	/* not for the clients of the gateway server */
+	if(cop_srv_serving())
+		return -2;
+	/* one command file at a time (e.g. no "exec" within a command file) */
+	if(!__sync_bool_compare_and_swap(&executing, 0, 1))
+		return -1;
+	if(!(file = fopen(filename, "r"))) {
+		executing = 0;
+		return -1;
+	}
+	memset(summary, 0, sizeof(COP_EXE_SUMMARY));
+	memset(steps, 0, sizeof(steps));
+	sdo_count = sdo_max = 0;
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	if(check) {
+		/* parse the commands one by one (they change a copy of the settings) */
+		memcpy(&copy, settings, sizeof(COP_TCP_SETTINGS));
+		while(exe_read(file, text, COP_EXE_LENGTH, &number, &result)) {
+			if(!result) {
+				exe_round(summary, cop_tcp_node(text, &copy));
+				result = cop_tcp_check(text, &copy, text, COP_EXE_LENGTH);
+			}
+			exe_output(text, result, number, settings->output, summary);
+		}
+	}
+	else {
+		/* the commands are scheduled by the gateway server */
+		batch.file = file;
+		batch.number = 0;
+		batch.output = settings->output;
+		batch.summary = summary;
+		if(cop_srv_batch(settings, exe_source, exe_sink, &batch) < 0) {
+			fclose(file);
+			executing = 0;
+			return -1;
+		}
+	}
+	fclose(file);
+	summary->rounds += exe_steps();
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	summary->elapsed = (unsigned long)(((long long)(t1.tv_sec - t0.tv_sec) * 1000LL) + ((long long)(t1.tv_nsec - t0.tv_nsec) / 1000000LL));
+	executing = 0;
+	return 0;
+}
+
+char* cop_exe_version()
+{
+	return (char*)_id;
+}
+
+/*  -----------  local functions  ------------------------------------------
+ */
+
+static int exe_read(FILE *file, char *text, int size, unsigned long *number, int *result)
+{
+	char buffer[COP_EXE_LENGTH];
+	int quoted, chr, n, i;
+
+	if(size > COP_EXE_LENGTH)
+		size = COP_EXE_LENGTH;
+	while(fgets(buffer, size, file)) {
+		*number += 1;
+		*result = 0;
+		/* a line longer than a command is a syntax error (the rest is skipped) */
+		if((n = (int)strlen(buffer)) > 0 && buffer[n-1] != '\n' && !feof(file)) {
+			while((chr = fgetc(file)) != EOF && chr != '\n')
+				;
+			snprintf(text, size, "[%lu] Error: %i\r\n", *number, ERROR_SYNTAX);
+			*result = ERROR_SYNTAX;
+			return 1;
+		}
+		/* cut off the comment (a '#' not within a visible string) and the line end */
+		for(quoted = 0, i = 0; buffer[i] && buffer[i] != '\r' && buffer[i] != '\n'; i++) {
+			if(buffer[i] == '\"')
+				quoted = !quoted;
+			else if(buffer[i] == '#' && !quoted)
+				break;
+		}
+		buffer[i] = '\0';
+		/* skip an empty line */
+		for(i = 0; WHITESPACE(buffer[i]); i++)
+			;
+		if(!buffer[i])
+			continue;
+		/* a command without a sequence number is numbered by its line */
+		if(buffer[i] == '[')
+			strcpy(text, &buffer[i]);
+		else if(snprintf(text, size, "[%lu] %s", *number, &buffer[i]) >= size) {
+			snprintf(text, size, "[%lu] Error: %i\r\n", *number, ERROR_SYNTAX);
+			*result = ERROR_SYNTAX;
+		}
+		return 1;
+	}
+	return 0;
+}
+
+static int exe_source(void *context, COP_SRV_REQUEST *request)
+{
+	BATCH *batch = (BATCH*)context;
+
+	/* the next command of the file, tagged with its line */
+	if(!exe_read(batch->file, request->text, request->size, &batch->number, &request->result))
+		return 0;
+	request->tag = batch->number;
+	return 1;
+}
+
+static void exe_sink(void *context, COP_SRV_REQUEST *request)
+{
+	BATCH *batch = (BATCH*)context;
+
+	/* a command that was not executed takes no step */
+	if(request->node >= 0)
+		exe_round(batch->summary, request->node);
+	exe_output(request->text, request->result, request->tag, batch->output, batch->summary);
+}
+
+static void exe_output(char *text, int result, unsigned long number, FILE *output, COP_EXE_SUMMARY *summary)
+{
+	summary->requests++;
+	if(result) {
+		summary->errors++;
+		if(!summary->line)
+			summary->line = number;
+	}
+	if(output)
+		fputs(text, output);
+}
+
+static void exe_round(COP_EXE_SUMMARY *summary, int node)
+{
+	if(1 <= node && node <= 127) {
+		/* the SDO commands to different nodes overlap */
+		sdo_count++;
+		if(++steps[node] > sdo_max)
+			sdo_max = steps[node];
+	}
+	else {
+		/* any other command follows the commands before */
+		summary->rounds += exe_steps() + 1;
+		memset(steps, 0, sizeof(steps));
+		sdo_count = sdo_max = 0;
+	}
+}
+
+static unsigned long exe_steps(void)
+{
+	unsigned long n = (sdo_count + COP_EXE_WORKERS - 1) / COP_EXE_WORKERS;
+
+	return (n > sdo_max)? n : sdo_max;
+}
+
+/*  -------------------------------------------------------------------------
+ *	Uwe Vogt,  UV Software,  Steinaecker 28,  88048 Friedrichshafen,  Germany
+ *	Fon: +49-7541-6041530, Fax. +49-1803-551809359, Cell fon: +49-170-3801903
+ *	E-Mail: uwe.vogt@uv-software.de, Internet URL: http://www.uv-software.de/
+ */
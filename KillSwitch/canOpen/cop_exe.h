@@ -0,0 +1,119 @@
+/*	-- $Header$ --
+ *
+ *	projekt   :  CAN - Controller Area Network.
+ *
+ *	purpose   :  Execution of DS-309/3 command files.
+ *
+ *	copyright :  (C) 2009, UV Software, Friedrichshafen.
+ *
+ *	compiler  :  GCC - GNU C Compiler (Linux Kernel 2.6)
+ *
+ *	export    :  <export>
+ *
+ *	includes  :  cop_tcp.h (default.h)
+ *
+ *	author    :  Uwe Vogt, UV Software, Friedrichshafen
+ *
+ *	e-mail    :  uwe.vogt@uv-software.de
+ *
+ *
+ *	-----------  description  -----------------------------------------------
+ *
+ *	CANopen Master - Batch Mode for the ASCII Mapping (DS-309/3).
+ *
+ *		Executes a file of DS-309/3 commands (one per line) as if they
+ *		were entered one after the other, e.g. the object writes of a
+ *		commissioning script. A '#' starts a comment until the end of
+ *		the line (not within a visible string); empty lines are skipped,
+ *		and a line without a '['<sequence>']' is numbered by its line.
+ *
+ *		The commands are scheduled by the gateway server (cop_srv.h):
+ *		the SDO commands to different nodes are executed concurrently,
+ *		the SDO commands to the same node in the order of the file. Any
+ *		other command waits until all commands before it are finished,
+ *		and the commands behind it wait for it. The responses are
+ *		written in the order of the file.
+ *
+ *		A command file is executed in local mode only; the clients of
+ *		the gateway server cannot execute (or check) a command file.
+ *
+ *		In check mode the commands are only parsed (cop_tcp_check), so
+ *		a file can be verified without accessing the CANopen network.
+ *
+ *
+ *	-----------  history  ---------------------------------------------------
+ *
+ *	$Log$
+ */
+
+#ifndef __COP_EXE_H
+#define __COP_EXE_H
+
+
+/*  -----------  includes  -------------------------------------------------
+ */
+
+#include "cop_tcp.h"					// Interfacing CANopen with TCP/IP
+
+
+/*  -----------  defines  --------------------------------------------------
+ */
+
+
+/*  -----------  types  ----------------------------------------------------
+ */
+
+typedef struct _cop_exe_summary			/* summary of a command file: */
+{
+	unsigned long requests;				/*   executed (or checked) commands */
+	unsigned long errors;				/*   commands with an error or abort */
+	unsigned long line;					/*   line of the first error (or 0) */
+	unsigned long rounds;				/*   min. number of consecutive steps */
+	unsigned long elapsed;				/*   execution time [msec] */
+}	COP_EXE_SUMMARY;
+
+
+/*  -----------  variables  ------------------------------------------------
+ */
+
+
+/*  -----------  prototypes  -----------------------------------------------
+ */
+
+int cop_exe_file(char *filename, COP_TCP_SETTINGS *settings, int check, COP_EXE_SUMMARY *summary);
+/*
+ *	function  :  executes (or checks) a command file. The responses are
+ *	             written to settings->output (if not NULL). The settings
+ *	             are changed by the commands of the file as by commands
+ *	             entered one by one (not in check mode).
+ *	             The number of rounds is the least number of consecutive
+ *	             steps of the file, if every command takes one step and
+ *	             the SDO commands to different nodes overlap.
+ *
+ *	parameter :  filename - name of the command file
+ *               settings - settings of the gateway (as for cop_tcp_parse)
+ *               check    - only parse the commands (dry run)
+ *               summary  - pointer to a buffer for the summary
+ *
+ *	result    :  0 if successful (even if commands failed), -2 while the
+ *	             gateway server is running, or -1 if the file cannot be
+ *	             opened, or a command file is already being executed.
+ */
+
+char* cop_exe_version();
+/*
+ *	function  :  retrieve RCS info of this module as a string.
+ *
+ *	parameter :  (none)
+ *
+ *	result    :  pointer to RCS info (zero-terminated string)
+ */
+
+
+#endif	// __COP_EXE_H
+
+/*  -------------------------------------------------------------------------
+ *	Uwe Vogt,  UV Software,  Steinaecker 28,  88048 Friedrichshafen,  Germany
+ *	Fon: +49-7541-6041530, Fax. +49-1803-551809359, Cell fon: +49-170-3801903
+ *	E-Mail: uwe.vogt@uv-software.de, Internet URL: http://www.uv-software.de/
+ */
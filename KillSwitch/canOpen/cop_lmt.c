@@ -112,7 +112,7 @@
  */
 
 extern BYTE cop_baudrate;				// actual baudrate
-extern LONG cop_error;					// last error code
+extern __thread LONG cop_error;			// last error code (per thread)
 extern BYTE cop_buffer[8];				// data buffer (8)
 static WORD cop_timeout = LMT_TIMEOUT;	// time-out value
 
@@ -41,6 +41,7 @@
  *		IDENTIFICATION PROTOCOLS
  *		- Identify Remote Slaves
  *		- Identify Non-configured Remote Slaves
+ *		- LSS Fastscan (CiA 305 Version 2.2)
  *
  *
  *	-----------  nderungshistorie  ------------------------------------------
@@ -110,12 +111,13 @@
 /*	-----------  Prototypen  -------------------------------------------------
  */
 
+static long lss_fastscan_request(DWORD id_number, BYTE bit_checked, BYTE lss_sub, BYTE lss_next, WORD timeout);
 
 /*	-----------  Variablen  --------------------------------------------------
  */
 
 extern BYTE cop_baudrate;				// actual baudrate
-extern LONG cop_error;					// last error code
+extern __thread LONG cop_error;			// last error code (per thread)
 extern BYTE cop_buffer[8];				// data buffer (8)
 static WORD cop_timeout = LSS_TIMEOUT;	// time-out value
 
@@ -780,6 +782,46 @@ long lss_identify_non_configured_remote_slaves(void)
 	return cop_error = cop_transmit(LSS_MASTER, 8, cop_buffer);
 }
 
+long lss_fastscan(DWORD *vendor_id, DWORD *product_code, DWORD *revision_number, DWORD *serial_number, BYTE known, WORD timeout)
+{
+	DWORD *lss_address[4];				// LSS address (4 parts)
+	DWORD id_number;					// part of the LSS address
+	BYTE  lss_sub;						// part to be scanned
+	int   bit;							// bit to be checked
+	
+	if(vendor_id == NULL || product_code == NULL ||
+	   revision_number == NULL || serial_number == NULL)
+		return cop_error = COPERR_NULLPTR;
+	lss_address[0] = vendor_id;
+	lss_address[1] = product_code;
+	lss_address[2] = revision_number;
+	lss_address[3] = serial_number;
+	if(timeout == 0)					// default time-out value
+		timeout = LSS_FASTSCAN_TIMEOUT;
+	
+	// 1. Reset the Fastscan of all non-configured slaves (any there?)
+	if((cop_error = lss_fastscan_request(0, 0x80, 0, 0, timeout)) != COPERR_NOERROR)
+		return cop_error;
+	// 2. Scan the LSS address part by part
+	for(lss_sub = 0; lss_sub < 4; lss_sub++) {
+		if(!(known & (1 << lss_sub))) {
+			// Binary search: a slave answers if the bits 31,..,bit match
+			for(id_number = 0, bit = 31; bit >= 0; bit--) {
+				if((cop_error = lss_fastscan_request(id_number, (BYTE)bit, lss_sub, lss_sub, timeout)) == COPERR_TIMEOUT)
+					id_number |= (DWORD)1 << bit;	// no slave with bit = 0
+				else if(cop_error != COPERR_NOERROR)
+					return cop_error;
+			}
+			*lss_address[lss_sub] = id_number;
+		}
+		// Confirm the part and proceed with the next one (after the
+		// serial-number the slave is switched to configuration mode)
+		if((cop_error = lss_fastscan_request(*lss_address[lss_sub], 0, lss_sub, (BYTE)((lss_sub + 1) % 4), timeout)) != COPERR_NOERROR)
+			return cop_error;
+	}
+	return cop_error = COPERR_NOERROR;
+}
+
 WORD lss_timeout(WORD milliseconds)
 {
 	WORD last_value = cop_timeout;		// copy old time-out value
@@ -792,6 +834,66 @@ LPSTR lss_version(void)
 	return (LPSTR)_id;					// Revision number
 }
 
+/*	-----------  Lokale Funktionen  ------------------------------------------
+ */
+
+static long lss_fastscan_request(DWORD id_number, BYTE bit_checked, BYTE lss_sub, BYTE lss_next, WORD timeout)
+{
+	short length;						// data length code
+	
+	// ---  LSS Fastscan  ---
+	cop_buffer[0] = (BYTE)0x51;			// command specifier
+	cop_buffer[1] = LOLOBYTE(id_number);// id-number (LSB)
+	cop_buffer[2] = LOHIBYTE(id_number);//  -"-
+	cop_buffer[3] = HILOBYTE(id_number);//  -"-
+	cop_buffer[4] = HIHIBYTE(id_number);// id-number (MSB)
+	cop_buffer[5] = (BYTE)bit_checked;	// bit checked
+	cop_buffer[6] = (BYTE)lss_sub;		// LSS sub (part of the LSS address)
+	cop_buffer[7] = (BYTE)lss_next;		// LSS next
+
+	// 1. Configure transmit message object for LSS master
+	if((cop_error = can_config(CANBUF_TX, LSS_MASTER, CANMSG_TRANSMIT)) != CANERR_NOERROR) {
+		can_delete(CANBUF_TX);
+		return cop_error;
+	}
+	// 2. Configure receive message object for LSS slave (discards late answers)
+	if((cop_error = can_config(CANBUF_RX, LSS_SLAVE, CANMSG_RECEIVE)) != CANERR_NOERROR) {
+		can_delete(CANBUF_TX);
+		can_delete(CANBUF_RX);
+		return cop_error;
+	}
+	// 2. Transmit the LSS master message
+	if((cop_error = can_transmit(CANBUF_TX, 8, cop_buffer)) != CANERR_NOERROR) {
+		can_delete(CANBUF_TX);
+		can_delete(CANBUF_RX);
+		return cop_error;
+	}
+	// 3. Start timer for LSS time-out
+	can_start_timer(timeout);
+
+	// 4. Wait until any slave answers (Identify slave)
+	do	{
+		if((cop_error = can_receive(CANBUF_RX, &length, cop_buffer)) == COPERR_NOERROR)
+		{
+			if(length == 8 && cop_buffer[0] == 0x4F) {
+				can_delete(CANBUF_TX);
+				can_delete(CANBUF_RX);
+				return cop_error;
+			}
+		}
+		else if(cop_error != COPERR_RX_EMPTY)
+		{
+			can_delete(CANBUF_TX);
+			can_delete(CANBUF_RX);
+			return cop_error;
+		}
+	}	while(!can_is_timeout());
+	// 4. A time-out occurred (no slave answered)
+	can_delete(CANBUF_TX);
+	can_delete(CANBUF_RX);
+	return cop_error = COPERR_TIMEOUT;
+}
+
 /*	--------------------------------------------------------------------------
  *	Uwe Vogt, UV Software, Muellerstrasse 12e, 88045 Friedrichshafen, Germany
  *	Fon: +49-7541-6047-470, Fax: +49-69-7912-33292, Cell fon: +49-170-3801903
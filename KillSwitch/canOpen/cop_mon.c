@@ -0,0 +1,263 @@
+/*	-- $Header$ --
+ *
+ *	Projekt   :  CAN - Controller Area Network.
+ *
+ *	Zweck     :  CANopen Master MON - Message Monitor.
+ *
+ *	Copyright :  (c) 2005-2009 by UV Software, Friedrichshafen.
+ *
+ *	Compiler  :  GCC - GNU C Compiler (Linux Kernel 2.6)
+ *
+ *	Export    :  (siehe Header-Datei)
+ *
+ *	Include   :  cop_api.h (can_defs.h, windows.h), can_ctrl.h
+ *
+ *	Autor     :  Uwe Vogt, UV Software.
+ *
+ *	E-Mail    :  uwe.vogt@uv-software.de
+ *
+ *
+ *	-----------  Modulbeschreibung  ------------------------------------------
+ *
+ *	CANopen Master MON - Message Monitor.
+ *
+ *		Every received CAN message (11-bit identifier, data frame) is taken
+ *		from the receive hook of the CAN Controller interface before it is
+ *		dispatched to the CANopen services; the message is not consumed.
+ *
+ *		Every subscriber has a filter (COB-Id. range and mask, minimal
+ *		interval per COB-Id.) and its own receive ring, so a subscriber of
+ *		a few COB-Ids. does not lose its messages on a busy bus. A message
+ *		which passes the filter is written into the ring; a subscriber
+ *		which does not keep up loses the oldest messages. The messages
+ *		dropped by the rate limit and on overrun are counted.
+ *
+ *		As long as there is no subscriber, the receive hook returns at
+ *		once (without taking the lock).
+ *
+ *
+ *	-----------  nderungshistorie  ------------------------------------------
+ *
+ *	$Log$
+ */
+
+#ifdef _DEBUG
+ static char _id[] = "$Id: cop_mon.c $ _DEBUG";
+#else
+ static char _id[] = "$Id: cop_mon.c $";
+#endif
+
+/*	-----------  Include-Dateien  --------------------------------------------
+ */
+
+#include "cop_api.h"					// Interface prototypes
+#include "can_ctrl.h"					// CAN Controller interface
+
+#include <stdio.h>						// Standard I/O routines
+#include <errno.h>						// System wide error numbers
+#include <string.h>						// String manipulation functions
+#include <stdlib.h>						// Commonly used library functions
+#include <pthread.h>					// POSIX threads
+
+
+/*	-----------  Definitionen  -----------------------------------------------
+ */
+
+#define MON_IDENTIFIERS			2048	// 11-bit identifiers
+
+
+/*	-----------  Typen  ------------------------------------------------------
+ */
+
+typedef struct _mon_subscriber			// subscriber:
+{
+	BOOL  used;							//   handle is in use
+	MON_FILTER filter;					//   message filter
+	MON_STATISTICS statistics;			//   counters of the subscription
+	DWORD head;							//   write position (sequence no.)
+	DWORD tail;							//   read position (sequence no.)
+	BYTE  passed[MON_IDENTIFIERS/8];	//   COB-Id. has passed the filter
+	DWORD last[MON_IDENTIFIERS];		//   time-stamp of its last message
+	MON_MESSAGE queue[MON_QUEUE];		//   receive ring
+}	MON_SUBSCRIBER;
+
+
+/*	-----------  Prototypen  -------------------------------------------------
+ */
+
+int  mon_dispatch(long cob_id, short length, BYTE *data, DWORD time_stamp);
+void mon_reset(void);
+
+
+/*	-----------  Variablen  --------------------------------------------------
+ */
+
+extern __thread LONG cop_error;			// last error code (per thread)
+static pthread_mutex_t mon_mutex = PTHREAD_MUTEX_INITIALIZER;
+static MON_SUBSCRIBER mon_subscriber[MON_SUBSCRIBERS];
+static volatile int mon_count = 0;		// number of subscribers
+
+
+/*	-----------  Funktionen  -------------------------------------------------
+ */
+
+LONG mon_subscribe(MON_FILTER *filter)
+{
+	MON_SUBSCRIBER *subscriber;			// the subscriber
+	int i;								// handle
+
+	if(filter == NULL)					// null pointer assignment?
+		return cop_error = COPERR_NULLPTR;
+	if(filter->first < 0x000 || 0x7FF < filter->last || filter->last < filter->first ||
+	   filter->mask < 0x000 || 0x7FF < filter->mask)
+		return cop_error = COPERR_ILLPARA;	// 11-bit identifiers only
+
+	pthread_mutex_lock(&mon_mutex);
+	for(i = 0; i < MON_SUBSCRIBERS; i++) {
+		subscriber = &mon_subscriber[i];
+		if(!subscriber->used) {
+			memcpy(&subscriber->filter, filter, sizeof(MON_FILTER));
+			memset(&subscriber->statistics, 0, sizeof(MON_STATISTICS));
+			memset(subscriber->passed, 0, sizeof(subscriber->passed));
+			subscriber->head = subscriber->tail = 0;
+			subscriber->used = TRUE;
+			mon_count++;
+			pthread_mutex_unlock(&mon_mutex);
+			return (LONG)i;
+		}
+	}
+	pthread_mutex_unlock(&mon_mutex);
+	return cop_error = COPERR_ILLPARA;	// no free handle
+}
+
+LONG mon_unsubscribe(LONG handle)
+{
+	if(handle < 0 || MON_SUBSCRIBERS <= handle)
+		return cop_error = COPERR_ILLPARA;
+
+	pthread_mutex_lock(&mon_mutex);
+	if(mon_subscriber[handle].used) {
+		mon_subscriber[handle].used = FALSE;
+		mon_count--;
+	}
+	pthread_mutex_unlock(&mon_mutex);
+	return cop_error = COPERR_NOERROR;
+}
+
+LONG mon_receive(LONG handle, MON_MESSAGE *message)
+{
+	MON_SUBSCRIBER *subscriber;			// the subscriber
+
+	if(handle < 0 || MON_SUBSCRIBERS <= handle)
+		return cop_error = COPERR_ILLPARA;
+	if(message == NULL)					// null pointer assignment?
+		return cop_error = COPERR_NULLPTR;
+
+	subscriber = &mon_subscriber[handle];
+	// Read the CAN messages of the interface when the ring is empty
+	// (not under the lock: it is taken by the receive hook)
+	if(subscriber->used && subscriber->tail == subscriber->head)
+		can_poll();
+	pthread_mutex_lock(&mon_mutex);
+	if(!subscriber->used) {				// not subscribed?
+		pthread_mutex_unlock(&mon_mutex);
+		return cop_error = COPERR_ILLPARA;
+	}
+	if(subscriber->tail == subscriber->head) {
+		pthread_mutex_unlock(&mon_mutex);
+		return COPERR_RX_EMPTY;			// no message pending
+	}
+	memcpy(message, &subscriber->queue[subscriber->tail % MON_QUEUE], sizeof(MON_MESSAGE));
+	subscriber->tail++;
+	pthread_mutex_unlock(&mon_mutex);
+	return COPERR_NOERROR;
+}
+
+LONG mon_statistics(LONG handle, MON_STATISTICS *statistics, BOOL reset)
+{
+	if(handle < 0 || MON_SUBSCRIBERS <= handle)
+		return cop_error = COPERR_ILLPARA;
+	if(statistics == NULL)				// null pointer assignment?
+		return cop_error = COPERR_NULLPTR;
+
+	pthread_mutex_lock(&mon_mutex);
+	if(!mon_subscriber[handle].used) {	// not subscribed?
+		pthread_mutex_unlock(&mon_mutex);
+		return cop_error = COPERR_ILLPARA;
+	}
+	memcpy(statistics, &mon_subscriber[handle].statistics, sizeof(MON_STATISTICS));
+	if(reset)
+		memset(&mon_subscriber[handle].statistics, 0, sizeof(MON_STATISTICS));
+	pthread_mutex_unlock(&mon_mutex);
+	return cop_error = COPERR_NOERROR;
+}
+
+LPSTR mon_version(void)
+{
+	return (LPSTR)_id;					// Revision number
+}
+
+int mon_dispatch(long cob_id, short length, BYTE *data, DWORD time_stamp)
+{
+	MON_SUBSCRIBER *subscriber;			// the subscriber
+	MON_MESSAGE *message;				// the message
+	long masked;						// COB-Id. ANDed with the mask
+	int i;								// handle
+
+	if(!mon_count)						// no subscriber
+		return 0;
+	if(cob_id < 0x000 || 0x7FF < cob_id)
+		return 0;
+
+	// Called from the receive hook of the CAN Controller interface
+	pthread_mutex_lock(&mon_mutex);
+	for(i = 0; i < MON_SUBSCRIBERS; i++) {
+		subscriber = &mon_subscriber[i];
+		if(!subscriber->used)
+			continue;
+		masked = cob_id & subscriber->filter.mask;
+		if(masked < (subscriber->filter.first & subscriber->filter.mask) ||
+		   (subscriber->filter.last & subscriber->filter.mask) < masked)
+			continue;
+		if(subscriber->filter.interval) {
+			if((subscriber->passed[cob_id >> 3] & (1 << (cob_id & 7))) &&
+			   (time_stamp - subscriber->last[cob_id]) < (DWORD)subscriber->filter.interval) {
+				subscriber->statistics.throttled++;
+				continue;				//   rate limit
+			}
+			subscriber->passed[cob_id >> 3] |= (BYTE)(1 << (cob_id & 7));
+			subscriber->last[cob_id] = time_stamp;
+		}
+		if((subscriber->head - subscriber->tail) >= MON_QUEUE) {
+			subscriber->tail++;			//   oldest message lost
+			subscriber->statistics.lost++;
+		}
+		message = &subscriber->queue[subscriber->head % MON_QUEUE];
+		message->cob_id = (LONG)cob_id;
+		message->length = (length < 8)? length : 8;
+		memcpy(message->data, data, message->length);
+		message->time_stamp = time_stamp;
+		subscriber->head++;
+		subscriber->statistics.received++;
+	}
+	pthread_mutex_unlock(&mon_mutex);
+	return 0;							// the message is not consumed
+}
+
+void mon_reset(void)
+{
+	int i;								// handle
+
+	// Cancel all subscriptions
+	pthread_mutex_lock(&mon_mutex);
+	for(i = 0; i < MON_SUBSCRIBERS; i++)
+		mon_subscriber[i].used = FALSE;
+	mon_count = 0;
+	pthread_mutex_unlock(&mon_mutex);
+}
+
+/*	--------------------------------------------------------------------------
+ *	Uwe Vogt,  UV Software,  Steinaecker 28,  88048 Friedrichshafen,  Germany
+ *	Fon: +49-7541-6041530, Fax. +49-1803-551809359, Cell fon: +49-170-3801903
+ *	E-Mail: uwe.vogt@uv-software.de, Internet URL: http://www.uv-software.de/
+ */
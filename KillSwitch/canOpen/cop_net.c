@@ -0,0 +1,817 @@
+/*	-- $Header$ --
+ *
+ *	projekt   :  CAN - Controller Area Network.
+ *
+ *	purpose   :  CANopen Gateway Router (several CANopen networks).
+ *
+ *	copyright :  (C) 2009, UV Software, Friedrichshafen.
+ *
+ *	compiler  :  GCC - GNU C Compiler (Linux Kernel 2.6)
+ *
+ *	export    :  (see header file)
+ *
+ *	includes  :  cop_net.h (cop_tcp.h, can_defs.h), cop_srv.h, cop_bin.h, cop_api.h
+ *
+ *	author    :  Uwe Vogt, UV Software, Friedrichshafen
+ *
+ *	e-mail    :  uwe.vogt@uv-software.de
+ *
+ *
+ *	-----------  description  -----------------------------------------------
+ *
+ *	CANopen Master - Gateway Router for the ASCII Mapping (DS-309/3).
+ *
+ *	For each network a listening socket is bound to an abstract local
+ *	address (nothing is left in the file system), and a process is forked
+ *	which initializes the CANopen Master on the CAN interface of the
+ *	network and serves the socket by cop_srv_loop(). The router waits
+ *	until every network process has reported the result of its cop_init.
+ *
+ *	When a client connects to the router, the router connects to every
+ *	network process; so a client receives the events of all networks
+ *	(tagged with the network number) from the start. The router splits
+ *	the requests of a client (lines, or frames of the binary framing),
+ *	determines their network (cop_tcp_net, or the net field of a frame)
+ *	and appends them to the send buffer of the connection to that network.
+ *	A request to an unknown network is passed to the default network of
+ *	the client, which answers it with error 106. The responses and events
+ *	are passed back to the client as whole lines (frames), so that those
+ *	of different networks are not mixed. The pipelining and the order of
+ *	execution within a network are those of the gateway server.
+ *
+ *	The clients of the local listening socket are routed like those of the
+ *	TCP/IP socket. A shared-memory ring is not routed: each network process
+ *	creates a ring of its own, named <ring>.<net> (e.g. "/can_open.2").
+ *
+ *	The sockets are non-blocking. When the connection to a network does
+ *	not take a request, the client is not read until it does; when the
+ *	client does not read its responses, the connections to the networks
+ *	are not read. At the end of file of a client the connections to the
+ *	networks are shut down for writing; the network processes execute the
+ *	pending requests and close them, and then the client is closed.
+ *
+ *	When the router terminates (or a network process has terminated) the
+ *	network processes are terminated by SIGTERM.
+ *
+ *
+ *	-----------  history  ---------------------------------------------------
+ *
+ *	$Log$
+ */
+
+static char _id[] = "$Id: cop_net.c $";
+
+
+/*  -----------  includes  -------------------------------------------------
+ */
+
+#include "cop_net.h"
+#include "cop_srv.h"
+#include "cop_bin.h"
+
+#include "can_defs.h"
+#include "cop_api.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <sys/epoll.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <fcntl.h>
+#include <arpa/inet.h>
+
+
+/*  -----------  defines  --------------------------------------------------
+ */
+
+#define EVENT_POLL			100			/* poll cycle [ms] */
+#define COP_NET_BUFFER		4096		/* size of the receive/send buffers */
+
+#define FRAMING_NONE		0			/* first byte not received yet */
+#define FRAMING_ASCII		1			/* ASCII Mapping (DS-309/3) */
+#define FRAMING_BINARY		2			/* binary framing (cop_bin.h) */
+
+#define GET16(p)			((int)(BYTE)(p)[0] | ((int)(BYTE)(p)[1] << 8))
+
+
+/*  -----------  types  ----------------------------------------------------
+ */
+
+typedef struct _network {				/* process of a network: */
+	pid_t pid;							/*   process id (or 0) */
+	char *ifname;						/*   its CAN interface */
+	struct sockaddr_un addr;			/*   address of its socket */
+	socklen_t addrlen;					/*   length of the address */
+}	NETWORK;
+
+typedef struct _link {					/* connection of a client to a network: */
+	int fd;								/*   socket (or -1) */
+	int eof;							/*   end of file received */
+	int blocked;						/*   send buffer not written */
+	unsigned int events;				/*   epoll events of interest */
+	char input[COP_NET_BUFFER];			/*   responses and events received */
+	int in_length;						/*   its length */
+	char output[COP_NET_BUFFER];		/*   requests to be sent */
+	int out_length;						/*   its length */
+}	LINK;
+
+typedef struct _route {					/* client of the router: */
+	int fd;								/*   socket (or -1) */
+	int closing;						/*   end of file received */
+	int shut;							/*   connections to the networks shut down */
+	int blocked;						/*   send buffer not written */
+	int failed;							/*   send failed: responses discarded */
+	int framing;						/*   framing of the requests (FRAMING_xyz) */
+	unsigned int events;				/*   epoll events of interest */
+	char peer[32];						/*   address of the client */
+	COP_TCP_SETTINGS settings;			/*   settings of the client (default network) */
+	char input[COP_NET_BUFFER];			/*   receive buffer */
+	int in_start, in_end;				/*   its unprocessed part */
+	char line[COP_SRV_LENGTH];			/*   request being split */
+	int length;							/*   its length */
+	int cr;								/*   last character was a CR */
+	int pending;						/*   request waits for room in the send buffer of its network */
+	char output[COP_NET_BUFFER];		/*   send buffer */
+	int out_length;						/*   its length */
+	unsigned long requests[COP_NET_NETWORKS];
+	LINK links[COP_NET_NETWORKS];		/*   connections to the networks */
+}	ROUTE;
+
+
+/*  -----------  prototypes  -----------------------------------------------
+ */
+
+static int  net_start(int net, struct _can_param *param, BYTE baudrate, const char *shm, COP_TCP_SETTINGS *settings, int echo, int *running);
+static void net_stop(void);
+static void net_accept(int epfd, int server, COP_TCP_SETTINGS *settings);
+static void net_receive(ROUTE *route);
+static void net_split(ROUTE *route);
+static void net_frame(ROUTE *route);
+static int  net_route(ROUTE *route);
+static void net_forward(ROUTE *route, LINK *link);
+static void net_flush(ROUTE *route);
+static void net_update(int epfd, ROUTE *route);
+static void net_close(int epfd, ROUTE *route);
+static void link_receive(ROUTE *route, LINK *link);
+static void link_flush(LINK *link);
+static void link_update(int epfd, ROUTE *route, LINK *link);
+
+
+/*  -----------  variables  ------------------------------------------------
+ */
+
+static NETWORK networks[COP_NET_NETWORKS];	/* processes of the networks */
+static int started = 0;					/* number of started processes */
+static int lost = 0;					/* a network process has terminated */
+static ROUTE routes[COP_SRV_CLIENTS];	/* connected clients */
+
+
+/*  -----------  functions  ------------------------------------------------
+ */
+
+int cop_net_loop(int server, int local, const char *shm, struct _can_param *params, int count, BYTE baudrate, COP_TCP_SETTINGS *settings, int echo, int *running)
+{
+	struct epoll_event event, events[COP_SRV_CLIENTS * (COP_NET_NETWORKS + 1) + 1];
+	ROUTE *route;
+	unsigned int id;
+	int epfd, n, i, k;
+
+	if(server < 0 || !params || count < 1 || COP_NET_NETWORKS < count || !settings || !running)
+		return -1;
+	if(settings->net < 1 || count < settings->net)
+		return -1;
+	/* the router executes the Set Default Network commands */
+	cop_tcp_networks(1, count);
+	for(i = 0; i < COP_SRV_CLIENTS; i++)
+		routes[i].fd = -1;
+	lost = 0;
+	/* one process for each network (before any thread or connection) */
+	for(started = 0; started < count; started++) {
+		if(net_start(started + 1, &params[started], baudrate, shm, settings, echo, running) < 0) {
+			net_stop();
+			return -1;
+		}
+	}
+	if((epfd = epoll_create(COP_SRV_CLIENTS + 1)) < 0) {
+		perror("+++ error(epoll_create)");
+		net_stop();
+		return -1;
+	}
+	memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN;
+	event.data.u32 = 0;					/* 0: the listening socket */
+	if(epoll_ctl(epfd, EPOLL_CTL_ADD, server, &event) < 0) {
+		perror("+++ error(epoll_ctl)");
+		close(epfd);
+		net_stop();
+		return -1;
+	}
+	event.data.u32 = 1;					/* 1: the local listening socket */
+	if(local >= 0 && epoll_ctl(epfd, EPOLL_CTL_ADD, local, &event) < 0) {
+		perror("+++ error(epoll_ctl)");
+		close(epfd);
+		net_stop();
+		return -1;
+	}
+	while(*running && !lost) {
+		if((n = epoll_wait(epfd, events, sizeof(events) / sizeof(events[0]), EVENT_POLL)) < 0) {
+			if(errno == EINTR)
+				continue;
+			perror("+++ error(epoll_wait)");
+			break;
+		}
+		for(i = 0; i < n; i++) {
+			/* id: client number (bits 8..15) and network (bits 0..7, 0 for the client) */
+			if((id = events[i].data.u32) <= 1) {
+				net_accept(epfd, id? local : server, settings);
+				continue;
+			}
+			route = &routes[(id >> 8) - 1];
+			if(route->fd < 0)
+				continue;
+			if(!(k = (int)(id & 0xFF))) {
+				if(events[i].events & EPOLLOUT)
+					net_flush(route);
+				if(events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+					net_receive(route);
+			}
+			else {
+				if(events[i].events & EPOLLOUT)
+					link_flush(&route->links[k - 1]);
+				if(events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+					link_receive(route, &route->links[k - 1]);
+			}
+		}
+		/* pass the requests, responses and events on */
+		for(i = 0; i < COP_SRV_CLIENTS; i++) {
+			if((route = &routes[i])->fd < 0)
+				continue;
+			for(k = 0; k < started; k++) {
+				net_forward(route, &route->links[k]);
+				if(route->links[k].out_length && !route->links[k].blocked)
+					link_flush(&route->links[k]);
+			}
+			net_split(route);
+			if(route->out_length && !route->blocked)
+				net_flush(route);
+			net_update(epfd, route);
+		}
+	}
+	for(i = 0; i < COP_SRV_CLIENTS; i++) {
+		if(routes[i].fd >= 0)
+			net_close(epfd, &routes[i]);
+	}
+	close(epfd);
+	net_stop();
+	return lost? -1 : 0;
+}
+
+char* cop_net_version()
+{
+	return (char*)_id;
+}
+
+/*  -----------  local functions  ------------------------------------------
+ */
+
+static int net_start(int net, struct _can_param *param, BYTE baudrate, const char *shm, COP_TCP_SETTINGS *settings, int echo, int *running)
+{
+	NETWORK *network = &networks[net - 1];
+	COP_TCP_SETTINGS defaults;
+	COP_SHM *ring = NULL;
+	char name[256];
+	int listener, status[2];
+	LONG rc;
+
+	memset(network, 0, sizeof(NETWORK));
+	network->ifname = param->ifname;
+	/* an abstract address (Linux): nothing is left in the file system */
+	network->addr.sun_family = AF_UNIX;
+	snprintf(&network->addr.sun_path[1], sizeof(network->addr.sun_path) - 1, "can_open.%i.%i", (int)getpid(), net);
+	network->addrlen = (socklen_t)(offsetof(struct sockaddr_un, sun_path) + 1 + strlen(&network->addr.sun_path[1]));
+	if((listener = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
+		perror("+++ error(socket)");
+		return -1;
+	}
+	if(bind(listener, (struct sockaddr*)&network->addr, network->addrlen) < 0 ||
+	   listen(listener, COP_SRV_CLIENTS) < 0) {
+		perror("+++ error(bind)");
+		close(listener);
+		return -1;
+	}
+	/* the network process reports the result of its cop_init through a pipe */
+	if(pipe(status) < 0) {
+		perror("+++ error(pipe)");
+		close(listener);
+		return -1;
+	}
+	fflush(stdout);
+	fflush(stderr);
+	if((network->pid = fork()) < 0) {
+		perror("+++ error(fork)");
+		network->pid = 0;
+		close(status[0]);
+		close(status[1]);
+		close(listener);
+		return -1;
+	}
+	if(network->pid == 0) {
+		/* network process: it is terminated by the router (SIGTERM), not by ^C;
+		 * the listening socket of the router is left open (see the signal handler) */
+		signal(SIGINT, SIG_IGN);
+		close(status[0]);
+		cop_tcp_networks(net, net);
+		rc = cop_init(CAN_NETDEV, param, baudrate);
+		if(rc == COPERR_NOERROR && shm) {
+			/* the shared-memory ring of the network */
+			snprintf(name, sizeof(name), "%s.%i", shm, net);
+			if(!(ring = cop_shm_create(name))) {
+				cop_exit();
+				rc = -1;
+			}
+		}
+		if(write(status[1], &rc, sizeof(rc)) < 0)
+			perror("+++ error(write)");
+		close(status[1]);
+		if(rc == COPERR_NOERROR) {
+			memcpy(&defaults, settings, sizeof(COP_TCP_SETTINGS));
+			defaults.net = (BYTE)net;
+			cop_srv_loop(listener, -1, ring, &defaults, echo, running);
+			cop_exit();
+			if(ring)
+				cop_shm_destroy(ring, name);
+		}
+		close(listener);
+		_exit(rc == COPERR_NOERROR? 0 : 1);
+	}
+	close(status[1]);
+	close(listener);					/* the address is released with the process */
+	if(read(status[0], &rc, sizeof(rc)) != sizeof(rc))
+		rc = -1;
+	close(status[0]);
+	if(rc != COPERR_NOERROR) {
+		fprintf(stderr, "+++ error: cop_init(%s) = %li\n", network->ifname, (long)rc);
+		waitpid(network->pid, NULL, 0);
+		network->pid = 0;
+		return -1;
+	}
+	fprintf(stderr, "Network %i: %s (pid %i)\n", net, network->ifname, (int)network->pid);
+	return 0;
+}
+
+static void net_stop(void)
+{
+	int i;
+
+	for(i = 0; i < COP_NET_NETWORKS; i++) {
+		if(networks[i].pid > 0)
+			kill(networks[i].pid, SIGTERM);
+	}
+	for(i = 0; i < COP_NET_NETWORKS; i++) {
+		if(networks[i].pid > 0)
+			waitpid(networks[i].pid, NULL, 0);
+		networks[i].pid = 0;
+	}
+	started = 0;
+}
+
+static void net_accept(int epfd, int server, COP_TCP_SETTINGS *settings)
+{
+	struct epoll_event event;
+	struct sockaddr_storage addr;
+	struct sockaddr_in *inet = (struct sockaddr_in*)&addr;
+	socklen_t len = sizeof(addr);
+	ROUTE *route = NULL;
+	LINK *link;
+	int fd, i, k, on = 1;
+
+	if((fd = accept(server, (struct sockaddr*)&addr, &len)) < 0) {
+		if(errno != EINTR && errno != EAGAIN)
+			perror("+++ error(accept)");
+		return;
+	}
+	for(i = 0; i < COP_SRV_CLIENTS && !route; i++) {
+		if(routes[i].fd < 0)
+			route = &routes[i];
+	}
+	if(!route) {
+		fprintf(stderr, "+++ error: too many clients (%i)\n", COP_SRV_CLIENTS);
+		close(fd);
+		return;
+	}
+	/* non-blocking, and the responses are not delayed by Nagle */
+	if(fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK) < 0)
+		perror("+++ error(fcntl)");
+	if(addr.ss_family == AF_INET && setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on)) < 0)
+		perror("+++ error(setsockopt)");
+	memset(route, 0, sizeof(ROUTE));
+	if(addr.ss_family == AF_INET)
+		snprintf(route->peer, sizeof(route->peer), "%s:%u", inet_ntoa(inet->sin_addr), ntohs(inet->sin_port));
+	else
+		strcpy(route->peer, "local");
+	memcpy(&route->settings, settings, sizeof(COP_TCP_SETTINGS));
+	route->settings.emcy = -1;
+	route->settings.monitor = -1;
+	/* a connection to each network (the events of all networks are received) */
+	for(k = 0; k < COP_NET_NETWORKS; k++)
+		route->links[k].fd = -1;
+	for(k = 0; k < started; k++) {
+		link = &route->links[k];
+		if((link->fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0 ||
+		   connect(link->fd, (struct sockaddr*)&networks[k].addr, networks[k].addrlen) < 0) {
+			perror("+++ error(connect)");
+			break;
+		}
+		fcntl(link->fd, F_SETFL, fcntl(link->fd, F_GETFL, 0) | O_NONBLOCK);
+	}
+	route->fd = fd;
+	if(k < started) {
+		net_close(epfd, route);
+		return;
+	}
+	memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN;
+	event.data.u32 = (unsigned int)(route - routes + 1) << 8;
+	if(epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &event) < 0) {
+		perror("+++ error(epoll_ctl)");
+		net_close(epfd, route);
+		return;
+	}
+	route->events = EPOLLIN;
+}
+
+static void net_receive(ROUTE *route)
+{
+	ssize_t res;
+
+	while(!route->closing && !route->pending) {
+		/* pass the received requests on (as long as the networks take them) */
+		net_split(route);
+		if(route->pending)
+			break;
+		/* the receive buffer is empty now: read the next chunk */
+		if((res = recv(route->fd, route->input, COP_NET_BUFFER, 0)) < 0) {
+			if(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+				break;
+			if(errno != ECONNRESET)
+				perror("+++ error(read)");
+		}
+		if(res <= 0) {
+			/* pass the pending requests on before closing */
+			route->closing = 1;
+			net_split(route);
+			break;
+		}
+		route->in_start = 0;
+		route->in_end = (int)res;
+	}
+}
+
+static void net_split(ROUTE *route)
+{
+	LINK *link;
+	char chr;
+	int k;
+
+	/* a request that waits for room in the send buffer of its network */
+	if(route->pending && !net_route(route))
+		return;
+	/* the first byte selects the framing (also of the connections to the networks) */
+	if(route->framing == FRAMING_NONE && route->in_start < route->in_end) {
+		if((BYTE)route->input[route->in_start] == COP_BIN_MAGIC) {
+			route->framing = FRAMING_BINARY;
+			route->in_start++;
+			for(k = 0; k < started; k++) {
+				link = &route->links[k];
+				link->output[link->out_length++] = (char)COP_BIN_MAGIC;
+			}
+		}
+		else
+			route->framing = FRAMING_ASCII;
+	}
+	if(route->framing == FRAMING_BINARY) {
+		net_frame(route);
+		return;
+	}
+	while(route->in_start < route->in_end && !route->pending) {
+		chr = route->input[route->in_start++];
+		if(chr == '\n' && route->cr) {	/* LF of a CR-LF */
+			route->cr = 0;
+			continue;
+		}
+		route->cr = (chr == '\r');
+		if(chr == '\r' || chr == '\n') {
+			if(route->length)			/* empty lines are ignored */
+				net_route(route);
+		}
+		else if(route->length + 2 < COP_SRV_LENGTH)
+			route->line[route->length++] = chr;
+	}
+	/* the last line may end without a line feed */
+	if(route->closing && route->in_start == route->in_end && !route->pending && route->length)
+		net_route(route);
+}
+
+static void net_frame(ROUTE *route)
+{
+	int n;
+
+	while(route->in_start < route->in_end && !route->pending) {
+		/* the length field, then the rest of the frame */
+		n = (route->length < 2)? 2 - route->length : 2 + GET16(route->line) - route->length;
+		if(n > route->in_end - route->in_start)
+			n = route->in_end - route->in_start;
+		memcpy(&route->line[route->length], &route->input[route->in_start], n);
+		route->in_start += n;
+		route->length += n;
+		if(route->length < 2)
+			break;
+		n = 2 + GET16(route->line);
+		if(n > COP_SRV_LENGTH) {
+			/* a frame that does not fit: the stream cannot be resynchronized */
+			fprintf(stderr, "+++ error: frame too long (%i bytes)\n", n);
+			route->in_start = route->in_end;
+			route->length = 0;
+			route->closing = 1;
+			break;
+		}
+		if(route->length == n)
+			net_route(route);
+	}
+	/* an incomplete frame at the end of file is discarded */
+	if(route->closing && route->in_start == route->in_end && !route->pending)
+		route->length = 0;
+}
+
+static int net_route(ROUTE *route)
+{
+	char response[COP_SRV_LENGTH];
+	LINK *link;
+	int net, n = route->length;
+
+	if(route->framing == FRAMING_BINARY)
+		net = (n > 6 && (BYTE)route->line[6] != COP_BIN_DEFAULT)? (BYTE)route->line[6] : route->settings.net;
+	else {
+		route->line[n] = '\0';
+		if(!(net = cop_tcp_net(route->line, &route->settings))) {
+			/* Set Default Network command: executed by the router */
+			if(COP_NET_BUFFER - route->out_length < COP_SRV_LENGTH) {
+				net_flush(route);
+				if(COP_NET_BUFFER - route->out_length < COP_SRV_LENGTH) {
+					route->pending = 1;
+					return 0;
+				}
+			}
+			cop_tcp_parse(route->line, &route->settings, response, COP_SRV_LENGTH);
+			n = (int)strlen(response);
+			memcpy(&route->output[route->out_length], response, n);
+			route->out_length += n;
+			route->length = 0;
+			route->pending = 0;
+			return 1;
+		}
+	}
+	/* a request to an unknown network is answered by the default network (error 106) */
+	if(net < 1 || started < net)
+		net = route->settings.net;
+	link = &route->links[net - 1];
+	if(COP_NET_BUFFER - link->out_length < n + 1) {
+		link_flush(link);
+		if(COP_NET_BUFFER - link->out_length < n + 1) {
+			route->pending = 1;
+			return 0;
+		}
+	}
+	memcpy(&link->output[link->out_length], route->line, n);
+	link->out_length += n;
+	if(route->framing != FRAMING_BINARY)
+		link->output[link->out_length++] = '\n';
+	route->requests[net - 1]++;
+	route->length = 0;
+	route->pending = 0;
+	return 1;
+}
+
+static void net_forward(ROUTE *route, LINK *link)
+{
+	char *end;
+	int n;
+
+	if(route->failed) {					/* the client is gone */
+		link->in_length = 0;
+		return;
+	}
+	/* whole lines (frames), so that the networks are not mixed */
+	while(link->in_length) {
+		if(route->framing == FRAMING_BINARY) {
+			if(link->in_length < 2)
+				break;
+			if((n = 2 + GET16(link->input)) > link->in_length && link->in_length < COP_NET_BUFFER)
+				break;
+		}
+		else if((end = (char*)memchr(link->input, '\n', link->in_length)) != NULL)
+			n = (int)(end - link->input) + 1;
+		else if(link->in_length < COP_NET_BUFFER)
+			break;
+		else
+			n = link->in_length;
+		if(n > link->in_length)			/* (cannot happen) */
+			n = link->in_length;
+		if(COP_NET_BUFFER - route->out_length < n) {
+			net_flush(route);
+			if(route->failed || COP_NET_BUFFER - route->out_length < n)
+				break;
+		}
+		memcpy(&route->output[route->out_length], link->input, n);
+		route->out_length += n;
+		memmove(link->input, &link->input[n], link->in_length - n);
+		link->in_length -= n;
+	}
+}
+
+static void net_flush(ROUTE *route)
+{
+	ssize_t res;
+
+	if(route->fd < 0 || !route->out_length)
+		return;
+	if((res = send(route->fd, route->output, route->out_length, MSG_NOSIGNAL)) < 0) {
+		if(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+			route->blocked = 1;			/* wait for EPOLLOUT */
+			return;
+		}
+		if(errno != EPIPE && errno != ECONNRESET)
+			perror("+++ error(write)");
+		/* the client is gone: its requests are finished by the networks */
+		route->in_start = route->in_end;
+		route->length = 0;
+		route->pending = 0;
+		route->closing = 1;
+		route->failed = 1;
+		route->out_length = 0;
+		route->blocked = 0;
+		return;
+	}
+	if(res < route->out_length) {
+		memmove(route->output, &route->output[res], route->out_length - res);
+		route->out_length -= (int)res;
+		route->blocked = 1;
+	}
+	else {
+		route->out_length = 0;
+		route->blocked = 0;
+	}
+}
+
+static void net_update(int epfd, ROUTE *route)
+{
+	struct epoll_event event;
+	unsigned int events;
+	int k, done = 1;
+
+	if(route->fd < 0)
+		return;
+	/* end of file: the networks finish the pending requests and close the connections */
+	if(route->closing && !route->pending && !route->shut) {
+		for(k = 0; k < started; k++)
+			done &= !route->links[k].out_length;
+		if(done) {
+			for(k = 0; k < started; k++)
+				shutdown(route->links[k].fd, SHUT_WR);
+			route->shut = 1;
+		}
+	}
+	/* close the connection when all is done */
+	if(route->shut && !route->out_length) {
+		for(k = 0; k < started; k++)
+			done &= (route->links[k].eof && !route->links[k].in_length);
+		if(done) {
+			net_close(epfd, route);
+			return;
+		}
+	}
+	for(k = 0; k < started; k++)
+		link_update(epfd, route, &route->links[k]);
+	/* read while the networks take the requests, write while the socket is blocked */
+	events = (!route->closing && !route->pending)? EPOLLIN : 0;
+	events |= route->blocked? EPOLLOUT : 0;
+	if(events != route->events) {
+		memset(&event, 0, sizeof(event));
+		event.events = events;
+		event.data.u32 = (unsigned int)(route - routes + 1) << 8;
+		if(epoll_ctl(epfd, !route->events? EPOLL_CTL_ADD : !events? EPOLL_CTL_DEL : EPOLL_CTL_MOD, route->fd, &event) < 0)
+			perror("+++ error(epoll_ctl)");
+		route->events = events;
+	}
+}
+
+static void net_close(int epfd, ROUTE *route)
+{
+	LINK *link;
+	int k;
+
+	fprintf(stderr, "Client %i (%s):", (int)(route - routes) + 1, route->peer);
+	for(k = 0; k < started; k++)
+		fprintf(stderr, "%s network %i: %lu requests", k? "," : "", k + 1, route->requests[k]);
+	fputc('\n', stderr);
+	for(k = 0; k < COP_NET_NETWORKS; k++) {
+		if((link = &route->links[k])->fd < 0)
+			continue;
+		if(link->events)
+			epoll_ctl(epfd, EPOLL_CTL_DEL, link->fd, NULL);
+		close(link->fd);
+		link->fd = -1;
+	}
+	if(route->events)
+		epoll_ctl(epfd, EPOLL_CTL_DEL, route->fd, NULL);
+	close(route->fd);
+	route->fd = -1;
+}
+
+static void link_receive(ROUTE *route, LINK *link)
+{
+	ssize_t res;
+
+	while(!link->eof && link->in_length < COP_NET_BUFFER) {
+		if((res = recv(link->fd, &link->input[link->in_length], COP_NET_BUFFER - link->in_length, 0)) < 0) {
+			if(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+				break;
+			if(errno != ECONNRESET)
+				perror("+++ error(read)");
+		}
+		if(res <= 0) {
+			/* before the shut down: the network process has terminated */
+			if(!route->shut) {
+				fprintf(stderr, "+++ error: network %i (%s) terminated\n",
+				        (int)(link - route->links) + 1, networks[link - route->links].ifname);
+				lost = 1;
+			}
+			link->eof = 1;
+			break;
+		}
+		link->in_length += (int)res;
+	}
+	net_forward(route, link);
+}
+
+static void link_flush(LINK *link)
+{
+	ssize_t res;
+
+	if(link->fd < 0 || !link->out_length)
+		return;
+	if((res = send(link->fd, link->output, link->out_length, MSG_NOSIGNAL)) < 0) {
+		if(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+			link->blocked = 1;			/* wait for EPOLLOUT */
+			return;
+		}
+		perror("+++ error(write)");
+		lost = 1;						/* the network process is gone */
+		link->out_length = 0;
+		link->blocked = 0;
+		return;
+	}
+	if(res < link->out_length) {
+		memmove(link->output, &link->output[res], link->out_length - res);
+		link->out_length -= (int)res;
+		link->blocked = 1;
+	}
+	else {
+		link->out_length = 0;
+		link->blocked = 0;
+	}
+}
+
+static void link_update(int epfd, ROUTE *route, LINK *link)
+{
+	struct epoll_event event;
+	unsigned int events;
+
+	/* read while the receive buffer has room, write while the socket is blocked */
+	events = (!link->eof && link->in_length < COP_NET_BUFFER)? EPOLLIN : 0;
+	events |= link->blocked? EPOLLOUT : 0;
+	if(events != link->events) {
+		memset(&event, 0, sizeof(event));
+		event.events = events;
+		event.data.u32 = ((unsigned int)(route - routes + 1) << 8) | (unsigned int)(link - route->links + 1);
+		if(epoll_ctl(epfd, !link->events? EPOLL_CTL_ADD : !events? EPOLL_CTL_DEL : EPOLL_CTL_MOD, link->fd, &event) < 0)
+			perror("+++ error(epoll_ctl)");
+		link->events = events;
+	}
+}
+
+/*  -------------------------------------------------------------------------
+ *	Uwe Vogt,  UV Software,  Steinaecker 28,  88048 Friedrichshafen,  Germany
+ *	Fon: +49-7541-6041530, Fax. +49-1803-551809359, Cell fon: +49-170-3801903
+ *	E-Mail: uwe.vogt@uv-software.de, Internet URL: http://www.uv-software.de/
+ */
@@ -0,0 +1,116 @@
+/*	-- $Header$ --
+ *
+ *	projekt   :  CAN - Controller Area Network.
+ *
+ *	purpose   :  CANopen Gateway Router (several CANopen networks).
+ *
+ *	copyright :  (C) 2009, UV Software, Friedrichshafen.
+ *
+ *	compiler  :  GCC - GNU C Compiler (Linux Kernel 2.6)
+ *
+ *	export    :  <export>
+ *
+ *	includes  :  cop_tcp.h (default.h), can_defs.h
+ *
+ *	author    :  Uwe Vogt, UV Software, Friedrichshafen
+ *
+ *	e-mail    :  uwe.vogt@uv-software.de
+ *
+ *
+ *	-----------  description  -----------------------------------------------
+ *
+ *	CANopen Master - Gateway Router for the ASCII Mapping (DS-309/3).
+ *
+ *		Interfaces several CANopen networks (one CAN interface each,
+ *		e.g. can0, can1, vcan0) with TCP/IP. Network 1 is the first
+ *		interface, network 2 the second, and so on.
+ *
+ *		The CANopen Master has one network per process, so each network
+ *		is served by a process of its own: a gateway server (cop_srv.h)
+ *		on a local socket, with its own CANopen Master, SDO workers and
+ *		error control. The router accepts the TCP/IP clients and passes
+ *		each request to the process of the network it addresses (the
+ *		<net> of the request, or the default network of the client),
+ *		and the responses and events back to the client. So the traffic
+ *		on one network never waits for another network.
+ *
+ *		The Set Default Network command is executed by the router. The
+ *		other settings of a client (default node-id, events, emergency
+ *		subscription, ...) are kept per network.
+ *
+ *
+ *	-----------  history  ---------------------------------------------------
+ *
+ *	$Log$
+ */
+
+#ifndef __COP_NET_H
+#define __COP_NET_H
+
+
+/*  -----------  includes  -------------------------------------------------
+ */
+
+#include "cop_tcp.h"					// Interfacing CANopen with TCP/IP
+#include "can_defs.h"					// CAN definitions and options
+
+
+/*  -----------  defines  --------------------------------------------------
+ */
+
+#define COP_NET_NETWORKS	8			/* max. number of networks */
+
+
+/*  -----------  types  ----------------------------------------------------
+ */
+
+
+/*  -----------  variables  ------------------------------------------------
+ */
+
+
+/*  -----------  prototypes  -----------------------------------------------
+ */
+
+int cop_net_loop(int server, int local, const char *shm, struct _can_param *params, int count, BYTE baudrate, COP_TCP_SETTINGS *settings, int echo, int *running);
+/*
+ *	function  :  starts a network process for each CAN interface and
+ *	             routes the requests of the clients of a listening socket
+ *	             (and of a local one) to them until the flag 'running'
+ *	             is cleared (e.g. by a signal handler), or a network
+ *	             process has terminated.
+ *	             The CANopen Master must not be initialized by the caller
+ *	             (each network process initializes its own).
+ *
+ *	parameter :  server   - listening socket
+ *               local    - local listening socket (AF_UNIX), or -1
+ *               shm      - name of the shared-memory rings, or NULL (each
+ *                          network creates the ring <shm>.<net>)
+ *               params   - parameters of the CAN interfaces (cop_init),
+ *                          the first one for network 1
+ *               count    - number of networks (1,..,COP_NET_NETWORKS)
+ *               baudrate - bit timing index (as for cop_init)
+ *               settings - default settings of the gateway
+ *               echo     - echo requests and responses to stdout
+ *               running  - pointer to the run flag
+ *
+ *	result    :  0 if successful, or a negative value on error.
+ */
+
+char* cop_net_version();
+/*
+ *	function  :  retrieve RCS info of this module as a string.
+ *
+ *	parameter :  (none)
+ *
+ *	result    :  pointer to RCS info (zero-terminated string)
+ */
+
+
+#endif	// __COP_NET_H
+
+/*  -------------------------------------------------------------------------
+ *	Uwe Vogt,  UV Software,  Steinaecker 28,  88048 Friedrichshafen,  Germany
+ *	Fon: +49-7541-6041530, Fax. +49-1803-551809359, Cell fon: +49-170-3801903
+ *	E-Mail: uwe.vogt@uv-software.de, Internet URL: http://www.uv-software.de/
+ */
@@ -31,6 +31,20 @@
  *		- Reset Node (Application)
  *		- Reset Communication
  *
+ *		Error Control Services:
+ *		- Heartbeat Consumer (up to 127 nodes)
+ *		- Heartbeat Producer
+ *		- Node Guarding
+ *
+ *		The error control services are served by a background thread which
+ *		is started with the first service and stopped with the last one.
+ *		Heartbeat and guarding messages (COB-Id. 701h to 77Fh) are taken
+ *		from the receive hook of the CAN Controller interface and stored
+ *		with their time-stamp in a table of all nodes. Every tick the thread
+ *		checks the table, transmits the guarding requests and the heartbeat
+ *		of the master, and reports lost nodes and state changes into an
+ *		event-queue. No other message is transmitted for the monitoring.
+ *
  *
  *	-----------  nderungshistorie  ------------------------------------------
  *
@@ -54,11 +68,18 @@
 #include <errno.h>						// System wide error numbers
 #include <string.h>						// String manipulation functions
 #include <stdlib.h>						// Commonly used library functions
+#include <time.h>						// Clocks and timers
+#include <pthread.h>					// POSIX threads
 
 
 /*	-----------  Definitionen  -----------------------------------------------
  */
 
+#define NMT_NODES				128		// Node-id 1,..,127 (0 not used)
+#define NMT_TICK				10		// Tick of the error control [ms]
+#define NMT_EVENTS				256		// Size of the event-queue
+#define NMT_TOGGLE				0x80	// Toggle bit of node guarding
+
 
 /*	-----------  Typen  ------------------------------------------------------
  */
@@ -67,14 +88,37 @@
 /*	-----------  Prototypen  -------------------------------------------------
  */
 
+int  nmt_dispatch(long cob_id, short length, BYTE *data, DWORD time_stamp);
+void nmt_reset(void);
+
+static void *nmt_error_control(void *arg);
+static LONG nmt_control(void);
+static void nmt_report(BYTE node_id, BYTE event, BYTE state, DWORD time_stamp);
+
 
 /*	-----------  Variablen  --------------------------------------------------
  */
 
 extern BYTE cop_baudrate;				// actual baudrate
-extern LONG cop_error;					// last error code
+extern __thread LONG cop_error;			// last error code (per thread)
 extern BYTE cop_buffer[8];				// data buffer (8)
 
+static pthread_t nmt_thread;			// error control thread
+static pthread_mutex_t nmt_mutex = PTHREAD_MUTEX_INITIALIZER;
+static volatile int nmt_running = FALSE;// thread is running
+static DWORD nmt_last[NMT_NODES];		// last-seen time-stamps [ms]
+static WORD  nmt_heartbeat[NMT_NODES];	// consumer heartbeat time [ms]
+static WORD  nmt_guard[NMT_NODES];		// guard time [ms]
+static BYTE  nmt_factor[NMT_NODES];		// life time factor
+static DWORD nmt_request[NMT_NODES];	// time-stamps of guarding requests
+static BYTE  nmt_toggle[NMT_NODES];		// expected toggle bit
+static BYTE  nmt_lost[NMT_NODES];		// guarding event reported
+static BYTE  nmt_state[NMT_NODES];		// NMT states (liveness table)
+static BYTE  nmt_master = 0;			// node-id of the master
+static WORD  nmt_producer = 0;			// producer heartbeat time [ms]
+static NMT_EVENT nmt_events[NMT_EVENTS];// event-queue
+static int   nmt_head = 0, nmt_tail = 0;// queue pointers
+
 
 /*	-----------  Funktionen  -------------------------------------------------
  */
@@ -139,6 +183,247 @@ LONG nmt_reset_communication(BYTE node_id)
 	return cop_error = cop_transmit(NMT_MASTER, 2, cop_buffer);
 }
 
+LONG nmt_heartbeat_consumer(BYTE node_id, WORD heartbeat_time)
+{
+	int i;								// node-id
+
+	if(/*node_id < 0 ||*/ 127 < node_id)	// node-id: 1,..,127
+		return cop_error = COPERR_NODE_ID;	//  0 for all nodes
+
+	pthread_mutex_lock(&nmt_mutex);
+	for(i = 1; i < NMT_NODES; i++) {
+		if(node_id == NMT_ALL || node_id == i) {
+			nmt_heartbeat[i] = heartbeat_time;
+			if(!nmt_heartbeat[i] && !nmt_guard[i])
+				nmt_state[i] = NMT_UNKNOWN;
+		}
+	}
+	pthread_mutex_unlock(&nmt_mutex);
+	return cop_error = nmt_control();
+}
+
+LONG nmt_heartbeat_producer(BYTE node_id, WORD heartbeat_time)
+{
+	if(node_id < 1 || 127 < node_id)	// node-id: 1,..,127
+		return cop_error = COPERR_NODE_ID;
+
+	pthread_mutex_lock(&nmt_mutex);
+	nmt_master = node_id;
+	nmt_producer = heartbeat_time;
+	pthread_mutex_unlock(&nmt_mutex);
+	return cop_error = nmt_control();
+}
+
+LONG nmt_node_guarding(BYTE node_id, WORD guard_time, BYTE life_time_factor)
+{
+	DWORD now = can_timestamp();		// current time
+	int i;								// node-id
+
+	if(/*node_id < 0 ||*/ 127 < node_id)	// node-id: 1,..,127
+		return cop_error = COPERR_NODE_ID;	//  0 for all nodes
+	if(guard_time && !life_time_factor)	// life time factor: 1,..,255
+		return cop_error = COPERR_ILLPARA;
+
+	pthread_mutex_lock(&nmt_mutex);
+	for(i = 1; i < NMT_NODES; i++) {
+		if(node_id == NMT_ALL || node_id == i) {
+			nmt_guard[i] = guard_time;
+			nmt_factor[i] = life_time_factor;
+			nmt_request[i] = now - guard_time;
+			nmt_last[i] = now;			//   the life time starts now
+			nmt_lost[i] = FALSE;
+			if(!nmt_heartbeat[i] && !nmt_guard[i])
+				nmt_state[i] = NMT_UNKNOWN;
+		}
+	}
+	pthread_mutex_unlock(&nmt_mutex);
+	return cop_error = nmt_control();
+}
+
+LONG nmt_node_state(BYTE node_id, BYTE *state)
+{
+	if(node_id < 1 || 127 < node_id)	// node-id: 1,..,127
+		return cop_error = COPERR_NODE_ID;
+	if(state == NULL)					// null pointer assignment?
+		return cop_error = COPERR_NULLPTR;
+
+	pthread_mutex_lock(&nmt_mutex);
+	*state = nmt_state[node_id];
+	pthread_mutex_unlock(&nmt_mutex);
+	return cop_error = COPERR_NOERROR;
+}
+
+LONG nmt_event(NMT_EVENT *event)
+{
+	if(event == NULL)					// null pointer assignment?
+		return cop_error = COPERR_NULLPTR;
+
+	pthread_mutex_lock(&nmt_mutex);
+	if(nmt_head == nmt_tail) {			// event-queue empty?
+		pthread_mutex_unlock(&nmt_mutex);
+		return COPERR_RX_EMPTY;
+	}
+	memcpy(event, &nmt_events[nmt_tail], sizeof(NMT_EVENT));
+	nmt_tail = (nmt_tail + 1) % NMT_EVENTS;
+	pthread_mutex_unlock(&nmt_mutex);
+	return COPERR_NOERROR;
+}
+
+int nmt_dispatch(long cob_id, short length, BYTE *data, DWORD time_stamp)
+{
+	BYTE node_id = (BYTE)(cob_id - NMT_SLAVE);
+	BYTE state;							// received NMT state
+	int consumed;						// message consumed
+
+	if(cob_id <= NMT_SLAVE || (NMT_SLAVE + 127) < cob_id || length != 1)
+		return 0;						// not an error control message
+
+	// Called from the receive hook of the CAN Controller interface
+	pthread_mutex_lock(&nmt_mutex);
+	state = data[0] & ~NMT_TOGGLE;		// NMT state (w/o toggle bit)
+	consumed = (nmt_heartbeat[node_id] || nmt_guard[node_id]);
+
+	if(state == NMT_BOOTUP) {			// boot-up (all nodes):
+		nmt_report(node_id, NMT_EVENT_BOOTUP, state, time_stamp);
+		nmt_toggle[node_id] = 0x00;		//   toggle bit starts with 0
+	}
+	else if(!consumed) {				// node not monitored
+		pthread_mutex_unlock(&nmt_mutex);
+		return 0;
+	}
+	else if(nmt_guard[node_id] && nmt_state[node_id] != NMT_UNKNOWN &&
+	       (data[0] & NMT_TOGGLE) != nmt_toggle[node_id]) {
+		pthread_mutex_unlock(&nmt_mutex);
+		return 1;						// wrong toggle bit: ignored
+	}
+	else if(nmt_state[node_id] != state)// node state changed
+		nmt_report(node_id, NMT_EVENT_STATE, state, time_stamp);
+
+	if(nmt_guard[node_id] && state != NMT_BOOTUP)
+		nmt_toggle[node_id] = (data[0] & NMT_TOGGLE) ^ NMT_TOGGLE;
+	nmt_state[node_id] = state;			// update the liveness table
+	nmt_last[node_id] = time_stamp;
+	nmt_lost[node_id] = FALSE;
+	pthread_mutex_unlock(&nmt_mutex);
+	return consumed;
+}
+
+void nmt_reset(void)
+{
+	// Stop all error control services and clear the table
+	pthread_mutex_lock(&nmt_mutex);
+	memset(nmt_heartbeat, 0, sizeof(nmt_heartbeat));
+	memset(nmt_guard, 0, sizeof(nmt_guard));
+	memset(nmt_state, NMT_UNKNOWN, sizeof(nmt_state));
+	memset(nmt_lost, FALSE, sizeof(nmt_lost));
+	nmt_producer = 0;
+	nmt_head = nmt_tail = 0;
+	pthread_mutex_unlock(&nmt_mutex);
+	nmt_control();
+}
+
+/*	-----------  Lokale Funktionen  ------------------------------------------
+ */
+
+static LONG nmt_control(void)
+{
+	int i, active;						// services active
+
+	pthread_mutex_lock(&nmt_mutex);
+	for(active = (nmt_producer != 0), i = 1; i < NMT_NODES && !active; i++)
+		active = (nmt_heartbeat[i] || nmt_guard[i]);
+	pthread_mutex_unlock(&nmt_mutex);
+
+	if(active && !nmt_running) {		// start the thread
+		nmt_running = TRUE;
+		if(pthread_create(&nmt_thread, NULL, nmt_error_control, NULL) != 0) {
+			nmt_running = FALSE;
+			return COPERR_FATAL;
+		}
+	}
+	else if(!active && nmt_running) {	// stop the thread
+		nmt_running = FALSE;
+		pthread_join(nmt_thread, NULL);
+		can_delete(CANBUF_HEARTBEAT);
+		can_delete(CANBUF_GUARDING);
+	}
+	return COPERR_NOERROR;
+}
+
+static void *nmt_error_control(void *arg)
+{
+	struct timespec tick = {0, NMT_TICK * 1000000L};
+	BYTE  guard[NMT_NODES];				// nodes to be guarded
+	DWORD now, next = can_timestamp();	// time-stamps [ms]
+	BYTE  master = 0, state = NMT_OPERATIONAL;
+	int   i, produce, config;
+
+	while(nmt_running) {
+		// 1. Read the received messages (served by the receive hook)
+		can_poll();
+		now = can_timestamp();
+
+		// 2. Check the liveness table
+		pthread_mutex_lock(&nmt_mutex);
+		for(i = 1; i < NMT_NODES; i++) {
+			guard[i] = 0;
+			// heartbeat: monitored from the first heartbeat on
+			if(nmt_state[i] != NMT_UNKNOWN && nmt_heartbeat[i] &&
+			   (now - nmt_last[i]) > (DWORD)nmt_heartbeat[i]) {
+				nmt_state[i] = NMT_UNKNOWN;
+				nmt_report((BYTE)i, NMT_EVENT_HEARTBEAT, NMT_UNKNOWN, now);
+			}
+			// guarding: from the start on (also when it never responded),
+			// reported once until the node responds again
+			else if(nmt_guard[i] && !nmt_lost[i] &&
+			       (now - nmt_last[i]) > ((DWORD)nmt_guard[i] * (DWORD)nmt_factor[i])) {
+				nmt_state[i] = NMT_UNKNOWN;
+				nmt_lost[i] = TRUE;
+				nmt_report((BYTE)i, NMT_EVENT_GUARDING, NMT_UNKNOWN, now);
+			}
+			if(nmt_guard[i] && (now - nmt_request[i]) >= (DWORD)nmt_guard[i]) {
+				nmt_request[i] = now;
+				guard[i] = 1;
+			}
+		}
+		config = 0;
+		if((produce = (nmt_producer && (LONG)(now - next) >= 0)) != 0) {
+			if(master != nmt_master) {	// (re-)configure the producer
+				master = nmt_master;
+				config = 1;
+			}
+			next = now + nmt_producer;
+		}
+		pthread_mutex_unlock(&nmt_mutex);
+
+		// 3. Transmit the guarding requests (remote frames)
+		for(i = 1; i < NMT_NODES; i++) {
+			if(guard[i])
+				can_config(CANBUF_GUARDING, NMT_SLAVE + i, (WORD)CAN_REQUEST(1));
+		}
+		// 4. Transmit the heartbeat of the master
+		if(config)
+			can_config(CANBUF_HEARTBEAT, NMT_SLAVE + master, CANMSG_TRANSMIT);
+		if(produce)
+			can_transmit(CANBUF_HEARTBEAT, 1, &state);
+		nanosleep(&tick, NULL);
+	}
+	arg = arg;
+	return NULL;
+}
+
+static void nmt_report(BYTE node_id, BYTE event, BYTE state, DWORD time_stamp)
+{
+	// Note: must be called within the critical section
+	nmt_events[nmt_head].node_id = node_id;
+	nmt_events[nmt_head].event = event;
+	nmt_events[nmt_head].state = state;
+	nmt_events[nmt_head].time_stamp = time_stamp;
+	nmt_head = (nmt_head + 1) % NMT_EVENTS;
+	if(nmt_head == nmt_tail)			// on queue overrun:
+		nmt_tail = (nmt_tail + 1) % NMT_EVENTS;//delete oldest event
+}
+
 /*	--------------------------------------------------------------------------
  *	Uwe Vogt,  UV Software,  Steinaecker 28,  88048 Friedrichshafen,  Germany
  *	Fon: +49-7541-6041530, Fax. +49-1803-551809359, Cell fon: +49-170-3801903
@@ -0,0 +1,439 @@
+/*	-- $Header$ --
+ *
+ *	Projekt   :  CAN - Controller Area Network.
+ *
+ *	Zweck     :  CANopen Master SCAN - Network Scan.
+ *
+ *	Copyright :  (c) 2005-2009 by UV Software, Friedrichshafen.
+ *
+ *	Compiler  :  GCC - GNU C Compiler (Linux Kernel 2.6)
+ *
+ *	Export    :  (siehe Header-Datei)
+ *
+ *	Include   :  cop_api.h (can_defs.h, windows.h), can_ctrl.h
+ *
+ *	Autor     :  Uwe Vogt, UV Software.
+ *
+ *	E-Mail    :  uwe.vogt@uv-software.de
+ *
+ *
+ *	-----------  Modulbeschreibung  ------------------------------------------
+ *
+ *	CANopen Master SCAN - Network Scan.
+ *
+ *		Discovers the nodes of the network by reading the device type
+ *		(object 1000h) and the identity object (object 1018h, sub-index
+ *		1 to 4) of each node with the SDO Upload Protocol (expedited).
+ *
+ *		The SDO transfers to all nodes are run concurrently by a thread
+ *		with its own message object (CANBUF_SCAN), the SDO responses are
+ *		taken from the receive hook. So the time for a scan of the whole
+ *		network is about one SDO time-out (for the absent nodes) and not
+ *		127 times the SDO time-out as with sequential SDO uploads.
+ *
+ *		Optionally the thread listens for boot-up messages and reads the
+ *		identity of each node that (re-)joins the network.
+ *
+ *
+ *	-----------  nderungshistorie  ------------------------------------------
+ *
+ *	$Log$
+ */
+
+#ifdef _DEBUG
+ static char _id[] = "$Id: cop_scn.c $ _DEBUG";
+#else
+ static char _id[] = "$Id: cop_scn.c $";
+#endif
+
+/*	-----------  Include-Dateien  --------------------------------------------
+ */
+
+#include "cop_api.h"					// Interface prototypes
+#include "can_ctrl.h"					// CAN Controller interface
+
+#include <stdio.h>						// Standard I/O routines
+#include <errno.h>						// System wide error numbers
+#include <string.h>						// String manipulation functions
+#include <stdlib.h>						// Commonly used library functions
+#include <time.h>						// Clocks and timers
+#include <pthread.h>					// POSIX threads
+
+
+/*	-----------  Definitionen  -----------------------------------------------
+ */
+
+#define SCAN_NODES				128		// Node-id 1,..,127 (0 not used)
+#define SCAN_STEPS				5		// Objects read from each node
+#define SCAN_TICK				1		// Tick while SDO transfers are running [ms]
+#define SCAN_IDLE				10		// Tick while listening for boot-ups [ms]
+
+#define PHASE_IDLE				0		// No SDO transfer
+#define PHASE_REQUEST			1		// SDO request to be transmitted
+#define PHASE_WAIT				2		// Waiting for the SDO response
+#define PHASE_RESPONSE			3		// SDO response received
+
+
+/*	-----------  Typen  ------------------------------------------------------
+ */
+
+
+/*	-----------  Prototypen  -------------------------------------------------
+ */
+
+int  scan_dispatch(long cob_id, short length, BYTE *data, DWORD time_stamp);
+void scan_reset(void);
+
+static void *scan_engine(void *arg);
+static LONG scan_control(void);
+static void scan_request(BYTE node_id, DWORD now);
+static int  scan_advance(BYTE node_id, DWORD now, BYTE *frame);
+static void scan_finish(BYTE node_id, BYTE state, DWORD now);
+
+
+/*	-----------  Variablen  --------------------------------------------------
+ */
+
+extern __thread LONG cop_error;			// last error code (per thread)
+
+static pthread_t scan_thread;			// scan engine thread
+static pthread_mutex_t scan_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  scan_done = PTHREAD_COND_INITIALIZER;
+static volatile int scan_running = FALSE;// thread is running
+static int   scan_listen = FALSE;		// listening for boot-up messages
+static int   scan_pending = 0;			// number of nodes being scanned
+static WORD  scan_time_out = SDO_TIMEOUT;// SDO time-out value [ms]
+static SCAN_NODE scan_nodes[SCAN_NODES];// node table
+static BYTE  scan_phase[SCAN_NODES];	// phase of the SDO transfer
+static BYTE  scan_step[SCAN_NODES];		// object being read
+static BYTE  scan_answer[SCAN_NODES];	// node has answered
+static DWORD scan_deadline[SCAN_NODES];	// time-out of the SDO transfer [ms]
+static BYTE  scan_response[SCAN_NODES][8];// received SDO response
+
+static const WORD scan_index[SCAN_STEPS] = {0x1000, 0x1018, 0x1018, 0x1018, 0x1018};
+static const BYTE scan_subindex[SCAN_STEPS] = {0x00, 0x01, 0x02, 0x03, 0x04};
+
+
+/*	-----------  Funktionen  -------------------------------------------------
+ */
+
+LONG scan_network(BYTE first_node, BYTE last_node)
+{
+	DWORD now = can_timestamp();		// current time
+	int i;								// node-id
+
+	if(first_node < 1 || 127 < first_node)	// node-id: 1,..,127
+		return cop_error = COPERR_NODE_ID;
+	if(last_node < first_node || 127 < last_node)
+		return cop_error = COPERR_NODE_ID;
+
+	// 1. Request the identity of the nodes
+	pthread_mutex_lock(&scan_mutex);
+	for(i = first_node; i <= last_node; i++)
+		scan_request((BYTE)i, now);
+	pthread_mutex_unlock(&scan_mutex);
+
+	// 2. Wait until all SDO transfers are finished
+	if((cop_error = scan_control()) != COPERR_NOERROR) {
+		scan_reset();
+		return cop_error;
+	}
+	pthread_mutex_lock(&scan_mutex);
+	while(scan_pending > 0)
+		pthread_cond_wait(&scan_done, &scan_mutex);
+	pthread_mutex_unlock(&scan_mutex);
+
+	// 3. Stop the thread (if not listening)
+	return cop_error = scan_control();
+}
+
+LONG scan_start(void)
+{
+	pthread_mutex_lock(&scan_mutex);
+	scan_listen = TRUE;
+	pthread_mutex_unlock(&scan_mutex);
+	return cop_error = scan_control();
+}
+
+LONG scan_stop(void)
+{
+	pthread_mutex_lock(&scan_mutex);
+	scan_listen = FALSE;
+	pthread_mutex_unlock(&scan_mutex);
+	return cop_error = scan_control();
+}
+
+LONG scan_node(BYTE node_id, SCAN_NODE *node)
+{
+	if(node_id < 1 || 127 < node_id)	// node-id: 1,..,127
+		return cop_error = COPERR_NODE_ID;
+	if(node == NULL)					// null pointer assignment?
+		return cop_error = COPERR_NULLPTR;
+
+	pthread_mutex_lock(&scan_mutex);
+	memcpy(node, &scan_nodes[node_id], sizeof(SCAN_NODE));
+	pthread_mutex_unlock(&scan_mutex);
+	return cop_error = COPERR_NOERROR;
+}
+
+LONG scan_table(SCAN_NODE *table, SHORT *count)
+{
+	SHORT n = 0;						// number of nodes
+	int i;								// node-id
+
+	if(table == NULL || count == NULL)	// null pointer assignment?
+		return cop_error = COPERR_NULLPTR;
+
+	pthread_mutex_lock(&scan_mutex);
+	for(i = 1; i < SCAN_NODES && n < *count; i++) {
+		if(scan_nodes[i].state == SCAN_PRESENT)
+			memcpy(&table[n++], &scan_nodes[i], sizeof(SCAN_NODE));
+	}
+	pthread_mutex_unlock(&scan_mutex);
+	*count = n;
+	return cop_error = COPERR_NOERROR;
+}
+
+WORD scan_timeout(WORD milliseconds)
+{
+	WORD last_value;					// old time-out value
+
+	pthread_mutex_lock(&scan_mutex);
+	last_value = scan_time_out;			// copy old time-out value
+	scan_time_out = milliseconds;		// set new time-out value
+	pthread_mutex_unlock(&scan_mutex);
+	return last_value;					// return old time-out value
+}
+
+LPSTR scan_version(void)
+{
+	return (LPSTR)_id;					// Revision number
+}
+
+int scan_dispatch(long cob_id, short length, BYTE *data, DWORD time_stamp)
+{
+	BYTE node_id;						// node-id of the sender
+	int consumed = 0;					// message consumed
+
+	// Called from the receive hook of the CAN Controller interface
+	if(NMT_SLAVE < cob_id && cob_id <= (NMT_SLAVE + 127) && length == 1) {
+		if(data[0] != NMT_BOOTUP)		// boot-up message?
+			return 0;
+		node_id = (BYTE)(cob_id - NMT_SLAVE);
+		pthread_mutex_lock(&scan_mutex);
+		if(scan_phase[node_id] != PHASE_IDLE) {
+			scan_phase[node_id] = PHASE_REQUEST;
+			scan_step[node_id] = 0;		// restart the SDO transfers
+			scan_deadline[node_id] = time_stamp + scan_time_out;
+		}
+		else if(scan_listen)			// read the identity
+			scan_request(node_id, time_stamp);
+		pthread_mutex_unlock(&scan_mutex);
+		return 0;						// note: not consumed (NMT)
+	}
+	if(SDO_SERVER < cob_id && cob_id <= (SDO_SERVER + 127) && length == 8) {
+		node_id = (BYTE)(cob_id - SDO_SERVER);
+		pthread_mutex_lock(&scan_mutex);
+		if(scan_phase[node_id] == PHASE_WAIT &&
+		   data[1] == (BYTE)(scan_index[scan_step[node_id]]) &&
+		   data[2] == (BYTE)(scan_index[scan_step[node_id]] >> 8) &&
+		   data[3] == scan_subindex[scan_step[node_id]]) {
+			memcpy(scan_response[node_id], data, 8);
+			scan_phase[node_id] = PHASE_RESPONSE;
+			consumed = 1;
+		}
+		pthread_mutex_unlock(&scan_mutex);
+	}
+	return consumed;
+}
+
+void scan_reset(void)
+{
+	int i;								// node-id
+
+	// Cancel all SDO transfers and clear the node table
+	pthread_mutex_lock(&scan_mutex);
+	for(i = 0; i < SCAN_NODES; i++) {
+		memset(&scan_nodes[i], 0, sizeof(SCAN_NODE));
+		scan_nodes[i].node_id = (BYTE)i;
+		scan_nodes[i].state = SCAN_ABSENT;
+		scan_phase[i] = PHASE_IDLE;
+	}
+	scan_listen = FALSE;
+	scan_pending = 0;
+	pthread_cond_broadcast(&scan_done);
+	pthread_mutex_unlock(&scan_mutex);
+	scan_control();
+}
+
+/*	-----------  Lokale Funktionen  ------------------------------------------
+ */
+
+static LONG scan_control(void)
+{
+	int active;							// thread required
+
+	pthread_mutex_lock(&scan_mutex);
+	active = (scan_listen || scan_pending > 0);
+	pthread_mutex_unlock(&scan_mutex);
+
+	if(active && !scan_running) {		// start the thread
+		scan_running = TRUE;
+		if(pthread_create(&scan_thread, NULL, scan_engine, NULL) != 0) {
+			scan_running = FALSE;
+			return COPERR_FATAL;
+		}
+	}
+	else if(!active && scan_running) {	// stop the thread
+		scan_running = FALSE;
+		pthread_join(scan_thread, NULL);
+		can_delete(CANBUF_SCAN);
+	}
+	return COPERR_NOERROR;
+}
+
+static void *scan_engine(void *arg)
+{
+	struct timespec tick = {0, 0};		// tick of the thread
+	BYTE  frame[8];						// SDO request or abort
+	DWORD now;							// current time [ms]
+	int   i, send, busy;
+
+	while(scan_running) {
+		// 1. Read the received messages (served by the receive hook)
+		can_poll();
+		now = can_timestamp();
+
+		// 2. Run the SDO transfers of all nodes
+		for(busy = FALSE, i = 1; i < SCAN_NODES && !busy; i++) {
+			pthread_mutex_lock(&scan_mutex);
+			send = scan_advance((BYTE)i, now, frame);
+			pthread_mutex_unlock(&scan_mutex);
+			if(!send)
+				continue;
+			if(can_config(CANBUF_SCAN, SDO_CLIENT + i, CANMSG_TRANSMIT) != CANERR_NOERROR ||
+			   can_transmit(CANBUF_SCAN, 8, frame) != CANERR_NOERROR) {
+				pthread_mutex_lock(&scan_mutex);
+				if(frame[0] == 0x40 && scan_phase[i] == PHASE_WAIT)
+					scan_phase[i] = PHASE_REQUEST;	// retry with the next tick
+				pthread_mutex_unlock(&scan_mutex);
+				busy = TRUE;			// transmitter busy (e.g. queue full)
+			}
+		}
+		// 3. Notify the waiting callers when all transfers are finished
+		pthread_mutex_lock(&scan_mutex);
+		if(scan_pending == 0)
+			pthread_cond_broadcast(&scan_done);
+		tick.tv_nsec = (scan_pending > 0? SCAN_TICK : SCAN_IDLE) * 1000000L;
+		pthread_mutex_unlock(&scan_mutex);
+		nanosleep(&tick, NULL);
+	}
+	arg = arg;
+	return NULL;
+}
+
+static void scan_request(BYTE node_id, DWORD now)
+{
+	// Note: must be called within the critical section
+	if(scan_phase[node_id] == PHASE_IDLE)
+		scan_pending++;
+	memset(&scan_nodes[node_id], 0, sizeof(SCAN_NODE));
+	scan_nodes[node_id].node_id = node_id;
+	scan_nodes[node_id].state = SCAN_PENDING;
+	scan_phase[node_id] = PHASE_REQUEST;
+	scan_step[node_id] = 0;
+	scan_answer[node_id] = FALSE;
+	scan_deadline[node_id] = now + scan_time_out;
+}
+
+static int scan_advance(BYTE node_id, DWORD now, BYTE *frame)
+{
+	BYTE *response = scan_response[node_id];
+	DWORD value = 0;					// object value
+	DWORD abort_code = 0;				// SDO abort code
+	BYTE step = scan_step[node_id];		// object being read
+	int i, n;
+
+	// Note: must be called within the critical section
+	switch(scan_phase[node_id]) {
+	case PHASE_REQUEST:					// request to be transmitted:
+		if((LONG)(now - scan_deadline[node_id]) >= 0) {
+			scan_finish(node_id, scan_answer[node_id]? SCAN_PRESENT : SCAN_ABSENT, now);
+			return 0;					//   no chance to transmit it
+		}
+		break;
+	case PHASE_WAIT:					// waiting for the response:
+		if((LONG)(now - scan_deadline[node_id]) < 0)
+			return 0;					//   not yet timed out
+		if(!scan_answer[node_id]) {		//   node is absent
+			scan_finish(node_id, SCAN_ABSENT, now);
+			return 0;
+		}
+		abort_code = SDOERR_PROTOCOL_TIMEOUT;
+		scan_step[node_id] = SCAN_STEPS;//   node does not answer anymore
+		break;
+	case PHASE_RESPONSE:				// response received:
+		scan_answer[node_id] = TRUE;
+		if((response[0] & 0xE2) == 0x42) {			// expedited upload:
+			n = (response[0] & 0x01)? 4 - ((response[0] >> 2) & 0x03) : 4;
+			for(i = 0; i < n; i++)
+				value |= (DWORD)response[4+i] << (8 * i);
+		}
+		else if(response[0] != 0x80)				// segmented upload:
+			abort_code = SDOERR_GENERAL_ERROR;		//   not expected
+		switch(step) {								// (0 on SDO abort)
+		case 0: scan_nodes[node_id].device_type = value; break;
+		case 1: scan_nodes[node_id].vendor_id = value; break;
+		case 2: scan_nodes[node_id].product_code = value; break;
+		case 3: scan_nodes[node_id].revision_number = value; break;
+		case 4: scan_nodes[node_id].serial_number = value; break;
+		}
+		scan_step[node_id]++;
+		break;
+	default:							// no transfer
+		return 0;
+	}
+	if(abort_code) {					// abort the transfer
+		frame[0] = 0x80;
+		frame[1] = (BYTE)(scan_index[step]);
+		frame[2] = (BYTE)(scan_index[step] >> 8);
+		frame[3] = scan_subindex[step];
+		for(i = 0; i < 4; i++)
+			frame[4+i] = (BYTE)(abort_code >> (8 * i));
+		if(scan_step[node_id] < SCAN_STEPS) {
+			scan_phase[node_id] = PHASE_REQUEST;	// next object with the next tick
+			scan_deadline[node_id] = now + scan_time_out;
+		}
+		else
+			scan_finish(node_id, SCAN_PRESENT, now);
+		return 1;
+	}
+	if(scan_step[node_id] >= SCAN_STEPS) {		// all objects read
+		scan_finish(node_id, SCAN_PRESENT, now);
+		return 0;
+	}
+	frame[0] = 0x40;					// initiate SDO upload
+	frame[1] = (BYTE)(scan_index[scan_step[node_id]]);
+	frame[2] = (BYTE)(scan_index[scan_step[node_id]] >> 8);
+	frame[3] = scan_subindex[scan_step[node_id]];
+	memset(&frame[4], 0x00, 4);
+	scan_phase[node_id] = PHASE_WAIT;
+	scan_deadline[node_id] = now + scan_time_out;
+	return 1;
+}
+
+static void scan_finish(BYTE node_id, BYTE state, DWORD now)
+{
+	// Note: must be called within the critical section
+	scan_nodes[node_id].state = state;
+	scan_nodes[node_id].time_stamp = now;
+	scan_phase[node_id] = PHASE_IDLE;
+	if(scan_pending > 0)
+		scan_pending--;
+}
+
+/*	--------------------------------------------------------------------------
+ *	Uwe Vogt,  UV Software,  Steinaecker 28,  88048 Friedrichshafen,  Germany
+ *	Fon: +49-7541-6041530, Fax. +49-1803-551809359, Cell fon: +49-170-3801903
+ *	E-Mail: uwe.vogt@uv-software.de, Internet URL: http://www.uv-software.de/
+ */
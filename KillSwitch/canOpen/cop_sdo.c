@@ -34,6 +34,9 @@
  *		- Read/Write an 8-bit value (expedited transfer)
  *		- Read/Write a 16-bit value (expedited transfer)
  *		- Read/Write a 32-bit value (expedited transfer)
+ *		SDO Channels
+ *		- Message buffers and data buffer kept per thread, so several
+ *		  threads can run SDO transfers to different nodes concurrently
  *
  *
  *	-----------  nderungshistorie  ------------------------------------------
@@ -119,8 +122,10 @@ static LONG sdo_receive(BYTE node_id, WORD index, BYTE subindex, SHORT *length,
  */
 
 extern BYTE cop_baudrate;				// actual baudrate
-extern LONG cop_error;					// last error code
-extern BYTE cop_buffer[8];				// data buffer (8)
+extern __thread LONG cop_error;			// last error code (per thread)
+static __thread BYTE sdo_buffer[8];		// data buffer (per thread)
+static __thread short sdo_tx = CANBUF_TX;// transmit message buffer (per thread)
+static __thread short sdo_rx = CANBUF_RX;// receive message buffer (per thread)
 static WORD cop_timeout = SDO_TIMEOUT;	// time-out value
 
 
@@ -148,6 +153,21 @@ LONG sdo_read(BYTE node_id, WORD index, BYTE subindex, SHORT *length, BYTE *data
 	return sdo_receive(node_id, index, subindex, length, data, max);
 }
 
+LONG sdo_channel(BYTE channel)
+{
+	if(channel > SDO_CHANNELS)			// channel: 0,..,SDO_CHANNELS?
+		return cop_error = COPERR_ILLPARA;
+	if(channel == 0) {					// default message buffers
+		sdo_tx = CANBUF_TX;
+		sdo_rx = CANBUF_RX;
+	}
+	else {								// message buffers of the channel
+		sdo_tx = CANBUF_SDO + 2 * (channel - 1);
+		sdo_rx = CANBUF_SDO + 2 * (channel - 1) + 1;
+	}
+	return cop_error = COPERR_NOERROR;
+}
+
 WORD sdo_timeout(WORD milliseconds)
 {
 	WORD last_value = cop_timeout;		// copy old time-out value
@@ -229,30 +249,30 @@ static LONG sdo_expedited(BYTE node_id, WORD index, BYTE subindex, SHORT length,
 	short rc;							// return value
 	
 	// ---  Expedited SDO Download  ---
-	cop_buffer[0]  = (BYTE)0x23;		// client command specifier
-	cop_buffer[0] |= (BYTE)((4 - length) << 2);
-	cop_buffer[1]  = LOBYTE(index);		// multiplexor: index (LSB)
-	cop_buffer[2]  = HIBYTE(index);		//              index (MSB)
-	cop_buffer[3]  = (BYTE)(subindex);	//              subindex
-	memset(&cop_buffer[4],0x00,4);		// clear data buffer
-	memcpy(&cop_buffer[4],data,length);	// copy data bytes
+	sdo_buffer[0]  = (BYTE)0x23;		// client command specifier
+	sdo_buffer[0] |= (BYTE)((4 - length) << 2);
+	sdo_buffer[1]  = LOBYTE(index);		// multiplexor: index (LSB)
+	sdo_buffer[2]  = HIBYTE(index);		//              index (MSB)
+	sdo_buffer[3]  = (BYTE)(subindex);	//              subindex
+	memset(&sdo_buffer[4],0x00,4);		// clear data buffer
+	memcpy(&sdo_buffer[4],data,length);	// copy data bytes
 	n = 8;								// 8 bytes to transmit!
 
 	// 1. Configure transmit message object for client SDO
-	if((cop_error = can_config(CANBUF_TX, SDO_CLIENT + node_id, CANMSG_TRANSMIT)) != CANERR_NOERROR) {
-		can_delete(CANBUF_TX);
+	if((cop_error = can_config(sdo_tx, SDO_CLIENT + node_id, CANMSG_TRANSMIT)) != CANERR_NOERROR) {
+		can_delete(sdo_tx);
 		return cop_error;
 	}
 	// 2. Configure receive message object for server SDO 
-	if((cop_error = can_config(CANBUF_RX, SDO_SERVER + node_id, CANMSG_RECEIVE)) != CANERR_NOERROR) {
-		can_delete(CANBUF_TX);
-		can_delete(CANBUF_RX);
+	if((cop_error = can_config(sdo_rx, SDO_SERVER + node_id, CANMSG_RECEIVE)) != CANERR_NOERROR) {
+		can_delete(sdo_tx);
+		can_delete(sdo_rx);
 		return cop_error;
 	}
 	// 2. Transmit the client SDO message
-	if((cop_error = can_transmit(CANBUF_TX, n, cop_buffer)) != CANERR_NOERROR) {
-		can_delete(CANBUF_TX);
-		can_delete(CANBUF_RX);
+	if((cop_error = can_transmit(sdo_tx, n, sdo_buffer)) != CANERR_NOERROR) {
+		can_delete(sdo_tx);
+		can_delete(sdo_rx);
 		return cop_error;
 	}
 	// 3. Start timer for SDO time-out
@@ -260,94 +280,94 @@ static LONG sdo_expedited(BYTE node_id, WORD index, BYTE subindex, SHORT length,
 
 	// 4. Wait until server message is received
 	do	{
-		switch((rc = can_receive(CANBUF_RX, &n, cop_buffer)))
+		switch((rc = can_receive(sdo_rx, &n, sdo_buffer)))
 		{
 		case CANERR_NOERROR:			// confirmation:
 			if(n != 8) {								// 8 bytes received?
 				cop_error = SDOERR_GENERAL_ERROR;		//   abort: general error
-				cop_buffer[0] = 0x80;					//   command specifier
-				cop_buffer[1] = LOBYTE(index);			//   multiplexor: index (LSB)
-				cop_buffer[2] = HIBYTE(index);			//                index (MSB)
-				cop_buffer[3] = (BYTE)(subindex);		//                subindex
-				cop_buffer[4] = LOLOBYTE(cop_error);	//   abort code (LSB)
-				cop_buffer[5] = LOHIBYTE(cop_error);	//    -"-
-				cop_buffer[6] = HILOBYTE(cop_error);	//    -"-
-				cop_buffer[7] = HIHIBYTE(cop_error);	//   abort code (MSB)
+				sdo_buffer[0] = 0x80;					//   command specifier
+				sdo_buffer[1] = LOBYTE(index);			//   multiplexor: index (LSB)
+				sdo_buffer[2] = HIBYTE(index);			//                index (MSB)
+				sdo_buffer[3] = (BYTE)(subindex);		//                subindex
+				sdo_buffer[4] = LOLOBYTE(cop_error);	//   abort code (LSB)
+				sdo_buffer[5] = LOHIBYTE(cop_error);	//    -"-
+				sdo_buffer[6] = HILOBYTE(cop_error);	//    -"-
+				sdo_buffer[7] = HIHIBYTE(cop_error);	//   abort code (MSB)
 				// Transmit SDO abort and return
-				can_transmit(CANBUF_TX, 8, cop_buffer);
-				can_delete(CANBUF_TX);
-				can_delete(CANBUF_RX);
+				can_transmit(sdo_tx, 8, sdo_buffer);
+				can_delete(sdo_tx);
+				can_delete(sdo_rx);
 				return cop_error = COPERR_LENGTH;
 			}
-			if((cop_buffer[1] != LOBYTE(index)) ||		// multiplexor? index (LSB)
-			   (cop_buffer[2] != HIBYTE(index)) ||		//              index (MSB)
-			   (cop_buffer[3] != (BYTE)(subindex))) {	//              subindex
+			if((sdo_buffer[1] != LOBYTE(index)) ||		// multiplexor? index (LSB)
+			   (sdo_buffer[2] != HIBYTE(index)) ||		//              index (MSB)
+			   (sdo_buffer[3] != (BYTE)(subindex))) {	//              subindex
 				rc = COPERR_FORMAT;
 				break;
 			}
-			if((cop_buffer[0] & 0xFF) == 0x80) {		// SDO abort received?
-				LOLOBYTE(cop_error) = cop_buffer[4];	//   abort code (LSB)
-				LOHIBYTE(cop_error) = cop_buffer[5];	//    -"-
-				HILOBYTE(cop_error) = cop_buffer[6];	//    -"-
-				HIHIBYTE(cop_error) = cop_buffer[7];	//   abort code (MSB)
+			if((sdo_buffer[0] & 0xFF) == 0x80) {		// SDO abort received?
+				LOLOBYTE(cop_error) = sdo_buffer[4];	//   abort code (LSB)
+				LOHIBYTE(cop_error) = sdo_buffer[5];	//    -"-
+				HILOBYTE(cop_error) = sdo_buffer[6];	//    -"-
+				HIHIBYTE(cop_error) = sdo_buffer[7];	//   abort code (MSB)
 				// Return value is abort code!
-				can_delete(CANBUF_TX);
-				can_delete(CANBUF_RX);
+				can_delete(sdo_tx);
+				can_delete(sdo_rx);
 				return cop_error;
 			}
-			if((cop_buffer[0] & 0xFF) != 0x60) {		// unknown command specifier?
+			if((sdo_buffer[0] & 0xFF) != 0x60) {		// unknown command specifier?
 				cop_error = SDOERR_UNKNOWN_SPECIFIER;	//   abort: unknown command specifier
-				cop_buffer[0] = 0x80;					//   command specifier
-				cop_buffer[1] = LOBYTE(index);			//   multiplexor: index (LSB)
-				cop_buffer[2] = HIBYTE(index);			//                index (MSB)
-				cop_buffer[3] = (BYTE)(subindex);		//                subindex
-				cop_buffer[4] = LOLOBYTE(cop_error);	//   abort code (LSB)
-				cop_buffer[5] = LOHIBYTE(cop_error);	//    -"-
-				cop_buffer[6] = HILOBYTE(cop_error);	//    -"-
-				cop_buffer[7] = HIHIBYTE(cop_error);	//   abort code (MSB)
+				sdo_buffer[0] = 0x80;					//   command specifier
+				sdo_buffer[1] = LOBYTE(index);			//   multiplexor: index (LSB)
+				sdo_buffer[2] = HIBYTE(index);			//                index (MSB)
+				sdo_buffer[3] = (BYTE)(subindex);		//                subindex
+				sdo_buffer[4] = LOLOBYTE(cop_error);	//   abort code (LSB)
+				sdo_buffer[5] = LOHIBYTE(cop_error);	//    -"-
+				sdo_buffer[6] = HILOBYTE(cop_error);	//    -"-
+				sdo_buffer[7] = HIHIBYTE(cop_error);	//   abort code (MSB)
 				// Transmit SDO abort and return
-				can_transmit(CANBUF_TX, 8, cop_buffer);
-				can_delete(CANBUF_TX);
-				can_delete(CANBUF_RX);
+				can_transmit(sdo_tx, 8, sdo_buffer);
+				can_delete(sdo_tx);
+				can_delete(sdo_rx);
 				return cop_error = COPERR_FORMAT;
 			}
 			else {										// success: data written!
-				can_delete(CANBUF_TX);
-				can_delete(CANBUF_RX);
+				can_delete(sdo_tx);
+				can_delete(sdo_rx);
 				return cop_error = COPERR_NOERROR;
 			}
 		case CANERR_RX_EMPTY:			// receiver empty:
 			if(can_is_timeout()) {						//   time-out occurred?
 				cop_error = SDOERR_PROTOCOL_TIMEOUT;	//   abort: time-out
-				cop_buffer[0] = 0x80;					//   command specifier
-				cop_buffer[1] = LOBYTE(index);			//   multiplexor: index (LSB)
-				cop_buffer[2] = HIBYTE(index);			//                index (MSB)
-				cop_buffer[3] = (BYTE)(subindex);		//                subindex
-				cop_buffer[4] = LOLOBYTE(cop_error);	//   abort code (LSB)
-				cop_buffer[5] = LOHIBYTE(cop_error);	//    -"-
-				cop_buffer[6] = HILOBYTE(cop_error);	//    -"-
-				cop_buffer[7] = HIHIBYTE(cop_error);	//   abort code (MSB)
+				sdo_buffer[0] = 0x80;					//   command specifier
+				sdo_buffer[1] = LOBYTE(index);			//   multiplexor: index (LSB)
+				sdo_buffer[2] = HIBYTE(index);			//                index (MSB)
+				sdo_buffer[3] = (BYTE)(subindex);		//                subindex
+				sdo_buffer[4] = LOLOBYTE(cop_error);	//   abort code (LSB)
+				sdo_buffer[5] = LOHIBYTE(cop_error);	//    -"-
+				sdo_buffer[6] = HILOBYTE(cop_error);	//    -"-
+				sdo_buffer[7] = HIHIBYTE(cop_error);	//   abort code (MSB)
 				// Transmit SDO abort and return
-				can_transmit(CANBUF_TX, 8, cop_buffer);
-				can_delete(CANBUF_TX);
-				can_delete(CANBUF_RX);
+				can_transmit(sdo_tx, 8, sdo_buffer);
+				can_delete(sdo_tx);
+				can_delete(sdo_rx);
 				return cop_error = COPERR_TIMEOUT;
 			}
 			break;
 		default:						// other errors:
 			cop_error = SDOERR_GENERAL_ERROR;			//   abort: general error
-			cop_buffer[0] = 0x80;						//   command specifier
-			cop_buffer[1] = LOBYTE(index);				//   multiplexor: index (LSB)
-			cop_buffer[2] = HIBYTE(index);				//                index (MSB)
-			cop_buffer[3] = (BYTE)(subindex);			//            subindex
-			cop_buffer[4] = LOLOBYTE(cop_error);		// abort code (LSB)
-			cop_buffer[5] = LOHIBYTE(cop_error);		//  -"-
-			cop_buffer[6] = HILOBYTE(cop_error);		//  -"-
-			cop_buffer[7] = HIHIBYTE(cop_error);		// abort code (MSB)
+			sdo_buffer[0] = 0x80;						//   command specifier
+			sdo_buffer[1] = LOBYTE(index);				//   multiplexor: index (LSB)
+			sdo_buffer[2] = HIBYTE(index);				//                index (MSB)
+			sdo_buffer[3] = (BYTE)(subindex);			//            subindex
+			sdo_buffer[4] = LOLOBYTE(cop_error);		// abort code (LSB)
+			sdo_buffer[5] = LOHIBYTE(cop_error);		//  -"-
+			sdo_buffer[6] = HILOBYTE(cop_error);		//  -"-
+			sdo_buffer[7] = HIHIBYTE(cop_error);		// abort code (MSB)
 			// Transmit SDO abort and return
-			can_transmit(CANBUF_TX, 8, cop_buffer);
-			can_delete(CANBUF_TX);
-			can_delete(CANBUF_RX);
+			can_transmit(sdo_tx, 8, sdo_buffer);
+			can_delete(sdo_tx);
+			can_delete(sdo_rx);
 			return cop_error = rc;
 		}
 	}	while(1);						// "the torture never stops!"
@@ -360,31 +380,31 @@ static LONG sdo_segmented(BYTE node_id, WORD index, BYTE subindex, SHORT length,
 	short t = 0;						// toggle bit
 	
 	// ---  Initiate SDO Download  ---
-	cop_buffer[0] = (BYTE)0x21;			// client command specifier
-	cop_buffer[1] = LOBYTE(index);		// multiplexor: index (LSB)
-	cop_buffer[2] = HIBYTE(index);		//              index (MSB)
-	cop_buffer[3] = (BYTE)(subindex);	//              subindex
-	cop_buffer[4] = LOBYTE(length);		// number of data bytes (LSB)
-	cop_buffer[5] = HIBYTE(length);		//  -"-
-	cop_buffer[6] = (BYTE)0x00;			//  -"-
-	cop_buffer[7] = (BYTE)0x00;			// number of data bytes (MSB)
+	sdo_buffer[0] = (BYTE)0x21;			// client command specifier
+	sdo_buffer[1] = LOBYTE(index);		// multiplexor: index (LSB)
+	sdo_buffer[2] = HIBYTE(index);		//              index (MSB)
+	sdo_buffer[3] = (BYTE)(subindex);	//              subindex
+	sdo_buffer[4] = LOBYTE(length);		// number of data bytes (LSB)
+	sdo_buffer[5] = HIBYTE(length);		//  -"-
+	sdo_buffer[6] = (BYTE)0x00;			//  -"-
+	sdo_buffer[7] = (BYTE)0x00;			// number of data bytes (MSB)
 	n = 8;								// 8 bytes to transmit!
 
 	// 1. Configure transmit message object for client SDO
-	if((cop_error = can_config(CANBUF_TX, SDO_CLIENT + node_id, CANMSG_TRANSMIT)) != CANERR_NOERROR) {
-		can_delete(CANBUF_TX);
+	if((cop_error = can_config(sdo_tx, SDO_CLIENT + node_id, CANMSG_TRANSMIT)) != CANERR_NOERROR) {
+		can_delete(sdo_tx);
 		return cop_error;
 	}
 	// 2. Configure receive message object for server SDO 
-	if((cop_error = can_config(CANBUF_RX, SDO_SERVER + node_id, CANMSG_RECEIVE)) != CANERR_NOERROR) {
-		can_delete(CANBUF_TX);
-		can_delete(CANBUF_RX);
+	if((cop_error = can_config(sdo_rx, SDO_SERVER + node_id, CANMSG_RECEIVE)) != CANERR_NOERROR) {
+		can_delete(sdo_tx);
+		can_delete(sdo_rx);
 		return cop_error;
 	}
 	// 2. Transmit the client SDO message
-	if((cop_error = can_transmit(CANBUF_TX, n, cop_buffer)) != CANERR_NOERROR) {
-		can_delete(CANBUF_TX);
-		can_delete(CANBUF_RX);
+	if((cop_error = can_transmit(sdo_tx, n, sdo_buffer)) != CANERR_NOERROR) {
+		can_delete(sdo_tx);
+		can_delete(sdo_rx);
 		return cop_error;
 	}
 	// 3. Start timer for SDO time-out
@@ -392,89 +412,89 @@ static LONG sdo_segmented(BYTE node_id, WORD index, BYTE subindex, SHORT length,
 
 	// 4. Wait until server message is received
 	do	{
-		switch((rc = can_receive(CANBUF_RX, &n, cop_buffer)))
+		switch((rc = can_receive(sdo_rx, &n, sdo_buffer)))
 		{
 		case CANERR_NOERROR:			// confirmation:
 			if(n != 8) {								// 8 bytes received?
 				cop_error = SDOERR_GENERAL_ERROR;		//   abort: general error
-				cop_buffer[0] = 0x80;					//   command specifier
-				cop_buffer[1] = LOBYTE(index);			//   multiplexor: index (LSB)
-				cop_buffer[2] = HIBYTE(index);			//                index (MSB)
-				cop_buffer[3] = (BYTE)(subindex);		//                subindex
-				cop_buffer[4] = LOLOBYTE(cop_error);	//   abort code (LSB)
-				cop_buffer[5] = LOHIBYTE(cop_error);	//    -"-
-				cop_buffer[6] = HILOBYTE(cop_error);	//    -"-
-				cop_buffer[7] = HIHIBYTE(cop_error);	//   abort code (MSB)
+				sdo_buffer[0] = 0x80;					//   command specifier
+				sdo_buffer[1] = LOBYTE(index);			//   multiplexor: index (LSB)
+				sdo_buffer[2] = HIBYTE(index);			//                index (MSB)
+				sdo_buffer[3] = (BYTE)(subindex);		//                subindex
+				sdo_buffer[4] = LOLOBYTE(cop_error);	//   abort code (LSB)
+				sdo_buffer[5] = LOHIBYTE(cop_error);	//    -"-
+				sdo_buffer[6] = HILOBYTE(cop_error);	//    -"-
+				sdo_buffer[7] = HIHIBYTE(cop_error);	//   abort code (MSB)
 				// Transmit SDO abort and return
-				can_transmit(CANBUF_TX, 8, cop_buffer);
-				can_delete(CANBUF_TX);
-				can_delete(CANBUF_RX);
+				can_transmit(sdo_tx, 8, sdo_buffer);
+				can_delete(sdo_tx);
+				can_delete(sdo_rx);
 				return cop_error = COPERR_LENGTH;
 			}
-			if((cop_buffer[1] != LOBYTE(index)) ||		// multiplexor? index (LSB)
-			   (cop_buffer[2] != HIBYTE(index)) ||		//              index (MSB)
-			   (cop_buffer[3] != (BYTE)(subindex))) {	//              subindex
+			if((sdo_buffer[1] != LOBYTE(index)) ||		// multiplexor? index (LSB)
+			   (sdo_buffer[2] != HIBYTE(index)) ||		//              index (MSB)
+			   (sdo_buffer[3] != (BYTE)(subindex))) {	//              subindex
 				rc = COPERR_FORMAT;
 				break;
 			}
-			if((cop_buffer[0] & 0xFF) == 0x80) {		// SDO abort received?
-				LOLOBYTE(cop_error) = cop_buffer[4];	//   abort code (LSB)
-				LOHIBYTE(cop_error) = cop_buffer[5];	//    -"-
-				HILOBYTE(cop_error) = cop_buffer[6];	//    -"-
-				HIHIBYTE(cop_error) = cop_buffer[7];	//   abort code (MSB)
+			if((sdo_buffer[0] & 0xFF) == 0x80) {		// SDO abort received?
+				LOLOBYTE(cop_error) = sdo_buffer[4];	//   abort code (LSB)
+				LOHIBYTE(cop_error) = sdo_buffer[5];	//    -"-
+				HILOBYTE(cop_error) = sdo_buffer[6];	//    -"-
+				HIHIBYTE(cop_error) = sdo_buffer[7];	//   abort code (MSB)
 				// Return value is abort code!
-				can_delete(CANBUF_TX);
-				can_delete(CANBUF_RX);
+				can_delete(sdo_tx);
+				can_delete(sdo_rx);
 				return cop_error;
 			}
-			if((cop_buffer[0] & 0xFF) != 0x60) {		// unknown command specifier?
+			if((sdo_buffer[0] & 0xFF) != 0x60) {		// unknown command specifier?
 				cop_error = SDOERR_UNKNOWN_SPECIFIER;	//   abort: unknown command specifier
-				cop_buffer[0] = 0x80;					//   command specifier
-				cop_buffer[1] = LOBYTE(index);			//   multiplexor: index (LSB)
-				cop_buffer[2] = HIBYTE(index);			//                index (MSB)
-				cop_buffer[3] = (BYTE)(subindex);		//                subindex
-				cop_buffer[4] = LOLOBYTE(cop_error);	//   abort code (LSB)
-				cop_buffer[5] = LOHIBYTE(cop_error);	//    -"-
-				cop_buffer[6] = HILOBYTE(cop_error);	//    -"-
-				cop_buffer[7] = HIHIBYTE(cop_error);	//   abort code (MSB)
+				sdo_buffer[0] = 0x80;					//   command specifier
+				sdo_buffer[1] = LOBYTE(index);			//   multiplexor: index (LSB)
+				sdo_buffer[2] = HIBYTE(index);			//                index (MSB)
+				sdo_buffer[3] = (BYTE)(subindex);		//                subindex
+				sdo_buffer[4] = LOLOBYTE(cop_error);	//   abort code (LSB)
+				sdo_buffer[5] = LOHIBYTE(cop_error);	//    -"-
+				sdo_buffer[6] = HILOBYTE(cop_error);	//    -"-
+				sdo_buffer[7] = HIHIBYTE(cop_error);	//   abort code (MSB)
 				// Transmit SDO abort and return
-				can_transmit(CANBUF_TX, 8, cop_buffer);
-				can_delete(CANBUF_TX);
-				can_delete(CANBUF_RX);
+				can_transmit(sdo_tx, 8, sdo_buffer);
+				can_delete(sdo_tx);
+				can_delete(sdo_rx);
 				return cop_error = COPERR_FORMAT;
 			}
 		case CANERR_RX_EMPTY:			// receiver empty:
 			if(can_is_timeout()) {						//   time-out occurred?
 				cop_error = SDOERR_PROTOCOL_TIMEOUT;	//   abort: time-out
-				cop_buffer[0] = 0x80;					//   command specifier
-				cop_buffer[1] = LOBYTE(index);			//   multiplexor: index (LSB)
-				cop_buffer[2] = HIBYTE(index);			//                index (MSB)
-				cop_buffer[3] = (BYTE)(subindex);		//                subindex
-				cop_buffer[4] = LOLOBYTE(cop_error);	//   abort code (LSB)
-				cop_buffer[5] = LOHIBYTE(cop_error);	//    -"-
-				cop_buffer[6] = HILOBYTE(cop_error);	//    -"-
-				cop_buffer[7] = HIHIBYTE(cop_error);	//   abort code (MSB)
+				sdo_buffer[0] = 0x80;					//   command specifier
+				sdo_buffer[1] = LOBYTE(index);			//   multiplexor: index (LSB)
+				sdo_buffer[2] = HIBYTE(index);			//                index (MSB)
+				sdo_buffer[3] = (BYTE)(subindex);		//                subindex
+				sdo_buffer[4] = LOLOBYTE(cop_error);	//   abort code (LSB)
+				sdo_buffer[5] = LOHIBYTE(cop_error);	//    -"-
+				sdo_buffer[6] = HILOBYTE(cop_error);	//    -"-
+				sdo_buffer[7] = HIHIBYTE(cop_error);	//   abort code (MSB)
 				// Transmit SDO abort and return
-				can_transmit(CANBUF_TX, 8, cop_buffer);
-				can_delete(CANBUF_TX);
-				can_delete(CANBUF_RX);
+				can_transmit(sdo_tx, 8, sdo_buffer);
+				can_delete(sdo_tx);
+				can_delete(sdo_rx);
 				return cop_error = COPERR_TIMEOUT;
 			}
 			break;
 		default:						// other errors:
 			cop_error = SDOERR_GENERAL_ERROR;			//   abort: general error
-			cop_buffer[0] = 0x80;						//   command specifier
-			cop_buffer[1] = LOBYTE(index);				//   multiplexor: index (LSB)
-			cop_buffer[2] = HIBYTE(index);				//                index (MSB)
-			cop_buffer[3] = (BYTE)(subindex);			//            subindex
-			cop_buffer[4] = LOLOBYTE(cop_error);		// abort code (LSB)
-			cop_buffer[5] = LOHIBYTE(cop_error);		//  -"-
-			cop_buffer[6] = HILOBYTE(cop_error);		//  -"-
-			cop_buffer[7] = HIHIBYTE(cop_error);		// abort code (MSB)
+			sdo_buffer[0] = 0x80;						//   command specifier
+			sdo_buffer[1] = LOBYTE(index);				//   multiplexor: index (LSB)
+			sdo_buffer[2] = HIBYTE(index);				//                index (MSB)
+			sdo_buffer[3] = (BYTE)(subindex);			//            subindex
+			sdo_buffer[4] = LOLOBYTE(cop_error);		// abort code (LSB)
+			sdo_buffer[5] = LOHIBYTE(cop_error);		//  -"-
+			sdo_buffer[6] = HILOBYTE(cop_error);		//  -"-
+			sdo_buffer[7] = HIHIBYTE(cop_error);		// abort code (MSB)
 			// Transmit SDO abort and return
-			can_transmit(CANBUF_TX, 8, cop_buffer);
-			can_delete(CANBUF_TX);
-			can_delete(CANBUF_RX);
+			can_transmit(sdo_tx, 8, sdo_buffer);
+			can_delete(sdo_tx);
+			can_delete(sdo_rx);
 			return cop_error = rc;
 		}
 	}	while(rc != CANERR_NOERROR);
@@ -486,19 +506,19 @@ static LONG sdo_segmented(BYTE node_id, WORD index, BYTE subindex, SHORT length,
 			n = 7 - length;
 		else							// no segment size indicated
 			n = 0;
-		cop_buffer[0] = (BYTE)(n << 1);	// client command specifier
-		memset(&cop_buffer[1], 0x00, 7);// clear data buffer
-		memcpy(&cop_buffer[1], &data[i], 7 - n);// copy segment data
+		sdo_buffer[0] = (BYTE)(n << 1);	// client command specifier
+		memset(&sdo_buffer[1], 0x00, 7);// clear data buffer
+		memcpy(&sdo_buffer[1], &data[i], 7 - n);// copy segment data
 		length -= 7 - n;				// remaining number of bytes
 		i	   += 7 - n;				// index to remainung bytes
-		cop_buffer[0]|= length? 0x00 : 0x01;// last segment to transmit
-		cop_buffer[0]|= t;				// toggle bit
+		sdo_buffer[0]|= length? 0x00 : 0x01;// last segment to transmit
+		sdo_buffer[0]|= t;				// toggle bit
 		n = 8;							// 8 bytes to transmit!
 
 		// 5. Transmit the client SDO message
-		if((cop_error = can_transmit(CANBUF_TX, n, cop_buffer)) != CANERR_NOERROR) {
-			can_delete(CANBUF_TX);
-			can_delete(CANBUF_RX);
+		if((cop_error = can_transmit(sdo_tx, n, sdo_buffer)) != CANERR_NOERROR) {
+			can_delete(sdo_tx);
+			can_delete(sdo_rx);
 			return cop_error;
 		}
 		// 6. Start timer for SDO time-out
@@ -506,104 +526,104 @@ static LONG sdo_segmented(BYTE node_id, WORD index, BYTE subindex, SHORT length,
 
 		// 7. Wait until server message is received
 		do	{
-			switch((rc = can_receive(CANBUF_RX, &n, cop_buffer)))
+			switch((rc = can_receive(sdo_rx, &n, sdo_buffer)))
 			{
 			case CANERR_NOERROR:			// confirmation:
 				if(n != 8) {								// 8 bytes received?
 					cop_error = SDOERR_GENERAL_ERROR;		//   abort: general error
-					cop_buffer[0] = 0x80;					//   command specifier
-					cop_buffer[1] = LOBYTE(index);			//   multiplexor: index (LSB)
-					cop_buffer[2] = HIBYTE(index);			//                index (MSB)
-					cop_buffer[3] = (BYTE)(subindex);		//                subindex
-					cop_buffer[4] = LOLOBYTE(cop_error);	//   abort code (LSB)
-					cop_buffer[5] = LOHIBYTE(cop_error);	//    -"-
-					cop_buffer[6] = HILOBYTE(cop_error);	//    -"-
-					cop_buffer[7] = HIHIBYTE(cop_error);	//   abort code (MSB)
+					sdo_buffer[0] = 0x80;					//   command specifier
+					sdo_buffer[1] = LOBYTE(index);			//   multiplexor: index (LSB)
+					sdo_buffer[2] = HIBYTE(index);			//                index (MSB)
+					sdo_buffer[3] = (BYTE)(subindex);		//                subindex
+					sdo_buffer[4] = LOLOBYTE(cop_error);	//   abort code (LSB)
+					sdo_buffer[5] = LOHIBYTE(cop_error);	//    -"-
+					sdo_buffer[6] = HILOBYTE(cop_error);	//    -"-
+					sdo_buffer[7] = HIHIBYTE(cop_error);	//   abort code (MSB)
 					// Transmit SDO abort and return
-					can_transmit(CANBUF_TX, 8, cop_buffer);
-					can_delete(CANBUF_TX);
-					can_delete(CANBUF_RX);
+					can_transmit(sdo_tx, 8, sdo_buffer);
+					can_delete(sdo_tx);
+					can_delete(sdo_rx);
 					return cop_error = COPERR_LENGTH;
 				}
-				if((cop_buffer[0] & 0xE0) == 0x80) {		// SDO abort received?
-					LOLOBYTE(cop_error) = cop_buffer[4];	//   abort code (LSB)
-					LOHIBYTE(cop_error) = cop_buffer[5];	//    -"-
-					HILOBYTE(cop_error) = cop_buffer[6];	//    -"-
-					HIHIBYTE(cop_error) = cop_buffer[7];	//   abort code (MSB)
+				if((sdo_buffer[0] & 0xE0) == 0x80) {		// SDO abort received?
+					LOLOBYTE(cop_error) = sdo_buffer[4];	//   abort code (LSB)
+					LOHIBYTE(cop_error) = sdo_buffer[5];	//    -"-
+					HILOBYTE(cop_error) = sdo_buffer[6];	//    -"-
+					HIHIBYTE(cop_error) = sdo_buffer[7];	//   abort code (MSB)
 					// Return value is abort code!
-					can_delete(CANBUF_TX);
-					can_delete(CANBUF_RX);
+					can_delete(sdo_tx);
+					can_delete(sdo_rx);
 					return cop_error;
 				}
-				if((cop_buffer[0] & 0xE0) != 0x20) {		// unknown command specifier?
+				if((sdo_buffer[0] & 0xE0) != 0x20) {		// unknown command specifier?
 					cop_error = SDOERR_UNKNOWN_SPECIFIER;	//   abort: unknown command specifier
-					cop_buffer[0] = 0x80;					//   command specifier
-					cop_buffer[1] = LOBYTE(index);			//   multiplexor: index (LSB)
-					cop_buffer[2] = HIBYTE(index);			//                index (MSB)
-					cop_buffer[3] = (BYTE)(subindex);		//                subindex
-					cop_buffer[4] = LOLOBYTE(cop_error);	//   abort code (LSB)
-					cop_buffer[5] = LOHIBYTE(cop_error);	//    -"-
-					cop_buffer[6] = HILOBYTE(cop_error);	//    -"-
-					cop_buffer[7] = HIHIBYTE(cop_error);	//   abort code (MSB)
+					sdo_buffer[0] = 0x80;					//   command specifier
+					sdo_buffer[1] = LOBYTE(index);			//   multiplexor: index (LSB)
+					sdo_buffer[2] = HIBYTE(index);			//                index (MSB)
+					sdo_buffer[3] = (BYTE)(subindex);		//                subindex
+					sdo_buffer[4] = LOLOBYTE(cop_error);	//   abort code (LSB)
+					sdo_buffer[5] = LOHIBYTE(cop_error);	//    -"-
+					sdo_buffer[6] = HILOBYTE(cop_error);	//    -"-
+					sdo_buffer[7] = HIHIBYTE(cop_error);	//   abort code (MSB)
 					// Transmit SDO abort and return
-					can_transmit(CANBUF_TX, 8, cop_buffer);
-					can_delete(CANBUF_TX);
-					can_delete(CANBUF_RX);
+					can_transmit(sdo_tx, 8, sdo_buffer);
+					can_delete(sdo_tx);
+					can_delete(sdo_rx);
 					return cop_error = COPERR_FORMAT;
 				}
-				if((cop_buffer[0] & 0x10) != t) {			// toggle bit not altered?
+				if((sdo_buffer[0] & 0x10) != t) {			// toggle bit not altered?
 					cop_error = SDOERR_WRONG_TOGGLEBIT;		//   abort: toggle bit not altered
-					cop_buffer[0] = 0x80;					//   command specifier
-					cop_buffer[1] = LOBYTE(index);			//   multiplexor: index (LSB)
-					cop_buffer[2] = HIBYTE(index);			//                index (MSB)
-					cop_buffer[3] = (BYTE)(subindex);		//                subindex
-					cop_buffer[4] = LOLOBYTE(cop_error);	//   abort code (LSB)
-					cop_buffer[5] = LOHIBYTE(cop_error);	//    -"-
-					cop_buffer[6] = HILOBYTE(cop_error);	//    -"-
-					cop_buffer[7] = HIHIBYTE(cop_error);	//   abort code (MSB)
+					sdo_buffer[0] = 0x80;					//   command specifier
+					sdo_buffer[1] = LOBYTE(index);			//   multiplexor: index (LSB)
+					sdo_buffer[2] = HIBYTE(index);			//                index (MSB)
+					sdo_buffer[3] = (BYTE)(subindex);		//                subindex
+					sdo_buffer[4] = LOLOBYTE(cop_error);	//   abort code (LSB)
+					sdo_buffer[5] = LOHIBYTE(cop_error);	//    -"-
+					sdo_buffer[6] = HILOBYTE(cop_error);	//    -"-
+					sdo_buffer[7] = HIHIBYTE(cop_error);	//   abort code (MSB)
 					// Transmit SDO abort and return
-					can_transmit(CANBUF_TX, 8, cop_buffer);
-					can_delete(CANBUF_TX);
-					can_delete(CANBUF_RX);
+					can_transmit(sdo_tx, 8, sdo_buffer);
+					can_delete(sdo_tx);
+					can_delete(sdo_rx);
 					return cop_error = COPERR_FORMAT;
 				}
 				if(length == 0)	{							// all data tranmitted?
-					can_delete(CANBUF_TX);
-					can_delete(CANBUF_RX);
+					can_delete(sdo_tx);
+					can_delete(sdo_rx);
 					return cop_error = COPERR_NOERROR;
 				}
 			case CANERR_RX_EMPTY:			// receiver empty:
 				if(can_is_timeout()) {						//   time-out occurred?
 					cop_error = SDOERR_PROTOCOL_TIMEOUT;	//   abort: time-out
-					cop_buffer[0] = 0x80;					//   command specifier
-					cop_buffer[1] = LOBYTE(index);			//   multiplexor: index (LSB)
-					cop_buffer[2] = HIBYTE(index);			//                index (MSB)
-					cop_buffer[3] = (BYTE)(subindex);		//                subindex
-					cop_buffer[4] = LOLOBYTE(cop_error);	//   abort code (LSB)
-					cop_buffer[5] = LOHIBYTE(cop_error);	//    -"-
-					cop_buffer[6] = HILOBYTE(cop_error);	//    -"-
-					cop_buffer[7] = HIHIBYTE(cop_error);	//   abort code (MSB)
+					sdo_buffer[0] = 0x80;					//   command specifier
+					sdo_buffer[1] = LOBYTE(index);			//   multiplexor: index (LSB)
+					sdo_buffer[2] = HIBYTE(index);			//                index (MSB)
+					sdo_buffer[3] = (BYTE)(subindex);		//                subindex
+					sdo_buffer[4] = LOLOBYTE(cop_error);	//   abort code (LSB)
+					sdo_buffer[5] = LOHIBYTE(cop_error);	//    -"-
+					sdo_buffer[6] = HILOBYTE(cop_error);	//    -"-
+					sdo_buffer[7] = HIHIBYTE(cop_error);	//   abort code (MSB)
 					// Transmit SDO abort and return
-					can_transmit(CANBUF_TX, 8, cop_buffer);
-					can_delete(CANBUF_TX);
-					can_delete(CANBUF_RX);
+					can_transmit(sdo_tx, 8, sdo_buffer);
+					can_delete(sdo_tx);
+					can_delete(sdo_rx);
 					return cop_error = COPERR_TIMEOUT;
 				}
 				break;
 			default:						// other errors:
 				cop_error = SDOERR_GENERAL_ERROR;			//   abort: general error
-				cop_buffer[0] = 0x80;						//   command specifier
-				cop_buffer[1] = LOBYTE(index);				//   multiplexor: index (LSB)
-				cop_buffer[2] = HIBYTE(index);				//                index (MSB)
-				cop_buffer[3] = (BYTE)(subindex);			//            subindex
-				cop_buffer[4] = LOLOBYTE(cop_error);		// abort code (LSB)
-				cop_buffer[5] = LOHIBYTE(cop_error);		//  -"-
-				cop_buffer[6] = HILOBYTE(cop_error);		//  -"-
-				cop_buffer[7] = HIHIBYTE(cop_error);		// abort code (MSB)
+				sdo_buffer[0] = 0x80;						//   command specifier
+				sdo_buffer[1] = LOBYTE(index);				//   multiplexor: index (LSB)
+				sdo_buffer[2] = HIBYTE(index);				//                index (MSB)
+				sdo_buffer[3] = (BYTE)(subindex);			//            subindex
+				sdo_buffer[4] = LOLOBYTE(cop_error);		// abort code (LSB)
+				sdo_buffer[5] = LOHIBYTE(cop_error);		//  -"-
+				sdo_buffer[6] = HILOBYTE(cop_error);		//  -"-
+				sdo_buffer[7] = HIHIBYTE(cop_error);		// abort code (MSB)
 				// Transmit SDO abort and return
-				can_transmit(CANBUF_TX, 8, cop_buffer);
-				can_delete(CANBUF_TX);
-				can_delete(CANBUF_RX);
+				can_transmit(sdo_tx, 8, sdo_buffer);
+				can_delete(sdo_tx);
+				can_delete(sdo_rx);
 				return cop_error = rc;
 			}
 		}	while(rc != CANERR_NOERROR);
@@ -619,31 +639,31 @@ static LONG sdo_receive(BYTE node_id, WORD index, BYTE subindex, SHORT *length,
 	short t = 0;						// toggle bit
 	
 	// ---  Initiate SDO Upload  ---
-	cop_buffer[0] = 0x40;				// client command specifier
-	cop_buffer[1] = LOBYTE(index);		// multiplexor: index (LSB)
-	cop_buffer[2] = HIBYTE(index);		//              index (MSB)
-	cop_buffer[3] = (BYTE)(subindex);	//              subindex
-	cop_buffer[4] = 0x00;				// reserved: set to 00h
-	cop_buffer[5] = 0x00;				//   -"-
-	cop_buffer[6] = 0x00;				//   -"-
-	cop_buffer[7] = 0x00;				//   -"-
+	sdo_buffer[0] = 0x40;				// client command specifier
+	sdo_buffer[1] = LOBYTE(index);		// multiplexor: index (LSB)
+	sdo_buffer[2] = HIBYTE(index);		//              index (MSB)
+	sdo_buffer[3] = (BYTE)(subindex);	//              subindex
+	sdo_buffer[4] = 0x00;				// reserved: set to 00h
+	sdo_buffer[5] = 0x00;				//   -"-
+	sdo_buffer[6] = 0x00;				//   -"-
+	sdo_buffer[7] = 0x00;				//   -"-
 	n = 8;								// 8 bytes to transmit!
 
 	// 1. Configure transmit message object for client SDO
-	if((cop_error = can_config(CANBUF_TX, SDO_CLIENT + node_id, CANMSG_TRANSMIT)) != CANERR_NOERROR) {
-		can_delete(CANBUF_TX);
+	if((cop_error = can_config(sdo_tx, SDO_CLIENT + node_id, CANMSG_TRANSMIT)) != CANERR_NOERROR) {
+		can_delete(sdo_tx);
 		return cop_error;
 	}
 	// 2. Configure receive message object for server SDO 
-	if((cop_error = can_config(CANBUF_RX, SDO_SERVER + node_id, CANMSG_RECEIVE)) != CANERR_NOERROR) {
-		can_delete(CANBUF_TX);
-		can_delete(CANBUF_RX);
+	if((cop_error = can_config(sdo_rx, SDO_SERVER + node_id, CANMSG_RECEIVE)) != CANERR_NOERROR) {
+		can_delete(sdo_tx);
+		can_delete(sdo_rx);
 		return cop_error;
 	}
 	// 2. Transmit the client SDO message
-	if((cop_error = can_transmit(CANBUF_TX, n, cop_buffer)) != CANERR_NOERROR) {
-		can_delete(CANBUF_TX);
-		can_delete(CANBUF_RX);
+	if((cop_error = can_transmit(sdo_tx, n, sdo_buffer)) != CANERR_NOERROR) {
+		can_delete(sdo_tx);
+		can_delete(sdo_rx);
 		return cop_error;
 	}
 	// 3. Start timer for SDO time-out
@@ -651,106 +671,106 @@ static LONG sdo_receive(BYTE node_id, WORD index, BYTE subindex, SHORT *length,
 
 	// 4. Wait until server message is received
 	do	{
-		switch((rc = can_receive(CANBUF_RX, &n, cop_buffer)))
+		switch((rc = can_receive(sdo_rx, &n, sdo_buffer)))
 		{
 		case CANERR_NOERROR:			// confirmation:
 			if(n != 8) {								// 8 bytes received?
 				cop_error = SDOERR_GENERAL_ERROR;		//   abort: general error
-				cop_buffer[0] = 0x80;					//   command specifier
-				cop_buffer[1] = LOBYTE(index);			//   multiplexor: index (LSB)
-				cop_buffer[2] = HIBYTE(index);			//                index (MSB)
-				cop_buffer[3] = (BYTE)(subindex);		//                subindex
-				cop_buffer[4] = LOLOBYTE(cop_error);	//   abort code (LSB)
-				cop_buffer[5] = LOHIBYTE(cop_error);	//    -"-
-				cop_buffer[6] = HILOBYTE(cop_error);	//    -"-
-				cop_buffer[7] = HIHIBYTE(cop_error);	//   abort code (MSB)
+				sdo_buffer[0] = 0x80;					//   command specifier
+				sdo_buffer[1] = LOBYTE(index);			//   multiplexor: index (LSB)
+				sdo_buffer[2] = HIBYTE(index);			//                index (MSB)
+				sdo_buffer[3] = (BYTE)(subindex);		//                subindex
+				sdo_buffer[4] = LOLOBYTE(cop_error);	//   abort code (LSB)
+				sdo_buffer[5] = LOHIBYTE(cop_error);	//    -"-
+				sdo_buffer[6] = HILOBYTE(cop_error);	//    -"-
+				sdo_buffer[7] = HIHIBYTE(cop_error);	//   abort code (MSB)
 			   *length = 0;								//   no data received!
 				// Transmit SDO abort and return
-				can_transmit(CANBUF_TX, 8, cop_buffer);
-				can_delete(CANBUF_TX);
-				can_delete(CANBUF_RX);
+				can_transmit(sdo_tx, 8, sdo_buffer);
+				can_delete(sdo_tx);
+				can_delete(sdo_rx);
 				return cop_error = COPERR_LENGTH;
 			}
-			if((cop_buffer[1] != LOBYTE(index)) ||		// multiplexor? index (LSB)
-			   (cop_buffer[2] != HIBYTE(index)) ||		//              index (MSB)
-			   (cop_buffer[3] != (BYTE)(subindex))) {	//              subindex
+			if((sdo_buffer[1] != LOBYTE(index)) ||		// multiplexor? index (LSB)
+			   (sdo_buffer[2] != HIBYTE(index)) ||		//              index (MSB)
+			   (sdo_buffer[3] != (BYTE)(subindex))) {	//              subindex
 				rc = COPERR_FORMAT;
 				break;
 			}
-			if((cop_buffer[0] & 0xE0) == 0x80) {// SDO abort received?
-				LOLOBYTE(cop_error) = cop_buffer[4];	//   abort code (LSB)
-				LOHIBYTE(cop_error) = cop_buffer[5];	//    -"-
-				HILOBYTE(cop_error) = cop_buffer[6];	//    -"-
-				HIHIBYTE(cop_error) = cop_buffer[7];	//   abort code (MSB)
+			if((sdo_buffer[0] & 0xE0) == 0x80) {// SDO abort received?
+				LOLOBYTE(cop_error) = sdo_buffer[4];	//   abort code (LSB)
+				LOHIBYTE(cop_error) = sdo_buffer[5];	//    -"-
+				HILOBYTE(cop_error) = sdo_buffer[6];	//    -"-
+				HIHIBYTE(cop_error) = sdo_buffer[7];	//   abort code (MSB)
 			   *length = 0;								//   no data received!
 				// Return value is abort code!
-				can_delete(CANBUF_TX);
-				can_delete(CANBUF_RX);
+				can_delete(sdo_tx);
+				can_delete(sdo_rx);
 				return cop_error;
 			}
-			if((cop_buffer[0] & 0xE0) != 0x40) {		// unknown command specifier?
+			if((sdo_buffer[0] & 0xE0) != 0x40) {		// unknown command specifier?
 				cop_error = SDOERR_UNKNOWN_SPECIFIER;	//   abort: unknown command specifier
-				cop_buffer[0] = 0x80;					//   command specifier
-				cop_buffer[1] = LOBYTE(index);			//   multiplexor: index (LSB)
-				cop_buffer[2] = HIBYTE(index);			//                index (MSB)
-				cop_buffer[3] = (BYTE)(subindex);		//                subindex
-				cop_buffer[4] = LOLOBYTE(cop_error);	//   abort code (LSB)
-				cop_buffer[5] = LOHIBYTE(cop_error);	//    -"-
-				cop_buffer[6] = HILOBYTE(cop_error);	//    -"-
-				cop_buffer[7] = HIHIBYTE(cop_error);	//   abort code (MSB)
+				sdo_buffer[0] = 0x80;					//   command specifier
+				sdo_buffer[1] = LOBYTE(index);			//   multiplexor: index (LSB)
+				sdo_buffer[2] = HIBYTE(index);			//                index (MSB)
+				sdo_buffer[3] = (BYTE)(subindex);		//                subindex
+				sdo_buffer[4] = LOLOBYTE(cop_error);	//   abort code (LSB)
+				sdo_buffer[5] = LOHIBYTE(cop_error);	//    -"-
+				sdo_buffer[6] = HILOBYTE(cop_error);	//    -"-
+				sdo_buffer[7] = HIHIBYTE(cop_error);	//   abort code (MSB)
 			   *length = 0;								//   no data received!
 				// Transmit SDO abort and return
-				can_transmit(CANBUF_TX, 8, cop_buffer);
-				can_delete(CANBUF_TX);
-				can_delete(CANBUF_RX);
+				can_transmit(sdo_tx, 8, sdo_buffer);
+				can_delete(sdo_tx);
+				can_delete(sdo_rx);
 				return cop_error = COPERR_FORMAT;
 			}
-			if((cop_buffer[0] & 0x02) == 0x02) {		// expedited transfer?
-				if((cop_buffer[0] & 0x01) == 0x01)
-					n = 4 - (short)((cop_buffer[0] & 0x0C) >> 2);
+			if((sdo_buffer[0] & 0x02) == 0x02) {		// expedited transfer?
+				if((sdo_buffer[0] & 0x01) == 0x01)
+					n = 4 - (short)((sdo_buffer[0] & 0x0C) >> 2);
 				else
 					n = 4;
-				memcpy(data, &cop_buffer[4], n < max? n : max);
+				memcpy(data, &sdo_buffer[4], n < max? n : max);
 			   *length = n < max? n : max;				//   data received!!!
-				can_delete(CANBUF_TX);
-				can_delete(CANBUF_RX);
+				can_delete(sdo_tx);
+				can_delete(sdo_rx);
 				return cop_error = COPERR_NOERROR;
 			}
 			break;
 		case CANERR_RX_EMPTY:				// receiver empty:
 			if(can_is_timeout()) {						//   time-out occurred?
 				cop_error = SDOERR_PROTOCOL_TIMEOUT;	//   abort: time-out
-				cop_buffer[0] = 0x80;					//   command specifier
-				cop_buffer[1] = LOBYTE(index);			//   multiplexor: index (LSB)
-				cop_buffer[2] = HIBYTE(index);			//                index (MSB)
-				cop_buffer[3] = (BYTE)(subindex);		//                subindex
-				cop_buffer[4] = LOLOBYTE(cop_error);	//   abort code (LSB)
-				cop_buffer[5] = LOHIBYTE(cop_error);	//    -"-
-				cop_buffer[6] = HILOBYTE(cop_error);	//    -"-
-				cop_buffer[7] = HIHIBYTE(cop_error);	//   abort code (MSB)
+				sdo_buffer[0] = 0x80;					//   command specifier
+				sdo_buffer[1] = LOBYTE(index);			//   multiplexor: index (LSB)
+				sdo_buffer[2] = HIBYTE(index);			//                index (MSB)
+				sdo_buffer[3] = (BYTE)(subindex);		//                subindex
+				sdo_buffer[4] = LOLOBYTE(cop_error);	//   abort code (LSB)
+				sdo_buffer[5] = LOHIBYTE(cop_error);	//    -"-
+				sdo_buffer[6] = HILOBYTE(cop_error);	//    -"-
+				sdo_buffer[7] = HIHIBYTE(cop_error);	//   abort code (MSB)
 			   *length = 0;								//   no data received!
 				// Transmit SDO abort and return
-				can_transmit(CANBUF_TX, 8, cop_buffer);
-				can_delete(CANBUF_TX);
-				can_delete(CANBUF_RX);
+				can_transmit(sdo_tx, 8, sdo_buffer);
+				can_delete(sdo_tx);
+				can_delete(sdo_rx);
 				return cop_error = COPERR_TIMEOUT;
 			}
 			break;
 		default:							// other errors:
 			cop_error = SDOERR_GENERAL_ERROR;			//   abort: general error
-			cop_buffer[0] = 0x80;						//   command specifier
-			cop_buffer[1] = LOBYTE(index);				//   multiplexor: index (LSB)
-			cop_buffer[2] = HIBYTE(index);				//                index (MSB)
-			cop_buffer[3] = (BYTE)(subindex);			//            subindex
-			cop_buffer[4] = LOLOBYTE(cop_error);		// abort code (LSB)
-			cop_buffer[5] = LOHIBYTE(cop_error);		//  -"-
-			cop_buffer[6] = HILOBYTE(cop_error);		//  -"-
-			cop_buffer[7] = HIHIBYTE(cop_error);		// abort code (MSB)
+			sdo_buffer[0] = 0x80;						//   command specifier
+			sdo_buffer[1] = LOBYTE(index);				//   multiplexor: index (LSB)
+			sdo_buffer[2] = HIBYTE(index);				//                index (MSB)
+			sdo_buffer[3] = (BYTE)(subindex);			//            subindex
+			sdo_buffer[4] = LOLOBYTE(cop_error);		// abort code (LSB)
+			sdo_buffer[5] = LOHIBYTE(cop_error);		//  -"-
+			sdo_buffer[6] = HILOBYTE(cop_error);		//  -"-
+			sdo_buffer[7] = HIHIBYTE(cop_error);		// abort code (MSB)
 		   *length = 0;									//   no data received!
 			// Transmit SDO abort and return
-			can_transmit(CANBUF_TX, 8, cop_buffer);
-			can_delete(CANBUF_TX);
-			can_delete(CANBUF_RX);
+			can_transmit(sdo_tx, 8, sdo_buffer);
+			can_delete(sdo_tx);
+			can_delete(sdo_rx);
 			return cop_error = rc;
 		}
 	}	while(rc != CANERR_NOERROR);		// segmented transfer:
@@ -758,20 +778,20 @@ static LONG sdo_receive(BYTE node_id, WORD index, BYTE subindex, SHORT *length,
 	// ---  Upload SDO Segment  ---
 	for(*length = 0;;)
 	{
-		cop_buffer[0] = 0x60 | t;		// client command specifier
-		cop_buffer[1] = 0x00;			// reserved: set to 00h
-		cop_buffer[2] = 0x00;			//   -"-
-		cop_buffer[3] = 0x00;			//   -"-
-		cop_buffer[4] = 0x00;			//   -"-
-		cop_buffer[5] = 0x00;			//   -"-
-		cop_buffer[6] = 0x00;			//   -"-
-		cop_buffer[7] = 0x00;			//   -"-
+		sdo_buffer[0] = 0x60 | t;		// client command specifier
+		sdo_buffer[1] = 0x00;			// reserved: set to 00h
+		sdo_buffer[2] = 0x00;			//   -"-
+		sdo_buffer[3] = 0x00;			//   -"-
+		sdo_buffer[4] = 0x00;			//   -"-
+		sdo_buffer[5] = 0x00;			//   -"-
+		sdo_buffer[6] = 0x00;			//   -"-
+		sdo_buffer[7] = 0x00;			//   -"-
 		n = 8;							// 8 bytes to transmit!
 
 		// 5. Transmit the client SDO message
-		if((cop_error = can_transmit(CANBUF_TX, n, cop_buffer)) != CANERR_NOERROR) {
-			can_delete(CANBUF_TX);
-			can_delete(CANBUF_RX);
+		if((cop_error = can_transmit(sdo_tx, n, sdo_buffer)) != CANERR_NOERROR) {
+			can_delete(sdo_tx);
+			can_delete(sdo_rx);
 			return cop_error;
 		}
 		// 6. Start timer for SDO time-out
@@ -779,122 +799,122 @@ static LONG sdo_receive(BYTE node_id, WORD index, BYTE subindex, SHORT *length,
 
 		// 7. Wait until server message is received
 		do	{
-			switch((rc = can_receive(CANBUF_RX, &n, cop_buffer)))
+			switch((rc = can_receive(sdo_rx, &n, sdo_buffer)))
 			{
 			case CANERR_NOERROR:			// confirmation:
 				if(n != 8) {								// 8 bytes received?
 					cop_error = SDOERR_GENERAL_ERROR;		//   abort: general error
-					cop_buffer[0] = 0x80;					//   command specifier
-					cop_buffer[1] = LOBYTE(index);			//   multiplexor: index (LSB)
-					cop_buffer[2] = HIBYTE(index);			//                index (MSB)
-					cop_buffer[3] = (BYTE)(subindex);		//                subindex
-					cop_buffer[4] = LOLOBYTE(cop_error);	//   abort code (LSB)
-					cop_buffer[5] = LOHIBYTE(cop_error);	//    -"-
-					cop_buffer[6] = HILOBYTE(cop_error);	//    -"-
-					cop_buffer[7] = HIHIBYTE(cop_error);	//   abort code (MSB)
+					sdo_buffer[0] = 0x80;					//   command specifier
+					sdo_buffer[1] = LOBYTE(index);			//   multiplexor: index (LSB)
+					sdo_buffer[2] = HIBYTE(index);			//                index (MSB)
+					sdo_buffer[3] = (BYTE)(subindex);		//                subindex
+					sdo_buffer[4] = LOLOBYTE(cop_error);	//   abort code (LSB)
+					sdo_buffer[5] = LOHIBYTE(cop_error);	//    -"-
+					sdo_buffer[6] = HILOBYTE(cop_error);	//    -"-
+					sdo_buffer[7] = HIHIBYTE(cop_error);	//   abort code (MSB)
 				   *length = 0;								//   no data received!
 					// Transmit SDO abort and return
-					can_transmit(CANBUF_TX, 8, cop_buffer);
-					can_delete(CANBUF_TX);
-					can_delete(CANBUF_RX);
+					can_transmit(sdo_tx, 8, sdo_buffer);
+					can_delete(sdo_tx);
+					can_delete(sdo_rx);
 					return cop_error = COPERR_LENGTH;
 				}
-				if((cop_buffer[0] & 0xE0) == 0x80) {// SDO abort received?
-					LOLOBYTE(cop_error) = cop_buffer[4];	//   abort code (LSB)
-					LOHIBYTE(cop_error) = cop_buffer[5];	//    -"-
-					HILOBYTE(cop_error) = cop_buffer[6];	//    -"-
-					HIHIBYTE(cop_error) = cop_buffer[7];	//   abort code (MSB)
+				if((sdo_buffer[0] & 0xE0) == 0x80) {// SDO abort received?
+					LOLOBYTE(cop_error) = sdo_buffer[4];	//   abort code (LSB)
+					LOHIBYTE(cop_error) = sdo_buffer[5];	//    -"-
+					HILOBYTE(cop_error) = sdo_buffer[6];	//    -"-
+					HIHIBYTE(cop_error) = sdo_buffer[7];	//   abort code (MSB)
 				   *length = 0;								//   no data received!
 					// Return value is abort code!
-					can_delete(CANBUF_TX);
-					can_delete(CANBUF_RX);
+					can_delete(sdo_tx);
+					can_delete(sdo_rx);
 					return cop_error;
 				}
-				if((cop_buffer[0] & 0xE0) != 0x00) {		// unknown command specifier?
+				if((sdo_buffer[0] & 0xE0) != 0x00) {		// unknown command specifier?
 					cop_error = SDOERR_UNKNOWN_SPECIFIER;	//   abort: unknown command specifier
-					cop_buffer[0] = 0x80;					//   command specifier
-					cop_buffer[1] = LOBYTE(index);			//   multiplexor: index (LSB)
-					cop_buffer[2] = HIBYTE(index);			//                index (MSB)
-					cop_buffer[3] = (BYTE)(subindex);		//                subindex
-					cop_buffer[4] = LOLOBYTE(cop_error);	//   abort code (LSB)
-					cop_buffer[5] = LOHIBYTE(cop_error);	//    -"-
-					cop_buffer[6] = HILOBYTE(cop_error);	//    -"-
-					cop_buffer[7] = HIHIBYTE(cop_error);	//   abort code (MSB)
+					sdo_buffer[0] = 0x80;					//   command specifier
+					sdo_buffer[1] = LOBYTE(index);			//   multiplexor: index (LSB)
+					sdo_buffer[2] = HIBYTE(index);			//                index (MSB)
+					sdo_buffer[3] = (BYTE)(subindex);		//                subindex
+					sdo_buffer[4] = LOLOBYTE(cop_error);	//   abort code (LSB)
+					sdo_buffer[5] = LOHIBYTE(cop_error);	//    -"-
+					sdo_buffer[6] = HILOBYTE(cop_error);	//    -"-
+					sdo_buffer[7] = HIHIBYTE(cop_error);	//   abort code (MSB)
 				   *length = 0;								//   no data received!
 					// Transmit SDO abort and return
-					can_transmit(CANBUF_TX, 8, cop_buffer);
-					can_delete(CANBUF_TX);
-					can_delete(CANBUF_RX);
+					can_transmit(sdo_tx, 8, sdo_buffer);
+					can_delete(sdo_tx);
+					can_delete(sdo_rx);
 					return cop_error = COPERR_FORMAT;
 				}
-				if((cop_buffer[0] & 0x10) != t) {			// toggle bit not altered?
+				if((sdo_buffer[0] & 0x10) != t) {			// toggle bit not altered?
 					cop_error = SDOERR_WRONG_TOGGLEBIT;		//   abort: toggle bit not altered
-					cop_buffer[0] = 0x80;					//   command specifier
-					cop_buffer[1] = LOBYTE(index);			//   multiplexor: index (LSB)
-					cop_buffer[2] = HIBYTE(index);			//                index (MSB)
-					cop_buffer[3] = (BYTE)(subindex);		//                subindex
-					cop_buffer[4] = LOLOBYTE(cop_error);	//   abort code (LSB)
-					cop_buffer[5] = LOHIBYTE(cop_error);	//    -"-
-					cop_buffer[6] = HILOBYTE(cop_error);	//    -"-
-					cop_buffer[7] = HIHIBYTE(cop_error);	//  abort code (MSB)
+					sdo_buffer[0] = 0x80;					//   command specifier
+					sdo_buffer[1] = LOBYTE(index);			//   multiplexor: index (LSB)
+					sdo_buffer[2] = HIBYTE(index);			//                index (MSB)
+					sdo_buffer[3] = (BYTE)(subindex);		//                subindex
+					sdo_buffer[4] = LOLOBYTE(cop_error);	//   abort code (LSB)
+					sdo_buffer[5] = LOHIBYTE(cop_error);	//    -"-
+					sdo_buffer[6] = HILOBYTE(cop_error);	//    -"-
+					sdo_buffer[7] = HIHIBYTE(cop_error);	//  abort code (MSB)
 				   *length = 0;								//   no data received!
 					// Transmit SDO abort and return
-					can_transmit(CANBUF_TX, 8, cop_buffer);
-					can_delete(CANBUF_TX);
-					can_delete(CANBUF_RX);
+					can_transmit(sdo_tx, 8, sdo_buffer);
+					can_delete(sdo_tx);
+					can_delete(sdo_rx);
 					return cop_error = COPERR_FORMAT;
 				}
-				if((cop_buffer[0] & 0x0E) != 0x00)			// number of segment data bytes
-					n = 7 - (int)((cop_buffer[0] & 0x0E) >> 1);
+				if((sdo_buffer[0] & 0x0E) != 0x00)			// number of segment data bytes
+					n = 7 - (int)((sdo_buffer[0] & 0x0E) >> 1);
 				else
 					n = 7;
 				if(max - *length > 0)						// copy segment data if space
-					memcpy(&data[*length], &cop_buffer[1], *length + n < max? n : max - *length);
+					memcpy(&data[*length], &sdo_buffer[1], *length + n < max? n : max - *length);
 			   *length += n;
-				if((cop_buffer[0] & 0x01) == 0x01) {		// no more segments?
+				if((sdo_buffer[0] & 0x01) == 0x01) {		// no more segments?
 					if(*length > max)
 					   *length = max;						//   truncate to buffer size!
 					if(*length < max)
 						data[*length] = '\0';				//   for zero-closed strings!
-					can_delete(CANBUF_TX);
-					can_delete(CANBUF_RX);
+					can_delete(sdo_tx);
+					can_delete(sdo_rx);
 					return cop_error = COPERR_NOERROR;
 				}
 				break;
 			case CANERR_RX_EMPTY:				// receiver empty:
 				if(can_is_timeout()) {						//   time-out occurred?
 					cop_error = SDOERR_PROTOCOL_TIMEOUT;	//   abort: time-out
-					cop_buffer[0] = 0x80;					//   command specifier
-					cop_buffer[1] = LOBYTE(index);			//   multiplexor: index (LSB)
-					cop_buffer[2] = HIBYTE(index);			//                index (MSB)
-					cop_buffer[3] = (BYTE)(subindex);		//                subindex
-					cop_buffer[4] = LOLOBYTE(cop_error);	//   abort code (LSB)
-					cop_buffer[5] = LOHIBYTE(cop_error);	//    -"-
-					cop_buffer[6] = HILOBYTE(cop_error);	//    -"-
-					cop_buffer[7] = HIHIBYTE(cop_error);	//   abort code (MSB)
+					sdo_buffer[0] = 0x80;					//   command specifier
+					sdo_buffer[1] = LOBYTE(index);			//   multiplexor: index (LSB)
+					sdo_buffer[2] = HIBYTE(index);			//                index (MSB)
+					sdo_buffer[3] = (BYTE)(subindex);		//                subindex
+					sdo_buffer[4] = LOLOBYTE(cop_error);	//   abort code (LSB)
+					sdo_buffer[5] = LOHIBYTE(cop_error);	//    -"-
+					sdo_buffer[6] = HILOBYTE(cop_error);	//    -"-
+					sdo_buffer[7] = HIHIBYTE(cop_error);	//   abort code (MSB)
 				   *length = 0;								//   no data received!
 					// Transmit SDO abort and return
-					can_transmit(CANBUF_TX, 8, cop_buffer);
-					can_delete(CANBUF_TX);
-					can_delete(CANBUF_RX);
+					can_transmit(sdo_tx, 8, sdo_buffer);
+					can_delete(sdo_tx);
+					can_delete(sdo_rx);
 					return cop_error = COPERR_TIMEOUT;
 				}
 				break;
 			default:							// other errors:
 				cop_error = SDOERR_GENERAL_ERROR;			//   abort: general error
-				cop_buffer[0] = 0x80;						//   command specifier
-				cop_buffer[1] = LOBYTE(index);				//   multiplexor: index (LSB)
-				cop_buffer[2] = HIBYTE(index);				//                index (MSB)
-				cop_buffer[3] = (BYTE)(subindex);			//            subindex
-				cop_buffer[4] = LOLOBYTE(cop_error);		// abort code (LSB)
-				cop_buffer[5] = LOHIBYTE(cop_error);		//  -"-
-				cop_buffer[6] = HILOBYTE(cop_error);		//  -"-
-				cop_buffer[7] = HIHIBYTE(cop_error);		// abort code (MSB)
+				sdo_buffer[0] = 0x80;						//   command specifier
+				sdo_buffer[1] = LOBYTE(index);				//   multiplexor: index (LSB)
+				sdo_buffer[2] = HIBYTE(index);				//                index (MSB)
+				sdo_buffer[3] = (BYTE)(subindex);			//            subindex
+				sdo_buffer[4] = LOLOBYTE(cop_error);		// abort code (LSB)
+				sdo_buffer[5] = LOHIBYTE(cop_error);		//  -"-
+				sdo_buffer[6] = HILOBYTE(cop_error);		//  -"-
+				sdo_buffer[7] = HIHIBYTE(cop_error);		// abort code (MSB)
 			   *length = 0;									//   no data received!
 				// Transmit SDO abort and return
-				can_transmit(CANBUF_TX, 8, cop_buffer);
-				can_delete(CANBUF_TX);
-				can_delete(CANBUF_RX);
+				can_transmit(sdo_tx, 8, sdo_buffer);
+				can_delete(sdo_tx);
+				can_delete(sdo_rx);
 				return cop_error = rc;
 			}
 		}	while(rc != CANERR_NOERROR);
@@ -0,0 +1,342 @@
+/*	-- $Header$ --
+ *
+ *	projekt   :  CAN - Controller Area Network.
+ *
+ *	purpose   :  CANopen Gateway - Shared-Memory Ring for local clients.
+ *
+ *	copyright :  (C) 2009, UV Software, Friedrichshafen.
+ *
+ *	compiler  :  GCC - GNU C Compiler (Linux Kernel 2.6)
+ *
+ *	export    :  (see header file)
+ *
+ *	includes  :  cop_shm.h
+ *
+ *	author    :  Uwe Vogt, UV Software, Friedrichshafen
+ *
+ *	e-mail    :  uwe.vogt@uv-software.de
+ *
+ *
+ *	-----------  description  -----------------------------------------------
+ *
+ *	CANopen Master - Shared-Memory Ring for the ASCII Mapping (DS-309/3).
+ *
+ *	A slot passes through the states
+ *
+ *	    FREE -> CLAIMED -> REQUEST -> BUSY -> RESPONSE -> FREE
+ *
+ *	A client takes the next slot number from 'head' (atomic increment) and
+ *	claims the slot when it is free (compare-and-swap, so two clients of
+ *	different rounds never share a slot). It writes the request, sets the
+ *	state to REQUEST and posts 'pending'. The gateway takes the slots in
+ *	turn ('tail'): a slot in state REQUEST is taken (BUSY), and after the
+ *	execution the response is written into it (RESPONSE) and 'done' of the
+ *	slot is posted. The client copies the response and frees the slot.
+ *	The gateway looks for the next request behind the slot it has taken
+ *	last, so a slot that is claimed but never submitted (e.g. its client
+ *	has been killed) does not hold up the others.
+ *
+ *	On a multi-core processor both sides spin for COP_SHM_SPIN microseconds
+ *	before they sleep on the semaphore; sem_post() and sem_wait() only enter
+ *	the kernel when there is a sleeper, so a busy gateway and a busy client
+ *	pass the requests and responses without any system call. On a single
+ *	core the spinning would only hold up the other side, so they sleep at
+ *	once.
+ *
+ *	A client that gives up on a request (COP_SHM_TIMEOUT) marks its slot as
+ *	DROPPED (not taken yet: the gateway skips it) or ORPHANED (executed:
+ *	the gateway frees the slot instead of writing the response).
+ *
+ *
+ *	-----------  history  ---------------------------------------------------
+ *
+ *	$Log$
+ */
+
+static char _id[] = "$Id: cop_shm.c $";
+
+
+/*  -----------  includes  -------------------------------------------------
+ */
+
+#include "cop_shm.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <sched.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+
+
+/*  -----------  defines  --------------------------------------------------
+ */
+
+#define SHM_MAGIC			0x434F5052	/* "COPR" */
+
+#define SHM_FREE			0			/* slot free */
+#define SHM_CLAIMED			1			/* request being written */
+#define SHM_REQUEST			2			/* request submitted */
+#define SHM_BUSY			3			/* request executed by the gateway */
+#define SHM_RESPONSE		4			/* response written */
+#define SHM_DROPPED			5			/* request given up (not taken yet) */
+#define SHM_ORPHANED		6			/* request given up (being executed) */
+
+
+/*  -----------  types  ----------------------------------------------------
+ */
+
+
+/*  -----------  prototypes  -----------------------------------------------
+ */
+
+static int shm_sleep(sem_t *sem, long msec);
+static long long shm_spin(void);
+static long long shm_clock(void);
+
+
+/*  -----------  variables  ------------------------------------------------
+ */
+
+
+/*  -----------  functions  ------------------------------------------------
+ */
+
+COP_SHM *cop_shm_open(const char *name)
+{
+	COP_SHM *ring;
+	struct stat st;
+	int fd;
+
+	if(!name)
+		return NULL;
+	if((fd = shm_open(name, O_RDWR, 0)) < 0)
+		return NULL;
+	if(fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(COP_SHM)) {
+		close(fd);
+		return NULL;
+	}
+	ring = (COP_SHM*)mmap(NULL, sizeof(COP_SHM), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if(ring == (COP_SHM*)MAP_FAILED)
+		return NULL;
+	if(ring->magic != SHM_MAGIC) {
+		munmap(ring, sizeof(COP_SHM));
+		return NULL;
+	}
+	return ring;
+}
+
+int cop_shm_request(COP_SHM *ring, const char *request, char *response, int nbyte)
+{
+	COP_SHM_SLOT *slot;
+	long long start, spin;
+	int length;
+
+	if(!ring || !request || !response || nbyte < 1)
+		return -1;
+	if((length = (int)strlen(request)) >= COP_SHM_LENGTH)
+		return -1;
+	/* claim the next slot (it may still be used by a client of the last round) */
+	slot = &ring->slots[__sync_fetch_and_add(&ring->head, 1) % COP_SHM_SLOTS];
+	start = shm_clock();
+	while(!__sync_bool_compare_and_swap(&slot->state, SHM_FREE, SHM_CLAIMED)) {
+		if((shm_clock() - start) >= COP_SHM_TIMEOUT * 1000000LL)
+			return -1;
+		sched_yield();
+	}
+	/* submit the request */
+	memcpy(slot->data, request, length + 1);
+	slot->length = length;
+	__sync_synchronize();
+	slot->state = SHM_REQUEST;
+	sem_post(&ring->pending);
+	/* spin, then sleep until the response is written */
+	spin = shm_clock() + shm_spin();
+	while(slot->state != SHM_RESPONSE && shm_clock() < spin)
+		;
+	if(shm_sleep(&slot->done, COP_SHM_TIMEOUT * 1000L) < 0) {
+		/* give the slot back, unless the response has been written meanwhile */
+		if(__sync_bool_compare_and_swap(&slot->state, SHM_REQUEST, SHM_DROPPED) ||
+		   __sync_bool_compare_and_swap(&slot->state, SHM_BUSY, SHM_ORPHANED))
+			return -1;
+		while(sem_wait(&slot->done) < 0 && errno == EINTR)
+			;
+	}
+	__sync_synchronize();
+	if((length = slot->length) >= nbyte)
+		length = nbyte - 1;
+	memcpy(response, slot->data, length);
+	response[length] = '\0';
+	__sync_synchronize();
+	slot->state = SHM_FREE;
+	return length;
+}
+
+void cop_shm_close(COP_SHM *ring)
+{
+	if(ring)
+		munmap(ring, sizeof(COP_SHM));
+}
+
+COP_SHM *cop_shm_create(const char *name)
+{
+	COP_SHM *ring;
+	int fd, i;
+
+	if(!name)
+		return NULL;
+	shm_unlink(name);					/* left by a former gateway */
+	if((fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0666)) < 0) {
+		perror("+++ error(shm_open)");
+		return NULL;
+	}
+	if(ftruncate(fd, sizeof(COP_SHM)) < 0) {
+		perror("+++ error(ftruncate)");
+		close(fd);
+		shm_unlink(name);
+		return NULL;
+	}
+	ring = (COP_SHM*)mmap(NULL, sizeof(COP_SHM), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if(ring == (COP_SHM*)MAP_FAILED) {
+		perror("+++ error(mmap)");
+		shm_unlink(name);
+		return NULL;
+	}
+	memset(ring, 0, sizeof(COP_SHM));
+	ring->server = (int)getpid();
+	sem_init(&ring->pending, 1, 0);
+	for(i = 0; i < COP_SHM_SLOTS; i++)
+		sem_init(&ring->slots[i].done, 1, 0);
+	__sync_synchronize();
+	ring->magic = SHM_MAGIC;			/* the clients may open it now */
+	return ring;
+}
+
+int cop_shm_wait(COP_SHM *ring, int timeout)
+{
+	long long spin = shm_clock() + shm_spin();
+
+	if(!ring)
+		return 0;
+	do {
+		if(sem_trywait(&ring->pending) == 0)
+			return 1;
+	}	while(shm_clock() < spin);
+	return (shm_sleep(&ring->pending, timeout) == 0)? 1 : 0;
+}
+
+int cop_shm_fetch(COP_SHM *ring, char *request, int nbyte)
+{
+	COP_SHM_SLOT *slot;
+	int i, index, length;
+
+	if(!ring || !request || nbyte < 1)
+		return -1;
+	for(i = 0; i < COP_SHM_SLOTS; i++) {
+		index = (int)((ring->tail + i) % COP_SHM_SLOTS);
+		slot = &ring->slots[index];
+		/* a request given up by its client is skipped */
+		if(__sync_bool_compare_and_swap(&slot->state, SHM_DROPPED, SHM_FREE))
+			continue;
+		if(slot->state != SHM_REQUEST)
+			continue;
+		__sync_synchronize();
+		if((length = slot->length) >= nbyte)
+			length = nbyte - 1;
+		memcpy(request, slot->data, length);
+		request[length] = '\0';
+		if(__sync_bool_compare_and_swap(&slot->state, SHM_REQUEST, SHM_BUSY)) {
+			ring->tail = (unsigned int)(index + 1) % COP_SHM_SLOTS;
+			return index;
+		}
+		/* given up meanwhile */
+		__sync_bool_compare_and_swap(&slot->state, SHM_DROPPED, SHM_FREE);
+	}
+	return -1;
+}
+
+void cop_shm_reply(COP_SHM *ring, int slot, const char *response, int length)
+{
+	COP_SHM_SLOT *p;
+
+	if(!ring || slot < 0 || COP_SHM_SLOTS <= slot || !response)
+		return;
+	p = &ring->slots[slot];
+	if(length >= COP_SHM_LENGTH)
+		length = COP_SHM_LENGTH - 1;
+	memcpy(p->data, response, length);
+	p->data[length] = '\0';
+	p->length = length;
+	__sync_synchronize();
+	if(__sync_bool_compare_and_swap(&p->state, SHM_BUSY, SHM_RESPONSE))
+		sem_post(&p->done);
+	else								/* the client has given up */
+		p->state = SHM_FREE;
+}
+
+void cop_shm_destroy(COP_SHM *ring, const char *name)
+{
+	if(ring) {
+		ring->magic = 0;
+		munmap(ring, sizeof(COP_SHM));
+	}
+	if(name)
+		shm_unlink(name);
+}
+
+char* cop_shm_version()
+{
+	return (char*)_id;
+}
+
+/*  -----------  local functions  ------------------------------------------
+ */
+
+static int shm_sleep(sem_t *sem, long msec)
+{
+	struct timespec ts;					/* absolute time-out */
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	ts.tv_sec += msec / 1000L;
+	ts.tv_nsec += (msec % 1000L) * 1000000L;
+	if(ts.tv_nsec >= 1000000000L) {
+		ts.tv_sec++;
+		ts.tv_nsec -= 1000000000L;
+	}
+	while(sem_timedwait(sem, &ts) < 0) {
+		if(errno != EINTR)
+			return -1;
+	}
+	return 0;
+}
+
+static long long shm_spin(void)
+{
+	static int cores = 0;				/* number of processors */
+
+	if(!cores)
+		cores = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	return (cores > 1)? COP_SHM_SPIN : 0;
+}
+
+static long long shm_clock(void)
+{
+	struct timespec ts;					/* current time */
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((long long)ts.tv_sec * 1000000LL) + ((long long)ts.tv_nsec / 1000LL);
+}
+
+/*  -------------------------------------------------------------------------
+ *	Uwe Vogt,  UV Software,  Steinaecker 28,  88048 Friedrichshafen,  Germany
+ *	Fon: +49-7541-6041530, Fax. +49-1803-551809359, Cell fon: +49-170-3801903
+ *	E-Mail: uwe.vogt@uv-software.de, Internet URL: http://www.uv-software.de/
+ */
@@ -0,0 +1,205 @@
+/*	-- $Header$ --
+ *
+ *	projekt   :  CAN - Controller Area Network.
+ *
+ *	purpose   :  CANopen Gateway - Shared-Memory Ring for local clients.
+ *
+ *	copyright :  (C) 2009, UV Software, Friedrichshafen.
+ *
+ *	compiler  :  GCC - GNU C Compiler (Linux Kernel 2.6)
+ *
+ *	export    :  <export>
+ *
+ *	includes  :  (none)
+ *
+ *	author    :  Uwe Vogt, UV Software, Friedrichshafen
+ *
+ *	e-mail    :  uwe.vogt@uv-software.de
+ *
+ *
+ *	-----------  description  -----------------------------------------------
+ *
+ *	CANopen Master - Shared-Memory Ring for the ASCII Mapping (DS-309/3).
+ *
+ *		A ring of request/response slots in POSIX shared memory, created
+ *		by the gateway (cop_srv.h) and opened by the processes on the same
+ *		board which talk to it most (e.g. the IOX1 service). A client
+ *		writes its request line into a slot and waits in the same slot for
+ *		the response; no socket and no copy through the kernel is needed,
+ *		and on a multi-core processor no system call while both sides are
+ *		busy (they spin COP_SHM_SPIN microseconds before they sleep on a
+ *		semaphore).
+ *
+ *		The requests of the ring are executed by the gateway like those of
+ *		a connected client (one client for the whole ring), i.e. round-robin
+ *		with the TCP/IP clients, and the SDO commands concurrently. Each
+ *		request is answered in its slot; the event notifications are not
+ *		delivered through the ring (use a socket to receive them).
+ *
+ *		The ring can be used by several processes and threads at a time.
+ *		The ring name is the name of a POSIX shared memory object, e.g.
+ *		"/can_open" (see shm_overview(7)).
+ *
+ *
+ *	-----------  history  ---------------------------------------------------
+ *
+ *	$Log$
+ */
+
+#ifndef __COP_SHM_H
+#define __COP_SHM_H
+
+
+/*  -----------  includes  -------------------------------------------------
+ */
+
+#include <semaphore.h>					// POSIX semaphores
+
+
+/*  -----------  defines  --------------------------------------------------
+ */
+
+#define COP_SHM_SLOTS		16			/* number of slots in the ring */
+#define COP_SHM_LENGTH		1025		/* max. length of a request/response */
+#define COP_SHM_SPIN		50			/* spin before sleeping [usec] */
+#define COP_SHM_TIMEOUT		10			/* max. time for a response [s] */
+
+
+/*  -----------  types  ----------------------------------------------------
+ */
+
+typedef struct _cop_shm_slot			/* slot of the ring: */
+{
+	volatile int state;					/*   state of the slot (see cop_shm.c) */
+	int length;							/*   length of the request/response */
+	sem_t done;							/*   posted when the response is written */
+	char data[COP_SHM_LENGTH];			/*   the request, then its response */
+}	COP_SHM_SLOT;
+
+typedef struct _cop_shm					/* the ring (in shared memory): */
+{
+	volatile unsigned int magic;		/*   magic number when initialized */
+	int server;							/*   process id of the gateway */
+	sem_t pending;						/*   posted for each submitted request */
+	volatile unsigned int head;			/*   next slot to be taken by a client */
+	volatile unsigned int tail;			/*   next slot to be looked at by the gateway */
+	COP_SHM_SLOT slots[COP_SHM_SLOTS];	/*   the slots */
+}	COP_SHM;
+
+
+/*  -----------  variables  ------------------------------------------------
+ */
+
+
+/*  -----------  prototypes  -----------------------------------------------
+ */
+
+COP_SHM *cop_shm_open(const char *name);
+/*
+ *	function  :  maps the ring of a gateway (client side).
+ *
+ *	parameter :  name - name of the ring (e.g. "/can_open")
+ *
+ *	result    :  pointer to the ring, or NULL on error (e.g. the gateway
+ *	             has not created the ring).
+ */
+
+int cop_shm_request(COP_SHM *ring, const char *request, char *response, int nbyte);
+/*
+ *	function  :  executes a request by the gateway (client side): the
+ *	             request is written into a free slot of the ring, and the
+ *	             function waits up to COP_SHM_TIMEOUT seconds for its
+ *	             response. A slot whose response is late is given back to
+ *	             the gateway.
+ *
+ *	parameter :  ring     - pointer to the ring
+ *               request  - request (zero-terminated, e.g. "[1] 2 r 0x1000 0 u32")
+ *               response - buffer for the response (zero-terminated)
+ *               nbyte    - size of the buffer
+ *
+ *	result    :  length of the response, or a negative value on error
+ *	             (request too long, or no response from the gateway).
+ */
+
+void cop_shm_close(COP_SHM *ring);
+/*
+ *	function  :  unmaps the ring (client side).
+ *
+ *	parameter :  ring - pointer to the ring
+ *
+ *	result    :  (none)
+ */
+
+COP_SHM *cop_shm_create(const char *name);
+/*
+ *	function  :  creates a ring (gateway side); a ring of the same name
+ *	             left by a former gateway is replaced.
+ *
+ *	parameter :  name - name of the ring (e.g. "/can_open")
+ *
+ *	result    :  pointer to the ring, or NULL on error.
+ */
+
+int cop_shm_wait(COP_SHM *ring, int timeout);
+/*
+ *	function  :  waits for a submitted request (gateway side): it spins
+ *	             COP_SHM_SPIN microseconds (multi-core), then it sleeps.
+ *
+ *	parameter :  ring    - pointer to the ring
+ *               timeout - max. time to sleep [ms]
+ *
+ *	result    :  1 if a request has been submitted, 0 on time-out.
+ */
+
+int cop_shm_fetch(COP_SHM *ring, char *request, int nbyte);
+/*
+ *	function  :  takes the next request of the ring (gateway side);
+ *	             the slots are looked at in turn.
+ *
+ *	parameter :  ring    - pointer to the ring
+ *               request - buffer for the request (zero-terminated)
+ *               nbyte   - size of the buffer
+ *
+ *	result    :  slot of the request, or -1 if no request is ready.
+ */
+
+void cop_shm_reply(COP_SHM *ring, int slot, const char *response, int length);
+/*
+ *	function  :  writes the response to a request into its slot and
+ *	             wakes up the client (gateway side).
+ *
+ *	parameter :  ring     - pointer to the ring
+ *               slot     - slot of the request (from cop_shm_fetch)
+ *               response - the response
+ *               length   - its length
+ *
+ *	result    :  (none)
+ */
+
+void cop_shm_destroy(COP_SHM *ring, const char *name);
+/*
+ *	function  :  removes a ring (gateway side).
+ *
+ *	parameter :  ring - pointer to the ring
+ *               name - name of the ring
+ *
+ *	result    :  (none)
+ */
+
+char* cop_shm_version();
+/*
+ *	function  :  retrieve RCS info of this module as a string.
+ *
+ *	parameter :  (none)
+ *
+ *	result    :  pointer to RCS info (zero-terminated string)
+ */
+
+
+#endif	// __COP_SHM_H
+
+/*  -------------------------------------------------------------------------
+ *	Uwe Vogt,  UV Software,  Steinaecker 28,  88048 Friedrichshafen,  Germany
+ *	Fon: +49-7541-6041530, Fax. +49-1803-551809359, Cell fon: +49-170-3801903
+ *	E-Mail: uwe.vogt@uv-software.de, Internet URL: http://www.uv-software.de/
+ */
@@ -0,0 +1,1144 @@
+/*	-- $Header$ --
+ *
+ *	projekt   :  CAN - Controller Area Network.
+ *
+ *	purpose   :  CANopen Gateway Server (DS-309/3 over TCP/IP).
+ *
+ *	copyright :  (C) 2009, UV Software, Friedrichshafen.
+ *
+ *	compiler  :  GCC - GNU C Compiler (Linux Kernel 2.6)
+ *
+ *	export    :  (see header file)
+ *
+ *	includes  :  cop_srv.h (cop_tcp.h, default.h), cop_bin.h, can_defs.h, cop_api.h
+ *
+ *	author    :  Uwe Vogt, UV Software, Friedrichshafen
+ *
+ *	e-mail    :  uwe.vogt@uv-software.de
+ *
+ *
+ *	-----------  description  -----------------------------------------------
+ *
+ *	CANopen Master - Gateway Server for the ASCII Mapping (DS-309/3).
+ *
+ *	The server waits on epoll for new connections and requests, queues the
+ *	complete request lines of each client, and then starts one request of
+ *	every client with pending requests (round-robin). When the queue of a
+ *	client is full, its socket is not read until a request has been
+ *	executed. Error control events are delivered to all clients that have
+ *	enabled them, EMCY messages and CAN messages ("enable recv") to the
+ *	clients that subscribed. The subscribed CAN messages are collected by
+ *	the CANopen Master as they are received, and sent to the client with
+ *	the other events (at the latest every EVENT_POLL ms), as many as fit
+ *	into the send buffer by one send().
+ *
+ *	A client may pipeline its requests: the SDO commands (read or write of
+ *	an object) are handed to a pool of worker threads, each with its own
+ *	SDO channel, so the SDO transfers to different nodes run concurrently
+ *	and each response is sent as soon as its transfer is finished (tagged
+ *	with the sequence number of the request, so the responses may arrive
+ *	out of order). The SDO commands to the same node are executed in the
+ *	order of their reception. Any other request is executed by the server
+ *	thread itself, when all requests received before it are finished and
+ *	no SDO command is running; the requests behind it wait until then.
+ *
+ *	The sockets are non-blocking. Each client has a receive buffer which
+ *	is filled by one recv() and split into lines in user space (a line
+ *	ends with LF, CR or CR-LF), and a send buffer in which the responses
+ *	and events are collected. The send buffer is written by one send()
+ *	when the client has no more pending requests, when it is full, or at
+ *	the latest COP_SRV_DELAY after its oldest response (TCP_NODELAY is
+ *	set, so nothing else delays the responses). When a client does not
+ *	read its responses, its requests are not executed until the send
+ *	buffer has been written.
+ *
+ *	A client that sends COP_BIN_MAGIC as its first byte uses the binary
+ *	framing (see cop_bin.h) instead of the ASCII Mapping: its requests are
+ *	split by their length field and executed by cop_bin_parse(), and the
+ *	event notifications are sent to it as event frames.
+ *
+ *	The clients on the same board may connect to a second, local listening
+ *	socket (AF_UNIX), or use the shared-memory ring of cop_shm.h. The ring
+ *	is served like one more client: a poller thread waits for submitted
+ *	requests and counts them on an eventfd, which is multiplexed by epoll
+ *	like a socket; the requests are taken from the ring instead of a
+ *	receive buffer, and each response is written into the slot of its
+ *	request instead of a send buffer.
+ *
+ *	A batch of requests (cop_srv_batch) is scheduled like the requests of
+ *	one more client: its source fills the queue instead of a receive buffer,
+ *	and its sink takes the responses in order instead of a send buffer. The
+ *	calling thread executes the requests that are no SDO commands, and waits
+ *	on the wakeup pipe instead of epoll. The workers are started for the
+ *	batch and stopped behind it, so a batch cannot run while the server runs.
+ *
+ *	Every COP_SRV_STATUS seconds in which requests have been executed the
+ *	metrics of the gateway (cop_tcp_report) are printed to stderr, and
+ *	once more when the server terminates.
+ *
+ *
+ *	-----------  history  ---------------------------------------------------
+ *
+ *	$Log$
+ */
+
+static char _id[] = "$Id: cop_srv.c $";
+
+
+/*  -----------  includes  -------------------------------------------------
+ */
+
+#include "cop_srv.h"
+#include "cop_bin.h"
+
+#include "can_defs.h"
+#include "cop_api.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <poll.h>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <fcntl.h>
+#include <arpa/inet.h>
+
+
+/*  -----------  defines  --------------------------------------------------
+ */
+
+#define EVENT_POLL			100			/* poll cycle for events [ms] */
+#define COP_SRV_BUFFER		4096		/* size of the receive/send buffers */
+#define COP_SRV_DELAY		1000		/* max. delay of a response [usec] */
+#define COP_SRV_WORKERS		SDO_CHANNELS/* max. concurrent SDO commands */
+#define COP_SRV_STATUS		60			/* period of the status report [s] */
+
+#define SLOT_QUEUED			0			/* request received */
+#define SLOT_RUNNING		1			/* request executed by a worker */
+#define SLOT_DONE			2			/* response to be sent */
+#define SLOT_SENT			3			/* response sent (slot free) */
+
+#define FRAMING_NONE		0			/* first byte not received yet */
+#define FRAMING_ASCII		1			/* ASCII Mapping (DS-309/3) */
+#define FRAMING_BINARY		2			/* binary framing (cop_bin.h) */
+
+
+/*  -----------  types  ----------------------------------------------------
+ */
+
+typedef struct _client {				/* client of the gateway: */
+	int fd;								/*   socket, eventfd of the ring (or -1) */
+	COP_SHM *ring;						/*   shared-memory ring (or NULL) */
+	int closing;						/*   end of file received */
+	int blocked;						/*   send buffer not written */
+	int failed;							/*   send failed: responses discarded */
+	int framing;						/*   framing of the requests (FRAMING_xyz) */
+	unsigned int events;				/*   epoll events of interest */
+	char peer[32];						/*   address of the client */
+	COP_TCP_SETTINGS settings;			/*   settings of the client */
+	char input[COP_SRV_BUFFER];			/*   receive buffer */
+	int in_start, in_end;				/*   its unprocessed part */
+	long long stamp;					/*   time of the last reception [usec] */
+	char line[COP_SRV_LENGTH];			/*   request being split */
+	int length;							/*   its length */
+	int cr;								/*   last character was a CR */
+	char queue[COP_SRV_QUEUE][COP_SRV_LENGTH];
+	int size[COP_SRV_QUEUE];			/*   length of the requests/responses */
+	long long received[COP_SRV_QUEUE];	/*   reception time [usec] */
+	char state[COP_SRV_QUEUE];			/*   state of the requests (SLOT_xyz) */
+	int slots[COP_SRV_QUEUE];			/*   slots of the requests in the ring */
+	int nodes[COP_SRV_QUEUE];			/*   node-id of the requests (-1 if not yet taken) */
+	int results[COP_SRV_QUEUE];			/*   results of the requests */
+	unsigned long tags[COP_SRV_QUEUE];	/*   tags of the requests of a batch */
+	int head, depth;					/*   queue of pending requests */
+	COP_SRV_SINK sink;					/*   sink of a batch (or NULL) */
+	void *context;						/*   its parameter */
+	char output[COP_SRV_BUFFER];		/*   send buffer */
+	int out_length;						/*   its length */
+	long long out_time;					/*   time of its oldest response [usec] */
+	int depth_max;						/*   max. pending requests */
+	unsigned long requests;				/*   executed requests */
+	unsigned long lost;					/*   events lost (send buffer full) */
+	unsigned long long latency_sum;		/*   sum of latencies [usec] */
+	unsigned long long latency_max;		/*   max. latency [usec] */
+}	CLIENT;
+
+typedef struct _worker {				/* worker for the SDO commands: */
+	pthread_t thread;					/*   the thread */
+	pthread_cond_t start;				/*   signaled when a request is assigned */
+	BYTE channel;						/*   SDO channel (1,..,SDO_CHANNELS) */
+	CLIENT *client;						/*   client of the request (or NULL) */
+	int slot;							/*   queue slot of the request */
+	int node;							/*   node-id of the request */
+	int done;							/*   request executed */
+}	WORKER;
+
+
+/*  -----------  prototypes  -----------------------------------------------
+ */
+
+static void srv_accept(int epfd, int server, COP_TCP_SETTINGS *settings);
+static int  srv_ring(int epfd, COP_SHM *ring, COP_TCP_SETTINGS *settings);
+static void srv_fetch(CLIENT *client, int echo);
+static void srv_receive(CLIENT *client, int echo);
+static void srv_split(CLIENT *client, int echo);
+static void srv_frame(CLIENT *client);
+static void srv_enqueue(CLIENT *client, int echo);
+static int  srv_source(CLIENT *client, COP_SRV_SOURCE source);
+static int  srv_execute(int echo);
+static void srv_deliver(CLIENT *client, int echo);
+static int  srv_dispatch(CLIENT *client);
+static int  srv_queued(CLIENT *client);
+static int  srv_node(CLIENT *client, int slot);
+static void srv_parse(CLIENT *client, int slot);
+static void srv_events(int echo);
+static void srv_notify(CLIENT *client, char *notification, int echo);
+static void srv_send(CLIENT *client, char *response, int length, int echo);
+static void srv_flush(CLIENT *client);
+static void srv_update(int epfd, CLIENT *client);
+static void srv_close(int epfd, CLIENT *client);
+static int  srv_start(int epfd);
+static void srv_stop(void);
+static void srv_collect(void);
+static void *srv_worker(void *arg);
+static void *srv_poller(void *arg);
+static void srv_report(FILE *stream, CLIENT *client);
+static long long srv_clock(void);
+
+
+/*  -----------  variables  ------------------------------------------------
+ */
+
+static CLIENT clients[COP_SRV_CLIENTS];	/* connected clients */
+static CLIENT batch;					/* requests of a batch */
+static int serving = 0;					/* the server is running */
+static int connected = 0;				/* number of connected clients */
+static WORKER workers[COP_SRV_WORKERS];	/* workers for the SDO commands */
+static int started = 0;					/* number of started workers */
+static int stopping = 0;				/* the workers shall terminate */
+static int wakeup[2] = {-1, -1};		/* pipe: a worker has finished */
+static int listeners[2] = {-1, -1};		/* listening sockets (TCP/IP, local) */
+static pthread_t poller;				/* poller thread of the ring */
+static int polling = 0;					/* the poller has been started */
+static unsigned long executed = 0;		/* executed requests (all clients) */
+static pthread_mutex_t srv_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+
+/*  -----------  functions  ------------------------------------------------
+ */
+
+int cop_srv_loop(int server, int local, COP_SHM *ring, COP_TCP_SETTINGS *settings, int echo, int *running)
+{
+	struct epoll_event event, events[COP_SRV_CLIENTS + 3];
+	char buffer[64];
+	CLIENT *client;
+	long long now, reported;
+	unsigned long executed_reported = executed;
+	int epfd, progress = 0, flush, n, i;
+
+	if(server < 0 || !settings || !running)
+		return -1;
+	if(started) {						/* a batch is executed */
+		fprintf(stderr, "+++ error: the workers are in use\n");
+		return -1;
+	}
+	if((epfd = epoll_create(COP_SRV_CLIENTS + 3)) < 0) {
+		perror("+++ error(epoll_create)");
+		return -1;
+	}
+	for(i = 0; i < COP_SRV_CLIENTS; i++)
+		clients[i].fd = -1;
+	connected = 0;
+	listeners[0] = server;
+	listeners[1] = local;
+	for(i = 0; i < 2; i++) {
+		if(listeners[i] < 0)
+			continue;
+		memset(&event, 0, sizeof(event));
+		event.events = EPOLLIN;
+		event.data.ptr = (void*)&listeners[i];	/* listeners: the listening sockets */
+		if(epoll_ctl(epfd, EPOLL_CTL_ADD, listeners[i], &event) < 0) {
+			perror("+++ error(epoll_ctl)");
+			close(epfd);
+			return -1;
+		}
+	}
+	serving = 1;
+	if(srv_start(epfd) < 0 || (ring && srv_ring(epfd, ring, settings) < 0)) {
+		srv_stop();
+		for(i = 0; i < COP_SRV_CLIENTS; i++) {
+			if(clients[i].fd >= 0)
+				srv_close(epfd, &clients[i]);
+		}
+		close(epfd);
+		serving = 0;
+		return -1;
+	}
+	reported = srv_clock();
+	while(*running) {
+		/* wait for connections, requests and finished SDO commands (or poll the events) */
+		for(flush = 0, i = 0; i < COP_SRV_CLIENTS; i++)
+			flush |= (clients[i].fd >= 0 && clients[i].out_length && !clients[i].blocked);
+		if((n = epoll_wait(epfd, events, COP_SRV_CLIENTS + 3, progress? 0 : flush? 1 : EVENT_POLL)) < 0) {
+			if(errno == EINTR)
+				continue;
+			perror("+++ error(epoll_wait)");
+			break;
+		}
+		for(i = 0; i < n; i++) {
+			if(events[i].data.ptr == (void*)workers) {
+				while(read(wakeup[0], buffer, sizeof(buffer)) > 0)
+					;					/* results are taken by srv_execute */
+			}
+			else if(events[i].data.ptr == (void*)&listeners[0] || events[i].data.ptr == (void*)&listeners[1])
+				srv_accept(epfd, *(int*)events[i].data.ptr, settings);
+			else if((client = (CLIENT*)events[i].data.ptr)->fd >= 0) {
+				if(events[i].events & EPOLLOUT)
+					srv_flush(client);
+				if(events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+					srv_receive(client, echo);
+			}
+		}
+		/* send the finished responses and start one request of each client */
+		progress = srv_execute(echo);
+		/* send pending events to the clients */
+		srv_events(echo);
+		/* write the send buffers (when due) */
+		now = srv_clock();
+		for(i = 0; i < COP_SRV_CLIENTS; i++) {
+			client = &clients[i];
+			if(client->fd >= 0 && client->out_length && !client->blocked &&
+			  (!srv_queued(client) || (now - client->out_time) >= COP_SRV_DELAY))
+				srv_flush(client);
+			srv_update(epfd, client);
+		}
+		/* print the status of the gateway (when requests have been executed) */
+		if((now - reported) >= COP_SRV_STATUS * 1000000LL) {
+			if(executed != executed_reported)
+				cop_tcp_report(stderr);
+			executed_reported = executed;
+			reported = now;
+		}
+	}
+	/* wait for the running SDO commands and send their responses */
+	srv_stop();
+	for(i = 0; i < COP_SRV_CLIENTS; i++) {
+		if(clients[i].fd >= 0)
+			srv_deliver(&clients[i], echo);
+		srv_flush(&clients[i]);
+		if(clients[i].fd >= 0)
+			srv_close(epfd, &clients[i]);
+	}
+	if(executed != executed_reported)
+		cop_tcp_report(stderr);
+	close(epfd);
+	serving = 0;
+	return 0;
+}
+
+int cop_srv_batch(COP_TCP_SETTINGS *settings, COP_SRV_SOURCE source, COP_SRV_SINK sink, void *context)
+{
+	CLIENT *client = &batch;
+	struct pollfd wait;
+	char buffer[64];
+	int eof = 0;
+
+	if(!settings || !source || !sink)
+		return -1;
+	/* the workers are not shared with the server (or another batch) */
+	if(serving || started)
+		return -1;
+	if(srv_start(-1) < 0) {
+		srv_stop();
+		return -1;
+	}
+	memset(client, 0, sizeof(CLIENT));
+	strcpy(client->peer, "batch");
+	memcpy(&client->settings, settings, sizeof(COP_TCP_SETTINGS));
+	client->framing = FRAMING_ASCII;
+	client->sink = sink;
+	client->context = context;
+	client->fd = -1;
+	for(;;) {
+		/* read ahead as long as the queue takes the requests */
+		while(!eof && client->depth < COP_SRV_QUEUE)
+			eof = !srv_source(client, source);
+		/* pass the finished responses, then start the next request */
+		srv_collect();
+		srv_deliver(client, 0);
+		if(eof && !client->depth)
+			break;
+		if(srv_dispatch(client))
+			continue;
+		/* nothing can be started: wait for a worker */
+		wait.fd = wakeup[0];
+		wait.events = POLLIN;
+		if(poll(&wait, 1, -1) > 0) {
+			while(read(wakeup[0], buffer, sizeof(buffer)) > 0)
+				;
+		}
+	}
+	srv_stop();
+	memcpy(settings, &client->settings, sizeof(COP_TCP_SETTINGS));
+	return 0;
+}
+
+int cop_srv_serving(void)
+{
+	return serving;
+}
+
+int cop_srv_statistics(int client, COP_SRV_STATISTICS *statistics)
+{
+	CLIENT *p;
+
+	if(client < 1 || COP_SRV_CLIENTS < client || !statistics)
+		return -1;
+	if((p = &clients[client - 1])->fd < 0)
+		return -1;
+	statistics->client = client;
+	statistics->depth = p->depth;
+	statistics->depth_max = p->depth_max;
+	statistics->requests = p->requests;
+	statistics->latency_avg = p->requests? (unsigned long)(p->latency_sum / p->requests) : 0;
+	statistics->latency_max = (unsigned long)p->latency_max;
+	return 0;
+}
+
+void cop_srv_report(FILE *stream)
+{
+	int i;
+
+	for(i = 0; i < COP_SRV_CLIENTS; i++) {
+		if(clients[i].fd >= 0)
+			srv_report(stream, &clients[i]);
+	}
+}
+
+char* cop_srv_version()
+{
+	return (char*)_id;
+}
+
+/*  -----------  local functions  ------------------------------------------
+ */
+
+static void srv_accept(int epfd, int server, COP_TCP_SETTINGS *settings)
+{
+	struct epoll_event event;
+	struct sockaddr_storage addr;
+	struct sockaddr_in *inet = (struct sockaddr_in*)&addr;
+	socklen_t len = sizeof(addr);
+	CLIENT *client = NULL;
+	int fd, i, on = 1;
+
+	if((fd = accept(server, (struct sockaddr*)&addr, &len)) < 0) {
+		if(errno != EINTR && errno != EAGAIN)
+			perror("+++ error(accept)");
+		return;
+	}
+	for(i = 0; i < COP_SRV_CLIENTS && !client; i++) {
+		if(clients[i].fd < 0)
+			client = &clients[i];
+	}
+	if(!client) {
+		fprintf(stderr, "+++ error: too many clients (%i)\n", COP_SRV_CLIENTS);
+		close(fd);
+		return;
+	}
+	/* non-blocking, and the responses are not delayed by Nagle */
+	if(fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK) < 0)
+		perror("+++ error(fcntl)");
+	if(addr.ss_family == AF_INET && setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on)) < 0)
+		perror("+++ error(setsockopt)");
+	memset(client, 0, sizeof(CLIENT));
+	if(addr.ss_family == AF_INET)
+		snprintf(client->peer, sizeof(client->peer), "%s:%u", inet_ntoa(inet->sin_addr), ntohs(inet->sin_port));
+	else
+		strcpy(client->peer, "local");	/* e.g. the router of cop_net.h */
+	memcpy(&client->settings, settings, sizeof(COP_TCP_SETTINGS));
+	client->settings.emcy = -1;
+	client->settings.monitor = -1;
+	client->events = EPOLLIN;
+	client->fd = fd;
+	memset(&event, 0, sizeof(event));
+	event.events = client->events;
+	event.data.ptr = client;
+	if(epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &event) < 0) {
+		perror("+++ error(epoll_ctl)");
+		close(fd);
+		client->fd = -1;
+		return;
+	}
+	connected++;
+}
+
+static int srv_ring(int epfd, COP_SHM *ring, COP_TCP_SETTINGS *settings)
+{
+	struct epoll_event event;
+	CLIENT *client = &clients[0];		/* the first client (none is connected yet) */
+	int fd;
+
+	/* the poller counts the submitted requests on an eventfd */
+	if((fd = eventfd(0, EFD_NONBLOCK)) < 0) {
+		perror("+++ error(eventfd)");
+		return -1;
+	}
+	memset(client, 0, sizeof(CLIENT));
+	strcpy(client->peer, "shm");
+	memcpy(&client->settings, settings, sizeof(COP_TCP_SETTINGS));
+	client->settings.events = 0;		/* no events through the ring */
+	client->settings.emcy = -1;
+	client->settings.monitor = -1;
+	client->framing = FRAMING_ASCII;
+	client->ring = ring;
+	client->events = EPOLLIN;
+	client->fd = fd;
+	memset(&event, 0, sizeof(event));
+	event.events = client->events;
+	event.data.ptr = client;
+	if(epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &event) < 0) {
+		perror("+++ error(epoll_ctl)");
+		close(fd);
+		client->fd = -1;
+		return -1;
+	}
+	if(pthread_create(&poller, NULL, srv_poller, client) != 0) {
+		perror("+++ error(pthread_create)");
+		return -1;
+	}
+	polling = 1;
+	return 0;
+}
+
+static void srv_fetch(CLIENT *client, int echo)
+{
+	int slot;
+
+	while(client->depth < COP_SRV_QUEUE &&
+	     (slot = cop_shm_fetch(client->ring, client->line, COP_SRV_LENGTH - 1)) >= 0) {
+		/* one request line per slot */
+		if(!(client->length = (int)strcspn(client->line, "\r\n"))) {
+			cop_shm_reply(client->ring, slot, "", 0);
+			continue;
+		}
+		client->stamp = srv_clock();
+		client->slots[(client->head + client->depth) % COP_SRV_QUEUE] = slot;
+		srv_enqueue(client, echo);
+	}
+}
+
+static void srv_receive(CLIENT *client, int echo)
+{
+	uint64_t count;
+	ssize_t res;
+
+	if(client->ring) {
+		/* the counter of the poller is reset, the ring is looked at */
+		if(read(client->fd, &count, sizeof(count)) < 0 && errno != EAGAIN && errno != EINTR)
+			perror("+++ error(read)");
+		srv_split(client, echo);
+		return;
+	}
+	while(!client->closing) {
+		/* split the received data into requests (as long as the queue takes them) */
+		srv_split(client, echo);
+		if(client->depth == COP_SRV_QUEUE)
+			break;
+		/* the receive buffer is empty now: read the next chunk */
+		if((res = recv(client->fd, client->input, COP_SRV_BUFFER, 0)) < 0) {
+			if(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+				break;
+			if(errno != ECONNRESET)
+				perror("+++ error(read)");
+		}
+		if(res <= 0) {
+			/* execute the pending requests before closing */
+			client->closing = 1;
+			srv_split(client, echo);
+			break;
+		}
+		client->in_start = 0;
+		client->in_end = (int)res;
+		client->stamp = srv_clock();
+	}
+}
+
+static void srv_split(CLIENT *client, int echo)
+{
+	char chr;
+
+	if(client->ring) {
+		srv_fetch(client, echo);
+		return;
+	}
+	/* the first byte selects the framing */
+	if(client->framing == FRAMING_NONE && client->in_start < client->in_end) {
+		if((BYTE)client->input[client->in_start] == COP_BIN_MAGIC) {
+			client->framing = FRAMING_BINARY;
+			client->in_start++;
+		}
+		else
+			client->framing = FRAMING_ASCII;
+	}
+	if(client->framing == FRAMING_BINARY) {
+		srv_frame(client);
+		return;
+	}
+	while(client->in_start < client->in_end && client->depth < COP_SRV_QUEUE) {
+		chr = client->input[client->in_start++];
+		if(chr == '\n' && client->cr) {	/* LF of a CR-LF */
+			client->cr = 0;
+			continue;
+		}
+		client->cr = (chr == '\r');
+		if(chr == '\r' || chr == '\n')
+			srv_enqueue(client, echo);
+		else if(client->length + 2 < COP_SRV_LENGTH)
+			client->line[client->length++] = chr;
+	}
+	/* the last line may end without a line feed */
+	if(client->closing && client->in_start == client->in_end && client->depth < COP_SRV_QUEUE)
+		srv_enqueue(client, echo);
+}
+
+static void srv_frame(CLIENT *client)
+{
+	int n;
+
+	while(client->in_start < client->in_end && client->depth < COP_SRV_QUEUE) {
+		/* the length field, then the rest of the frame */
+		n = (client->length < 2)? 2 - client->length : 2 + ((BYTE)client->line[0] | ((BYTE)client->line[1] << 8)) - client->length;
+		if(n > client->in_end - client->in_start)
+			n = client->in_end - client->in_start;
+		memcpy(&client->line[client->length], &client->input[client->in_start], n);
+		client->in_start += n;
+		client->length += n;
+		if(client->length < 2)
+			break;
+		n = 2 + ((BYTE)client->line[0] | ((BYTE)client->line[1] << 8));
+		if(n > COP_SRV_LENGTH) {
+			/* a frame that does not fit: the stream cannot be resynchronized */
+			fprintf(stderr, "+++ error: frame too long (%i bytes)\n", n);
+			client->in_start = client->in_end;
+			client->length = 0;
+			client->closing = 1;
+			break;
+		}
+		if(client->length == n)
+			srv_enqueue(client, 0);
+	}
+	/* an incomplete frame at the end of file is discarded */
+	if(client->closing && client->in_start == client->in_end)
+		client->length = 0;
+}
+
+static void srv_enqueue(CLIENT *client, int echo)
+{
+	int i = (client->head + client->depth) % COP_SRV_QUEUE;
+
+	if(!client->length)					/* empty lines are ignored */
+		return;
+	memcpy(client->queue[i], client->line, client->length);
+	if(client->framing != FRAMING_BINARY) {
+		client->queue[i][client->length++] = '\n';
+		client->queue[i][client->length] = '\0';
+	}
+	client->size[i] = client->length;
+	client->received[i] = client->stamp;
+	client->state[i] = SLOT_QUEUED;
+	client->nodes[i] = -1;
+	client->results[i] = 0;
+	client->length = 0;
+	if(echo)
+		fputs(client->queue[i], stdout);
+	if(++client->depth > client->depth_max)
+		client->depth_max = client->depth;
+}
+
+static int srv_source(CLIENT *client, COP_SRV_SOURCE source)
+{
+	COP_SRV_REQUEST request;
+	int i = (client->head + client->depth) % COP_SRV_QUEUE;
+
+	/* the request is taken from the source (room for its line end) */
+	memset(&request, 0, sizeof(request));
+	request.text = client->line;
+	request.size = COP_SRV_LENGTH - 1;
+	request.node = -1;
+	if(!source(client->context, &request))
+		return 0;
+	client->line[COP_SRV_LENGTH - 2] = '\0';
+	client->length = (int)strlen(client->line);
+	client->stamp = srv_clock();
+	client->tags[i] = request.tag;
+	if(!request.result) {
+		srv_enqueue(client, 0);
+		return 1;
+	}
+	/* a response of the source keeps its place in the order */
+	memcpy(client->queue[i], client->line, client->length + 1);
+	client->size[i] = client->length;
+	client->received[i] = client->stamp;
+	client->state[i] = SLOT_DONE;
+	client->nodes[i] = -1;
+	client->results[i] = request.result;
+	client->length = 0;
+	if(++client->depth > client->depth_max)
+		client->depth_max = client->depth;
+	return 1;
+}
+
+static int srv_execute(int echo)
+{
+	static int first = 0;				/* first client of the round */
+	CLIENT *client;
+	int i, k, next = first, n = 0;
+
+	/* take the results of the workers */
+	srv_collect();
+	for(i = 0; i < COP_SRV_CLIENTS; i++) {
+		k = (first + i) % COP_SRV_CLIENTS;
+		client = &clients[k];
+		if(client->fd < 0 || !client->depth)
+			continue;
+		/* send the responses of the finished requests */
+		srv_deliver(client, echo);
+		/* start (or execute) the next request, unless the client does not read */
+		if(!client->blocked && srv_dispatch(client)) {
+			srv_deliver(client, echo);
+			next = k + 1;				/* the next round starts behind it */
+			n++;
+		}
+		/* take the next request from the receive buffer */
+		srv_split(client, echo);
+	}
+	first = next % COP_SRV_CLIENTS;
+	return n;
+}
+
+static void srv_deliver(CLIENT *client, int echo)
+{
+	COP_SRV_REQUEST request;
+	long long latency;
+	int i, slot;
+
+	for(i = 0; i < client->depth; i++) {
+		slot = (client->head + i) % COP_SRV_QUEUE;
+		if(client->state[slot] != SLOT_DONE) {
+			if(client->sink)			/* the responses of a batch in order */
+				break;
+			continue;
+		}
+		if(client->sink) {
+			request.text = client->queue[slot];
+			request.size = COP_SRV_LENGTH;
+			request.node = client->nodes[slot];
+			request.result = client->results[slot];
+			request.tag = client->tags[slot];
+			client->sink(client->context, &request);
+		}
+		else if(client->ring) {
+			/* the response is written into the slot of its request */
+			cop_shm_reply(client->ring, client->slots[slot], client->queue[slot], client->size[slot]);
+			if(echo)
+				fwrite(client->queue[slot], 1, client->size[slot], stdout);
+		}
+		else {
+			/* the response must fit into the send buffer */
+			if(COP_SRV_BUFFER - client->out_length < COP_SRV_LENGTH) {
+				srv_flush(client);
+				if(COP_SRV_BUFFER - client->out_length < COP_SRV_LENGTH)
+					break;
+			}
+			srv_send(client, client->queue[slot], client->size[slot], echo);
+		}
+		client->state[slot] = SLOT_SENT;
+		latency = srv_clock() - client->received[slot];
+		client->requests++;
+		executed++;
+		client->latency_sum += (unsigned long long)latency;
+		if((unsigned long long)latency > client->latency_max)
+			client->latency_max = (unsigned long long)latency;
+	}
+	/* free the slots at the head of the queue */
+	while(client->depth && client->state[client->head] == SLOT_SENT) {
+		client->head = (client->head + 1) % COP_SRV_QUEUE;
+		client->depth--;
+	}
+}
+
+static int srv_dispatch(CLIENT *client)
+{
+	WORKER *worker;
+	int earlier = 0;					/* a request before is not finished */
+	int i, j, slot, node;
+
+	for(i = 0; i < client->depth; i++) {
+		slot = (client->head + i) % COP_SRV_QUEUE;
+		if(client->state[slot] == SLOT_RUNNING)
+			earlier = 1;
+		if(client->state[slot] != SLOT_QUEUED)
+			continue;
+		/* the node-id is taken once (the requests before it have been started) */
+		if(client->nodes[slot] < 0)
+			client->nodes[slot] = srv_node(client, slot);
+		if(!(node = client->nodes[slot])) {
+			/* any other request waits for the requests before and the running SDO commands */
+			for(j = 0; j < COP_SRV_WORKERS && !earlier; j++)
+				earlier = (workers[j].client != NULL);
+			if(earlier)
+				return 0;
+			srv_parse(client, slot);
+			client->state[slot] = SLOT_DONE;
+			return 1;
+		}
+		/* an SDO command waits while its node is busy (the next one may go) */
+		for(worker = NULL, j = 0; j < COP_SRV_WORKERS; j++) {
+			if(workers[j].client && workers[j].node == node)
+				break;
+			if(!workers[j].client && !worker)
+				worker = &workers[j];
+		}
+		if(j < COP_SRV_WORKERS) {
+			earlier = 1;
+			continue;
+		}
+		if(!worker)						/* all workers are busy */
+			return 0;
+		pthread_mutex_lock(&srv_mutex);
+		worker->client = client;
+		worker->slot = slot;
+		worker->node = node;
+		worker->done = 0;
+		pthread_cond_signal(&worker->start);
+		pthread_mutex_unlock(&srv_mutex);
+		client->state[slot] = SLOT_RUNNING;
+		return 1;
+	}
+	return 0;
+}
+
+static int srv_queued(CLIENT *client)
+{
+	int i, n = 0;
+
+	for(i = 0; i < client->depth; i++)
+		n += (client->state[(client->head + i) % COP_SRV_QUEUE] == SLOT_QUEUED);
+	return n;
+}
+
+static int srv_node(CLIENT *client, int slot)
+{
+	if(client->framing == FRAMING_BINARY)
+		return cop_bin_node((BYTE*)client->queue[slot], client->size[slot], &client->settings);
+	else
+		return cop_tcp_node(client->queue[slot], &client->settings);
+}
+
+static void srv_parse(CLIENT *client, int slot)
+{
+	char *request = client->queue[slot];
+
+	/* execute the request (in place) */
+	if(client->framing == FRAMING_BINARY)
+		client->size[slot] = cop_bin_parse((BYTE*)request, client->size[slot], &client->settings, (BYTE*)request, COP_SRV_LENGTH);
+	else {
+		client->results[slot] = cop_tcp_parse(request, &client->settings, request, COP_SRV_LENGTH);
+		client->size[slot] = (int)strlen(request);
+	}
+}
+
+static void srv_events(int echo)
+{
+	char buffer[COP_SRV_LENGTH];
+	NMT_EVENT event;
+	int i;
+
+	if(!connected)						/* events are kept until a client connects */
+		return;
+	/* emergency messages (per subscription) */
+	for(i = 0; i < COP_SRV_CLIENTS; i++) {
+		while(clients[i].fd >= 0 && cop_tcp_emcy(&clients[i].settings, buffer, COP_SRV_LENGTH))
+			srv_notify(&clients[i], buffer, echo);
+	}
+	/* CAN messages (per subscription) */
+	for(i = 0; i < COP_SRV_CLIENTS; i++) {
+		while(clients[i].fd >= 0 && cop_tcp_message(&clients[i].settings, buffer, COP_SRV_LENGTH))
+			srv_notify(&clients[i], buffer, echo);
+	}
+	/* error control events (to all clients) */
+	while(nmt_event(&event) == COPERR_NOERROR) {
+		for(i = 0; i < COP_SRV_CLIENTS; i++) {
+			if(clients[i].fd >= 0 && cop_tcp_notify(&clients[i].settings, &event, buffer, COP_SRV_LENGTH))
+				srv_notify(&clients[i], buffer, echo);
+		}
+	}
+}
+
+static void srv_notify(CLIENT *client, char *notification, int echo)
+{
+	char frame[COP_SRV_LENGTH];
+
+	if(client->ring)					/* no events through the ring */
+		return;
+	if(client->framing == FRAMING_BINARY)
+		srv_send(client, frame, cop_bin_event(notification, (BYTE*)frame, COP_SRV_LENGTH), echo);
+	else
+		srv_send(client, notification, (int)strlen(notification), echo);
+}
+
+static void srv_send(CLIENT *client, char *response, int length, int echo)
+{
+	if(client->failed)					/* the client is gone */
+		return;
+	if(COP_SRV_BUFFER - client->out_length < length)
+		srv_flush(client);
+	if(client->fd < 0 || client->failed)
+		return;
+	if(COP_SRV_BUFFER - client->out_length < length) {
+		client->lost++;					/* the client does not read */
+		return;
+	}
+	if(!client->out_length)
+		client->out_time = srv_clock();
+	memcpy(&client->output[client->out_length], response, length);
+	client->out_length += length;
+	if(echo && client->framing != FRAMING_BINARY)
+		fwrite(response, 1, length, stdout);
+}
+
+static void srv_flush(CLIENT *client)
+{
+	ssize_t res;
+	int i, slot;
+
+	if(client->fd < 0 || !client->out_length)
+		return;
+	if((res = send(client->fd, client->output, client->out_length, MSG_NOSIGNAL)) < 0) {
+		if(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+			client->blocked = 1;		/* wait for EPOLLOUT */
+			return;
+		}
+		if(errno != EPIPE && errno != ECONNRESET)
+			perror("+++ error(write)");
+		/* the client is gone: discard its requests and responses
+		 * (the requests being executed by a worker are finished first) */
+		for(i = 0; i < client->depth; i++) {
+			slot = (client->head + i) % COP_SRV_QUEUE;
+			if(client->state[slot] != SLOT_RUNNING)
+				client->state[slot] = SLOT_SENT;
+		}
+		while(client->depth && client->state[client->head] == SLOT_SENT) {
+			client->head = (client->head + 1) % COP_SRV_QUEUE;
+			client->depth--;
+		}
+		client->closing = 1;
+		client->failed = 1;
+		client->out_length = 0;
+		client->blocked = 0;
+		return;
+	}
+	if(res < client->out_length) {
+		memmove(client->output, &client->output[res], client->out_length - res);
+		client->out_length -= (int)res;
+		client->out_time = srv_clock();
+		client->blocked = 1;
+	}
+	else {
+		client->out_length = 0;
+		client->blocked = 0;
+	}
+}
+
+static void srv_update(int epfd, CLIENT *client)
+{
+	struct epoll_event event;
+	unsigned int events;
+
+	if(client->fd < 0)
+		return;
+	/* close the connection when all is done */
+	if(client->closing && !client->depth && !client->out_length) {
+		srv_close(epfd, client);
+		return;
+	}
+	/* read while the queue has room, write while the socket is blocked */
+	events = (!client->closing && client->depth < COP_SRV_QUEUE)? EPOLLIN : 0;
+	events |= client->blocked? EPOLLOUT : 0;
+	if(events != client->events) {
+		/* without events of interest the socket is removed from epoll
+		 * (a hang-up would be reported while its SDO commands are running) */
+		memset(&event, 0, sizeof(event));
+		event.events = events;
+		event.data.ptr = client;
+		if(epoll_ctl(epfd, !client->events? EPOLL_CTL_ADD : !events? EPOLL_CTL_DEL : EPOLL_CTL_MOD, client->fd, &event) < 0)
+			perror("+++ error(epoll_ctl)");
+		client->events = events;
+	}
+}
+
+static void srv_close(int epfd, CLIENT *client)
+{
+	srv_report(stderr, client);
+	cop_tcp_close(&client->settings);
+	if(client->events)
+		epoll_ctl(epfd, EPOLL_CTL_DEL, client->fd, NULL);
+	close(client->fd);
+	client->fd = -1;
+	if(!client->ring)
+		connected--;
+	client->ring = NULL;
+}
+
+static int srv_start(int epfd)
+{
+	struct epoll_event event;
+	int i;
+
+	/* the workers signal a finished SDO command through a pipe (epoll of the server) */
+	if(pipe(wakeup) < 0) {
+		perror("+++ error(pipe)");
+		return -1;
+	}
+	for(i = 0; i < 2; i++)
+		fcntl(wakeup[i], F_SETFL, fcntl(wakeup[i], F_GETFL, 0) | O_NONBLOCK);
+	memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN;
+	event.data.ptr = (void*)workers;	/* workers: the pipe */
+	if(epfd >= 0 && epoll_ctl(epfd, EPOLL_CTL_ADD, wakeup[0], &event) < 0) {
+		perror("+++ error(epoll_ctl)");
+		return -1;
+	}
+	/* one worker for each SDO channel */
+	stopping = 0;
+	for(started = 0; started < COP_SRV_WORKERS; started++) {
+		memset(&workers[started], 0, sizeof(WORKER));
+		pthread_cond_init(&workers[started].start, NULL);
+		workers[started].channel = (BYTE)(started + 1);
+		if(pthread_create(&workers[started].thread, NULL, srv_worker, &workers[started]) != 0) {
+			perror("+++ error(pthread_create)");
+			pthread_cond_destroy(&workers[started].start);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+static void srv_stop(void)
+{
+	int i;
+
+	/* the workers finish their SDO commands before they terminate */
+	pthread_mutex_lock(&srv_mutex);
+	stopping = 1;
+	for(i = 0; i < started; i++)
+		pthread_cond_signal(&workers[i].start);
+	pthread_mutex_unlock(&srv_mutex);
+	for(i = 0; i < started; i++)
+		pthread_join(workers[i].thread, NULL);
+	if(polling)
+		pthread_join(poller, NULL);
+	polling = 0;
+	srv_collect();
+	for(i = 0; i < started; i++)
+		pthread_cond_destroy(&workers[i].start);
+	started = 0;
+	for(i = 0; i < 2; i++) {
+		if(wakeup[i] >= 0)
+			close(wakeup[i]);
+		wakeup[i] = -1;
+	}
+}
+
+static void srv_collect(void)
+{
+	int i;
+
+	pthread_mutex_lock(&srv_mutex);
+	for(i = 0; i < started; i++) {
+		if(workers[i].client && workers[i].done) {
+			workers[i].client->state[workers[i].slot] = SLOT_DONE;
+			workers[i].client = NULL;
+			workers[i].done = 0;
+		}
+	}
+	pthread_mutex_unlock(&srv_mutex);
+}
+
+static void *srv_worker(void *arg)
+{
+	WORKER *worker = (WORKER*)arg;
+	CLIENT *client;
+	int slot;
+
+	/* each worker has its own message buffers for the SDO transfers */
+	sdo_channel(worker->channel);
+	pthread_mutex_lock(&srv_mutex);
+	while(!stopping || (worker->client && !worker->done)) {
+		if(!worker->client || worker->done) {
+			pthread_cond_wait(&worker->start, &srv_mutex);
+			continue;
+		}
+		client = worker->client;
+		slot = worker->slot;
+		pthread_mutex_unlock(&srv_mutex);
+		/* execute the SDO command (in place) */
+		srv_parse(client, slot);
+		pthread_mutex_lock(&srv_mutex);
+		worker->done = 1;
+		if(write(wakeup[1], "", 1) < 0 && errno != EAGAIN)
+			perror("+++ error(write)");
+	}
+	pthread_mutex_unlock(&srv_mutex);
+	return NULL;
+}
+
+static void *srv_poller(void *arg)
+{
+	CLIENT *client = (CLIENT*)arg;
+	uint64_t one = 1;
+
+	/* wake up the server for each request submitted to the ring */
+	while(!stopping) {
+		if(cop_shm_wait(client->ring, EVENT_POLL) &&
+		   write(client->fd, &one, sizeof(one)) < 0 && errno != EAGAIN)
+			perror("+++ error(write)");
+	}
+	return NULL;
+}
+
+static void srv_report(FILE *stream, CLIENT *client)
+{
+	unsigned long long avg = client->requests? client->latency_sum / client->requests : 0ULL;
+
+	fprintf(stream, "Client %i (%s): %lu requests, queue depth %i (max. %i), latency %llu.%03llu ms (max. %llu.%03llu ms)",
+	        (int)(client - clients) + 1, client->peer, client->requests, client->depth, client->depth_max,
+	        avg / 1000ULL, avg % 1000ULL, client->latency_max / 1000ULL, client->latency_max % 1000ULL);
+	if(client->lost)
+		fprintf(stream, ", %lu events lost", client->lost);
+	fputc('\n', stream);
+}
+
+static long long srv_clock(void)
+{
+	struct timespec ts;					/* current time */
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((long long)ts.tv_sec * 1000000LL) + ((long long)ts.tv_nsec / 1000LL);
+}
+
+/*  -------------------------------------------------------------------------
+ *	Uwe Vogt,  UV Software,  Steinaecker 28,  88048 Friedrichshafen,  Germany
+ *	Fon: +49-7541-6041530, Fax. +49-1803-551809359, Cell fon: +49-170-3801903
+ *	E-Mail: uwe.vogt@uv-software.de, Internet URL: http://www.uv-software.de/
+ */
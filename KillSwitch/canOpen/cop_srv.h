@@ -0,0 +1,195 @@
+/*	-- $Header$ --
+ *
+ *	projekt   :  CAN - Controller Area Network.
+ *
+ *	purpose   :  CANopen Gateway Server (DS-309/3 over TCP/IP).
+ *
+ *	copyright :  (C) 2009, UV Software, Friedrichshafen.
+ *
+ *	compiler  :  GCC - GNU C Compiler (Linux Kernel 2.6)
+ *
+ *	export    :  <export>
+ *
+ *	includes  :  cop_tcp.h (default.h), cop_shm.h
+ *
+ *	author    :  Uwe Vogt, UV Software, Friedrichshafen
+ *
+ *	e-mail    :  uwe.vogt@uv-software.de
+ *
+ *
+ *	-----------  description  -----------------------------------------------
+ *
+ *	CANopen Master - Gateway Server for the ASCII Mapping (DS-309/3).
+ *
+ *		Serves several TCP/IP clients at a time. The connections are
+ *		multiplexed by epoll; the requests of each client are queued and
+ *		executed round-robin (one request per client and round), so that
+ *		no client can starve the others of the CANopen Master.
+ *
+ *		The requests can be pipelined: SDO commands to different nodes
+ *		are executed concurrently (one SDO channel per worker thread),
+ *		and each response is sent as soon as it is available, tagged
+ *		with the sequence number of its request.
+ *
+ *		A client may use the binary framing of cop_bin.h instead of
+ *		the ASCII Mapping; it is selected by the first byte received.
+ *
+ *		The clients on the same board may connect to a local (AF_UNIX)
+ *		socket instead, or pass their requests through the shared-memory
+ *		ring of cop_shm.h, without the costs of the TCP/IP stack.
+ *
+ *		A batch of requests (e.g. a command file, see cop_exe.h) is
+ *		executed by the same scheduler, when the server is not running.
+ *
+ *
+ *	-----------  history  ---------------------------------------------------
+ *
+ *	$Log$
+ */
+
+#ifndef __COP_SRV_H
+#define __COP_SRV_H
+
+
+/*  -----------  includes  -------------------------------------------------
+ */
+
+#include "cop_tcp.h"					// Interfacing CANopen with TCP/IP
+#include "cop_shm.h"					// Shared-memory ring for local clients
+
+#include <stdio.h>						// Standard I/O routines
+
+
+/*  -----------  defines  --------------------------------------------------
+ */
+
+#define COP_SRV_CLIENTS		16			/* max. number of clients */
+#define COP_SRV_QUEUE		8			/* max. pending requests per client */
+#define COP_SRV_LENGTH		1025		/* max. length of a request */
+
+
+/*  -----------  types  ----------------------------------------------------
+ */
+
+typedef struct _cop_srv_statistics		/* statistics of a client: */
+{
+	int client;							/*   client number */
+	int depth;							/*   pending requests */
+	int depth_max;						/*   max. pending requests */
+	unsigned long requests;				/*   executed requests */
+	unsigned long latency_avg;			/*   avg. latency [usec] */
+	unsigned long latency_max;			/*   max. latency [usec] */
+}	COP_SRV_STATISTICS;
+
+typedef struct _cop_srv_request			/* request of a batch: */
+{
+	char *text;							/*   request, then its response */
+	int size;							/*   size of the buffer */
+	int node;							/*   node-id of an SDO command, 0 for any
+										 *   other request, -1 if not executed */
+	int result;							/*   result of cop_tcp_parse (or of the source) */
+	unsigned long tag;					/*   tag of the source (e.g. its line) */
+}	COP_SRV_REQUEST;
+
+typedef int  (*COP_SRV_SOURCE)(void *context, COP_SRV_REQUEST *request);
+typedef void (*COP_SRV_SINK)(void *context, COP_SRV_REQUEST *request);
+
+
+/*  -----------  variables  ------------------------------------------------
+ */
+
+
+/*  -----------  prototypes  -----------------------------------------------
+ */
+
+int cop_srv_loop(int server, int local, COP_SHM *ring, COP_TCP_SETTINGS *settings, int echo, int *running);
+/*
+ *	function  :  serves the clients of a listening socket, of a local
+ *	             listening socket and of a shared-memory ring until the
+ *	             flag 'running' is cleared (e.g. by a signal handler).
+ *	             Each client starts with a copy of the given settings.
+ *	             Its requests are executed round-robin with the requests
+ *	             of the other clients; the latency of a request is the
+ *	             time from its reception until its response is sent.
+ *	             The responses of SDO commands to different nodes may be
+ *	             sent in another order than the requests were received.
+ *
+ *	parameter :  server   - listening socket
+ *               local    - local listening socket (AF_UNIX), or -1
+ *               ring     - shared-memory ring (cop_shm_create), or NULL
+ *               settings - default settings of the gateway
+ *               echo     - echo requests and responses to stdout
+ *               running  - pointer to the run flag
+ *
+ *	result    :  0 if successful, or a negative value on error.
+ */
+
+int cop_srv_batch(COP_TCP_SETTINGS *settings, COP_SRV_SOURCE source, COP_SRV_SINK sink, void *context);
+/*
+ *	function  :  executes a batch of requests, as the requests of a client
+ *	             are executed by the server: the source is called for the
+ *	             next request while the queue has room, and the sink for
+ *	             each response in the order of the requests.
+ *	             The source writes a request (zero-terminated) into the
+ *	             buffer, may set its tag, and returns 0 at the end. With
+ *	             a result other than 0 the text is a response already
+ *	             (e.g. to an invalid line), which is not executed.
+ *	             The settings are changed by the requests as by requests
+ *	             entered one by one.
+ *
+ *	parameter :  settings - settings of the gateway (as for cop_tcp_parse)
+ *               source   - function for the next request
+ *               sink     - function for each response
+ *               context  - parameter of the source and the sink
+ *
+ *	result    :  0 if successful (even if requests failed), or a negative
+ *	             value if the server is running (its workers are in use),
+ *	             or the workers cannot be started.
+ */
+
+int cop_srv_serving(void);
+/*
+ *	function  :  tells if the server is running (cop_srv_loop).
+ *
+ *	parameter :  (none)
+ *
+ *	result    :  non-zero if the server is running, otherwise 0.
+ */
+
+int cop_srv_statistics(int client, COP_SRV_STATISTICS *statistics);
+/*
+ *	function  :  retrieves the queue depth and latency of a client.
+ *
+ *	parameter :  client     - client number (1,..,COP_SRV_CLIENTS)
+ *               statistics - pointer to a buffer for the statistics
+ *
+ *	result    :  0 if successful, or a negative value if the client is
+ *	             not connected.
+ */
+
+void cop_srv_report(FILE *stream);
+/*
+ *	function  :  prints the queue depth and latency of all clients.
+ *
+ *	parameter :  stream - output stream
+ *
+ *	result    :  (none)
+ */
+
+char* cop_srv_version();
+/*
+ *	function  :  retrieve RCS info of this module as a string.
+ *
+ *	parameter :  (none)
+ *
+ *	result    :  pointer to RCS info (zero-terminated string)
+ */
+
+
+#endif	// __COP_SRV_H
+
+/*  -------------------------------------------------------------------------
+ *	Uwe Vogt,  UV Software,  Steinaecker 28,  88048 Friedrichshafen,  Germany
+ *	Fon: +49-7541-6041530, Fax. +49-1803-551809359, Cell fon: +49-170-3801903
+ *	E-Mail: uwe.vogt@uv-software.de, Internet URL: http://www.uv-software.de/
+ */
@@ -0,0 +1,275 @@
+/*	-- $Header$ --
+ *
+ *	Projekt   :  CAN - Controller Area Network.
+ *
+ *	Zweck     :  CANopen Master SYNC - Synchronization Object.
+ *
+ *	Copyright :  (c) 2005-2009 by UV Software, Friedrichshafen.
+ *
+ *	Compiler  :  GCC - GNU C Compiler (Linux Kernel 2.6)
+ *
+ *	Export    :  (siehe Header-Datei)
+ *
+ *	Include   :  cop_api.h (can_defs.h, windows.h), can_ctrl.h
+ *
+ *	Autor     :  Uwe Vogt, UV Software.
+ *
+ *	E-Mail    :  uwe.vogt@uv-software.de
+ *
+ *
+ *	-----------  Modulbeschreibung  ------------------------------------------
+ *
+ *	CANopen Master SYNC - Synchronization Object.
+ *
+ *		Implements the SYNC producer according to CiA DS-301 (Version 4.02
+ *		of February 13, 2002).
+ *
+ *		The SYNC message is transmitted by a dedicated thread with its own
+ *		message object (CANBUF_SYNC). The thread sleeps until the absolute
+ *		time of the next cycle on CLOCK_MONOTONIC (clock_nanosleep with
+ *		TIMER_ABSTIME), so the cycle period does not drift with the time
+ *		needed for the transmission. Optionally the thread is scheduled
+ *		with SCHED_FIFO (requires CAP_SYS_NICE).
+ *
+ *		The period jitter, i.e. the deviation of the time between two
+ *		consecutive SYNC messages from the communication cycle period,
+ *		is recorded in a histogram with logarithmic classes.
+ *
+ *
+ *	-----------  nderungshistorie  ------------------------------------------
+ *
+ *	$Log$
+ */
+
+#ifdef _DEBUG
+ static char _id[] = "$Id: cop_syn.c $ _DEBUG";
+#else
+ static char _id[] = "$Id: cop_syn.c $";
+#endif
+
+/*	-----------  Include-Dateien  --------------------------------------------
+ */
+
+#include "cop_api.h"					// Interface prototypes
+#include "can_ctrl.h"					// CAN Controller interface
+
+#include <stdio.h>						// Standard I/O routines
+#include <errno.h>						// System wide error numbers
+#include <string.h>						// String manipulation functions
+#include <stdlib.h>						// Commonly used library functions
+#include <time.h>						// Clocks and timers
+#include <sched.h>						// Scheduling policies
+#include <pthread.h>					// POSIX threads
+
+
+/*	-----------  Definitionen  -----------------------------------------------
+ */
+
+#define SYNC_MIN_PERIOD			100		// Minimal cycle period [usec]
+
+
+/*	-----------  Typen  ------------------------------------------------------
+ */
+
+
+/*	-----------  Prototypen  -------------------------------------------------
+ */
+
+static void *sync_producer(void *arg);
+static long long sync_clock(void);
+static int sync_class(long long jitter);
+
+
+/*	-----------  Variablen  --------------------------------------------------
+ */
+
+extern __thread LONG cop_error;			// last error code (per thread)
+static pthread_t sync_thread;			// SYNC producer thread
+static pthread_mutex_t sync_mutex = PTHREAD_MUTEX_INITIALIZER;
+static volatile int sync_running = FALSE;// thread is running
+static DWORD sync_period = 0;			// communication cycle period [usec]
+static BYTE  sync_overflow = 0;			// synchronous counter overflow value
+static SYNC_STATISTICS sync_stats;		// period jitter statistics
+static DWORD sync_samples = 0;			// number of jitter samples
+
+
+/*	-----------  Funktionen  -------------------------------------------------
+ */
+
+LONG sync_start(DWORD cycle_period, BYTE counter_overflow, LONG priority)
+{
+	pthread_attr_t attr;				// thread attributes
+	struct sched_param param;			// scheduling parameter
+	int rc;								// return value
+
+	if(sync_running)					// already started?
+		return cop_error = COPERR_ONLINE;
+	if(cycle_period < SYNC_MIN_PERIOD)	// cycle period too short?
+		return cop_error = COPERR_ILLPARA;
+	if(counter_overflow == 1 || 240 < counter_overflow)
+		return cop_error = COPERR_ILLPARA;	// counter: 0 or 2,..,240
+	if(priority < 0 || 99 < priority)	// priority: 0 or 1,..,99
+		return cop_error = COPERR_ILLPARA;
+
+	// 1. Configure transmit message object for SYNC
+	if((cop_error = can_config(CANBUF_SYNC, SYNC_COB_ID, CANMSG_TRANSMIT)) != CANERR_NOERROR) {
+		can_delete(CANBUF_SYNC);
+		return cop_error;
+	}
+	// 2. Reset the statistics
+	pthread_mutex_lock(&sync_mutex);
+	memset(&sync_stats, 0, sizeof(sync_stats));
+	sync_stats.cycle_period = cycle_period;
+	sync_period = cycle_period;
+	sync_overflow = counter_overflow;
+	sync_samples = 0;
+	pthread_mutex_unlock(&sync_mutex);
+
+	// 3. Start the SYNC producer thread (real-time if requested)
+	sync_running = TRUE;
+	rc = -1;
+	if(priority > 0) {
+		pthread_attr_init(&attr);
+		pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+		pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+		param.sched_priority = (int)priority;
+		pthread_attr_setschedparam(&attr, &param);
+		pthread_mutex_lock(&sync_mutex);	// the producer may be running
+		if((rc = pthread_create(&sync_thread, &attr, sync_producer, NULL)) == 0)
+			sync_stats.priority = priority;
+		pthread_mutex_unlock(&sync_mutex);
+		pthread_attr_destroy(&attr);
+	}
+	if(rc != 0) {						// normal scheduling (or EPERM)
+		if(pthread_create(&sync_thread, NULL, sync_producer, NULL) != 0) {
+			sync_running = FALSE;
+			can_delete(CANBUF_SYNC);
+			return cop_error = COPERR_FATAL;
+		}
+	}
+	return cop_error = COPERR_NOERROR;
+}
+
+LONG sync_stop(void)
+{
+	if(!sync_running)					// not started?
+		return cop_error = COPERR_NOERROR;
+
+	// 1. Stop the SYNC producer thread
+	sync_running = FALSE;
+	pthread_join(sync_thread, NULL);
+
+	// 2. Delete the message object
+	can_delete(CANBUF_SYNC);
+	return cop_error = COPERR_NOERROR;
+}
+
+LONG sync_statistics(SYNC_STATISTICS *statistics, BOOL reset)
+{
+	if(statistics == NULL)				// null pointer assignment?
+		return cop_error = COPERR_NULLPTR;
+
+	pthread_mutex_lock(&sync_mutex);
+	memcpy(statistics, &sync_stats, sizeof(SYNC_STATISTICS));
+	if(reset) {							// reset the counters
+		memset(sync_stats.histogram, 0, sizeof(sync_stats.histogram));
+		sync_stats.count = 0;
+		sync_stats.errors = 0;
+		sync_stats.overruns = 0;
+		sync_stats.jitter_min = 0;
+		sync_stats.jitter_max = 0;
+		sync_samples = 0;
+	}
+	pthread_mutex_unlock(&sync_mutex);
+	return sync_running? COPERR_NOERROR : COPERR_OFFLINE;
+}
+
+LPSTR sync_version(void)
+{
+	return (LPSTR)_id;					// Revision number
+}
+
+/*	-----------  Lokale Funktionen  ------------------------------------------
+ */
+
+static void *sync_producer(void *arg)
+{
+	struct timespec next;				// absolute time of the next cycle
+	long long period = (long long)sync_period * 1000LL;
+	long long t_next, t_now, t_last = 0;// times in [nsec]
+	long long jitter, missed;			// period jitter in [nsec]
+	BYTE counter = 1;					// synchronous counter
+	int cls;							// histogram class
+	short rc;							// return value
+
+	t_next = sync_clock();
+	while(sync_running) {
+		// 1. Sleep until the absolute time of the next cycle
+		t_next += period;
+		next.tv_sec = (time_t)(t_next / 1000000000LL);
+		next.tv_nsec = (long)(t_next % 1000000000LL);
+		while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR)
+			;
+		if(!sync_running)
+			break;
+		t_now = sync_clock();
+
+		// 2. Transmit the SYNC message (with or without counter)
+		rc = can_transmit(CANBUF_SYNC, sync_overflow? 1 : 0, &counter);
+		if(sync_overflow)
+			counter = (counter < sync_overflow)? counter + 1 : 1;
+
+		// 3. Update the statistics
+		pthread_mutex_lock(&sync_mutex);
+		if(rc == CANERR_NOERROR) {
+			if(t_last) {
+				jitter = (t_now - t_last) - period;
+				if(!sync_samples || jitter / 1000LL < sync_stats.jitter_min)
+					sync_stats.jitter_min = (LONG)(jitter / 1000LL);
+				if(!sync_samples || jitter / 1000LL > sync_stats.jitter_max)
+					sync_stats.jitter_max = (LONG)(jitter / 1000LL);
+				cls = sync_class(jitter);
+				sync_stats.histogram[cls]++;
+				sync_samples++;
+			}
+			sync_stats.count++;
+			t_last = t_now;
+		}
+		else
+			sync_stats.errors++;
+		// Skip the cycles which have been missed completely
+		if((missed = (t_now - t_next) / period) > 0) {
+			sync_stats.overruns += (DWORD)missed;
+			t_next += missed * period;
+		}
+		pthread_mutex_unlock(&sync_mutex);
+	}
+	arg = arg;
+	return NULL;
+}
+
+static long long sync_clock(void)
+{
+	struct timespec ts;					// current time
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((long long)ts.tv_sec * 1000000000LL) + (long long)ts.tv_nsec;
+}
+
+static int sync_class(long long jitter)
+{
+	long long usec = (jitter < 0? -jitter : jitter) / 1000LL;
+	int cls = 0;						// class 0: below 1 usec
+
+	while(usec > 0 && cls < SYNC_HISTOGRAM - 1) {
+		usec >>= 1;						// class n: 2^(n-1),..,2^n-1 usec
+		cls++;
+	}
+	return cls;
+}
+
+/*	--------------------------------------------------------------------------
+ *	Uwe Vogt,  UV Software,  Steinaecker 28,  88048 Friedrichshafen,  Germany
+ *	Fon: +49-7541-6041530, Fax. +49-1803-551809359, Cell fon: +49-170-3801903
+ *	E-Mail: uwe.vogt@uv-software.de, Internet URL: http://www.uv-software.de/
+ */
@@ -10,7 +10,7 @@
  *
  *	export    :  (see header file)
  *
- *	includes  :  cop_tcp.h (default.h), can_defs.h, cop_api.h, base64.h
+ *	includes  :  cop_tcp.h (default.h), cop_exe.h, can_defs.h, cop_api.h, base64.h
  *
  *	author    :  Uwe Vogt, UV Software, Friedrichshafen
  *
@@ -21,6 +21,15 @@
  *
  *	CANopen Master - Interfacing CANopen with TCP/IP (ASCII Mapping).
  *
+ *	Each request is counted with its latency and its result in the metrics
+ *	of its command class (and of its node for an SDO command). They are
+ *	updated with atomic operations only, so the workers of the server need
+ *	no lock, and can be read by the "status" command or cop_tcp_report().
+ *
+ *	In check mode (cop_tcp_check) a request is parsed as it is executed,
+ *	but nothing is done on the CANopen network (nor waited for). It is
+ *	used by the "exec" command to verify a command file (see cop_exe.c).
+ *
  *
  *	-----------  history  ---------------------------------------------------
  *
@@ -34,6 +43,7 @@ static char _id[] = "$Id: cop_tcp.c 34 2009-02-25 20:31:10Z saturn $";
  */
 
 #include "cop_tcp.h"
+#include "cop_exe.h"
 
 #include "can_defs.h"
 #include "cop_api.h"
@@ -55,7 +65,6 @@ static char _id[] = "$Id: cop_tcp.c 34 2009-02-25 20:31:10Z saturn $";
 #define DECIMAL(x)			('0' <= (x) && (x) <= '9')
 #define OCTAL(x)			('0' <= (x) && (x) <= '7')
 #define HEXADECIMAL(x)		('0' <= (x) && (x) <= '9')||('a' <= (x) && (x) <= 'f')||('A' <= (x) && (x) <= 'F')
-#define BASE64(x)			('0' <= (x) && (x) <= '9')||('a' <= (x) && (x) <= 'z')||('A' <= (x) && (x) <= 'Z')||((x) == '+')||((x) == '/')
 
 /* *** **
 #define SDO_BOOLEAN			0x1
@@ -89,6 +98,7 @@ static char _id[] = "$Id: cop_tcp.c 34 2009-02-25 20:31:10Z saturn $";
 #define ERROR_SYNTAX		101
 #define ERROR_NOT_PROCESSED	102
 #define ERROR_TIMEOUT		103
+#define ERROR_UNSUPPORTED_NET	106
 #define ERROR_EXIT			900
 #define ERROR_FATAL			999
 
@@ -161,19 +171,71 @@ static char _id[] = "$Id: cop_tcp.c 34 2009-02-25 20:31:10Z saturn $";
 #define VISIBLE_STRING		62
 #define WAIT				63
 #define WRITE				64
+#define IDENTITY			65
+#define SCAN				66
+#define STATUS				67
+#define CHECK				68
+#define MASK				69
+#define RATE				70
+#define COMMISSION			71
+
+#define COMMISSION_NODES	32			/* max. nodes of a commission request */
+
+#define METRIC_CODES		64			/* slots for error and abort codes */
+#define METRIC_ABORT		1000		/* results from here: SDO abort codes */
 
 
 /*  -----------  types  ----------------------------------------------------
  */
 
+typedef struct _keyword {				/* keyword of the command language: */
+	char *string;						/*   keyword in lower case */
+	int length;							/*   length of the keyword */
+	int token;							/*   token for the keyword */
+}	KEYWORD;
+
+#define KEY(s,t)			{s, sizeof(s) - 1, t}
+
+typedef struct _metric {				/* metrics of a command class or node: */
+	unsigned long errors;				/*   error codes of DS-309/3 */
+	unsigned long aborts;				/*   SDO abort codes */
+	unsigned long long latency_sum;		/*   sum of latencies [usec] */
+	unsigned long latency_max;			/*   max. latency [usec] */
+	unsigned long histogram[COP_TCP_HISTOGRAM];
+}	METRIC;								/*   class 0 = below 1 usec, class n = 2^(n-1) to 2^n-1 usec
+										 *   (the number of requests is their sum) */
+
+typedef struct _metric_code {			/* counter of an error or abort code: */
+	unsigned long code;					/*   the code (0: slot free) */
+	unsigned long count;				/*   number of occurrences */
+}	METRIC_CODE;
+
 
 /*  -----------  prototypes  -----------------------------------------------
  */
 
+static int parse_request(char *request, COP_TCP_SETTINGS *settings, char *response, int nbyte, int *command, int *target);
 static int read_object(unsigned long nr, unsigned char net, unsigned char node, char *request, char *response, int nbyte);
 static int write_object(unsigned long nr, unsigned char net, unsigned char node, char *request, char *response, int nbyte);
 static int send_message(unsigned long nr, unsigned char net, char *request, char *response, int nbyte);
 static int recv_message(unsigned long nr, unsigned char net, char *response, int nbyte);
+static int recv_subscribe(unsigned long nr, char *request, COP_TCP_SETTINGS *settings, char *response, int nbyte);
+static int recv_statistics(unsigned long nr, COP_TCP_SETTINGS *settings, char *response, int nbyte);
+static int read_sync(unsigned long nr, char *response, int nbyte);
+static int read_error(unsigned long nr, unsigned char node, char *response, int nbyte);
+static int read_identity(unsigned long nr, unsigned char node, char *response, int nbyte);
+static int scan_nodes(unsigned long nr, char *response, int nbyte);
+static int read_status(unsigned long nr, char *request, char *response, int nbyte);
+static int make_status(unsigned long nr, METRIC *metric, char *response, int nbyte);
+static int exec_file(unsigned long nr, char *request, COP_TCP_SETTINGS *settings, char *response, int nbyte);
+static int commission_nodes(unsigned long nr, char *request, char *response, int nbyte);
+
+static int metric_command(int token);
+static int metric_class(unsigned long usec);
+static unsigned long metric_count(METRIC *metric);
+static void metric_add(METRIC *metric, unsigned long usec, unsigned long result);
+static void metric_code(unsigned long code);
+static void metric_report(FILE *stream, char *name, METRIC *metric);
 
 static int make_string(char *buffer, int nbyte);
 static int make_base64(char *buffer, int length, int nbyte);
@@ -184,6 +246,7 @@ static int character(char *line, int *pos);
 static int token(char *line, int *pos);
 static int compare(char *string, char *keyword);
 
+static int ascii2number(char *line, int *pos, int bits, int sign, unsigned long *value);
 static int ascii2unsigned8(char *line, int *pos, unsigned char *value);
 static int ascii2unsigned16(char *line, int *pos, unsigned short *value);
 static int ascii2unsigned32(char *line, int *pos, unsigned long *value);
@@ -197,11 +260,232 @@ static int ascii2string(char *line, int *pos, char *buffer, int *length, int nby
 /*  -----------  variables  ------------------------------------------------
  */
 
+/* keywords by their first character, in order of precedence: the first
+ * keyword that is a prefix of the input is taken (e.g. "comm" must come
+ * after "communication", "e" after all other keywords starting with 'e')
+ */
+static KEYWORD keywords_b[] = {
+	KEY("b", BOOLEAN),
+	{NULL, 0, -1}
+};
+
+static KEYWORD keywords_c[] = {
+	KEY("communication", COMMUNICATION),
+	KEY("commission", COMMISSION),
+	KEY("comm", COMMUNICATION),
+	KEY("copyright", COPYRIGHT),
+	KEY("check", CHECK),
+	{NULL, 0, -1}
+};
+
+static KEYWORD keywords_d[] = {
+	KEY("disable", DISABLE),
+	KEY("d", DOMAIN),
+	{NULL, 0, -1}
+};
+
+static KEYWORD keywords_e[] = {
+	KEY("emcy", EMCY),
+	KEY("enable", ENABLE),
+	KEY("error", ERROR),
+	KEY("event", EVENT),
+	KEY("execute", EXECUTE),
+	KEY("exec", EXECUTE),
+	KEY("exit", EXIT),
+	KEY("e", ERROR),
+	{NULL, 0, -1}
+};
+
+static KEYWORD keywords_f[] = {
+	KEY("firmware", FIRMWARE),
+	{NULL, 0, -1}
+};
+
+static KEYWORD keywords_g[] = {
+	KEY("guarding", GUARDING),
+	{NULL, 0, -1}
+};
+
+static KEYWORD keywords_h[] = {
+	KEY("hardware", HARDWARE),
+	KEY("heartbeat", HEARTBEAT),
+	{NULL, 0, -1}
+};
+
+static KEYWORD keywords_i[] = {
+	KEY("i8", INTEGER8),
+	KEY("i16", INTEGER16),
+	KEY("i24", INTEGER24),
+	KEY("i32", INTEGER32),
+	KEY("i40", INTEGER40),
+	KEY("i48", INTEGER48),
+	KEY("i56", INTEGER56),
+	KEY("i64", INTEGER64),
+	KEY("identity", IDENTITY),
+	KEY("id", ID),
+	KEY("info", INFO),
+	KEY("init", INIT),
+	{NULL, 0, -1}
+};
+
+static KEYWORD keywords_m[] = {
+	KEY("mask", MASK),
+	{NULL, 0, -1}
+};
+
+static KEYWORD keywords_n[] = {
+	KEY("network", NETWORK),
+	KEY("node", NODE),
+	{NULL, 0, -1}
+};
+
+static KEYWORD keywords_o[] = {
+	KEY("ok", OK),
+	KEY("os", OCTET_STRING),
+	{NULL, 0, -1}
+};
+
+static KEYWORD keywords_p[] = {
+	KEY("pdo", PDO),
+	KEY("preoperational", PREOPERATIONAL),
+	KEY("preop", PREOPERATIONAL),
+	KEY("p", PDO),
+	{NULL, 0, -1}
+};
+
+static KEYWORD keywords_r[] = {
+	KEY("r32", REAL32),
+	KEY("r64", REAL64),
+	KEY("rate", RATE),
+	KEY("read", READ),
+	KEY("receive", RECEIVE),
+	KEY("recv", RECEIVE),
+	KEY("restore", RESTORE),
+	KEY("reset", RESET),
+	KEY("rpdo", RPDO),
+	KEY("rtr", RTR),
+	KEY("r", READ),
+	{NULL, 0, -1}
+};
+
+static KEYWORD keywords_s[] = {
+	KEY("scan", SCAN),
+	KEY("sdo_timeout", SDO_TIME_OUT),
+	KEY("set", SET),
+	KEY("send", SEND),
+	KEY("software", SOFTWARE),
+	KEY("start", START),
+	KEY("status", STATUS),
+	KEY("stop", STOP),
+	KEY("store", STORE),
+	KEY("sync", SYNC),
+	{NULL, 0, -1}
+};
+
+static KEYWORD keywords_t[] = {
+	KEY("td", TIME_DIFFERENCE),
+	KEY("tpdo", TPDO),
+	KEY("t", TIME_OF_DAY),
+	{NULL, 0, -1}
+};
+
+static KEYWORD keywords_u[] = {
+	KEY("u8", UNSIGNED8),
+	KEY("u16", UNSIGNED16),
+	KEY("u24", UNSIGNED24),
+	KEY("u32", UNSIGNED32),
+	KEY("u40", UNSIGNED40),
+	KEY("u48", UNSIGNED48),
+	KEY("u56", UNSIGNED56),
+	KEY("u64", UNSIGNED64),
+	KEY("user", USER),
+	KEY("us", UNICODE_STRING),
+	{NULL, 0, -1}
+};
+
+static KEYWORD keywords_v[] = {
+	KEY("version", VERSION),
+	KEY("vs", VISIBLE_STRING),
+	{NULL, 0, -1}
+};
+
+static KEYWORD keywords_w[] = {
+	KEY("wait", WAIT),
+	KEY("write", WRITE),
+	KEY("w", WRITE),
+	{NULL, 0, -1}
+};
+
+static KEYWORD *keywords[26] = {
+	NULL, keywords_b, keywords_c, keywords_d, keywords_e, keywords_f,
+	keywords_g, keywords_h, keywords_i, NULL, NULL, NULL,
+	keywords_m, keywords_n, keywords_o, keywords_p, NULL, keywords_r,
+	keywords_s, keywords_t, keywords_u, keywords_v, keywords_w, NULL,
+	NULL, NULL
+};
+
+/* value of a digit plus one (zero: not a digit) */
+static unsigned char digits[256] = {
+	['0'] = 1, ['1'] = 2, ['2'] = 3, ['3'] = 4, ['4'] = 5,
+	['5'] = 6, ['6'] = 7, ['7'] = 8, ['8'] = 9, ['9'] = 10,
+	['A'] = 11, ['B'] = 12, ['C'] = 13, ['D'] = 14, ['E'] = 15, ['F'] = 16,
+	['a'] = 11, ['b'] = 12, ['c'] = 13, ['d'] = 14, ['e'] = 15, ['f'] = 16
+};
+
+
+/* metrics of the command classes, of the SDO commands to each node, and
+ * the counters of the error and abort codes (open addressing)
+ */
+static METRIC metrics[COP_TCP_COMMANDS];
+static METRIC nodes[128];
+static METRIC_CODE codes[METRIC_CODES];
+static unsigned long codes_lost = 0;
+
+static char *commands[COP_TCP_COMMANDS] = {
+	"read", "write", "start", "stop", "preop", "reset", "enable", "disable",
+	"set", "info", "init", "scan", "send", "recv", "wait", "status", "other"
+};
+
+/* the request is only parsed (check mode of the calling thread) */
+static __thread int checking = 0;
+
+/* the networks served by this process (see cop_tcp_networks) */
+static unsigned char net_first = 1, net_last = 1;
+
 
 /*  -----------  functions  ------------------------------------------------
  */
 
 int cop_tcp_parse(char *request, COP_TCP_SETTINGS *settings, char *response, int nbyte)
+{
+	struct timespec t0, t1;
+	int command = -1, node = 0, rc;
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	rc = parse_request(request, settings, response, nbyte, &command, &node);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	cop_tcp_measure(metric_command(command), node,
+	                ((long long)(t1.tv_sec - t0.tv_sec) * 1000000LL) + ((long long)(t1.tv_nsec - t0.tv_nsec) / 1000LL),
+	                (unsigned long)rc);
+	return rc;
+}
+
+int cop_tcp_check(char *request, COP_TCP_SETTINGS *settings, char *response, int nbyte)
+{
+	unsigned long sequence = 0;
+	int command = -1, node = 0, rc;
+
+	checking = 1;
+	rc = parse_request(request, settings, response, nbyte, &command, &node);
+	checking = 0;
+	if(!rc && response) {
+		cop_tcp_sequence(request, &sequence);
+		snprintf(response, nbyte, "[%lu] OK\r\n", sequence);
+	}
+	return rc;
+}
+
+static int parse_request(char *request, COP_TCP_SETTINGS *settings, char *response, int nbyte, int *command, int *target)
 {
 	unsigned long sequence = 0;
 	unsigned char net = 0, number1;
@@ -209,7 +493,9 @@ int cop_tcp_parse(char *request, COP_TCP_SETTINGS *settings, char *response, int
 	unsigned short timeout;
 	unsigned short baudrate;
 	unsigned short heartbeat;
-	unsigned char master;
+	unsigned char master, factor;
+	unsigned long period;
+	unsigned char overflow, priority;
 	time_t now = time(NULL);
 	size_t prefix;
 	int pos = 0, chr;
@@ -256,20 +542,63 @@ int cop_tcp_parse(char *request, COP_TCP_SETTINGS *settings, char *response, int
 		node = settings->node;
 		net = settings->net;
 	}
+	if(net < net_first || net_last < net)
+		return make_error(response, nbyte, sequence, ERROR_UNSUPPORTED_NET);
 	/* scan the command */
-	switch(token(request, &pos)) {
+	switch((*command = token(request, &pos))) {
 	case DISABLE:
 		/* token DISABLE read: */
 		if((chr = lookahead(request, &pos)) == -1)
 			return make_error(response, nbyte, sequence, ERROR_SYNTAX);
 		/* scan next token */
 		switch(token(request, &pos)) {
+		case EMCY:
+			/* token EMCY read: execute Unsubscribe Emergency command */
+			if(settings->emcy >= 0 && !checking)
+				emcy_unsubscribe(settings->emcy);
+			settings->emcy = -1;
+			snprintf(response, nbyte, "[%lu] OK\r\n", sequence);
+			break;
+		case RECEIVE:
+			/* token RECEIVE read: execute Unsubscribe CAN Messages command */
+			if(settings->monitor >= 0 && !checking)
+				mon_unsubscribe(settings->monitor);
+			settings->monitor = -1;
+			snprintf(response, nbyte, "[%lu] OK\r\n", sequence);
+			break;
+		case EVENT:
+			/* token EVENT read: execute Disable Event Notification command */
+			settings->events = 0;
+			snprintf(response, nbyte, "[%lu] OK\r\n", sequence);
+			break;
 		case GUARDING:
-			//@ToDo: disable node guarding
-			return make_error(response, nbyte, sequence, ERROR_NOT_SUPPORTED);
+			/* token GUARDING read: execute Disable Node Guarding command */
+			if(!checking && nmt_node_guarding(node, 0, 0) != COPERR_NOERROR) {
+				return make_error(response, nbyte, sequence, ERROR_NOT_PROCESSED);
+			}
+			snprintf(response, nbyte, "[%lu] OK\r\n", sequence);
+			break;
 		case HEARTBEAT:
-			//@ToDo: disable heartbeat
-			return make_error(response, nbyte, sequence, ERROR_NOT_SUPPORTED);
+			/* token HEARTBEAT read: execute Stop Heartbeat Consumer command */
+			if(!checking && nmt_heartbeat_consumer(node, 0) != COPERR_NOERROR) {
+				return make_error(response, nbyte, sequence, ERROR_NOT_PROCESSED);
+			}
+			snprintf(response, nbyte, "[%lu] OK\r\n", sequence);
+			break;
+		case SCAN:
+			/* token SCAN read: execute Stop Boot-up Scan command */
+			if(!checking && scan_stop() != COPERR_NOERROR) {
+				return make_error(response, nbyte, sequence, ERROR_NOT_PROCESSED);
+			}
+			snprintf(response, nbyte, "[%lu] OK\r\n", sequence);
+			break;
+		case SYNC:
+			/* token SYNC read: execute Stop SYNC producer command */
+			if(!checking && sync_stop() != COPERR_NOERROR) {
+				return make_error(response, nbyte, sequence, ERROR_NOT_PROCESSED);
+			}
+			snprintf(response, nbyte, "[%lu] OK\r\n", sequence);
+			break;
 		default:
 			return make_error(response, nbyte, sequence, ERROR_SYNTAX);
 		}
@@ -280,12 +609,83 @@ int cop_tcp_parse(char *request, COP_TCP_SETTINGS *settings, char *response, int
 			return make_error(response, nbyte, sequence, ERROR_SYNTAX);
 		/* scan next token */
 		switch(token(request, &pos)) {
+		case EMCY:
+			/* token EMCY read: execute Subscribe Emergency command */
+			if(settings->emcy < 0 && !checking && (settings->emcy = emcy_subscribe(NMT_ALL)) < 0) {
+				settings->emcy = -1;
+				return make_error(response, nbyte, sequence, ERROR_NOT_PROCESSED);
+			}
+			snprintf(response, nbyte, "[%lu] OK\r\n", sequence);
+			break;
+		case RECEIVE:
+			/* token RECEIVE read: execute Subscribe CAN Messages command */
+			return recv_subscribe(sequence, &request[pos], settings, response, nbyte);
+		case EVENT:
+			/* token EVENT read: execute Enable Event Notification command */
+			settings->events = 1;
+			snprintf(response, nbyte, "[%lu] OK\r\n", sequence);
+			break;
 		case GUARDING:
-			//@ToDo: enable node guarding
-			return make_error(response, nbyte, sequence, ERROR_NOT_SUPPORTED);
+			/* token GUARDING read: */
+			if((chr = lookahead(request, &pos)) == -1)
+				return make_error(response, nbyte, sequence, ERROR_SYNTAX);
+			/* scan the <guarding-time> */
+			if(!ascii2unsigned16(request, &pos, &timeout))
+				return make_error(response, nbyte, sequence, ERROR_SYNTAX);
+			if((chr = lookahead(request, &pos)) == -1)
+				return make_error(response, nbyte, sequence, ERROR_SYNTAX);
+			/* scan the <lifetime-factor> */
+			if(!ascii2unsigned8(request, &pos, &factor))
+				return make_error(response, nbyte, sequence, ERROR_SYNTAX);
+			/* execute Enable Node Guarding command */
+			if(!checking && nmt_node_guarding(node, timeout, factor) != COPERR_NOERROR) {
+				return make_error(response, nbyte, sequence, ERROR_NOT_PROCESSED);
+			}
+			snprintf(response, nbyte, "[%lu] OK\r\n", sequence);
+			break;
 		case HEARTBEAT:
-			//@ToDo: enable heartbeat
-			return make_error(response, nbyte, sequence, ERROR_NOT_SUPPORTED);
+			/* token HEARTBEAT read: */
+			if((chr = lookahead(request, &pos)) == -1)
+				return make_error(response, nbyte, sequence, ERROR_SYNTAX);
+			/* scan the <heartbeat-time> */
+			if(!ascii2unsigned16(request, &pos, &heartbeat))
+				return make_error(response, nbyte, sequence, ERROR_SYNTAX);
+			/* execute Start Heartbeat Consumer command */
+			if(!checking && nmt_heartbeat_consumer(node, heartbeat) != COPERR_NOERROR) {
+				return make_error(response, nbyte, sequence, ERROR_NOT_PROCESSED);
+			}
+			snprintf(response, nbyte, "[%lu] OK\r\n", sequence);
+			break;
+		case SCAN:
+			/* token SCAN read: execute Start Boot-up Scan command */
+			if(!checking && scan_start() != COPERR_NOERROR) {
+				return make_error(response, nbyte, sequence, ERROR_NOT_PROCESSED);
+			}
+			snprintf(response, nbyte, "[%lu] OK\r\n", sequence);
+			break;
+		case SYNC:
+			/* token SYNC read: */
+			if((chr = lookahead(request, &pos)) == -1)
+				return make_error(response, nbyte, sequence, ERROR_SYNTAX);
+			/* scan the <cycle-period> */
+			if(!ascii2unsigned32(request, &pos, &period))
+				return make_error(response, nbyte, sequence, ERROR_SYNTAX);
+			/* scan the optional [<counter-overflow> [<priority>]] */
+			overflow = priority = 0;
+			if(DECIMAL(chr = lookahead(request, &pos))) {
+				if(!ascii2unsigned8(request, &pos, &overflow))
+					return make_error(response, nbyte, sequence, ERROR_SYNTAX);
+				if(DECIMAL(chr = lookahead(request, &pos))) {
+					if(!ascii2unsigned8(request, &pos, &priority))
+						return make_error(response, nbyte, sequence, ERROR_SYNTAX);
+				}
+			}
+			/* execute Start SYNC producer command */
+			if(!checking && sync_start((DWORD)period, (BYTE)overflow, (LONG)priority) != COPERR_NOERROR) {
+				return make_error(response, nbyte, sequence, ERROR_NOT_PROCESSED);
+			}
+			snprintf(response, nbyte, "[%lu] OK\r\n", sequence);
+			break;
 		default:
 			return make_error(response, nbyte, sequence, ERROR_SYNTAX);
 		}
@@ -321,6 +721,9 @@ int cop_tcp_parse(char *request, COP_TCP_SETTINGS *settings, char *response, int
 			snprintf(response, nbyte, "[%lu] \"%s", sequence, cop_version());
 			make_string(&response[prefix], nbyte - prefix);
 			break;
+		case RECEIVE:
+			/* token RECEIVE read: counters of the CAN message subscription */
+			return recv_statistics(sequence, settings, response, nbyte);
 		case COPYRIGHT:
 			/* token COPYRIGHT read:  */
 			snprintf(response, nbyte, "[%lu] \"Copyright (C) 2008-%u UV Software, Friedrichshafen.\"\r\n", sequence, 1900+localtime(&now)->tm_year);
@@ -348,14 +751,14 @@ int cop_tcp_parse(char *request, COP_TCP_SETTINGS *settings, char *response, int
 		case 10: baudrate = 8; break;
 		}
 		/* execute Initialize Gateway command */
-		if(cop_reset((BYTE)baudrate) != COPERR_NOERROR) {
+		if(!checking && cop_reset((BYTE)baudrate) != COPERR_NOERROR) {
 			return make_error(response, nbyte, sequence, ERROR_NOT_PROCESSED);
 		}
 		snprintf(response, nbyte, "[%lu] OK\r\n", sequence);
 		break;
 	case PREOPERATIONAL:
 		/* token PREOPERATIONAL read: execute NMT Enter Pre-operational command */
-		if(nmt_enter_preoperational(node) != COPERR_NOERROR) {
+		if(!checking && nmt_enter_preoperational(node) != COPERR_NOERROR) {
 			return make_error(response, nbyte, sequence, ERROR_NOT_PROCESSED);
 		}
 		snprintf(response, nbyte, "[%lu] OK\r\n", sequence);
@@ -366,17 +769,24 @@ int cop_tcp_parse(char *request, COP_TCP_SETTINGS *settings, char *response, int
 			return make_error(response, nbyte, sequence, ERROR_SYNTAX);
 		if(DECIMAL(chr)) {
 			/* execute Upload SDO command */
+			*target = node;
 			return read_object(sequence, net, node, &request[pos], response, nbyte);
 		}
 		else {
 			/* scan next token */
 			switch(token(request, &pos)) {
 			case ERROR:
-				//@ToDo: read the f*cking manual!
-				return make_error(response, nbyte, sequence, ERROR_NOT_SUPPORTED);
+				/* token ERROR read: execute Read Device Error command */
+				return read_error(sequence, node, response, nbyte);
+			case IDENTITY:
+				/* token IDENTITY read: execute Read Node Identity command */
+				return read_identity(sequence, node, response, nbyte);
 			case PDO:
 				//@ToDo: read the f*cking manual!
 				return make_error(response, nbyte, sequence, ERROR_NOT_SUPPORTED);
+			case SYNC:
+				/* token SYNC read: execute Read SYNC statistics command */
+				return read_sync(sequence, response, nbyte);
 			default:
 				return make_error(response, nbyte, sequence, ERROR_SYNTAX);
 			}
@@ -390,14 +800,14 @@ int cop_tcp_parse(char *request, COP_TCP_SETTINGS *settings, char *response, int
 		switch(token(request, &pos)) {
 		case NODE:
 			/* token NODE read: execute NMT Reset Node command */
-			if(nmt_reset_node(node) != COPERR_NOERROR) {
+			if(!checking && nmt_reset_node(node) != COPERR_NOERROR) {
 				return make_error(response, nbyte, sequence, ERROR_NOT_PROCESSED);
 			}
 			snprintf(response, nbyte, "[%lu] OK\r\n", sequence);
 			break;
 		case COMMUNICATION:
 			/* token NODE read: execute NMT Reset Communication command */
-			if(nmt_reset_communication(node) != COPERR_NOERROR) {
+			if(!checking && nmt_reset_communication(node) != COPERR_NOERROR) {
 				return make_error(response, nbyte, sequence, ERROR_NOT_PROCESSED);
 			}
 			snprintf(response, nbyte, "[%lu] OK\r\n", sequence);
@@ -412,6 +822,9 @@ int cop_tcp_parse(char *request, COP_TCP_SETTINGS *settings, char *response, int
 	case RESTORE:
 		/* token RESTORE read: we want not support it! */
 		return make_error(response, nbyte, sequence, ERROR_NOT_SUPPORTED);
+	case SCAN:
+		/* token SCAN read: execute Scan Network command */
+		return scan_nodes(sequence, response, nbyte);
 	case SEND:
 		/* token SEND read: */
 		if((chr = lookahead(request, &pos)) == -1)
@@ -432,8 +845,14 @@ int cop_tcp_parse(char *request, COP_TCP_SETTINGS *settings, char *response, int
 			/* scan the <value> */
 			if(!ascii2unsigned16(request, &pos, &heartbeat))
 				return make_error(response, nbyte, sequence, ERROR_SYNTAX);
-			//@ToDo: set heartbeat time of the local node!
-			return make_error(response, nbyte, sequence, ERROR_NOT_SUPPORTED);
+			if(settings->master < 1 || 127 < settings->master)
+				return make_error(response, nbyte, sequence, ERROR_NOT_PROCESSED);
+			/* execute Set Heartbeat Producer command */
+			if(!checking && nmt_heartbeat_producer(settings->master, heartbeat) != COPERR_NOERROR) {
+				return make_error(response, nbyte, sequence, ERROR_NOT_PROCESSED);
+			}
+			snprintf(response, nbyte, "[%lu] OK\r\n", sequence);
+			break;
 		case ID:
 			/* token ID read: */
 			if((chr = lookahead(request, &pos)) == -1)
@@ -443,8 +862,10 @@ int cop_tcp_parse(char *request, COP_TCP_SETTINGS *settings, char *response, int
 				return make_error(response, nbyte, sequence, ERROR_SYNTAX);
 			if(master < 1 || 127 < master)
 				return make_error(response, nbyte, sequence, ERROR_NOT_PROCESSED);
-			//@ToDo: set node-id. of the local node!
-			return make_error(response, nbyte, sequence, ERROR_NOT_SUPPORTED);
+			/* execute Set Node-Id. command (used by the heartbeat producer) */
+			settings->master = master;
+			snprintf(response, nbyte, "[%lu] OK\r\n", sequence);
+			break;
 		case NETWORK:
 			/* token NETWORK read: */
 			if((chr = lookahead(request, &pos)) == -1)
@@ -452,8 +873,8 @@ int cop_tcp_parse(char *request, COP_TCP_SETTINGS *settings, char *response, int
 			/* scan the <value> */
 			if(!ascii2unsigned8(request, &pos, &net))
 				return make_error(response, nbyte, sequence, ERROR_SYNTAX);
-			if(net != 1)
-				return make_error(response, nbyte, sequence, ERROR_NOT_PROCESSED);
+			if(net < net_first || net_last < net)
+				return make_error(response, nbyte, sequence, ERROR_UNSUPPORTED_NET);
 			/* execute Set Default Network command */
 			settings->net = net;
 			snprintf(response, nbyte, "[%lu] OK\r\n", sequence);
@@ -485,7 +906,10 @@ int cop_tcp_parse(char *request, COP_TCP_SETTINGS *settings, char *response, int
 			if(!ascii2unsigned16(request, &pos, &timeout))
 				return make_error(response, nbyte, sequence, ERROR_SYNTAX);
 			/* execute Configure SDO Time-out command */
-			timeout = sdo_timeout(timeout);
+			if(!checking) {
+				scan_timeout(timeout);
+				timeout = sdo_timeout(timeout);
+			}
 			snprintf(response, nbyte, "[%lu] OK\r\n", sequence);
 			break;
 		case TPDO:
@@ -500,18 +924,33 @@ int cop_tcp_parse(char *request, COP_TCP_SETTINGS *settings, char *response, int
 		break;
 	case START:
 		/* token START read: execute NMT Start Node command */
-		if(nmt_start_remote_node(node) != COPERR_NOERROR) {
+		if(!checking && nmt_start_remote_node(node) != COPERR_NOERROR) {
 			return make_error(response, nbyte, sequence, ERROR_NOT_PROCESSED);
 		}
 		snprintf(response, nbyte, "[%lu] OK\r\n", sequence);
 		break;
 	case STOP:
 		/* token STOP read: execute NMT Stop Node command */
-		if(nmt_stop_remote_node(node) != COPERR_NOERROR) {
+		if(!checking && nmt_stop_remote_node(node) != COPERR_NOERROR) {
 			return make_error(response, nbyte, sequence, ERROR_NOT_PROCESSED);
 		}
 		snprintf(response, nbyte, "[%lu] OK\r\n", sequence);
 		break;
+	case STATUS:
+		/* token STATUS read: execute Read Gateway Status command */
+		return read_status(sequence, &request[pos], response, nbyte);
+	case EXECUTE:
+		/* token EXECUTE read: */
+		if((chr = lookahead(request, &pos)) == -1)
+			return make_error(response, nbyte, sequence, ERROR_SYNTAX);
+		/* execute Execute Command File command */
+		return exec_file(sequence, &request[pos], settings, response, nbyte);
+	case COMMISSION:
+		/* token COMMISSION read: */
+		if((chr = lookahead(request, &pos)) == -1)
+			return make_error(response, nbyte, sequence, ERROR_SYNTAX);
+		/* execute Commission Nodes command */
+		return commission_nodes(sequence, &request[pos], response, nbyte);
 	case STORE:
 		/* token STORE read: we want not support it! */
 		return make_error(response, nbyte, sequence, ERROR_NOT_SUPPORTED);
@@ -523,7 +962,9 @@ int cop_tcp_parse(char *request, COP_TCP_SETTINGS *settings, char *response, int
 		if(!ascii2unsigned16(request, &pos, &timeout))
 			return make_error(response, nbyte, sequence, ERROR_SYNTAX);
 		/* execute Wait command */
-		if(timeout < 1000)
+		if(checking)
+			;
+		else if(timeout < 1000)
 			usleep((long)timeout * 1000L);
 		else
 			sleep((unsigned)timeout / 1000);
@@ -535,6 +976,7 @@ int cop_tcp_parse(char *request, COP_TCP_SETTINGS *settings, char *response, int
 			return make_error(response, nbyte, sequence, ERROR_SYNTAX);
 		if(DECIMAL(chr)) {
 			/* execute Download SDO command */
+			*target = node;
 			return write_object(sequence, net, node, &request[pos], response, nbyte);
 		}
 		else {
@@ -557,6 +999,98 @@ int cop_tcp_parse(char *request, COP_TCP_SETTINGS *settings, char *response, int
 	return 0;
 }
 
+int cop_tcp_event(COP_TCP_SETTINGS *settings, char *response, int nbyte)
+{
+	NMT_EVENT event;
+	
+	if(!settings || !response)
+		return 0;
+	/* emergency messages (if subscribed) */
+	if(cop_tcp_emcy(settings, response, nbyte))
+		return 1;
+	/* CAN messages (if subscribed) */
+	if(cop_tcp_message(settings, response, nbyte))
+		return 1;
+	/* error control events (discarded if disabled) */
+	while(nmt_event(&event) == COPERR_NOERROR) {
+		if(cop_tcp_notify(settings, &event, response, nbyte))
+			return 1;
+	}
+	return 0;
+}
+
+int cop_tcp_emcy(COP_TCP_SETTINGS *settings, char *response, int nbyte)
+{
+	EMCY_MESSAGE emcy;
+	
+	if(!settings || !response)
+		return 0;
+	if(settings->emcy < 0 || emcy_receive(settings->emcy, &emcy) != COPERR_NOERROR)
+		return 0;
+	snprintf(response, nbyte, "%u %u EMCY 0x%04X 0x%02X 0x%02X%02X%02X%02X%02X\r\n", settings->net, emcy.node_id,
+	         emcy.error_code, emcy.error_register, emcy.manufacturer[0], emcy.manufacturer[1],
+	         emcy.manufacturer[2], emcy.manufacturer[3], emcy.manufacturer[4]);
+	return 1;
+}
+
+int cop_tcp_message(COP_TCP_SETTINGS *settings, char *response, int nbyte)
+{
+	MON_MESSAGE message;
+	int i, len;
+	
+	if(!settings || !response)
+		return 0;
+	if(settings->monitor < 0 || mon_receive(settings->monitor, &message) != COPERR_NOERROR)
+		return 0;
+	len = snprintf(response, nbyte, "%u RECV 0x%03lX %i", settings->net, (unsigned long)message.cob_id, message.length);
+	for(i = 0; i < message.length && 0 < len && len < nbyte; i++)
+		len += snprintf(&response[len], nbyte - len, " 0x%X", message.data[i]);
+	if(0 < len && len < nbyte)
+		snprintf(&response[len], nbyte - len, "\r\n");
+	return 1;
+}
+
+int cop_tcp_notify(COP_TCP_SETTINGS *settings, struct _nmt_event *event, char *response, int nbyte)
+{
+	if(!settings || !event || !response)
+		return 0;
+	if(!settings->events)
+		return 0;
+	switch(event->event) {
+	case NMT_EVENT_BOOTUP:
+		snprintf(response, nbyte, "%u %u BOOT_UP\r\n", settings->net, event->node_id);
+		break;
+	case NMT_EVENT_GUARDING:
+		snprintf(response, nbyte, "%u %u ERROR 1\r\n", settings->net, event->node_id);
+		break;
+	case NMT_EVENT_HEARTBEAT:
+		snprintf(response, nbyte, "%u %u ERROR 2\r\n", settings->net, event->node_id);
+		break;
+	case NMT_EVENT_STATE:
+		snprintf(response, nbyte, "%u %u STATE %s\r\n", settings->net, event->node_id,
+		         (event->state == NMT_OPERATIONAL)? "OPERATIONAL" :
+		         (event->state == NMT_STOPPED)? "STOPPED" :
+		         (event->state == NMT_PREOPERATIONAL)? "PREOPERATIONAL" : "UNKNOWN");
+		break;
+	default:
+		return 0;
+	}
+	return 1;
+}
+
+void cop_tcp_close(COP_TCP_SETTINGS *settings)
+{
+	if(!settings)
+		return;
+	if(settings->emcy >= 0)
+		emcy_unsubscribe(settings->emcy);
+	settings->emcy = -1;
+	if(settings->monitor >= 0)
+		mon_unsubscribe(settings->monitor);
+	settings->monitor = -1;
+	settings->events = 1;
+}
+
 int cop_tcp_sequence(char *string, unsigned long *sequence)
 {
 	int pos = 0, chr;
@@ -582,6 +1116,119 @@ int cop_tcp_sequence(char *string, unsigned long *sequence)
 	return 0;
 }
 
+int cop_tcp_node(char *request, COP_TCP_SETTINGS *settings)
+{
+	unsigned long sequence;
+	unsigned char number, node;
+	int pos = 0, chr, cmd;
+
+	if(!request || !settings)
+		return 0;
+	/* scan the [<sequence>] */
+	if((chr = lookahead(request, &pos)) != '[' || character(request, &pos) != '[')
+		return 0;
+	if((chr = lookahead(request, &pos)) == -1 || !ascii2unsigned32(request, &pos, &sequence))
+		return 0;
+	if((chr = lookahead(request, &pos)) != ']' || character(request, &pos) != ']')
+		return 0;
+	/* scan the [[<net>] <node>] (the last number is the node-id) */
+	node = settings->node;
+	while((chr = lookahead(request, &pos)) != -1 && DECIMAL(chr)) {
+		if(!ascii2unsigned8(request, &pos, &number))
+			return 0;
+		node = number;
+	}
+	/* only an Upload or Download SDO command addresses a node */
+	if((cmd = token(request, &pos)) != READ && cmd != WRITE)
+		return 0;
+	if((chr = lookahead(request, &pos)) == -1 || !DECIMAL(chr))
+		return 0;
+	return (1 <= node && node <= 127)? node : 0;
+}
+
+int cop_tcp_net(char *request, COP_TCP_SETTINGS *settings)
+{
+	unsigned long sequence;
+	unsigned char number[2];
+	int pos = 0, chr, n = 0;
+
+	if(!request || !settings)
+		return 0;
+	/* scan the [<sequence>] (a syntax error is answered by the network) */
+	if((chr = lookahead(request, &pos)) != '[' || character(request, &pos) != '[')
+		return settings->net;
+	if((chr = lookahead(request, &pos)) == -1 || !ascii2unsigned32(request, &pos, &sequence))
+		return settings->net;
+	if((chr = lookahead(request, &pos)) != ']' || character(request, &pos) != ']')
+		return settings->net;
+	/* scan the [[<net>] <node>] (the first of two numbers is the network) */
+	while(n < 2 && (chr = lookahead(request, &pos)) != -1 && DECIMAL(chr)) {
+		if(!ascii2unsigned8(request, &pos, &number[n]))
+			return settings->net;
+		n++;
+	}
+	/* a Set Default Network command is executed by the caller */
+	if(n < 2 && token(request, &pos) == SET && token(request, &pos) == NETWORK)
+		return 0;
+	return (n == 2)? number[0] : settings->net;
+}
+
+void cop_tcp_networks(int first, int last)
+{
+	if(first < 1 || last < first || 255 < last)
+		return;
+	net_first = (unsigned char)first;
+	net_last = (unsigned char)last;
+}
+
+void cop_tcp_measure(int command, int node, long long usec, unsigned long result)
+{
+	if(command < 0 || COP_TCP_COMMANDS <= command)
+		command = COP_TCP_CMD_OTHER;
+	if(usec < 0LL)
+		usec = 0LL;
+	metric_add(&metrics[command], (unsigned long)usec, result);
+	if(1 <= node && node <= 127)
+		metric_add(&nodes[node], (unsigned long)usec, result);
+	if(result)
+		metric_code(result);
+}
+
+void cop_tcp_report(FILE *stream)
+{
+	unsigned long count = 0;
+	char name[16];
+	int i;
+
+	if(!stream)
+		return;
+	for(i = 0; i < COP_TCP_COMMANDS; i++)
+		count += metric_count(&metrics[i]);
+	fprintf(stream, "Gateway status: %lu requests\n", count);
+	for(i = 0; i < COP_TCP_COMMANDS; i++) {
+		if(metric_count(&metrics[i])) {
+			snprintf(name, sizeof(name), "Command %s", commands[i]);
+			metric_report(stream, name, &metrics[i]);
+		}
+	}
+	for(i = 1; i <= 127; i++) {
+		if(metric_count(&nodes[i])) {
+			snprintf(name, sizeof(name), "Node %i", i);
+			metric_report(stream, name, &nodes[i]);
+		}
+	}
+	for(count = 0, i = 0; i < METRIC_CODES; i++) {
+		if(codes[i].code) {
+			fprintf(stream, (codes[i].code < METRIC_ABORT)? "%s %lu (%lux)" : "%s 0x%08lX (%lux)",
+			        count++? "," : "Error codes:", codes[i].code, codes[i].count);
+		}
+	}
+	if(codes_lost)
+		fprintf(stream, "%s %lu other", count++? "," : "Error codes:", codes_lost);
+	if(count)
+		fputc('\n', stream);
+}
+
 /*  -----------  local functions  ------------------------------------------
  */
 
@@ -595,7 +1242,7 @@ static int read_object(unsigned long nr, unsigned char net, unsigned char node,
 	SHORT length = 0;
 	size_t prefix;
 	int pos = 0;
-	long rc;
+	long rc = COPERR_NOERROR;
 	
 	/* scan the <index> */
 	if(!ascii2unsigned16(request, &pos, &index))
@@ -606,45 +1253,45 @@ static int read_object(unsigned long nr, unsigned char net, unsigned char node,
 	/* scan the <datatype> */
 	switch(token(request, &pos)) {
 	case INTEGER8:
-		if((rc = sdo_read_8bit(node, index, subindex, (BYTE*)&int8)) == COPERR_NOERROR)
+		if(!checking && (rc = sdo_read_8bit(node, index, subindex, (BYTE*)&int8)) == COPERR_NOERROR)
 			snprintf(response, nbyte, "[%lu] %+i\r\n", nr, int8);
 		break;
 	case INTEGER16:
-		if((rc = sdo_read_16bit(node, index, subindex, (WORD*)&int16)) == COPERR_NOERROR)
+		if(!checking && (rc = sdo_read_16bit(node, index, subindex, (WORD*)&int16)) == COPERR_NOERROR)
 			snprintf(response, nbyte, "[%lu] %+i\r\n", nr, int16);
 		break;
 	case INTEGER32:
-		if((rc = sdo_read_32bit(node, index, subindex, (DWORD*)&int32)) == COPERR_NOERROR)
+		if(!checking && (rc = sdo_read_32bit(node, index, subindex, (DWORD*)&int32)) == COPERR_NOERROR)
 			snprintf(response, nbyte, "[%lu] %+li\r\n", nr, int32);
 		break;
 	case UNSIGNED8:
-		if((rc = sdo_read_8bit(node, index, subindex, (BYTE*)&uint8)) == COPERR_NOERROR)
+		if(!checking && (rc = sdo_read_8bit(node, index, subindex, (BYTE*)&uint8)) == COPERR_NOERROR)
 			snprintf(response, nbyte, "[%lu] 0x%X\r\n", nr, uint8);
 		break;
 	case UNSIGNED16:
-		if((rc = sdo_read_16bit(node, index, subindex, (WORD*)&uint16)) == COPERR_NOERROR)
+		if(!checking && (rc = sdo_read_16bit(node, index, subindex, (WORD*)&uint16)) == COPERR_NOERROR)
 			snprintf(response, nbyte, "[%lu] 0x%X\r\n", nr, uint16);
 		break;
 	case UNSIGNED32:
-		if((rc = sdo_read_32bit(node, index, subindex, (DWORD*)&uint32)) == COPERR_NOERROR)
+		if(!checking && (rc = sdo_read_32bit(node, index, subindex, (DWORD*)&uint32)) == COPERR_NOERROR)
 			snprintf(response, nbyte, "[%lu] 0x%lX\r\n", nr, uint32);
 		break;
 	case VISIBLE_STRING:
 		snprintf(response, nbyte, "[%lu] \"", nr);
 		prefix = strlen(response);
-		if((rc = sdo_read(node, index, subindex, &length, (BYTE*)&response[prefix], nbyte - prefix - 1)) == COPERR_NOERROR)
+		if(!checking && (rc = sdo_read(node, index, subindex, &length, (BYTE*)&response[prefix], nbyte - prefix - 1)) == COPERR_NOERROR)
 			make_string(&response[prefix], nbyte - prefix);
 		break;
 	case OCTET_STRING:
 	case DOMAIN:
 		snprintf(response, nbyte, "[%lu] ", nr);
 		prefix = strlen(response);
-		if((rc = sdo_read(node, index, subindex, &length, (BYTE*)&response[prefix], nbyte - prefix - 1)) == COPERR_NOERROR)
+		if(!checking && (rc = sdo_read(node, index, subindex, &length, (BYTE*)&response[prefix], nbyte - prefix - 1)) == COPERR_NOERROR)
 			make_base64(&response[prefix], length, nbyte - prefix);
 		break;
 	case TIME_OF_DAY:
 	case TIME_DIFFERENCE:
-		if((rc = sdo_read(node, index, subindex, &length, (BYTE*)&time_of_day[0], sizeof(time_of_day))) == COPERR_NOERROR) {
+		if(!checking && (rc = sdo_read(node, index, subindex, &length, (BYTE*)&time_of_day[0], sizeof(time_of_day))) == COPERR_NOERROR) {
 			uint32 = (DWORD)time_of_day[0] << 0;
 			uint32 |= (DWORD)time_of_day[1] << 8;
 			uint32 |= (DWORD)time_of_day[2] << 16;
@@ -682,7 +1329,7 @@ static int write_object(unsigned long nr, unsigned char net, unsigned char node,
 	BYTE uint8; WORD uint16; DWORD uint32;
 	BYTE time_of_day[6];
 	int pos = 0, off, len;
-	long rc;
+	long rc = COPERR_NOERROR;
 	
 	/* scan the <index> */
 	if(!ascii2unsigned16(request, &pos, &index))
@@ -695,44 +1342,44 @@ static int write_object(unsigned long nr, unsigned char net, unsigned char node,
 	case INTEGER8:
 		if(!ascii2integer8(request, &pos, &int8))
 			return make_error(response, nbyte, nr, ERROR_SYNTAX);
-		if((rc = sdo_write_8bit(node, index, subindex, (BYTE)int8)) == COPERR_NOERROR)
+		if(!checking && (rc = sdo_write_8bit(node, index, subindex, (BYTE)int8)) == COPERR_NOERROR)
 			snprintf(response, nbyte, "[%lu] OK\r\n", nr);
 		break;
 	case INTEGER16:
 		if(!ascii2integer16(request, &pos, &int16))
 			return make_error(response, nbyte, nr, ERROR_SYNTAX);
-		if((rc = sdo_write_16bit(node, index, subindex, (WORD)int16)) == COPERR_NOERROR)
+		if(!checking && (rc = sdo_write_16bit(node, index, subindex, (WORD)int16)) == COPERR_NOERROR)
 			snprintf(response, nbyte, "[%lu] OK\r\n", nr);
 		break;
 	case INTEGER32:
 		if(!ascii2integer32(request, &pos, &int32))
 			return make_error(response, nbyte, nr, ERROR_SYNTAX);
-		if((rc = sdo_write_32bit(node, index, subindex, (DWORD)int32)) == COPERR_NOERROR)
+		if(!checking && (rc = sdo_write_32bit(node, index, subindex, (DWORD)int32)) == COPERR_NOERROR)
 			snprintf(response, nbyte, "[%lu] OK\r\n", nr);
 		break;
 	case UNSIGNED8:
 		if(!ascii2unsigned8(request, &pos, &uint8))
 			return make_error(response, nbyte, nr, ERROR_SYNTAX);
-		if((rc = sdo_write_8bit(node, index, subindex, (BYTE)uint8)) == COPERR_NOERROR)
+		if(!checking && (rc = sdo_write_8bit(node, index, subindex, (BYTE)uint8)) == COPERR_NOERROR)
 			snprintf(response, nbyte, "[%lu] OK\r\n", nr);
 		break;
 	case UNSIGNED16:
 		if(!ascii2unsigned16(request, &pos, &uint16))
 			return make_error(response, nbyte, nr, ERROR_SYNTAX);
-		if((rc = sdo_write_16bit(node, index, subindex, (WORD)uint16)) == COPERR_NOERROR)
+		if(!checking && (rc = sdo_write_16bit(node, index, subindex, (WORD)uint16)) == COPERR_NOERROR)
 			snprintf(response, nbyte, "[%lu] OK\r\n", nr);
 		break;
 	case UNSIGNED32:
 		if(!ascii2unsigned32(request, &pos, &uint32))
 			return make_error(response, nbyte, nr, ERROR_SYNTAX);
-		if((rc = sdo_write_32bit(node, index, subindex, (DWORD)uint32)) == COPERR_NOERROR)
+		if(!checking && (rc = sdo_write_32bit(node, index, subindex, (DWORD)uint32)) == COPERR_NOERROR)
 			snprintf(response, nbyte, "[%lu] OK\r\n", nr);
 		break;
 	case VISIBLE_STRING:
 		off = pos;
 		if(!ascii2string(request, &pos, (char*)&request[off], &len, nbyte - pos))
 			return make_error(response, nbyte, nr, ERROR_SYNTAX);
-		if((rc = sdo_write(node, index, subindex, (SHORT)len, (BYTE*)&request[off])) == COPERR_NOERROR)
+		if(!checking && (rc = sdo_write(node, index, subindex, (SHORT)len, (BYTE*)&request[off])) == COPERR_NOERROR)
 			snprintf(response, nbyte, "[%lu] OK\r\n", nr);
 		break;
 	case OCTET_STRING:
@@ -740,16 +1387,22 @@ static int write_object(unsigned long nr, unsigned char net, unsigned char node,
 		off = pos;
 		if(!ascii2domain(request, &pos, (unsigned char*)&request[off], &len, nbyte - pos))
 			return make_error(response, nbyte, nr, ERROR_SYNTAX);
-		if((rc = sdo_write(node, index, subindex, (SHORT)len, (BYTE*)&request[off])) == COPERR_NOERROR)
+		if(!checking && (rc = sdo_write(node, index, subindex, (SHORT)len, (BYTE*)&request[off])) == COPERR_NOERROR)
 			snprintf(response, nbyte, "[%lu] OK\r\n", nr);
 		break;
 	case TIME_OF_DAY:
 	case TIME_DIFFERENCE:
-		if(!ascii2unsigned16(request, &pos, (unsigned short*)&time_of_day[4]))
+		if(!ascii2unsigned16(request, &pos, &uint16))
 			return make_error(response, nbyte, nr, ERROR_SYNTAX);
-		if(!ascii2unsigned32(request, &pos, (unsigned long*)&time_of_day[0]))
+		if(!ascii2unsigned32(request, &pos, &uint32))
 			return make_error(response, nbyte, nr, ERROR_SYNTAX);
-		if((rc = sdo_write(node, index, subindex, (SHORT)6, (BYTE*)&time_of_day[0])) == COPERR_NOERROR)
+		time_of_day[0] = (BYTE)(uint32 >> 0);
+		time_of_day[1] = (BYTE)(uint32 >> 8);
+		time_of_day[2] = (BYTE)(uint32 >> 16);
+		time_of_day[3] = (BYTE)(uint32 >> 24);
+		time_of_day[4] = (BYTE)(uint16 >> 0);
+		time_of_day[5] = (BYTE)(uint16 >> 8);
+		if(!checking && (rc = sdo_write(node, index, subindex, (SHORT)6, (BYTE*)&time_of_day[0])) == COPERR_NOERROR)
 			snprintf(response, nbyte, "[%lu] OK\r\n", nr);
 		break;
 	//@ToDo: To be continued...
@@ -778,7 +1431,7 @@ static int send_message(unsigned long nr, unsigned char net, char *request, char
 	SHORT dlc, i;
 	char buffer[6];
 	int pos = 0, chr;
-	long rc;
+	long rc = COPERR_NOERROR;
 	
 	/* scan the <cob-id> */
 	if(!ascii2unsigned32(request, &pos, (unsigned long*)&cob))
@@ -797,7 +1450,7 @@ static int send_message(unsigned long nr, unsigned char net, char *request, char
 				return make_error(response, nbyte, nr, ERROR_SYNTAX);
 		}
 		/* transmit the request */
-		if((rc = cop_transmit(cob, dlc, data)) == COPERR_NOERROR)
+		if(!checking && (rc = cop_transmit(cob, dlc, data)) == COPERR_NOERROR)
 			snprintf(response, nbyte, "[%lu] OK\r\n", nr);
 	}
 	else if(token(request, &pos) == RTR) {
@@ -806,7 +1459,7 @@ static int send_message(unsigned long nr, unsigned char net, char *request, char
 			return make_error(response, nbyte, nr, ERROR_SYNTAX);
 		dlc = (SHORT)length;
 		/* request the request */
-		if((rc = cop_request(cob, &dlc, data)) == COPERR_NOERROR) {
+		if(!checking && (rc = cop_request(cob, &dlc, data)) == COPERR_NOERROR) {
 			snprintf(response, nbyte, "[%lu] %i", nr, dlc);
 			for(i = 0; i < dlc && i < 8; i++) {
 				snprintf(buffer, 6, " 0x%X", data[i]);
@@ -832,7 +1485,11 @@ static int recv_message(unsigned long nr, unsigned char net, char *response, int
 	char buffer[6];
 	long rc;
 
-	if((rc = cop_queue_read(&cob, &dlc, data)) == COPERR_NOERROR) {
+	if(checking)
+		rc = COPERR_RX_EMPTY;			/* the queue is not read */
+	else
+		rc = cop_queue_read(&cob, &dlc, data);
+	if(rc == COPERR_NOERROR) {
 		snprintf(response, nbyte, "[%lu] 0x%03lX %i", nr, cob, dlc);
 		for(i = 0; i < dlc && i < 8; i++) {
 			snprintf(buffer, 6, " 0x%X", data[i]);
@@ -842,6 +1499,7 @@ static int recv_message(unsigned long nr, unsigned char net, char *response, int
 	}
 	else if(rc == COPERR_RX_EMPTY) {
 		snprintf(response, nbyte, "[%lu] OK\r\n", nr);
+		rc = COPERR_NOERROR;
 	}
 	else {
 		return make_error(response, nbyte, nr, ERROR_NOT_PROCESSED);
@@ -850,52 +1508,348 @@ static int recv_message(unsigned long nr, unsigned char net, char *response, int
 	return rc;
 }
 
-static int make_string(char *buffer, int nbyte)
+static int recv_subscribe(unsigned long nr, char *request, COP_TCP_SETTINGS *settings, char *response, int nbyte)
 {
-	int i, j, l;
-	
-	if(!buffer)
-		return -1;
-	l = strlen(buffer);
-	for(i = 0; i < l; i++) {
-		if(buffer[i] == '\"') {
-			for(j = (l + 1 < nbyte)? l : l - 1, l = j + 1; i <= j; j--)
-				buffer[j+1] = buffer[j];
-			buffer[i++] = '\"';
-			buffer[l] = '\0';
+	MON_FILTER filter = {0x000, 0x7FF, 0x7FF, 0};
+	unsigned short value;
+	int pos = 0, chr;
+	LONG handle;
+
+	/* scan the optional [<cob-id> [<cob-id>]] */
+	if(DECIMAL(chr = lookahead(request, &pos))) {
+		if(!ascii2unsigned16(request, &pos, &value) || value > 0x7FF)
+			return make_error(response, nbyte, nr, ERROR_SYNTAX);
+		filter.first = filter.last = (LONG)value;
+		if(DECIMAL(chr = lookahead(request, &pos))) {
+			if(!ascii2unsigned16(request, &pos, &value) || value > 0x7FF || value < filter.first)
+				return make_error(response, nbyte, nr, ERROR_SYNTAX);
+			filter.last = (LONG)value;
 		}
 	}
-	if(l + 1 < nbyte) {
-		buffer[l++] = '\"';
-		buffer[l] = '\0';
-	}
-	if(l + 1 < nbyte) {
-		buffer[l++] = '\r';
-		buffer[l] = '\0';
+	/* scan the optional ["mask" <mask>] ["rate" <milliseconds>] */
+	while((chr = lookahead(request, &pos)) != -1 && chr != '\r' && chr != '\n') {
+		switch(token(request, &pos)) {
+		case MASK:
+			if(!ascii2unsigned16(request, &pos, &value) || value > 0x7FF)
+				return make_error(response, nbyte, nr, ERROR_SYNTAX);
+			filter.mask = (LONG)value;
+			break;
+		case RATE:
+			if(!ascii2unsigned16(request, &pos, &value))
+				return make_error(response, nbyte, nr, ERROR_SYNTAX);
+			filter.interval = (WORD)value;
+			break;
+		default:
+			return make_error(response, nbyte, nr, ERROR_SYNTAX);
+		}
 	}
-	if(l + 1 < nbyte) {
-		buffer[l++] = '\n';
-		buffer[l] = '\0';
+	/* the subscription is replaced (by the new filter) */
+	if(!checking) {
+		if(settings->monitor >= 0)
+			mon_unsubscribe(settings->monitor);
+		settings->monitor = -1;
+		if((handle = mon_subscribe(&filter)) < 0)
+			return make_error(response, nbyte, nr, ERROR_NOT_PROCESSED);
+		settings->monitor = handle;
 	}
-	return l;
+	snprintf(response, nbyte, "[%lu] OK\r\n", nr);
+	return 0;
 }
 
-static int make_base64(char *buffer, int length, int nbyte)
+static int recv_statistics(unsigned long nr, COP_TCP_SETTINGS *settings, char *response, int nbyte)
 {
-	int i, j, l, L;
-	
-	if(!buffer)
-		return -1;
+	MON_STATISTICS stats;
 
-	l = length;
-	L = (((l + 2) / 3) * 4);
-	
-	if(L >= nbyte)
-		L = nbyte - 1;
+	if(checking)
+		memset(&stats, 0, sizeof(stats));
+	else if(settings->monitor < 0 || mon_statistics(settings->monitor, &stats, FALSE) != COPERR_NOERROR)
+		return make_error(response, nbyte, nr, ERROR_NOT_PROCESSED);
+	snprintf(response, nbyte, "[%lu] %lu %lu %lu\r\n", nr, (unsigned long)stats.received,
+	         (unsigned long)stats.throttled, (unsigned long)stats.lost);
+	return 0;
+}
 
-	for(j = (((L - 1) / 4) * 4), i = ((j / 4) * 3); j >= 0 && i >= 0; j -= 4, i -=3) {
-		base64_encode((unsigned char*)&buffer[i], ((l - i) < 3 ? (l - i) : 3), (unsigned char*)&buffer[j], ((L - j) < 4 ? (L - j) : 4));
+static int read_sync(unsigned long nr, char *response, int nbyte)
+{
+	SYNC_STATISTICS stats;
+	int i, n, len;
+	LONG rc;
+	
+	/* the statistics of the last run when the producer has been stopped */
+	if((rc = sync_statistics(&stats, FALSE)) != COPERR_NOERROR &&
+	   (rc != COPERR_OFFLINE || !stats.cycle_period))
+		return make_error(response, nbyte, nr, ERROR_NOT_PROCESSED);
+	/* trailing empty jitter classes are omitted */
+	for(n = SYNC_HISTOGRAM; n > 1 && !stats.histogram[n-1]; n--)
+		;
+	len = snprintf(response, nbyte, "[%lu] %lu %lu %lu %li %li", nr,
+	               (unsigned long)stats.count, (unsigned long)stats.overruns, (unsigned long)stats.errors,
+	               (long)stats.jitter_min, (long)stats.jitter_max);
+	for(i = 0; i < n && 0 < len && len < nbyte; i++)
+		len += snprintf(&response[len], nbyte - len, " %lu", (unsigned long)stats.histogram[i]);
+	if(0 < len && len < nbyte)
+		snprintf(&response[len], nbyte - len, "\r\n");
+	return 0;
+}
+
+static int read_error(unsigned long nr, unsigned char node, char *response, int nbyte)
+{
+	EMCY_MESSAGE history[EMCY_HISTORY];
+	SHORT count = EMCY_HISTORY;
+	int i, len;
+	
+	if(emcy_history(node, history, &count) != COPERR_NOERROR)
+		return make_error(response, nbyte, nr, ERROR_NOT_PROCESSED);
+	/* newest emergency message first */
+	len = snprintf(response, nbyte, "[%lu] %i", nr, count);
+	for(i = 0; i < count && 0 < len && len < nbyte; i++)
+		len += snprintf(&response[len], nbyte - len, " 0x%04X 0x%02X 0x%02X%02X%02X%02X%02X",
+		                history[i].error_code, history[i].error_register,
+		                history[i].manufacturer[0], history[i].manufacturer[1], history[i].manufacturer[2],
+		                history[i].manufacturer[3], history[i].manufacturer[4]);
+	if(0 < len && len < nbyte)
+		snprintf(&response[len], nbyte - len, "\r\n");
+	return 0;
+}
+
+static int read_identity(unsigned long nr, unsigned char node, char *response, int nbyte)
+{
+	SCAN_NODE entry;
+	
+	if(scan_node(node, &entry) != COPERR_NOERROR)
+		return make_error(response, nbyte, nr, ERROR_NOT_PROCESSED);
+	if(entry.state != SCAN_PRESENT)
+		return make_error(response, nbyte, nr, ERROR_NOT_PROCESSED);
+	snprintf(response, nbyte, "[%lu] 0x%08lX 0x%08lX 0x%08lX 0x%08lX 0x%08lX\r\n", nr,
+	         (unsigned long)entry.device_type, (unsigned long)entry.vendor_id, (unsigned long)entry.product_code,
+	         (unsigned long)entry.revision_number, (unsigned long)entry.serial_number);
+	return 0;
+}
+
+static int scan_nodes(unsigned long nr, char *response, int nbyte)
+{
+	SCAN_NODE table[127];
+	SHORT count = 127;
+	int i, len;
+	
+	if(!checking && scan_network(1, 127) != COPERR_NOERROR)
+		return make_error(response, nbyte, nr, ERROR_NOT_PROCESSED);
+	if(scan_table(table, &count) != COPERR_NOERROR)
+		return make_error(response, nbyte, nr, ERROR_NOT_PROCESSED);
+	/* node-ids of the present nodes in ascending order */
+	len = snprintf(response, nbyte, "[%lu] %i", nr, count);
+	for(i = 0; i < count && 0 < len && len < nbyte; i++)
+		len += snprintf(&response[len], nbyte - len, " %u", table[i].node_id);
+	if(0 < len && len < nbyte)
+		snprintf(&response[len], nbyte - len, "\r\n");
+	return 0;
+}
+
+static int read_status(unsigned long nr, char *request, char *response, int nbyte)
+{
+	unsigned long count = 0;
+	unsigned char node;
+	int i, n, len, pos = 0, chr, command;
+
+	if((chr = lookahead(request, &pos)) == -1 || chr == '\r' || chr == '\n') {
+		/* the number of requests, and the metrics of each command class */
+		for(i = 0; i < COP_TCP_COMMANDS; i++)
+			count += metric_count(&metrics[i]);
+		len = snprintf(response, nbyte, "[%lu] %lu", nr, count);
+		for(i = 0; i < COP_TCP_COMMANDS && 0 < len && len < nbyte; i++) {
+			if((count = metric_count(&metrics[i])))
+				len += snprintf(&response[len], nbyte - len, " %s=%lu/%lu/%lu/%lu/%lu", commands[i],
+				                count, metrics[i].errors, metrics[i].aborts,
+				                (unsigned long)(metrics[i].latency_sum / count), metrics[i].latency_max);
+		}
+		if(0 < len && len < nbyte)
+			snprintf(&response[len], nbyte - len, "\r\n");
+		return 0;
+	}
+	/* scan next token */
+	switch((command = token(request, &pos))) {
+	case ERROR:
+		/* token ERROR read: the error and abort codes with their number */
+		for(n = 0, i = 0; i < METRIC_CODES; i++)
+			n += (codes[i].code != 0);
+		len = snprintf(response, nbyte, "[%lu] %i", nr, n);
+		for(i = 0; i < METRIC_CODES && 0 < len && len < nbyte; i++) {
+			if(codes[i].code)
+				len += snprintf(&response[len], nbyte - len, (codes[i].code < METRIC_ABORT)? " %lu=%lu" : " 0x%08lX=%lu",
+				                codes[i].code, codes[i].count);
+		}
+		if(0 < len && len < nbyte)
+			snprintf(&response[len], nbyte - len, "\r\n");
+		return 0;
+	case NODE:
+		/* token NODE read: the metrics of the SDO commands to a node */
+		if((chr = lookahead(request, &pos)) == -1)
+			return make_error(response, nbyte, nr, ERROR_SYNTAX);
+		if(!ascii2unsigned8(request, &pos, &node))
+			return make_error(response, nbyte, nr, ERROR_SYNTAX);
+		if(node < 1 || 127 < node)
+			return make_error(response, nbyte, nr, ERROR_NOT_PROCESSED);
+		return make_status(nr, &nodes[node], response, nbyte);
+	default:
+		/* a command: the metrics of its command class */
+		if((command = metric_command(command)) == COP_TCP_CMD_OTHER)
+			return make_error(response, nbyte, nr, ERROR_SYNTAX);
+		return make_status(nr, &metrics[command], response, nbyte);
+	}
+}
+
+static int make_status(unsigned long nr, METRIC *metric, char *response, int nbyte)
+{
+	unsigned long count = metric_count(metric);
+	int i, n, len;
+
+	/* trailing empty latency classes are omitted */
+	for(n = COP_TCP_HISTOGRAM; n > 1 && !metric->histogram[n-1]; n--)
+		;
+	len = snprintf(response, nbyte, "[%lu] %lu %lu %lu %lu %lu", nr,
+	               count, metric->errors, metric->aborts,
+	               count? (unsigned long)(metric->latency_sum / count) : 0UL, metric->latency_max);
+	for(i = 0; i < n && 0 < len && len < nbyte; i++)
+		len += snprintf(&response[len], nbyte - len, " %lu", metric->histogram[i]);
+	if(0 < len && len < nbyte)
+		snprintf(&response[len], nbyte - len, "\r\n");
+	return 0;
+}
+
+static int exec_file(unsigned long nr, char *request, COP_TCP_SETTINGS *settings, char *response, int nbyte)
+{
+	COP_EXE_SUMMARY summary;
+	char filename[256];
+	int pos = 0, chr, len, check = 0, rc;
+
+	/* scan the <filename> */
+	if(!ascii2string(request, &pos, filename, &len, sizeof(filename)) || !len)
+		return make_error(response, nbyte, nr, ERROR_SYNTAX);
+	if(len + 1 >= (int)sizeof(filename))
+		return make_error(response, nbyte, nr, ERROR_NOT_PROCESSED);
+	/* scan the optional "check" */
+	if((chr = lookahead(request, &pos)) != -1 && chr != '\r' && chr != '\n') {
+		if(token(request, &pos) != CHECK)
+			return make_error(response, nbyte, nr, ERROR_SYNTAX);
+		check = 1;
+	}
+	/* in check mode the command file is not opened */
+	if(checking)
+		return 0;
+	/* a command file is not executed for a client of the gateway */
+	if((rc = cop_exe_file(filename, settings, check, &summary)) < 0)
+		return make_error(response, nbyte, nr, (rc == -2)? ERROR_NOT_SUPPORTED : ERROR_NOT_PROCESSED);
+	/* the number of commands and errors, the first error, rounds and time */
+	snprintf(response, nbyte, "[%lu] %lu %lu %lu %lu %lu\r\n", nr,
+	         summary.requests, summary.errors, summary.line, summary.rounds, summary.elapsed);
+	return 0;
+}
+
+static int commission_nodes(unsigned long nr, char *request, char *response, int nbyte)
+{
+	CFG_NODE table[COMMISSION_NODES];
+	unsigned long vendor, product, revision, serial;
+	unsigned char node_id, baudrate = CFG_KEEP, store = 0;
+	int i, n = 0, len, pos = 0, chr;
+	LONG rc;
+
+	/* scan the <vendor-id> <product-code> <revision-number> of the nodes */
+	if(!ascii2unsigned32(request, &pos, &vendor) || lookahead(request, &pos) == -1 ||
+	   !ascii2unsigned32(request, &pos, &product) || lookahead(request, &pos) == -1 ||
+	   !ascii2unsigned32(request, &pos, &revision))
+		return make_error(response, nbyte, nr, ERROR_SYNTAX);
+	/* scan the {<serial-number> <node-id>} */
+	while(DECIMAL(chr = lookahead(request, &pos))) {
+		if(!ascii2unsigned32(request, &pos, &serial) || lookahead(request, &pos) == -1 ||
+		   !ascii2unsigned8(request, &pos, &node_id))
+			return make_error(response, nbyte, nr, ERROR_SYNTAX);
+		if(node_id < 1 || 127 < node_id || n == COMMISSION_NODES)
+			return make_error(response, nbyte, nr, ERROR_NOT_PROCESSED);
+		memset(&table[n], 0, sizeof(CFG_NODE));
+		table[n].protocol = CFG_LSS;
+		table[n].vendor_id = (DWORD)vendor;
+		table[n].product_code = (DWORD)product;
+		table[n].revision_number = (DWORD)revision;
+		table[n].serial_number = (DWORD)serial;
+		table[n++].node_id = node_id;
+	}
+	if(!n)
+		return make_error(response, nbyte, nr, ERROR_SYNTAX);
+	/* scan the optional ["rate" <index>] ["store"] */
+	while(chr != -1 && chr != '\r' && chr != '\n') {
+		switch(token(request, &pos)) {
+		case RATE:
+			if(lookahead(request, &pos) == -1 || !ascii2unsigned8(request, &pos, &baudrate))
+				return make_error(response, nbyte, nr, ERROR_SYNTAX);
+			if(baudrate > 8)
+				return make_error(response, nbyte, nr, ERROR_NOT_PROCESSED);
+			break;
+		case STORE:
+			store = 1;
+			break;
+		default:
+			return make_error(response, nbyte, nr, ERROR_SYNTAX);
+		}
+		chr = lookahead(request, &pos);
 	}
+	for(i = 0; i < n; i++) {
+		table[i].baudrate = baudrate;
+		table[i].store = store? TRUE : FALSE;
+	}
+	/* in check mode no node is switched */
+	if(checking)
+		return 0;
+	if((rc = cfg_commission(table, (SHORT)n, 0)) < 0)
+		return make_error(response, nbyte, nr, ERROR_NOT_PROCESSED);
+	/* the nodes commissioned, and the failed step and time of each node */
+	len = snprintf(response, nbyte, "[%lu] %li", nr, (long)rc);
+	for(i = 0; i < n && 0 < len && len < nbyte; i++)
+		len += snprintf(&response[len], nbyte - len, " %u %u %lu",
+		                table[i].node_id, table[i].step, (unsigned long)table[i].duration);
+	if(0 < len && len < nbyte)
+		snprintf(&response[len], nbyte - len, "\r\n");
+	return 0;
+}
+
+static int make_string(char *buffer, int nbyte)
+{
+	int i, j, l;
+	
+	if(!buffer)
+		return -1;
+	l = strlen(buffer);
+	for(i = 0; i < l; i++) {
+		if(buffer[i] == '\"') {
+			for(j = (l + 1 < nbyte)? l : l - 1, l = j + 1; i <= j; j--)
+				buffer[j+1] = buffer[j];
+			buffer[i++] = '\"';
+			buffer[l] = '\0';
+		}
+	}
+	if(l + 1 < nbyte) {
+		buffer[l++] = '\"';
+		buffer[l] = '\0';
+	}
+	if(l + 1 < nbyte) {
+		buffer[l++] = '\r';
+		buffer[l] = '\0';
+	}
+	if(l + 1 < nbyte) {
+		buffer[l++] = '\n';
+		buffer[l] = '\0';
+	}
+	return l;
+}
+
+static int make_base64(char *buffer, int length, int nbyte)
+{
+	int L;
+	
+	if(!buffer)
+		return -1;
+
+	/* in place (the data is encoded from its end) */
+	L = base64_encode_buffer((unsigned char*)buffer, length, (unsigned char*)buffer, nbyte - 1);
 	buffer[L] = '\0';
 
 	if(L + 1 < nbyte) {
@@ -943,299 +1897,21 @@ static int character(char *line, int *pos)
 
 static int token(char *line, int *pos)
 {
+	KEYWORD *keyword;
+	int chr;
+	
 	for(; WHITESPACE(line[*pos]); *pos += 1)
 		;
-	if(compare(&line[*pos], "b")) {
-		*pos += strlen("b");
-		return BOOLEAN;
-	}
-	if(compare(&line[*pos], "communication")) {
-		*pos += strlen("communication");
-		return COMMUNICATION;
-	}
-	if(compare(&line[*pos], "comm")) {
-		*pos += strlen("comm");
-		return COMMUNICATION;
-	}
-	if(compare(&line[*pos], "copyright")) {
-		*pos += strlen("copyright");
-		return COPYRIGHT;
-	}
-	if(compare(&line[*pos], "disable")) {
-		*pos += strlen("disable");
-		return DISABLE;
-	}
-	if(compare(&line[*pos], "d")) {
-		*pos += strlen("d");
-		return DOMAIN;
-	}
-	if(compare(&line[*pos], "emcy")) {
-		*pos += strlen("emcy");
-		return EMCY;
-	}
-	if(compare(&line[*pos], "enable")) {
-		*pos += strlen("enable");
-		return ENABLE;
-	}
-	if(compare(&line[*pos], "error")) {
-		*pos += strlen("error");
-		return ERROR;
-	}
-	if(compare(&line[*pos], "event")) {
-		*pos += strlen("event");
-		return EVENT;
-	}
-	if(compare(&line[*pos], "execute")) {
-		*pos += strlen("execute");
-		return EXECUTE;
-	}
-	if(compare(&line[*pos], "exec")) {
-		*pos += strlen("exec");
-		return EXECUTE;
-	}
-	if(compare(&line[*pos], "exit")) {
-		*pos += strlen("exit");
-		return EXIT;
-	}
-	if(compare(&line[*pos], "e")) {
-		*pos += strlen("e");
-		return ERROR;
-	}
-	if(compare(&line[*pos], "firmware")) {
-		*pos += strlen("firmware");
-		return FIRMWARE;
-	}
-	if(compare(&line[*pos], "guarding")) {
-		*pos += strlen("guarding");
-		return GUARDING;
-	}
-	if(compare(&line[*pos], "hardware")) {
-		*pos += strlen("hardware");
-		return HARDWARE;
-	}
-	if(compare(&line[*pos], "heartbeat")) {
-		*pos += strlen("heartbeat");
-		return HEARTBEAT;
-	}
-	if(compare(&line[*pos], "i8")) {
-		*pos += strlen("i8");
-		return INTEGER8;
-	}
-	if(compare(&line[*pos], "i16")) {
-		*pos += strlen("i16");
-		return INTEGER16;
-	}
-	if(compare(&line[*pos], "i24")) {
-		*pos += strlen("i24");
-		return INTEGER24;
-	}
-	if(compare(&line[*pos], "i32")) {
-		*pos += strlen("i32");
-		return INTEGER32;
-	}
-	if(compare(&line[*pos], "i40")) {
-		*pos += strlen("i40");
-		return INTEGER40;
-	}
-	if(compare(&line[*pos], "i48")) {
-		*pos += strlen("i48");
-		return INTEGER48;
-	}
-	if(compare(&line[*pos], "i56")) {
-		*pos += strlen("i56");
-		return INTEGER56;
-	}
-	if(compare(&line[*pos], "i64")) {
-		*pos += strlen("i64");
-		return INTEGER64;
-	}
-	if(compare(&line[*pos], "id")) {
-		*pos += strlen("id");
-		return ID;
-	}
-	if(compare(&line[*pos], "info")) {
-		*pos += strlen("info");
-		return INFO;
-	}
-	if(compare(&line[*pos], "init")) {
-		*pos += strlen("init");
-		return INIT;
-	}
-	if(compare(&line[*pos], "network")) {
-		*pos += strlen("network");
-		return NETWORK;
-	}
-	if(compare(&line[*pos], "node")) {
-		*pos += strlen("node");
-		return NODE;
-	}
-	if(compare(&line[*pos], "ok")) {
-		*pos += strlen("ok");
-		return OK;
-	}
-	if(compare(&line[*pos], "os")) {
-		*pos += strlen("os");
-		return OCTET_STRING;
-	}
-	if(compare(&line[*pos], "pdo")) {
-		*pos += strlen("pdo");
-		return PDO;
-	}
-	if(compare(&line[*pos], "preoperational")) {
-		*pos += strlen("preoperational");
-		return PREOPERATIONAL;
-	}
-	if(compare(&line[*pos], "preop")) {
-		*pos += strlen("preop");
-		return PREOPERATIONAL;
-	}
-	if(compare(&line[*pos], "p")) {
-		*pos += strlen("p");
-		return PDO;
-	}
-	if(compare(&line[*pos], "r32")) {
-		*pos += strlen("r32");
-		return REAL32;
-	}
-	if(compare(&line[*pos], "r64")) {
-		*pos += strlen("r64");
-		return REAL64;
-	}
-	if(compare(&line[*pos], "read")) {
-		*pos += strlen("read");
-		return READ;
-	}
-	if(compare(&line[*pos], "receive")) {
-		*pos += strlen("receive");
-		return RECEIVE;
-	}
-	if(compare(&line[*pos], "recv")) {
-		*pos += strlen("recv");
-		return RECEIVE;
-	}
-	if(compare(&line[*pos], "restore")) {
-		*pos += strlen("restore");
-		return RESTORE;
-	}
-	if(compare(&line[*pos], "reset")) {
-		*pos += strlen("reset");
-		return RESET;
-	}
-	if(compare(&line[*pos], "rpdo")) {
-		*pos += strlen("rpdo");
-		return RPDO;
-	}
-	if(compare(&line[*pos], "rtr")) {
-		*pos += strlen("rtr");
-		return RTR;
-	}
-	if(compare(&line[*pos], "r")) {
-		*pos += strlen("r");
-		return READ;
-	}
-	if(compare(&line[*pos], "sdo_timeout")) {
-		*pos += strlen("sdo_timeout");
-		return SDO_TIME_OUT;
-	}
-	if(compare(&line[*pos], "set")) {
-		*pos += strlen("set");
-		return SET;
-	}
-	if(compare(&line[*pos], "send")) {
-		*pos += strlen("send");
-		return SEND;
-	}
-	if(compare(&line[*pos], "software")) {
-		*pos += strlen("software");
-		return SOFTWARE;
-	}
-	if(compare(&line[*pos], "start")) {
-		*pos += strlen("start");
-		return START;
-	}
-	if(compare(&line[*pos], "stop")) {
-		*pos += strlen("stop");
-		return STOP;
-	}
-	if(compare(&line[*pos], "store")) {
-		*pos += strlen("store");
-		return STORE;
-	}
-	if(compare(&line[*pos], "sync")) {
-		*pos += strlen("sync");
-		return SYNC;
-	}
-	if(compare(&line[*pos], "td")) {
-		*pos += strlen("td");
-		return TIME_DIFFERENCE;
-	}
-	if(compare(&line[*pos], "tpdo")) {
-		*pos += strlen("tpdo");
-		return TPDO;
-	}
-	if(compare(&line[*pos], "t")) {
-		*pos += strlen("t");
-		return TIME_OF_DAY;
-	}
-	if(compare(&line[*pos], "u8")) {
-		*pos += strlen("u8");
-		return UNSIGNED8;
-	}
-	if(compare(&line[*pos], "u16")) {
-		*pos += strlen("u16");
-		return UNSIGNED16;
-	}
-	if(compare(&line[*pos], "u24")) {
-		*pos += strlen("u24");
-		return UNSIGNED24;
-	}
-	if(compare(&line[*pos], "u32")) {
-		*pos += strlen("u32");
-		return UNSIGNED32;
-	}
-	if(compare(&line[*pos], "u40")) {
-		*pos += strlen("u40");
-		return UNSIGNED40;
-	}
-	if(compare(&line[*pos], "u48")) {
-		*pos += strlen("u48");
-		return UNSIGNED48;
-	}
-	if(compare(&line[*pos], "u56")) {
-		*pos += strlen("u56");
-		return UNSIGNED56;
-	}
-	if(compare(&line[*pos], "u64")) {
-		*pos += strlen("u64");
-		return UNSIGNED64;
-	}
-	if(compare(&line[*pos], "user")) {
-		*pos += strlen("user");
-		return USER;
-	}
-	if(compare(&line[*pos], "us")) {
-		*pos += strlen("us");
-		return UNICODE_STRING;
-	}
-	if(compare(&line[*pos], "version")) {
-		*pos += strlen("version");
-		return VERSION;
-	}
-	if(compare(&line[*pos], "vs")) {
-		*pos += strlen("vs");
-		return VISIBLE_STRING;
-	}
-	if(compare(&line[*pos], "wait")) {
-		*pos += strlen("wait");
-		return WAIT;
-	}
-	if(compare(&line[*pos], "write")) {
-		*pos += strlen("write");
-		return WRITE;
-	}
-	if(compare(&line[*pos], "w")) {
-		*pos += strlen("w");
-		return WRITE;
+	/* switch on the first character */
+	chr = tolower((unsigned char)line[*pos]);
+	if(chr < 'a' || 'z' < chr || !(keyword = keywords[chr - 'a']))
+		return -1;
+	/* the first keyword that is a prefix of the input wins */
+	for(; keyword->string; keyword++) {
+		if(compare(&line[*pos + 1], &keyword->string[1])) {
+			*pos += keyword->length;
+			return keyword->token;
+		}
 	}
 	return -1;
 }
@@ -1255,496 +1931,111 @@ static int compare(char *string, char *keyword)
 	return 1;
 }
 
-static int ascii2unsigned8(char *line, int *pos, unsigned char *value)
+static int ascii2number(char *line, int *pos, int bits, int sign, unsigned long *value)
 {
-	unsigned char num = 0;
-	int n = 0;
+	unsigned long long num = 0, limit;
+	unsigned int base = 10, digit;
+	int minus = 0, overflow = 0;
 	
-	if(value)
-		*value = 0;
+	*value = 0;
 	if(!line || !pos)
 		return 0;
 	for(; WHITESPACE(line[*pos]); *pos += 1)
 		;
+	limit = (1ULL << bits) - 1ULL;
 	if(line[*pos] == '0') {
-		num = (unsigned char)(line[*pos] - '0');
+		/* hexadecimal or octal number (bit pattern) */
 		*pos += 1;
 		if(line[*pos] == 'x' || line[*pos] == 'X') {
 			*pos += 1;
-			/* hexadecimal number */
-			for(; '0' == line[*pos]; *pos += 1)
-				;
-			for(; HEXADECIMAL(line[*pos]); *pos += 1, n++) {
-				if(DECIMAL(line[*pos]))
-					num = (num << 4) + (unsigned char)(line[*pos] - '0');
-				else if('a' <= line[*pos] && line[*pos] <= 'f')
-					num = (num << 4) + (unsigned char)(line[*pos] - 'a' + 10);
-				else if('A' <= line[*pos] && line[*pos] <= 'F')
-					num = (num << 4) + (unsigned char)(line[*pos] - 'A' + 10);
-			}
-			if(value)
-				*value = num;
-			if(n > 2)
-				return 0;
-			else
-				return 1;
+			base = 16;
 		}
-		/* octal number */
-		for(; '0' == line[*pos]; *pos += 1)
-			;
-		for(; OCTAL(line[*pos]); *pos += 1, n++) {
-			if(n == 2 && num > 037)
-	       		n = 4;
-			num = (num << 3) + (unsigned char)(line[*pos] - '0');
-		}
-		if(value)
-			*value = num;
-		if(n > 3)
-			return 0;
 		else
-			return 1;
+			base = 8;
 	}
-	if(DECIMAL(line[*pos])) {
-		/* decimal number */
-		for(; '0' == line[*pos]; *pos += 1)
-			;
-		for(; DECIMAL(line[*pos]); *pos += 1, n++) {
-			if(n == 2 && num > 25)
-	       		n = 4;
-			if(n == 2 && num == 25 && line[*pos] > '5')
-	       		n = 4;
-			num = (num * 10) + (unsigned char)(line[*pos] - '0');
+	else if(sign) {
+		/* signed decimal number */
+		if(line[*pos] == '-') {
+			*pos += 1;
+			minus = 1;
 		}
-		if(value)
-			*value = num;
-		if(n > 3)
+		else if(line[*pos] == '+')
+			*pos += 1;
+		limit = (1ULL << (bits - 1)) - 1ULL + (unsigned long long)minus;
+		if(!DECIMAL(line[*pos]))
 			return 0;
-		else
-			return 1;
 	}
-	return 0;
+	else if(!DECIMAL(line[*pos]))
+		return 0;
+	/* all digits in one pass, the overflow is sticky */
+	for(; (digit = (unsigned int)digits[(unsigned char)line[*pos]] - 1U) < base; *pos += 1) {
+		num = (num * base) + digit;
+		overflow |= (num > limit);
+	}
+	if(overflow)
+		return 0;
+	*value = (unsigned long)(minus? (0ULL - num) & ((1ULL << bits) - 1ULL) : num);
+	return 1;
 }
 
-static int ascii2integer8(char *line, int *pos, char *value)
+static int ascii2unsigned8(char *line, int *pos, unsigned char *value)
 {
-	char num = 0;
-	int n = 0;
+	unsigned long num;
+	int rc = ascii2number(line, pos, 8, 0, &num);
 	
 	if(value)
-		*value = 0;
-	if(!line || !pos)
-		return 0;
-	for(; WHITESPACE(line[*pos]); *pos += 1)
-		;
-	if(line[*pos] == '0') {
-		num = (unsigned char)(line[*pos] - '0');
-		*pos += 1;
-		if(line[*pos] == 'x' || line[*pos] == 'X') {
-			*pos += 1;
-			/* hexadecimal number */
-			for(; '0' == line[*pos]; *pos += 1)
-				;
-			for(; HEXADECIMAL(line[*pos]); *pos += 1, n++) {
-				if(DECIMAL(line[*pos]))
-					num = (num << 4) + (unsigned char)(line[*pos] - '0');
-				else if('a' <= line[*pos] && line[*pos] <= 'f')
-					num = (num << 4) + (unsigned char)(line[*pos] - 'a' + 10);
-				else if('A' <= line[*pos] && line[*pos] <= 'F')
-					num = (num << 4) + (unsigned char)(line[*pos] - 'A' + 10);
-			}
-			if(value)
-				*value = num;
-			if(n > 2)
-				return 0;
-			else
-				return 1;
-		}
-		/* octal number */
-		for(; '0' == line[*pos]; *pos += 1)
-			;
-		for(; OCTAL(line[*pos]); *pos += 1, n++) {
-			if(n == 2 && num > 037)
-	       		n = 4;
-			num = (num << 3) + (unsigned char)(line[*pos] - '0');
-		}
-		if(value)
-			*value = num;
-		if(n > 3)
-			return 0;
-		else
-			return 1;
-	}
-	if(line[*pos] == '-') {
-		*pos += 1;
-		if(DECIMAL(line[*pos])) {
-			/* negative decimal number */
-			for(; '0' == line[*pos]; *pos += 1)
-				;
-			for(; DECIMAL(line[*pos]); *pos += 1, n++) {
-				if(n == 2 && num > 12)
-		       		n = 4;
-				if(n == 2 && num == 12 && line[*pos] > '8')
-		       		n = 4;
-				num = (num * 10) + (unsigned char)(line[*pos] - '0');
-			}
-			if(value)
-				*value = num * (-1);
-			if(n > 3)
-				return 0;
-			else
-				return 1;
-		}
-	}
-	if(line[*pos] == '+') {
-		*pos += 1;
-	}
-	if(DECIMAL(line[*pos])) {
-		/* positive decimal number */
-		for(; '0' == line[*pos]; *pos += 1)
-			;
-		for(; DECIMAL(line[*pos]); *pos += 1, n++) {
-			if(n == 2 && num > 12)
-	       		n = 4;
-			if(n == 2 && num == 12 && line[*pos] > '7')
-	       		n = 4;
-			num = (num * 10) + (unsigned char)(line[*pos] - '0');
-		}
-		if(value)
-			*value = num;
-		if(n > 3)
-			return 0;
-		else
-			return 1;
-	}
-	return 0;
+		*value = (unsigned char)num;
+	return rc;
 }
 
 static int ascii2unsigned16(char *line, int *pos, unsigned short *value)
 {
-	unsigned short num = 0;
-	int n = 0;
+	unsigned long num;
+	int rc = ascii2number(line, pos, 16, 0, &num);
 	
 	if(value)
-		*value = 0;
-	if(!line || !pos)
-		return 0;
-	for(; WHITESPACE(line[*pos]); *pos += 1)
-		;
-	if(line[*pos] == '0') {
-		num = (unsigned short)(line[*pos] - '0');
-		*pos += 1;
-		if(line[*pos] == 'x' || line[*pos] == 'X') {
-			*pos += 1;
-			/* hexadecimal number */
-			for(; '0' == line[*pos]; *pos += 1)
-				;
-			for(; HEXADECIMAL(line[*pos]); *pos += 1, n++) {
-				if(DECIMAL(line[*pos]))
-					num = (num << 4) + (unsigned short)(line[*pos] - '0');
-				else if('a' <= line[*pos] && line[*pos] <= 'f')
-					num = (num << 4) + (unsigned short)(line[*pos] - 'a' + 10);
-				else if('A' <= line[*pos] && line[*pos] <= 'F')
-					num = (num << 4) + (unsigned short)(line[*pos] - 'A' + 10);
-			}
-			if(value)
-				*value = num;
-			if(n > 4)
-				return 0;
-			else
-				return 1;
-		}
-		/* octal number */
-		for(; '0' == line[*pos]; *pos += 1)
-			;
-		for(; OCTAL(line[*pos]); *pos += 1, n++) {
-			if(n == 5 && num > 017777)
-	       		n = 7;
-			num = (num << 3) + (unsigned short)(line[*pos] - '0');
-		}
-		if(value)
-			*value = num;
-		if(n > 6)
-			return 0;
-		else
-			return 1;
-	}
-	if(DECIMAL(line[*pos])) {
-		/* decimal number */
-		for(; '0' == line[*pos]; *pos += 1)
-			;
-		for(; DECIMAL(line[*pos]); *pos += 1, n++) {
-			if(n == 4 && num > 6553)
-	       		n = 6;
-			if(n == 4 && num == 6553 && line[*pos] > '5')
-	       		n = 6;
-			num = (num * 10) + (unsigned short)(line[*pos] - '0');
-		}
-		if(value)
-			*value = num;
-		if(n > 5)
-			return 0;
-		else
-			return 1;
-	}
-	return 0;
+		*value = (unsigned short)num;
+	return rc;
 }
 
-static int ascii2integer16(char *line, int *pos, short *value)
+static int ascii2unsigned32(char *line, int *pos, unsigned long *value)
 {
-	short num = 0;
-	int n = 0;
+	unsigned long num;
+	int rc = ascii2number(line, pos, 32, 0, &num);
 	
 	if(value)
-		*value = 0;
-	if(!line || !pos)
-		return 0;
-	for(; WHITESPACE(line[*pos]); *pos += 1)
-		;
-	if(line[*pos] == '0') {
-		num = (unsigned short)(line[*pos] - '0');
-		*pos += 1;
-		if(line[*pos] == 'x' || line[*pos] == 'X') {
-			*pos += 1;
-			/* hexadecimal number */
-			for(; '0' == line[*pos]; *pos += 1)
-				;
-			for(; HEXADECIMAL(line[*pos]); *pos += 1, n++) {
-				if(DECIMAL(line[*pos]))
-					num = (num << 4) + (unsigned short)(line[*pos] - '0');
-				else if('a' <= line[*pos] && line[*pos] <= 'f')
-					num = (num << 4) + (unsigned short)(line[*pos] - 'a' + 10);
-				else if('A' <= line[*pos] && line[*pos] <= 'F')
-					num = (num << 4) + (unsigned short)(line[*pos] - 'A' + 10);
-			}
-			if(value)
-				*value = num;
-			if(n > 4)
-				return 0;
-			else
-				return 1;
-		}
-		/* octal number */
-		for(; '0' == line[*pos]; *pos += 1)
-			;
-		for(; OCTAL(line[*pos]); *pos += 1, n++) {
-			if(n == 5 && num > 017777)
-	       		n = 7;
-			num = (num << 3) + (unsigned short)(line[*pos] - '0');
-		}
-		if(value)
-			*value = num;
-		if(n > 6)
-			return 0;
-		else
-			return 1;
-	}
-	if(line[*pos] == '-') {
-		*pos += 1;
-		if(DECIMAL(line[*pos])) {
-			/* negative decimal number */
-			for(; '0' == line[*pos]; *pos += 1)
-				;
-			for(; DECIMAL(line[*pos]); *pos += 1, n++) {
-				if(n == 4 && num > 3276)
-		       		n = 6;
-				if(n == 4 && num == 3276 && line[*pos] > '8')
-		       		n = 6;
-				num = (num * 10) + (unsigned short)(line[*pos] - '0');
-			}
-			if(value)
-				*value = num * (-1);
-			if(n > 5)
-				return 0;
-			else
-				return 1;
-		}
-	}
-	if(line[*pos] == '+') {
-		*pos += 1;
-	}
-	if(DECIMAL(line[*pos])) {
-		/* positive decimal number */
-		for(; '0' == line[*pos]; *pos += 1)
-			;
-		for(; DECIMAL(line[*pos]); *pos += 1, n++) {
-			if(n == 4 && num > 3276)
-	       		n = 6;
-			if(n == 4 && num == 3276 && line[*pos] > '7')
-	       		n = 6;
-			num = (num * 10) + (unsigned short)(line[*pos] - '0');
-		}
-		if(value)
-			*value = num;
-		if(n > 5)
-			return 0;
-		else
-			return 1;
-	}
-	return 0;
+		*value = num;
+	return rc;
 }
 
-static int ascii2unsigned32(char *line, int *pos, unsigned long *value)
+static int ascii2integer8(char *line, int *pos, char *value)
 {
-	unsigned long num = 0;
-	int n = 0;
+	unsigned long num;
+	int rc = ascii2number(line, pos, 8, 1, &num);
 	
 	if(value)
-		*value = 0;
-	if(!line || !pos)
-		return 0;
-	for(; WHITESPACE(line[*pos]); *pos += 1)
-		;
-	if(line[*pos] == '0') {
-		num = (unsigned long)(line[*pos] - '0');
-		*pos += 1;
-		if(line[*pos] == 'x' || line[*pos] == 'X') {
-			*pos += 1;
-			/* hexadecimal number */
-			for(; '0' == line[*pos]; *pos += 1)
-				;
-			for(; HEXADECIMAL(line[*pos]); *pos += 1, n++) {
-				if(DECIMAL(line[*pos]))
-					num = (num << 4) + (unsigned long)(line[*pos] - '0');
-				else if('a' <= line[*pos] && line[*pos] <= 'f')
-					num = (num << 4) + (unsigned long)(line[*pos] - 'a' + 10);
-				else if('A' <= line[*pos] && line[*pos] <= 'F')
-					num = (num << 4) + (unsigned long)(line[*pos] - 'A' + 10);
-			}
-			if(value)
-				*value = num;
-			if(n > 8)
-				return 0;
-			else
-				return 1;
-		}
-		/* octal number */
-		for(; '0' == line[*pos]; *pos += 1)
-			;
-		for(; OCTAL(line[*pos]); *pos += 1, n++) {
-			if(n == 10 && num > 03777777777UL)
-	       		n = 12;
-			num = (num << 3) + (unsigned long)(line[*pos] - '0');
-		}
-		if(value)
-			*value = num;
-		if(n > 11)
-			return 0;
-		else
-			return 1;
-	}
-	if(DECIMAL(line[*pos])) {
-		/* decimal number */
-		for(; '0' == line[*pos]; *pos += 1)
-			;
-		for(; DECIMAL(line[*pos]); *pos += 1, n++) {
-			if(n == 9 && num > 429496729UL)
-	       		n = 11;
-			if(n == 9 && num == 429496729UL && line[*pos] > '5')
-	       		n = 11;
-			num = (num * 10) + (unsigned long)(line[*pos] - '0');
-		}
-		if(value)
-			*value = num;
-		if(n > 10)
-			return 0;
-		else
-			return 1;
-	}
-	return 0;
+		*value = (char)num;
+	return rc;
+}
+
+static int ascii2integer16(char *line, int *pos, short *value)
+{
+	unsigned long num;
+	int rc = ascii2number(line, pos, 16, 1, &num);
+	
+	if(value)
+		*value = (short)num;
+	return rc;
 }
 
 static int ascii2integer32(char *line, int *pos, long *value)
 {
-	long num = 0;
-	int n = 0;
+	unsigned long num;
+	int rc = ascii2number(line, pos, 32, 1, &num);
 	
 	if(value)
-		*value = 0;
-	if(!line || !pos)
-		return 0;
-	for(; WHITESPACE(line[*pos]); *pos += 1)
-		;
-	if(line[*pos] == '0') {
-		num = (unsigned long)(line[*pos] - '0');
-		*pos += 1;
-		if(line[*pos] == 'x' || line[*pos] == 'X') {
-			*pos += 1;
-			/* hexadecimal number */
-			for(; '0' == line[*pos]; *pos += 1)
-				;
-			for(; HEXADECIMAL(line[*pos]); *pos += 1, n++) {
-				if(DECIMAL(line[*pos]))
-					num = (num << 4) + (unsigned long)(line[*pos] - '0');
-				else if('a' <= line[*pos] && line[*pos] <= 'f')
-					num = (num << 4) + (unsigned long)(line[*pos] - 'a' + 10);
-				else if('A' <= line[*pos] && line[*pos] <= 'F')
-					num = (num << 4) + (unsigned long)(line[*pos] - 'A' + 10);
-			}
-			if(value)
-				*value = num;
-			if(n > 8)
-				return 0;
-			else
-				return 1;
-		}
-		/* octal number */
-		for(; '0' == line[*pos]; *pos += 1)
-			;
-		for(; OCTAL(line[*pos]); *pos += 1, n++) {
-			if(n == 10 && num > 03777777777UL)
-	       		n = 12;
-			num = (num << 3) + (unsigned long)(line[*pos] - '0');
-		}
-		if(value)
-			*value = num;
-		if(n > 11)
-			return 0;
-		else
-			return 1;
-	}
-	if(line[*pos] == '-') {
-		*pos += 1;
-		if(DECIMAL(line[*pos])) {
-			/* positive decimal number */
-			for(; '0' == line[*pos]; *pos += 1)
-				;
-			for(; DECIMAL(line[*pos]); *pos += 1, n++) {
-				if(n == 9 && num > 214748364L)
-		       		n = 11;
-				if(n == 9 && num == 214748364L && line[*pos] > '8')
-		       		n = 11;
-				num = (num * 10) + (unsigned long)(line[*pos] - '0');
-			}
-			if(value)
-				*value = num * (-1L);
-			if(n > 10)
-				return 0;
-			else
-				return 1;
-		}
-	}
-	if(line[*pos] == '+') {
-		*pos += 1;
-	}
-	if(DECIMAL(line[*pos])) {
-		/* positive decimal number */
-		for(; '0' == line[*pos]; *pos += 1)
-			;
-		for(; DECIMAL(line[*pos]); *pos += 1, n++) {
-			if(n == 9 && num > 214748364L)
-	       		n = 11;
-			if(n == 9 && num == 214748364L && line[*pos] > '7')
-	       		n = 11;
-			num = (num * 10) + (unsigned long)(line[*pos] - '0');
-		}
-		if(value)
-			*value = num;
-		if(n > 10)
-			return 0;
-		else
-			return 1;
-	}
-	return 0;
+		*value = (long)(int)num;
+	return rc;
 }
 
 static int ascii2domain(char *line, int *pos, unsigned char *buffer, int *length, int nbyte)
@@ -1755,24 +2046,9 @@ static int ascii2domain(char *line, int *pos, unsigned char *buffer, int *length
 		return 0;
 	for(; WHITESPACE(line[*pos]); *pos += 1)
 		;
-	for(n = 0, *length = 0; BASE64(line[*pos]) /*|| line[*pos] == '='*/; *pos += 1, n++) {
-		if(n == 4) {
-			*length += base64_decode((unsigned char*)&line[*pos-4], 4, &buffer[*length], (*length + 3) < nbyte ? 3 : nbyte - *length);
-			n = 0;
-		}
-	}
-	if(n == 4) {
-		*length += base64_decode((unsigned char*)&line[*pos-4], 4, &buffer[*length], (*length + 3) < nbyte ? 3 : nbyte - *length);
-	}
-	if(n == 3) {
-		*length += base64_decode((unsigned char*)&line[*pos-3], 3, &buffer[*length], (*length + 3) < nbyte ? 3 : nbyte - *length);
-	}
-	if(n == 2) {
-		*length += base64_decode((unsigned char*)&line[*pos-2], 2, &buffer[*length], (*length + 2) < nbyte ? 2 : nbyte - *length);
-	}
-	if(n == 1) {
-		*length += base64_decode((unsigned char*)&line[*pos-1], 1, &buffer[*length], (*length + 1) < nbyte ? 1 : nbyte - *length);
-	}
+	n = base64_length((unsigned char*)&line[*pos], (int)strlen(&line[*pos]));
+	*length = base64_decode_buffer((unsigned char*)&line[*pos], n, buffer, nbyte);
+	*pos += n;
 	for(; line[*pos] == '='; *pos += 1)
 		;
 	return 1;
@@ -1807,6 +2083,95 @@ static int ascii2string(char *line, int *pos, char *buffer, int *length, int nby
 	return 1;
 }
 
+static int metric_command(int token)
+{
+	switch(token) {
+	case READ: return COP_TCP_CMD_READ;
+	case WRITE: return COP_TCP_CMD_WRITE;
+	case START: return COP_TCP_CMD_START;
+	case STOP: return COP_TCP_CMD_STOP;
+	case PREOPERATIONAL: return COP_TCP_CMD_PREOP;
+	case RESET: return COP_TCP_CMD_RESET;
+	case ENABLE: return COP_TCP_CMD_ENABLE;
+	case DISABLE: return COP_TCP_CMD_DISABLE;
+	case SET: return COP_TCP_CMD_SET;
+	case INFO: return COP_TCP_CMD_INFO;
+	case INIT: return COP_TCP_CMD_INIT;
+	case SCAN: return COP_TCP_CMD_SCAN;
+	case SEND: return COP_TCP_CMD_SEND;
+	case RECEIVE: return COP_TCP_CMD_RECV;
+	case WAIT: return COP_TCP_CMD_WAIT;
+	case STATUS: return COP_TCP_CMD_STATUS;
+	default: return COP_TCP_CMD_OTHER;
+	}
+}
+
+static int metric_class(unsigned long usec)
+{
+	int cls = 0;						/* class 0: below 1 usec */
+
+	while(usec > 0 && cls < COP_TCP_HISTOGRAM - 1) {
+		usec >>= 1;						/* class n: 2^(n-1),..,2^n-1 usec */
+		cls++;
+	}
+	return cls;
+}
+
+static unsigned long metric_count(METRIC *metric)
+{
+	unsigned long count = 0;
+	int i;
+
+	for(i = 0; i < COP_TCP_HISTOGRAM; i++)
+		count += metric->histogram[i];
+	return count;
+}
+
+static void metric_add(METRIC *metric, unsigned long usec, unsigned long result)
+{
+	unsigned long max;
+
+	if(result >= METRIC_ABORT)
+		__sync_fetch_and_add(&metric->aborts, 1UL);
+	else if(result)
+		__sync_fetch_and_add(&metric->errors, 1UL);
+	__sync_fetch_and_add(&metric->latency_sum, (unsigned long long)usec);
+	while((max = metric->latency_max) < usec && !__sync_bool_compare_and_swap(&metric->latency_max, max, usec))
+		;
+	__sync_fetch_and_add(&metric->histogram[metric_class(usec)], 1UL);
+}
+
+static void metric_code(unsigned long code)
+{
+	METRIC_CODE *slot;
+	int i, n;
+
+	/* the slot of the code, or a free slot for it (linear probing) */
+	for(i = 0, n = (int)((code ^ (code >> 16)) % METRIC_CODES); i < METRIC_CODES; i++, n = (n + 1) % METRIC_CODES) {
+		slot = &codes[n];
+		if(slot->code == code || __sync_bool_compare_and_swap(&slot->code, 0UL, code) || slot->code == code) {
+			__sync_fetch_and_add(&slot->count, 1UL);
+			return;
+		}
+	}
+	__sync_fetch_and_add(&codes_lost, 1UL);
+}
+
+static void metric_report(FILE *stream, char *name, METRIC *metric)
+{
+	unsigned long count = metric_count(metric), sum = 0, below;
+	unsigned long long avg = count? metric->latency_sum / count : 0ULL;
+	int n;
+
+	/* the upper bound of the latency class of the 99th percentile */
+	for(n = 0; n < COP_TCP_HISTOGRAM - 1 && (sum += metric->histogram[n]) < count - count / 100; n++)
+		;
+	below = (n < COP_TCP_HISTOGRAM - 1)? (1UL << n) : metric->latency_max + 1;
+	fprintf(stream, "%s: %lu requests, %lu errors, %lu aborts, latency %llu.%03llu ms (max. %lu.%03lu ms, 99%% below %lu.%03lu ms)\n",
+	        name, count, metric->errors, metric->aborts, avg / 1000ULL, avg % 1000ULL,
+	        metric->latency_max / 1000UL, metric->latency_max % 1000UL, below / 1000UL, below % 1000UL);
+}
+
 /*  -----------  command syntax  -------------------------------------------
  */
 
@@ -1898,25 +2263,79 @@ void cop_tcp_syntax(FILE *stream)
 	fprintf(stream, "\n");
 	fprintf(stream, "<enable-guarding-request>  ::= \'[\'<sequence>\']\' [[<net>] <node>] \"enable\" \"guarding\" <guarding-time> <lifetime-factor>\n");
 	fprintf(stream, "\n");
-	fprintf(stream, "<enable-guarding-response> ::= \'[\'<sequence>\']\' \"Error: 100\"\n");
+	fprintf(stream, "<enable-guarding-response> ::= \'[\'<sequence>\']\' \"OK\" |\n");
+	fprintf(stream, "                               \'[\'<sequence>\']\' \"Error:\" <error-code>\n");
 	fprintf(stream, "\n");
 	fprintf(stream, "3.7 Disable node guarding command\n");
 	fprintf(stream, "\n");
 	fprintf(stream, "<disable-guarding-request>  ::= \'[\'<sequence>\']\' [[<net>] <node>] \"disable\" \"guarding\"\n");
 	fprintf(stream, "\n");
-	fprintf(stream, "<disable-guarding-response> ::= \'[\'<sequence>\']\' \"Error: 100\"\n");
+	fprintf(stream, "<disable-guarding-response> ::= \'[\'<sequence>\']\' \"OK\" |\n");
+	fprintf(stream, "                                \'[\'<sequence>\']\' \"Error:\" <error-code>\n");
 	fprintf(stream, "\n");
 	fprintf(stream, "3.8 Start heartbeat consumer command\n");
 	fprintf(stream, "\n");
 	fprintf(stream, "<enable-heartbeat-request>  ::= \'[\'<sequence>\']\' [[<net>] <node>] \"enable\" \"heartbeat\" <heartbeat-time>\n");
 	fprintf(stream, "\n");
-	fprintf(stream, "<enable-heartbeat-response> ::= \'[\'<sequence>\']\' \"Error: 100\"\n");
+	fprintf(stream, "<enable-heartbeat-response> ::= \'[\'<sequence>\']\' \"OK\" |\n");
+	fprintf(stream, "                                \'[\'<sequence>\']\' \"Error:\" <error-code>\n");
 	fprintf(stream, "\n");
 	fprintf(stream, "3.9 Stop heartbeat consumer command\n");
 	fprintf(stream, "\n");
 	fprintf(stream, "<disable-heartbeat-request>  ::= \'[\'<sequence>\']\' [[<net>] <node>] \"disable\" \"heartbeat\"\n");
 	fprintf(stream, "\n");
-	fprintf(stream, "<disable-heartbeat-response> ::= \'[\'<sequence>\']\' \"Error: 100\"\n");
+	fprintf(stream, "<disable-heartbeat-response> ::= \'[\'<sequence>\']\' \"OK\" |\n");
+	fprintf(stream, "                                 \'[\'<sequence>\']\' \"Error:\" <error-code>\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "3.10 Start SYNC producer command\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "<enable-sync-request>  ::= \'[\'<sequence>\']\' [<net>] \"enable\" \"sync\" <cycle-period> [<counter-overflow> [<priority>]]\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "<enable-sync-response> ::= \'[\'<sequence>\']\' \"OK\" |\n");
+	fprintf(stream, "                           \'[\'<sequence>\']\' \"Error:\" <error-code>\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "3.11 Stop SYNC producer command\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "<disable-sync-request>  ::= \'[\'<sequence>\']\' [<net>] \"disable\" \"sync\"\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "<disable-sync-response> ::= \'[\'<sequence>\']\' \"OK\" |\n");
+	fprintf(stream, "                            \'[\'<sequence>\']\' \"Error:\" <error-code>\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "3.12 Read SYNC statistics command\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "<read-sync-request>  ::= \'[\'<sequence>\']\' [<net>] (\"read\"|\'r\') \"sync\"\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "<read-sync-response> ::= \'[\'<sequence>\']\' <count> <overruns> <errors> <jitter-min> <jitter-max> {<jitter-class>}* |\n");
+	fprintf(stream, "                         \'[\'<sequence>\']\' \"Error:\" <error-code>\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "3.13 Scan network command\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "<scan-request>  ::= \'[\'<sequence>\']\' [<net>] \"scan\"\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "<scan-response> ::= \'[\'<sequence>\']\' <count> {<node>}* |\n");
+	fprintf(stream, "                    \'[\'<sequence>\']\' \"Error:\" <error-code>\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "The device type and the identity object of all nodes are read concurrently,\n");
+	fprintf(stream, "so the scan takes about one SDO timeout. The present nodes are returned.\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "3.14 Read node identity command\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "<read-identity-request>  ::= \'[\'<sequence>\']\' [[<net>] <node>] (\"read\"|\'r\') \"identity\"\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "<read-identity-response> ::= \'[\'<sequence>\']\' <device-type> <vendor-id> <product-code> <revision-number> <serial-number> |\n");
+	fprintf(stream, "                             \'[\'<sequence>\']\' \"Error:\" <error-code>\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "The identity is taken from the node table (no SDO transfer).\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "3.15 Enable/disable boot-up scan command\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "<enable-scan-request>  ::= \'[\'<sequence>\']\' [<net>] (\"enable\"|\"disable\") \"scan\"\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "<enable-scan-response> ::= \'[\'<sequence>\']\' \"OK\" |\n");
+	fprintf(stream, "                           \'[\'<sequence>\']\' \"Error:\" <error-code>\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "When enabled, the identity of each node sending a boot-up message is read\n");
+	fprintf(stream, "and entered into the node table.\n");
 	fprintf(stream, "\n");
 	fprintf(stream, "4. Device failure management commands\n");
 	fprintf(stream, "\n");
@@ -1924,7 +2343,42 @@ void cop_tcp_syntax(FILE *stream)
 	fprintf(stream, "\n");
 	fprintf(stream, "<read-error-request>  ::= \'[\'<sequence>\']\' [[<net>] <node>] (\"read\"|\'r\') \"error\"\n");
 	fprintf(stream, "\n");
-	fprintf(stream, "<read-error-response> ::= \'[\'<sequence>\']\' \"Error: 100\"\n");
+	fprintf(stream, "<read-error-response> ::= \'[\'<sequence>\']\' <count> {<error-code> <error-register> <manufacturer-field>}* |\n");
+	fprintf(stream, "                          \'[\'<sequence>\']\' \"Error:\" <error-code>\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "The last %u emergency messages of the node are returned, newest first.\n", EMCY_HISTORY);
+	fprintf(stream, "\n");
+	fprintf(stream, "4.2 Error control events\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "<boot-up-event>       ::= <net> <node> \"BOOT_UP\"\n");
+	fprintf(stream, "<error-control-event> ::= <net> <node> \"ERROR\" <error>\n");
+	fprintf(stream, "<node-state-event>    ::= <net> <node> \"STATE\" (\"OPERATIONAL\"|\"STOPPED\"|\"PREOPERATIONAL\")\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "<error> ::= \'1\' (node guarding event) | \'2\' (heartbeat event)\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "Events are sent without a request. Boot-up events are sent for all nodes,\n");
+	fprintf(stream, "the other events for nodes with node guarding or heartbeat consumer enabled.\n");
+	fprintf(stream, "A node state event is also sent when a lost node is alive again.\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "4.3 Emergency events\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "<emcy-event> ::= <net> <node> \"EMCY\" <error-code> <error-register> <manufacturer-field>\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "4.4 Enable/disable emergency events command\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "<enable-emcy-request>  ::= \'[\'<sequence>\']\' [<net>] (\"enable\"|\"disable\") \"emcy\"\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "<enable-emcy-response> ::= \'[\'<sequence>\']\' \"OK\" |\n");
+	fprintf(stream, "                           \'[\'<sequence>\']\' \"Error:\" <error-code>\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "4.5 Enable/disable error control events command\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "<enable-event-request>  ::= \'[\'<sequence>\']\' [<net>] (\"enable\"|\"disable\") \"event\"\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "<enable-event-response> ::= \'[\'<sequence>\']\' \"OK\"\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "Emergency events are disabled and error control events are enabled when a\n");
+	fprintf(stream, "client connects. Emergency events are sent for all nodes.\n");
 	fprintf(stream, "\n");
 	fprintf(stream, "5. CANopen interface configuration commands\n");
 	fprintf(stream, "\n");
@@ -1951,13 +2405,15 @@ void cop_tcp_syntax(FILE *stream)
 	fprintf(stream, "\n");
 	fprintf(stream, "<set-heartbeat-request>  ::= \'[\'<sequence>\']\' [<net>] \"set\" \"heartbeat\" <heartbeat-time>\n");
 	fprintf(stream, "\n");
-	fprintf(stream, "<set-heartbeat-response> ::= \'[\'<sequence>\']\' \"Error: 100\"\n");
+	fprintf(stream, "<set-heartbeat-response> ::= \'[\'<sequence>\']\' \"OK\" |\n");
+	fprintf(stream, "                             \'[\'<sequence>\']\' \"Error:\" <error-code>\n");
 	fprintf(stream, "\n");
 	fprintf(stream, "5.5 Set node-id command\n");
 	fprintf(stream, "\n");
 	fprintf(stream, "<set-id-request>  ::= \'[\'<sequence>\']\' [<net>] \"set\" \"id\" <node-id>\n");
 	fprintf(stream, "\n");
-	fprintf(stream, "<set-id-response> ::= \'[\'<sequence>\']\' \"Error: 100\"\n");
+	fprintf(stream, "<set-id-response> ::= \'[\'<sequence>\']\' \"OK\" |\n");
+	fprintf(stream, "                      \'[\'<sequence>\']\' \"Error:\" <error-code>\n");
 	fprintf(stream, "\n");
 	fprintf(stream, "6. Gateway management commands\n");
 	fprintf(stream, "\n");
@@ -2020,6 +2476,44 @@ void cop_tcp_syntax(FILE *stream)
 	fprintf(stream, "<get-information-response> ::= \'[\'<sequence>\']\' <string> |\n");
 	fprintf(stream, "                               \'[\'<sequence>\']\' \"Error:\" <error-code>\n");
 	fprintf(stream, "\n");
+	fprintf(stream, "7.6 Read gateway status command\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "<read-status-request>  ::= \'[\'<sequence>\']\' \"status\" [<command> | \"node\" <node> | \"error\"]\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "<read-status-response> ::= \'[\'<sequence>\']\' <requests> {<command>\'=\'<count>\'/\'<errors>\'/\'<aborts>\'/\'<average>\'/\'<maximum>}* |\n");
+	fprintf(stream, "                           \'[\'<sequence>\']\' <count> <errors> <aborts> <average> <maximum> {<latency-class>}* |\n");
+	fprintf(stream, "                           \'[\'<sequence>\']\' <number> {<code>\'=\'<count>}* |\n");
+	fprintf(stream, "                           \'[\'<sequence>\']\' \"Error:\" <error-code>\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "7.7 Execute command file\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "<execute-request>  ::= \'[\'<sequence>\']\' \"exec\" <filename> [\"check\"]\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "<execute-response> ::= \'[\'<sequence>\']\' <requests> <errors> <line> <rounds> <milliseconds> |\n");
+	fprintf(stream, "                       \'[\'<sequence>\']\' \"Error:\" <error-code>\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "7.8 Subscribe CAN messages command\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "<subscribe-message-request>  ::= \'[\'<sequence>\']\' [<net>] \"enable\" \"recv\" [<cob-id> [<cob-id>]] [\"mask\" <mask>] [\"rate\" <milliseconds>]\n");
+	fprintf(stream, "<unsubscribe-message-request> ::= \'[\'<sequence>\']\' [<net>] \"disable\" \"recv\"\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "<subscribe-message-response> ::= \'[\'<sequence>\']\' \"OK\" |\n");
+	fprintf(stream, "                                 \'[\'<sequence>\']\' \"Error:\" <error-code>\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "<message-event> ::= <net> \"RECV\" <cob-id> <length> {<value>}*\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "<read-counters-request>  ::= \'[\'<sequence>\']\' [<net>] \"info\" \"recv\"\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "<read-counters-response> ::= \'[\'<sequence>\']\' <received> <throttled> <lost> |\n");
+	fprintf(stream, "                             \'[\'<sequence>\']\' \"Error:\" <error-code>\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "7.9 Commission nodes command\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "<commission-request>  ::= \'[\'<sequence>\']\' [<net>] \"commission\" <vendor-id> <product-code> <revision-number> {<serial-number> <node-id>}+ [\"rate\" <baudrate-index>] [\"store\"]\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "<commission-response> ::= \'[\'<sequence>\']\' <count> {<node-id> <step> <microseconds>}+ |\n");
+	fprintf(stream, "                          \'[\'<sequence>\']\' \"Error:\" <error-code>\n");
+	fprintf(stream, "\n");
 	fprintf(stream, "8. Miscellaneous\n");
 	fprintf(stream, "\n");
 	fprintf(stream, "8.1 Supported data types\n");
@@ -2049,8 +2543,61 @@ void cop_tcp_syntax(FILE *stream)
 	fprintf(stream, "\"Error: 101\" = Syntax error\n");
 	fprintf(stream, "\"Error: 102\" = Request not executed\n");
 	fprintf(stream, "\"Error: 103\" = Time-out occurred\n");
+	fprintf(stream, "\"Error: 106\" = Unsupported network\n");
 	fprintf(stream, "\"Error: 999\" = Fatal error\n");
 	fprintf(stream, "\n");
+	fprintf(stream, "8.4 SYNC producer\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "The cycle period is given in microseconds (minimum 100), the counter overflow\n");
+	fprintf(stream, "value is 0 (no counter) or 2 to 240, and the priority is 0 (normal scheduling)\n");
+	fprintf(stream, "or 1 to 99 (SCHED_FIFO). The jitter is given in microseconds; jitter class 0\n");
+	fprintf(stream, "counts periods with a jitter below 1 usec, class n from 2^(n-1) to 2^n-1 usec.\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "8.5 Gateway status\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "Each request is counted with its latency in microseconds by its command: \"read\",\n");
+	fprintf(stream, "\"write\", \"start\", \"stop\", \"preop\", \"reset\", \"enable\", \"disable\", \"set\", \"info\",\n");
+	fprintf(stream, "\"init\", \"scan\", \"send\", \"recv\", \"wait\", \"status\" (any other request as \"other\"),\n");
+	fprintf(stream, "and an SDO command also by its node. Errors are error codes of DS-309/3, aborts\n");
+	fprintf(stream, "SDO abort codes; \"status error\" gives the number of each code. Latency class 0\n");
+	fprintf(stream, "counts requests below 1 usec, class n from 2^(n-1) to 2^n-1 usec. The server\n");
+	fprintf(stream, "prints the status to stderr every minute when requests have been executed.\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "8.6 Command files\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "A command file has one request per line; a \'#\' starts a comment (not within a\n");
+	fprintf(stream, "string), empty lines are skipped, and a request without \'[\'<sequence>\']\' is\n");
+	fprintf(stream, "numbered by its line. SDO commands to different nodes are executed concurrently,\n");
+	fprintf(stream, "any other request after all requests before it. With \"check\" the requests are\n");
+	fprintf(stream, "only parsed. The response gives the number of requests and errors, the line of\n");
+	fprintf(stream, "the first error (or 0), the least number of consecutive steps and the time, and\n");
+	fprintf(stream, "the responses of the requests are printed. Command files are executed in local\n");
+	fprintf(stream, "mode only; in gateway mode \"exec\" is refused (\"Error: 100\").\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "8.7 CAN message subscription\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "A subscription passes the received CAN messages to the client as message events\n");
+	fprintf(stream, "(see 7.8), without a request per message. A message passes when its COB-ID ANDed\n");
+	fprintf(stream, "with the mask (default 0x7FF) is within the range of COB-IDs ANDed with the mask\n");
+	fprintf(stream, "(default all COB-IDs; one COB-ID for a range of one). With \"rate\", a message is\n");
+	fprintf(stream, "dropped when the last message of the same COB-ID passed less than the given time\n");
+	fprintf(stream, "before. The messages are also received by \"recv\" as before. A new \"enable recv\"\n");
+	fprintf(stream, "replaces the subscription of the client. The counters give the number of passed\n");
+	fprintf(stream, "messages, of messages dropped by the rate limit, and of messages lost when the\n");
+	fprintf(stream, "client did not keep up (the oldest are lost).\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "8.8 Commissioning\n");
+	fprintf(stream, "\n");
+	fprintf(stream, "The nodes of a product are commissioned one after the other by LSS (CiA DSP-305):\n");
+	fprintf(stream, "each node is switched to configuration mode by its LSS address (the vendor-id,\n");
+	fprintf(stream, "product-code and revision-number of the request and its serial-number), gets its\n");
+	fprintf(stream, "node-id, optionally the bit-timing (baudrate index as by \"init\") and \"store\",\n");
+	fprintf(stream, "and is switched back to operation mode. Up to 32 nodes are given by a request.\n");
+	fprintf(stream, "The response gives the number of nodes commissioned, and for each node the step\n");
+	fprintf(stream, "that failed (0 = none, 1 = switch mode selective, 2 = node-id, 3 = bit-timing,\n");
+	fprintf(stream, "4 = store, 5 = switch mode global) and the time taken in microseconds. The new\n");
+	fprintf(stream, "node-id and bit-timing become valid after a reset of the node.\n");
+	fprintf(stream, "\n");
 	fprintf(stream, "9. Further information\n");
 	fprintf(stream, "\n");
 	fprintf(stream, "CiA DS-301, CANopen application layer and communication profile, version 4.02\n");
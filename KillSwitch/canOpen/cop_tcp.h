@@ -49,11 +49,37 @@
 /*  -----------  defines  --------------------------------------------------
  */
 
+#define COP_TCP_CMD_READ		0		/* command classes of the metrics: */
+#define COP_TCP_CMD_WRITE		1
+#define COP_TCP_CMD_START		2
+#define COP_TCP_CMD_STOP		3
+#define COP_TCP_CMD_PREOP		4
+#define COP_TCP_CMD_RESET		5
+#define COP_TCP_CMD_ENABLE		6
+#define COP_TCP_CMD_DISABLE		7
+#define COP_TCP_CMD_SET			8
+#define COP_TCP_CMD_INFO		9
+#define COP_TCP_CMD_INIT		10
+#define COP_TCP_CMD_SCAN		11
+#define COP_TCP_CMD_SEND		12
+#define COP_TCP_CMD_RECV		13
+#define COP_TCP_CMD_WAIT		14
+#define COP_TCP_CMD_STATUS		15
+#define COP_TCP_CMD_OTHER		16		/*   any other (or invalid) request */
+#define COP_TCP_COMMANDS		17		/* number of command classes */
+#define COP_TCP_HISTOGRAM		24		/* number of latency classes */
+
+struct _nmt_event;						/* error control event (cop_api.h) */
+
 typedef struct _cop_tcp_settings		/* settings for the gateway: */
 {
 	BYTE net;							/*   default network number */
 	BYTE node;							/*   default node-id */
 	BYTE master;						/*   node-id of the master */
+	BYTE events;						/*   error control events enabled */
+	LONG emcy;							/*   EMCY subscription (or -1) */
+	FILE *output;						/*   responses of a command file (or NULL) */
+	LONG monitor;						/*   CAN message subscription (or -1) */
 }	COP_TCP_SETTINGS;
 
 /*  -----------  types  ----------------------------------------------------
@@ -79,6 +105,22 @@ int cop_tcp_parse(char *request, COP_TCP_SETTINGS *settings, char *response, int
  *	result    :  0 if successful, or a negative value on error. 
  */
 
+int cop_tcp_check(char *request, COP_TCP_SETTINGS *settings, char *response, int nbyte);
+/*
+ *	function  :  parses a request as cop_tcp_parse, but does not execute
+ *	             it on the CANopen network (check mode of a command file).
+ *	             The settings are changed as by cop_tcp_parse, so a copy
+ *	             should be passed. The request is not counted in the
+ *	             metrics.
+ *
+ *	parameter :  request  - the request (as for cop_tcp_parse)
+ *               settings - settings of the gateway
+ *               response - buffer for the response ("OK" or the error)
+ *               nbyte    - size of the buffer
+ *
+ *	result    :  0 if the request is valid, or the error code.
+ */
+
 int cop_tcp_sequence(char *string, unsigned long *sequence);
 /*
  *	function  :  ...
@@ -89,6 +131,138 @@ int cop_tcp_sequence(char *string, unsigned long *sequence);
  *	result    :  0 if successful, or a negative value on error. 
  */
 
+int cop_tcp_node(char *request, COP_TCP_SETTINGS *settings);
+/*
+ *	function  :  retrieves the node-id addressed by an Upload or Download
+ *	             SDO command (without executing the request), so that the
+ *	             SDO commands to different nodes can be run concurrently.
+ *
+ *	parameter :  request  - the request (as for cop_tcp_parse)
+ *               settings - settings of the gateway (default node-id)
+ *
+ *	result    :  node-id (1,..,127) of an SDO command, or 0 for any other
+ *	             request (or on a syntax error).
+ */
+
+int cop_tcp_net(char *request, COP_TCP_SETTINGS *settings);
+/*
+ *	function  :  retrieves the network addressed by a request (without
+ *	             executing it), so that a router can pass the request to
+ *	             the process serving that network.
+ *
+ *	parameter :  request  - the request (as for cop_tcp_parse)
+ *               settings - settings of the gateway (default network)
+ *
+ *	result    :  network number of the request (the default network if
+ *	             none is given, or on a syntax error), or 0 for a Set
+ *	             Default Network command (executed by the router).
+ */
+
+void cop_tcp_networks(int first, int last);
+/*
+ *	function  :  sets the network numbers served by this process (default
+ *	             1 to 1). A request to another network, and a Set Default
+ *	             Network command to another network, are answered with
+ *	             error 106.
+ *
+ *	parameter :  first - first network number (1,..,255)
+ *               last  - last network number (first,..,255)
+ *
+ *	result    :  (none)
+ */
+
+int cop_tcp_event(COP_TCP_SETTINGS *settings, char *response, int nbyte);
+/*
+ *	function  :  formats the next pending event of the CANopen Master
+ *	             (boot-up, node state changed, node lost, emergency,
+ *	             subscribed CAN message) as an event notification, e.g.
+ *	             "1 5 BOOT_UP".
+ *
+ *	parameter :  settings - settings of the gateway (network number)
+ *               response - buffer for the notification
+ *               nbyte    - size of the buffer
+ *
+ *	result    :  non-zero if an event is written, or 0 if none is pending.
+ */
+
+int cop_tcp_emcy(COP_TCP_SETTINGS *settings, char *response, int nbyte);
+/*
+ *	function  :  formats the next emergency message of the subscription
+ *	             of a client as an event notification (without polling
+ *	             the error control events).
+ *
+ *	parameter :  settings - settings of the gateway (EMCY subscription)
+ *               response - buffer for the notification
+ *               nbyte    - size of the buffer
+ *
+ *	result    :  non-zero if an event is written, or 0 if none is pending.
+ */
+
+int cop_tcp_message(COP_TCP_SETTINGS *settings, char *response, int nbyte);
+/*
+ *	function  :  formats the next CAN message of the subscription of a
+ *	             client ("enable recv") as an event notification, e.g.
+ *	             "1 RECV 0x181 2 0x1 0x0".
+ *
+ *	parameter :  settings - settings of the gateway (message subscription)
+ *               response - buffer for the notification
+ *               nbyte    - size of the buffer
+ *
+ *	result    :  non-zero if an event is written, or 0 if none is pending.
+ */
+
+int cop_tcp_notify(COP_TCP_SETTINGS *settings, struct _nmt_event *event, char *response, int nbyte);
+/*
+ *	function  :  formats an error control event (read by nmt_event) as an
+ *	             event notification for a client, e.g. when one event is
+ *	             delivered to several clients.
+ *
+ *	parameter :  settings - settings of the gateway (network number)
+ *               event    - the error control event (NMT_EVENT)
+ *               response - buffer for the notification
+ *               nbyte    - size of the buffer
+ *
+ *	result    :  non-zero if the notification is written, or 0 if the
+ *	             client has disabled the error control events.
+ */
+
+void cop_tcp_close(COP_TCP_SETTINGS *settings);
+/*
+ *	function  :  releases the subscriptions of a client (e.g. when the
+ *	             connection is closed).
+ *
+ *	parameter :  settings - settings of the gateway
+ *
+ *	result    :  (none)
+ */
+
+void cop_tcp_measure(int command, int node, long long usec, unsigned long result);
+/*
+ *	function  :  records the latency and the result of a request in the
+ *	             metrics of the gateway (lock-free, so it may be called by
+ *	             several threads). cop_tcp_parse records its requests itself.
+ *
+ *	parameter :  command - command class (COP_TCP_CMD_xyz)
+ *               node    - node-id of an SDO command, or 0
+ *               usec    - latency of the request [usec]
+ *               result  - 0, an error code of DS-309/3 (below 1000), or an
+ *                         SDO abort code
+ *
+ *	result    :  (none)
+ */
+
+void cop_tcp_report(FILE *stream);
+/*
+ *	function  :  prints the metrics of the gateway: number of requests,
+ *	             errors, aborts and the latency of each command class and
+ *	             of the SDO commands to each node, and the counts of the
+ *	             error and abort codes.
+ *
+ *	parameter :  stream - output stream
+ *
+ *	result    :  (none)
+ */
+
 void cop_tcp_syntax(FILE *stream);
 /*
  *	function  :  ...
@@ -8,9 +8,11 @@
  *
  *	compiler  :  GCC - GNU C Compiler (Linux Kernel 2.6)
  *
- *	syntax    :  can_open <interface> [<option>...]
+ *	syntax    :  can_open <interface>[,<interface>...] [<option>...]
  *	             Options:
  *	               -g, --gateway=<port>         operate in gateway mode on <port>
+ *	                   --local=<path>           local socket of the gateway (AF_UNIX)
+ *	                   --shm=<name>             shared-memory ring of the gateway
  *	               -t, --timeout=<seconds>      time-out in seconds (client only)
  *	               -b, --baudrate=<baudrate>    bit timing in kbps (default=250)
  *	               -i, --id=<node-id>           node-id of CANopen Master (default=-1)
@@ -24,7 +26,7 @@
  *
  *	libraries :  (none)
  *
- *	includes  :  default.h, cop_tcp.h, cop_api.h, can_defs.h
+ *	includes  :  default.h, cop_tcp.h, cop_srv.h, cop_net.h, cop_api.h, can_defs.h
  *
  *	author    :  Uwe Vogt, UV Software, Friedrichshafen
  *
@@ -53,10 +55,13 @@ static const char  _rev[] = "$Rev: 34 $";
 #include "can_defs.h"
 #include "cop_api.h"
 #include "cop_tcp.h"
+#include "cop_srv.h"
+#include "cop_net.h"
 #include "default.h"
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <unistd.h>
 #include <string.h>
 #include <libgen.h>
@@ -67,6 +72,7 @@ static const char  _rev[] = "$Rev: 34 $";
 #include <sys/time.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/un.h>
 #include <netinet/in.h>
 #include <sys/ioctl.h>
 #include <net/if.h>
@@ -78,7 +84,6 @@ static const char  _rev[] = "$Rev: 34 $";
  */
 
 #define __no_can_ioctl
-#define __single_channel
 
 
 /* ***	defines  ***
@@ -108,11 +113,12 @@ void version(FILE *stream, char *program);
 
 void syntax(FILE *stream, char *program);
 ssize_t readline(int fd, char *buf, size_t nbyte);
+socklen_t unixaddr(struct sockaddr_un *addr, const char *path);
 
 /* ***	variables  ***
  */
 
-static int client = -1, server = -1;
+static int client = -1, server = -1, local = -1;
 static int running = 1;
 
 
@@ -142,9 +148,15 @@ int main(int argc, char *argv[])
 	long   sequence = SEQUENCE_NO;
 	long   request = 0, response = 0;
 	char   buffer[BUFFER_LENGTH];
-	long   rc; ssize_t n; int on;
+	long   rc; int on;
 	struct sockaddr_in addr;
 	char  *device, *firmware, *software;
+	char  *ifname; int networks = 1;
+	char  *path = NULL; int lc = 0;
+	char  *shm = NULL; int sh = 0;
+	char  *remote = NULL;
+	COP_SHM *ring = NULL;
+	struct sockaddr_un unaddr; socklen_t unlen;
 		
 	struct option long_options[] = {
 		{"baudrate", required_argument, 0, 'b'},
@@ -155,13 +167,16 @@ int main(int argc, char *argv[])
 		{"prompt", no_argument, 0, 'p'},
 		{"syntax", no_argument, 0, 's'},
 		{"gateway", required_argument, 0, 'g'},
+		{"local", required_argument, 0, 'L'},
+		{"shm", required_argument, 0, 'S'},
 		//{"timeout", required_argument, 0, 't'},
 		{"help", no_argument, 0, 'h'},
 		{"version", no_argument, 0, 'v'},
 		{0, 0, 0, 0}
 	};
 	struct _can_param can_param = {"can0", PF_CAN, SOCK_RAW, CAN_RAW};
-	struct _cop_tcp_settings settings = {DEFAULT_NET, DEFAULT_NODE, NODE_ID};
+	struct _can_param can_params[COP_NET_NETWORKS];
+	struct _cop_tcp_settings settings = {DEFAULT_NET, DEFAULT_NODE, NODE_ID, 1, -1, NULL, -1};
 	
 	signal(SIGINT, sigterm);	
 	signal(SIGHUP, sigterm);	
@@ -263,16 +278,12 @@ int main(int argc, char *argv[])
 					usage(stderr, basename(argv[0]));
 					return 1;
 				}
-				if(sscanf(optarg, "%i", &default_node) != 1) {
+				if(sscanf(optarg, "%i", &default_net) != 1) {
 					fprintf(stderr, "+++ error: illegal argument in option -- net\n");
 					usage(stderr, basename(argv[0]));
 					return 1;
 				}
-#ifndef __single_channel				
-				if((default_net < 1) || (255 < default_net)) {
-#else
-				if((default_net != DEFAULT_NET)) {
-#endif
+				if((default_net < 1) || (COP_NET_NETWORKS < default_net)) {
 					fprintf(stderr, "+++ error: illegal argument in option -- net\n");
 					usage(stderr, basename(argv[0]));
 					return 1;
@@ -302,6 +313,32 @@ int main(int argc, char *argv[])
 				}
 				gateway = 1;
 				break;
+			case 'L':
+				if(lc++) {
+					fprintf(stderr, "+++ error: conflict in option -- local\n");
+					usage(stderr, basename(argv[0]));
+					return 1;
+				}
+				if(!optarg || !optarg[0] || optarg[0] == '-' || !unixaddr(&unaddr, optarg)) {
+					fprintf(stderr, "+++ error: illegal argument in option -- local\n");
+					usage(stderr, basename(argv[0]));
+					return 1;
+				}
+				path = optarg;
+				break;
+			case 'S':
+				if(sh++) {
+					fprintf(stderr, "+++ error: conflict in option -- shm\n");
+					usage(stderr, basename(argv[0]));
+					return 1;
+				}
+				if(!optarg || optarg[0] != '/' || strchr(&optarg[1], '/')) {
+					fprintf(stderr, "+++ error: illegal argument in option -- shm\n");
+					usage(stderr, basename(argv[0]));
+					return 1;
+				}
+				shm = optarg;
+				break;
 			/* *** **
 			case 't':
 				if(to++) {
@@ -392,6 +429,16 @@ int main(int argc, char *argv[])
 				}
 				mode = MODE_REMOTE;
 			}
+			else if(argv[optind][0] == '/' || argv[optind][0] == '@') {
+				/* the local socket of a gateway */
+				if(!unixaddr(&unaddr, argv[optind])) {
+					fprintf(stderr, "+++ error: illegal socket path\n");
+					usage(stderr, basename(argv[0]));
+					return 1;
+				}
+				remote = argv[optind];
+				mode = MODE_REMOTE;
+			}
 			else {
 				can_param.ifname = argv[optind];
 				mode = MODE_LOCAL;
@@ -401,6 +448,44 @@ int main(int argc, char *argv[])
 			can_param.ifname = argv[optind];
 			mode = MODE_GATEWAY;
 		}
+		/* several interfaces: one network each (gateway mode only) */
+		if(mode != MODE_REMOTE && strchr(argv[optind], ',')) {
+			if(mode != MODE_GATEWAY) {
+				fprintf(stderr, "+++ error: several interfaces in gateway mode only\n");
+				usage(stderr, basename(argv[0]));
+				return 1;
+			}
+			for(networks = 0, ifname = strtok(argv[optind], ","); ifname; ifname = strtok(NULL, ",")) {
+				if(networks == COP_NET_NETWORKS) {
+					fprintf(stderr, "+++ error: too many interfaces (max. %i)\n", COP_NET_NETWORKS);
+					usage(stderr, basename(argv[0]));
+					return 1;
+				}
+				memcpy(&can_params[networks], &can_param, sizeof(can_param));
+				can_params[networks++].ifname = ifname;
+			}
+			if(networks == 0) {
+				fprintf(stderr, "+++ error: no interface given\n");
+				usage(stderr, basename(argv[0]));
+				return 1;
+			}
+			can_param.ifname = can_params[0].ifname;
+		}
+	}
+	if(mode != MODE_REMOTE && networks < default_net) {
+		fprintf(stderr, "+++ error: illegal argument in option -- net\n");
+		usage(stderr, basename(argv[0]));
+		return 1;
+	}
+	if(mode != MODE_GATEWAY && lc) {
+		fprintf(stderr, "+++ error: conflict in option -- local\n");
+		usage(stderr, basename(argv[0]));
+		return 1;
+	}
+	if(mode != MODE_GATEWAY && sh) {
+		fprintf(stderr, "+++ error: conflict in option -- shm\n");
+		usage(stderr, basename(argv[0]));
+		return 1;
 	}
 	if(mode == MODE_REMOTE && node) {
 		fprintf(stderr, "+++ error: conflict in option -- node\n");
@@ -443,17 +528,57 @@ int main(int argc, char *argv[])
 			close(server);
 			return 1;
 		}
-		if(listen(server, 1) < 0) {
+		if(listen(server, COP_SRV_CLIENTS) < 0) {
 			perror("+++ error(listen)");
 			close(server);
 			return 1;
 		}
+		if(path) {
+			/* the local socket: a file is replaced, an abstract name starts with '@' */
+			unlen = unixaddr(&unaddr, path);
+			if(path[0] != '@')
+				unlink(path);
+			if((local = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
+				perror("+++ error(socket)");
+				close(server);
+				return 1;
+			}
+			if(bind(local, (struct sockaddr*)&unaddr, unlen) < 0 ||
+			   listen(local, COP_SRV_CLIENTS) < 0) {
+				perror("+++ error(bind)");
+				close(local);
+				close(server);
+				return 1;
+			}
+		}
+		if(networks > 1) {
+			/* one process for each network (they initialize the CANopen Master) */
+			fprintf(stderr, "Interfacing CANopen with TCP/IP acc. DS-309/3: port=%li, %i networks\n", port, networks);
+			fprintf(stderr, "\nPress ^C to abort.\n\n");
+			rc = cop_net_loop(server, local, shm, can_params, networks, (BYTE)baudrate, &settings, echo, &running);
+			close(server);
+			if(local != -1)
+				close(local);
+			if(path && path[0] != '@')
+				unlink(path);
+			fprintf(stderr, "Port %li closed.\n", port);
+			return (rc < 0)? 1 : 0;
+		}
 		if((rc = cop_init(CAN_NETDEV, &can_param, (BYTE)baudrate)) != 0) {
 			fprintf(stderr, "+++ error: cop_init = %li\n", rc);
 			close(server);
 			return 1;
 		}
+		if(shm && !(ring = cop_shm_create(shm))) {
+			close(server);
+			cop_exit();
+			return 1;
+		}
 		fprintf(stderr, "Interfacing CANopen with TCP/IP acc. DS-309/3: port=%li\n", port);
+		if(path)
+			fprintf(stderr, "Local socket: %s\n", path);
+		if(shm)
+			fprintf(stderr, "Shared-memory ring: %s\n", shm);
 		if(((device = cop_hardware()) != NULL) &&
 		   ((firmware = cop_software()) != NULL) &&
 		   ((software = cop_version()) != NULL)) {
@@ -465,44 +590,45 @@ int main(int argc, char *argv[])
 		}
 		fprintf(stderr, "\nPress ^C to abort.\n\n");
 		
-		while(running && (client = accept(server, NULL, NULL)) >= 0) {
-			while(running && (n = readline(client, &buffer[0], BUFFER_LENGTH)) > 0) {
-				if(echo) {
-					fputs(&buffer[0], stdout);
-				}
-				if(strcmp(buffer, "\r\n") && strcmp(buffer, "\n")) {
-					cop_tcp_parse(&buffer[0], &settings, &buffer[0], BUFFER_LENGTH);
-					if(write(client, buffer, strlen(buffer)) < 0) {
-						perror("+++ error(write)");
-					}
-					else if(echo) {
-						fputs(&buffer[0], stdout);
-					}
-				}
-			}
-			if(running && n < 0 && errno != ECONNRESET) {
-				perror("+++ error(read)");
-			}
-			close(client);
-			client = -1;
-		}
+		cop_srv_loop(server, local, ring, &settings, echo, &running);
 		close(server);
+		if(local != -1)
+			close(local);
+		if(path && path[0] != '@')
+			unlink(path);
+		if(ring)
+			cop_shm_destroy(ring, shm);
 		cop_exit();
 		fprintf(stderr, "Port %li closed.\n", port);
 		break;
 	case MODE_REMOTE:
-		memset(&addr, 0, sizeof(addr));
-		addr.sin_family = AF_INET;
-		addr.sin_addr.s_addr = htonl((unsigned long)(ip1 * (256*256*256) + ip2 * (256*256) + ip3 * (256) + ip4));
-		addr.sin_port = htons((unsigned short)port);
-		if((client = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
-			perror("+++ error(socket)");
-			return 1;
+		if(remote) {
+			/* the local socket of a gateway on the same board */
+			unlen = unixaddr(&unaddr, remote);
+			if((client = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
+				perror("+++ error(socket)");
+				return 1;
+			}
+			if(connect(client, (struct sockaddr*)&unaddr, unlen) < 0) {
+				perror("+++ error(connect)");
+				close(client);
+				return 1;
+			}
 		}
-		if(connect(client, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
-			perror("+++ error(connect)");
-			close(client);
-			return 1;
+		else {
+			memset(&addr, 0, sizeof(addr));
+			addr.sin_family = AF_INET;
+			addr.sin_addr.s_addr = htonl((unsigned long)(ip1 * (256*256*256) + ip2 * (256*256) + ip3 * (256) + ip4));
+			addr.sin_port = htons((unsigned short)port);
+			if((client = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
+				perror("+++ error(socket)");
+				return 1;
+			}
+			if(connect(client, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+				perror("+++ error(connect)");
+				close(client);
+				return 1;
+			}
 		}
 		while(running && !feof(stdin)) {
 			if(prompt) {
@@ -549,6 +675,7 @@ int main(int argc, char *argv[])
 			fprintf(stderr, "+++ error: cop_init = %li\n", rc);
 			return 1;
 		}
+		settings.output = stdout;		/* responses of a command file */
 		while(running && !feof(stdin)) {
 			if(prompt) {
 				sprintf(buffer, "[%li] ", sequence++);
@@ -566,6 +693,9 @@ int main(int argc, char *argv[])
 					cop_tcp_parse(&buffer[0], &settings, &buffer[0], BUFFER_LENGTH);
 					fputs(&buffer[0], stdout);
 				}
+				while(cop_tcp_event(&settings, &buffer[0], BUFFER_LENGTH)) {
+					fputs(&buffer[0], stdout);
+				}
 			}
 			else if(ferror(stdin)) {
 				perror("+++ error(stdin)");
@@ -612,9 +742,11 @@ void version(FILE *stream, char *program)
 
 void usage(FILE *stream, char *program)
 {
-	fprintf(stream, "Usage: %s <interface> [<option>...]\n", program);
+	fprintf(stream, "Usage: %s <interface>[,<interface>...] [<option>...]\n", program);
 	fprintf(stream, "Options:\n");
 	fprintf(stream, " -g, --gateway=<port>         operate in gateway mode on <port>\n");
+	fprintf(stream, "     --local=<path>           local socket of the gateway (AF_UNIX)\n");
+	fprintf(stream, "     --shm=<name>             shared-memory ring of the gateway\n");
 	//fprintf(stream, " -t, --timeout=<seconds>      time-out in seconds (client only)\n");
 #ifndef __no_can_ioctl
 	fprintf(stream, " -b, --baudrate=<baudrate>    bit timing in kbps (default=250)\n");
@@ -643,24 +775,42 @@ void syntax(FILE *stream, char *program)
 
 ssize_t readline(int fd, char *buf, size_t nbyte)
 {
+	static char input[BUFFER_LENGTH];	/* receive buffer (one connection) */
+	static ssize_t start = 0, end = 0;
 	char chr; ssize_t pos = 0, res;
-	while((res = read(fd, &chr, sizeof(chr))) > 0) {
+	for(;;) {
+		if(start == end) {
+			if((res = read(fd, input, sizeof(input))) <= 0)
+				return (res == 0)? pos : res;
+			start = 0;
+			end = res;
+		}
+		chr = input[start++];
 		if(pos + 1 < nbyte) {
 			buf[pos++] = chr;
 			buf[pos] = 0;
 		}
 		if(chr == '\n') {
-			//@ToDo: CRLF
 			return pos;
 		}
 		if(!running) {
 			return 0;
 		}
 	}
-	if(res == 0)
-		return pos;
-	else
-		return res;
+}
+
+socklen_t unixaddr(struct sockaddr_un *addr, const char *path)
+{
+	size_t length = strlen(path);		/* '@': an abstract name (Linux) */
+
+	if(length < 2 || length >= sizeof(addr->sun_path))
+		return 0;
+	memset(addr, 0, sizeof(struct sockaddr_un));
+	addr->sun_family = AF_UNIX;
+	memcpy(addr->sun_path, path, length);
+	if(path[0] == '@')
+		addr->sun_path[0] = '\0';
+	return (socklen_t)(offsetof(struct sockaddr_un, sun_path) + length + (path[0] != '@'));
 }
 
 /* ***	end of file  ***
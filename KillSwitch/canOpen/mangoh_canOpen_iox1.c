@@ -10,24 +10,18 @@
 #include "interfaces.h"
 #include "can_defs.h"
 #include "cop_api.h"
-#include "cop_tcp.h"
 #include "default.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
-#include <libgen.h>
-#include <getopt.h>
-#include <signal.h>
 #include <errno.h>
 
-#include <sys/time.h>
+#include <pthread.h>
+
 #include <sys/types.h>
 #include <sys/socket.h>
-#include <netinet/in.h>
-#include <sys/ioctl.h>
-#include <net/if.h>
 
 #include <linux/can.h>
 
@@ -38,28 +32,135 @@
 #define PRINT_DEBUG(_fs_, ...)
 #endif
 
-#define NODE_ID            255
-#define DEFAULT_NET        1
-#define DEFAULT_NODE    1
-#define BUFFER_LENGTH    1025
-#define SEQUENCE_NO        1
+#define IOX1_NODE       1           // node-id of the IOX1 module
+
+#define DI_8BIT         0x6000      // Read Digital Input 8-Bit
+#define DI_16BIT        0x6100      // Read Digital Input 16-Bit
+#define DO_8BIT         0x6200      // Write Digital Output 8-Bit
+#define DO_16BIT        0x6300      // Write Digital Output 16-Bit
+
+#define RETRIES         2           // default retries of a failed input read
+#define RETRY_BACKOFF   20          // default delay before the first retry [ms]
+#define MAX_RETRIES     10          // max. retries of a failed input read
+#define MAX_BACKOFF     1000        // max. delay between two retries [ms]
+
+#define POLL_INTERVAL   200         // default interval of the input poller [ms]
+#define MIN_POLL        10          // min. interval of the input poller [ms]
+#define MAX_POLL        60000       // max. interval of the input poller [ms]
+#define HANDLERS        8           // input change handlers of the pool
+
+#define OUTPUT_WINDOW   10          // default window for merging output writes [ms]
+#define MAX_WINDOW      1000        // max. window for merging output writes [ms]
+
+// Input change handler of a client
+typedef struct
+{
+    uint16_t mask;                  // inputs of interest
+    bool primed;                    // the current state (or the failure) has been reported
+    mangoh_canOpenIox1_InputChangeHandlerFunc_t handlerPtr;
+    void* contextPtr;
+    le_msg_SessionRef_t sessionRef; // client of the handler
+    mangoh_canOpenIox1_InputChangeHandlerRef_t ref;
+    le_dls_Link_t link;
+} InputChangeHandler_t;
+
+// Priorities of the requests to the CANopen worker (the first one is served first)
+typedef enum
+{
+    PRIO_SAFETY,                    // digital inputs (kill switch, overheat)
+    PRIO_NORMAL,                    // single reads and writes
+    PRIO_BULK,                      // groups of bulk transfers
+    PRIORITIES
+} Priority_t;
+
+typedef enum
+{
+    REQ_INIT,                       // cop_init
+    REQ_EXIT,                       // cop_exit
+    REQ_TIMEOUT,                    // sdo_timeout
+    REQ_READ8,                      // sdo_read_8bit
+    REQ_READ16,                     // sdo_read_16bit
+    REQ_WRITE8,                     // sdo_write_8bit
+    REQ_WRITE16                     // sdo_write_16bit
+} RequestType_t;
+
+// Request to the CANopen worker (on the stack of the requesting thread)
+typedef struct Request
+{
+    RequestType_t type;
+    unsigned short index;
+    unsigned char subIndex;
+    WORD value;                     // value to be written, or the value read
+    long rc;                        // result of the CANopen Master
+    bool done;
+    struct Request* nextPtr;
+} Request_t;
+
+static bool di16Supported = true;   // cleared when the module aborts 6100H
+
+static uint32_t retryBudget = RETRIES;
+static uint32_t retryBackoff = RETRY_BACKOFF;
+static uint32_t retryCount = 0;     // retries of failed input reads
+static uint32_t failureCount = 0;   // input reads failed after all retries
+
+// The CANopen Master has one transfer buffer and one error state, so it is
+// owned by the worker thread: the service functions (main thread) and the
+// input poller (thread of its own) queue their requests to it, and a request
+// of the inputs is served before the single and bulk transfers waiting
+static pthread_mutex_t workerMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t workerCond = PTHREAD_COND_INITIALIZER;   // a request has been queued
+static pthread_cond_t doneCond = PTHREAD_COND_INITIALIZER;     // a request has been executed
+static Request_t* queueHead[PRIORITIES];
+static Request_t* queueTail[PRIORITIES];
 
-#define DI0_DI7_CMD  "1 r 0x6000 1 u8"
-#define DI8_DI15_CMD "1 r 0x6000 2 u8"
-#define DO0_DO7_CMD  "1 w 0x6200 1 u8"
+static le_thread_Ref_t mainThread;
+static le_thread_Ref_t pollerThread;
+static le_sem_Ref_t pollerStarted;
 
-static int cnt = 1;
+static le_mem_PoolRef_t handlerPool;
+static le_ref_MapRef_t handlerRefMap;
+static le_dls_List_t handlerList = LE_DLS_LIST_INIT;
+static le_timer_Ref_t pollTimer;
+static uint32_t pollInterval = POLL_INTERVAL;
+static bool pollActive = false;     // there are handlers
+static uint16_t lastInputs;         // snapshot of the last poll
+static bool lastValid = false;
+static bool inputsFailed = false;   // the last poll has failed
 
-static unsigned char genericDigitalInput(const char* cmd);
+static uint8_t outputShadow;        // DO0~DO7 as written to the module
+static bool outputShadowValid = false;
+static uint8_t outputPending;       // DO0~DO7 to be written at the end of the window
+static bool outputPendingValid = false;
+static uint32_t outputWindow = OUTPUT_WINDOW;
+static bool outputVerify = false;
+static le_timer_Ref_t outputTimer;
+static uint32_t suppressedCount = 0;    // writes of the value of the module
+static uint32_t mergedCount = 0;        // writes replaced by a later one of the window
+static uint32_t verifyFailureCount = 0; // writes whose read-back differs
+
+static le_result_t genericDigitalInput(unsigned char subIndex, unsigned char* valuePtr);
+static le_result_t genericDigitalInput16(unsigned short* valuePtr);
+static long readInput(Priority_t priority, unsigned short index, unsigned char subIndex, WORD* valuePtr);
+static le_result_t writeOutput8(Priority_t priority, uint8_t subIndex, uint8_t value);
+static long submit(Priority_t priority, RequestType_t type, unsigned short index, unsigned char subIndex, WORD* valuePtr);
+static void* workerMain(void* contextPtr);
+static void* pollerMain(void* contextPtr);
+static void updatePoller(void* param1Ptr, void* param2Ptr);
+static void pollInputs(le_timer_Ref_t timer);
+static void reportInputs(void* param1Ptr, void* param2Ptr);
+static void unprimeHandlers(void);
+static void removeHandler(InputChangeHandler_t* handler);
+static void closeSession(le_msg_SessionRef_t sessionRef, void* contextPtr);
+static void writeOutputShadow(uint8_t value);
+static void flushOutputs(le_timer_Ref_t timer);
+static le_result_t sdoResult(long rc, const char* function, unsigned short index, unsigned char subIndex);
 
 
 le_result_t mangoh_canOpenIox1_Init(void)
 {
-    long   baudrate = 3;
     long rc;
-    struct _can_param can_param = {"can0", PF_CAN, SOCK_RAW, CAN_RAW};
 
-    if((rc = cop_init(CAN_NETDEV, &can_param, (BYTE)baudrate)) != 0) {
+    if((rc = submit(PRIO_NORMAL, REQ_INIT, 0, 0, NULL)) != 0) {
         fprintf(stderr, "+++ error: cop_init = %li\n", rc);
         return LE_FAULT;
     }
@@ -69,63 +170,673 @@ le_result_t mangoh_canOpenIox1_Init(void)
 
 void mangoh_canOpenIox1_Free(void)
 {
-    cop_exit();
+    submit(PRIO_NORMAL, REQ_EXIT, 0, 0, NULL);
 }
 
 
-unsigned char mangoh_canOpenIox1_DigitalInput_DI0_DI7(void)
+le_result_t mangoh_canOpenIox1_DigitalInput_DI0_DI7(uint8_t* valuePtr)
+{
+    return genericDigitalInput(1, valuePtr);
+}
+
+le_result_t mangoh_canOpenIox1_DigitalInput_DI8_DI15(uint8_t* valuePtr)
 {
-    return genericDigitalInput(DI0_DI7_CMD);
+    return genericDigitalInput(2, valuePtr);
 }
 
-unsigned char mangoh_canOpenIox1_DigitalInput_DI8_DI15(void)
+le_result_t mangoh_canOpenIox1_DigitalInput_DI0_DI15(uint16_t* valuePtr)
 {
-    return genericDigitalInput(DI8_DI15_CMD);
+    return genericDigitalInput16(valuePtr);
 }
 
 void mangoh_canOpenIox1_DigitalOutput_DO0_DO7(unsigned char value)
 {
-    char buf[64];
-    struct _cop_tcp_settings settings = {DEFAULT_NET, DEFAULT_NODE, NODE_ID};
+    // The first write is transferred at once and opens a window; the writes
+    // within the window are merged into one transfer at its end
+    if (le_timer_IsRunning(outputTimer))
+    {
+        if (outputPendingValid)
+        {
+            mergedCount++;
+        }
+        outputPending = value;
+        outputPendingValid = true;
+        return;
+    }
+    writeOutputShadow(value);
+    if (outputWindow != 0)
+    {
+        LE_ASSERT(le_timer_Start(outputTimer) == LE_OK);
+    }
+    return;
+}
+
+le_result_t mangoh_canOpenIox1_ReadInput8
+(
+    uint8_t subIndex,
+    uint8_t* valuePtr
+)
+{
+    WORD value = 0;
+    long rc;
 
-    snprintf(buf, sizeof(buf), "[%d] %s 0x%x", cnt++, DO0_DO7_CMD, value);
-    PRINT_DEBUG("\t%s cmd: %s\n", __FUNCTION__, buf);
-    cop_tcp_parse(&buf[0], &settings, &buf[0], sizeof(buf));
-    PRINT_DEBUG("\t%s: result:%s\n", __FUNCTION__, buf);
+    rc = readInput(PRIO_NORMAL, DI_8BIT, subIndex, &value);
+    *valuePtr = (uint8_t)value;
+    return sdoResult(rc, __FUNCTION__, DI_8BIT, subIndex);
+}
 
-    return;
+le_result_t mangoh_canOpenIox1_ReadInput16
+(
+    uint8_t subIndex,
+    uint16_t* valuePtr
+)
+{
+    WORD value = 0;
+    long rc;
+
+    rc = readInput(PRIO_NORMAL, DI_16BIT, subIndex, &value);
+    *valuePtr = value;
+    return sdoResult(rc, __FUNCTION__, DI_16BIT, subIndex);
+}
+
+le_result_t mangoh_canOpenIox1_ReadInputs8
+(
+    uint8_t firstSubIndex,
+    uint8_t* valuesPtr,
+    size_t* valuesSizePtr
+)
+{
+    le_result_t result;
+    WORD value;
+    size_t i;
+
+    if (*valuesSizePtr > MANGOH_CANOPENIOX1_MAX_GROUPS ||
+        firstSubIndex + *valuesSizePtr > 0x100)
+    {
+        *valuesSizePtr = 0;
+        return LE_BAD_PARAMETER;
+    }
+    // One request per group, so a request of the inputs is served in between
+    for (i = 0; i < *valuesSizePtr; i++)
+    {
+        value = 0;
+        result = sdoResult(readInput(PRIO_BULK, DI_8BIT, firstSubIndex + i, &value),
+                           __FUNCTION__, DI_8BIT, firstSubIndex + i);
+        valuesPtr[i] = (uint8_t)value;
+        if (result != LE_OK)
+        {
+            *valuesSizePtr = i;         // the values read so far
+            return result;
+        }
+    }
+    return LE_OK;
+}
+
+le_result_t mangoh_canOpenIox1_WriteOutput8
+(
+    uint8_t subIndex,
+    uint8_t value
+)
+{
+    return writeOutput8(PRIO_NORMAL, subIndex, value);
+}
+
+le_result_t mangoh_canOpenIox1_WriteOutput16
+(
+    uint8_t subIndex,
+    uint16_t value
+)
+{
+    WORD value16 = value;
+    long rc;
+
+    rc = submit(PRIO_NORMAL, REQ_WRITE16, DO_16BIT, subIndex, &value16);
+    if (subIndex == 1)
+    {
+        outputShadowValid = false;  // DO0~DO7 written through 6300H
+    }
+    return sdoResult(rc, __FUNCTION__, DO_16BIT, subIndex);
+}
+
+le_result_t mangoh_canOpenIox1_WriteOutputs8
+(
+    uint8_t firstSubIndex,
+    const uint8_t* valuesPtr,
+    size_t valuesSize
+)
+{
+    le_result_t result;
+    size_t i;
+
+    if (valuesSize > MANGOH_CANOPENIOX1_MAX_GROUPS || firstSubIndex + valuesSize > 0x100)
+    {
+        return LE_BAD_PARAMETER;
+    }
+    // One request per group, so a request of the inputs is served in between
+    for (i = 0; i < valuesSize; i++)
+    {
+        result = writeOutput8(PRIO_BULK, firstSubIndex + i, valuesPtr[i]);
+        if (result != LE_OK)
+        {
+            return result;
+        }
+    }
+    return LE_OK;
+}
+
+le_result_t mangoh_canOpenIox1_SetRetryPolicy
+(
+    uint32_t retries,
+    uint32_t backoff,
+    uint32_t timeout
+)
+{
+    if (retries > MAX_RETRIES || backoff > MAX_BACKOFF || timeout > 0xFFFF)
+    {
+        return LE_BAD_PARAMETER;
+    }
+    retryBudget = retries;
+    retryBackoff = backoff;
+    if (timeout != 0)
+    {
+        WORD value = (WORD)timeout;
+        submit(PRIO_NORMAL, REQ_TIMEOUT, 0, 0, &value);
+    }
+    return LE_OK;
+}
+
+void mangoh_canOpenIox1_GetRetryStatistics
+(
+    uint32_t* retriesPtr,
+    uint32_t* failuresPtr,
+    bool reset
+)
+{
+    // the counters are counted by the main thread and the input poller
+    if (reset)
+    {
+        *retriesPtr = __sync_lock_test_and_set(&retryCount, 0);
+        *failuresPtr = __sync_lock_test_and_set(&failureCount, 0);
+    }
+    else
+    {
+        *retriesPtr = retryCount;
+        *failuresPtr = failureCount;
+    }
+}
+
+mangoh_canOpenIox1_InputChangeHandlerRef_t mangoh_canOpenIox1_AddInputChangeHandler
+(
+    uint16_t mask,
+    mangoh_canOpenIox1_InputChangeHandlerFunc_t handlerPtr,
+    void* contextPtr
+)
+{
+    InputChangeHandler_t* handler;
+
+    if (handlerPtr == NULL || mask == 0)
+    {
+        return NULL;
+    }
+    handler = le_mem_ForceAlloc(handlerPool);
+    handler->mask = mask;
+    handler->primed = false;
+    handler->handlerPtr = handlerPtr;
+    handler->contextPtr = contextPtr;
+    handler->sessionRef = mangoh_canOpenIox1_GetClientSessionRef();
+    handler->link = LE_DLS_LINK_INIT;
+    handler->ref = le_ref_CreateRef(handlerRefMap, handler);
+    le_dls_Queue(&handlerList, &handler->link);
+
+    // One poller for all clients, running while there is a handler
+    if (!pollActive)
+    {
+        pollActive = true;
+        le_event_QueueFunctionToThread(pollerThread, updatePoller, NULL, NULL);
+    }
+    return handler->ref;
+}
+
+void mangoh_canOpenIox1_RemoveInputChangeHandler
+(
+    mangoh_canOpenIox1_InputChangeHandlerRef_t handlerRef
+)
+{
+    InputChangeHandler_t* handler = le_ref_Lookup(handlerRefMap, handlerRef);
+
+    if (handler != NULL)
+    {
+        removeHandler(handler);
+    }
+}
+
+le_result_t mangoh_canOpenIox1_SetPollInterval
+(
+    uint32_t interval
+)
+{
+    if (interval < MIN_POLL || interval > MAX_POLL)
+    {
+        return LE_BAD_PARAMETER;
+    }
+    pollInterval = interval;
+    le_event_QueueFunctionToThread(pollerThread, updatePoller, NULL, NULL);
+    return LE_OK;
+}
+
+le_result_t mangoh_canOpenIox1_SetOutputPolicy
+(
+    uint32_t window,
+    bool verify
+)
+{
+    if (window > MAX_WINDOW)
+    {
+        return LE_BAD_PARAMETER;
+    }
+    outputWindow = window;
+    outputVerify = verify;
+    if (outputWindow != 0)
+    {
+        LE_ASSERT(le_timer_SetMsInterval(outputTimer, outputWindow) == LE_OK);
+    }
+    return LE_OK;
+}
+
+void mangoh_canOpenIox1_GetOutputStatistics
+(
+    uint32_t* suppressedPtr,
+    uint32_t* mergedPtr,
+    uint32_t* verifyFailuresPtr,
+    bool reset
+)
+{
+    *suppressedPtr = suppressedCount;
+    *mergedPtr = mergedCount;
+    *verifyFailuresPtr = verifyFailureCount;
+    if (reset)
+    {
+        suppressedCount = 0;
+        mergedCount = 0;
+        verifyFailureCount = 0;
+    }
+}
+
+static void writeOutputShadow(uint8_t value)
+{
+    WORD value16 = value;
+    WORD readBack = 0;
+    long rc;
+
+    if (outputShadowValid && value == outputShadow)
+    {
+        suppressedCount++;          // the module has the value already
+        return;
+    }
+    rc = submit(PRIO_NORMAL, REQ_WRITE8, DO_8BIT, 1, &value16);
+    PRINT_DEBUG("\t%s: value:0x%x result:%li\n", __FUNCTION__, value, rc);
+    outputShadow = value;
+    outputShadowValid = (rc == COPERR_NOERROR);
+    if (sdoResult(rc, __FUNCTION__, DO_8BIT, 1) != LE_OK || !outputVerify)
+    {
+        return;
+    }
+    rc = submit(PRIO_NORMAL, REQ_READ8, DO_8BIT, 1, &readBack);
+    if (sdoResult(rc, __FUNCTION__, DO_8BIT, 1) != LE_OK || readBack != value)
+    {
+        if (rc == COPERR_NOERROR)
+        {
+            LE_ERROR("%s: object 0x%04X:1 reads 0x%02X after writing 0x%02X",
+                     __FUNCTION__, DO_8BIT, readBack, value);
+        }
+        verifyFailureCount++;
+        outputShadowValid = false;  // written again by the next write
+    }
+}
+
+static void flushOutputs(le_timer_Ref_t timer)
+{
+    // The last write of the window, if any, opens the next window
+    if (outputPendingValid)
+    {
+        outputPendingValid = false;
+        writeOutputShadow(outputPending);
+        if (outputWindow != 0)
+        {
+            LE_ASSERT(le_timer_Start(outputTimer) == LE_OK);
+        }
+    }
+}
+
+static void* pollerMain(void* contextPtr)
+{
+    pollTimer = le_timer_Create("InputPoller");
+    LE_ASSERT(le_timer_SetHandler(pollTimer, pollInputs) == LE_OK);
+    LE_ASSERT(le_timer_SetMsInterval(pollTimer, pollInterval) == LE_OK);
+    LE_ASSERT(le_timer_SetRepeat(pollTimer, 0) == LE_OK);
+    le_sem_Post(pollerStarted);
+
+    le_event_RunLoop();
+    return NULL;
+}
+
+static void updatePoller(void* param1Ptr, void* param2Ptr)
+{
+    // Runs in the poller thread: takes over the interval and the run state
+    // set by the main thread
+    le_timer_Stop(pollTimer);
+    LE_ASSERT(le_timer_SetMsInterval(pollTimer, pollInterval) == LE_OK);
+    if (pollActive)
+    {
+        LE_ASSERT(le_timer_Start(pollTimer) == LE_OK);
+    }
+}
+
+static void pollInputs(le_timer_Ref_t timer)
+{
+    unsigned short inputs = 0;
+    le_result_t result;
+
+    // Runs in the poller thread, so the inputs are read (with the highest
+    // priority) while the main thread waits for other transfers; a failed
+    // read (after all retries) is reported as well
+    result = genericDigitalInput16(&inputs);
+    le_event_QueueFunctionToThread(mainThread, reportInputs, (void*)(uintptr_t)inputs, (void*)(intptr_t)result);
+}
+
+static void reportInputs(void* param1Ptr, void* param2Ptr)
+{
+    InputChangeHandler_t* handler;
+    le_dls_Link_t* linkPtr;
+    uint16_t inputs = (uint16_t)(uintptr_t)param1Ptr;
+    le_result_t result = (le_result_t)(intptr_t)param2Ptr;
+    uint16_t changed;
+
+    // The inputs are unknown from a failed read on: every handler gets the
+    // failure once, and the current state again by the next successful read
+    if (result != LE_OK)
+    {
+        if (!inputsFailed)
+        {
+            LE_WARN("Digital inputs lost (%s)", LE_RESULT_TXT(result));
+            inputsFailed = true;
+            unprimeHandlers();
+        }
+        lastValid = false;
+        inputs = lastInputs;
+    }
+    else if (inputsFailed)
+    {
+        LE_INFO("Digital inputs read again (0x%04X)", inputs);
+        inputsFailed = false;
+        unprimeHandlers();
+    }
+    changed = lastValid ? (inputs ^ lastInputs) : 0;
+    lastInputs = inputs;
+    lastValid = (result == LE_OK);
+
+    // A new handler gets the current state of its inputs first, then
+    // only the edges of its inputs
+    linkPtr = le_dls_Peek(&handlerList);
+    while (linkPtr != NULL)
+    {
+        handler = CONTAINER_OF(linkPtr, InputChangeHandler_t, link);
+        linkPtr = le_dls_PeekNext(&handlerList, linkPtr);
+        if (!handler->primed)
+        {
+            handler->primed = true;
+            handler->handlerPtr(result, inputs, (result == LE_OK) ? handler->mask : 0, handler->contextPtr);
+        }
+        else if (changed & handler->mask)
+        {
+            handler->handlerPtr(LE_OK, inputs, changed & handler->mask, handler->contextPtr);
+        }
+    }
+}
+
+static void unprimeHandlers(void)
+{
+    le_dls_Link_t* linkPtr;
+
+    for (linkPtr = le_dls_Peek(&handlerList); linkPtr != NULL; linkPtr = le_dls_PeekNext(&handlerList, linkPtr))
+    {
+        CONTAINER_OF(linkPtr, InputChangeHandler_t, link)->primed = false;
+    }
+}
+
+static void removeHandler(InputChangeHandler_t* handler)
+{
+    le_ref_DeleteRef(handlerRefMap, handler->ref);
+    le_dls_Remove(&handlerList, &handler->link);
+    le_mem_Release(handler);
+    if (le_dls_IsEmpty(&handlerList))
+    {
+        pollActive = false;
+        le_event_QueueFunctionToThread(pollerThread, updatePoller, NULL, NULL);
+        lastValid = false;
+        inputsFailed = false;
+    }
+}
+
+static void closeSession(le_msg_SessionRef_t sessionRef, void* contextPtr)
+{
+    InputChangeHandler_t* handler;
+    le_dls_Link_t* linkPtr;
+
+    // The handlers of a client which has gone
+    linkPtr = le_dls_Peek(&handlerList);
+    while (linkPtr != NULL)
+    {
+        handler = CONTAINER_OF(linkPtr, InputChangeHandler_t, link);
+        linkPtr = le_dls_PeekNext(&handlerList, linkPtr);
+        if (handler->sessionRef == sessionRef)
+        {
+            removeHandler(handler);
+        }
+    }
+}
+
+static le_result_t genericDigitalInput(unsigned char subIndex, unsigned char* valuePtr)
+{
+    WORD value = 0;
+    long rc;
+
+    rc = readInput(PRIO_SAFETY, DI_8BIT, subIndex, &value);
+    *valuePtr = (unsigned char)value;
+    return sdoResult(rc, __FUNCTION__, DI_8BIT, subIndex);
 }
 
-static unsigned char genericDigitalInput(const char* cmd)
+static le_result_t genericDigitalInput16(unsigned short* valuePtr)
 {
-    unsigned char rt;
-    char* token;
-    const char* search = " ";
-    char buf[32];
-    struct _cop_tcp_settings settings = {DEFAULT_NET, DEFAULT_NODE, NODE_ID};
+    unsigned char low = 0, high = 0;
+    WORD value = 0;
+    le_result_t result;
+    long rc;
 
-    while (true)
+    // All 16 inputs by one SDO transfer (one snapshot of the module), as long
+    // as the module has the object. Otherwise the two 8-bit groups are read.
+    if (di16Supported)
     {
-        snprintf(buf, sizeof(buf), "[%d] %s", cnt++, cmd);
-        PRINT_DEBUG("\t%s cmd: %s\n", __FUNCTION__, buf);
-        cop_tcp_parse(&buf[0], &settings, &buf[0], sizeof(buf));
-        PRINT_DEBUG("\t%s: result:%s\n", __FUNCTION__, buf);
-        token = strtok(buf, search);
-        PRINT_DEBUG("token 1 = %s\n", token);
-        token = strtok(NULL, search);
-        PRINT_DEBUG("token 2 = %s, %c\n", token, token[0]);
-        if (token[0] == 'E')
+        rc = readInput(PRIO_SAFETY, DI_16BIT, 1, &value);
+        *valuePtr = value;
+        if (rc <= 0)
         {
-            PRINT_DEBUG("Got error result, try read again!\n");
+            return sdoResult(rc, __FUNCTION__, DI_16BIT, 1);
         }
-        else
+        LE_WARN("Object 0x%04X:1 aborted with 0x%08lX, reading the inputs by 8 bit",
+                DI_16BIT, (unsigned long)rc);
+        di16Supported = false;
+    }
+
+    if ((result = genericDigitalInput(1, &low)) == LE_OK)
+    {
+        result = genericDigitalInput(2, &high);
+    }
+    *valuePtr = (unsigned short)low | ((unsigned short)high << 8);
+    return result;
+}
+
+static long readInput(Priority_t priority, unsigned short index, unsigned char subIndex, WORD* valuePtr)
+{
+    uint32_t backoff = retryBackoff;
+    uint32_t retry;
+    long rc;
+
+    // A failed transfer (time-out, error) is retried up to the retry budget,
+    // with a delay doubled from retry to retry. An SDO abort is the answer
+    // of the module and is not retried. The worker is free for other
+    // requests during the delay.
+    for (retry = 0; ; retry++)
+    {
+        rc = submit(priority, (index == DI_16BIT) ? REQ_READ16 : REQ_READ8, index, subIndex, valuePtr);
+        PRINT_DEBUG("\t%s: object:0x%04X:%u value:0x%x result:%li\n", __FUNCTION__, index, subIndex, *valuePtr, rc);
+        if (rc >= COPERR_NOERROR || retry >= retryBudget)
         {
             break;
         }
+        PRINT_DEBUG("Got error result, try read again in %u ms!\n", backoff);
+        __sync_fetch_and_add(&retryCount, 1);
+        usleep(backoff * 1000);
+        backoff = (backoff * 2 < MAX_BACKOFF) ? backoff * 2 : MAX_BACKOFF;
+    }
+    if (rc != COPERR_NOERROR)
+    {
+        __sync_fetch_and_add(&failureCount, 1);
+    }
+    return rc;
+}
+
+static le_result_t writeOutput8(Priority_t priority, uint8_t subIndex, uint8_t value)
+{
+    WORD value16 = value;
+    long rc;
+
+    rc = submit(priority, REQ_WRITE8, DO_8BIT, subIndex, &value16);
+    if (subIndex == 1)
+    {
+        outputShadow = value;
+        outputShadowValid = (rc == COPERR_NOERROR);
+    }
+    return sdoResult(rc, __FUNCTION__, DO_8BIT, subIndex);
+}
+
+static long submit(Priority_t priority, RequestType_t type, unsigned short index, unsigned char subIndex, WORD* valuePtr)
+{
+    Request_t request;
+
+    request.type = type;
+    request.index = index;
+    request.subIndex = subIndex;
+    request.value = valuePtr ? *valuePtr : 0;
+    request.rc = COPERR_NOERROR;
+    request.done = false;
+    request.nextPtr = NULL;
+
+    // Queue the request behind those of its priority, and wait until the
+    // worker has executed it
+    pthread_mutex_lock(&workerMutex);
+    if (queueTail[priority] != NULL)
+    {
+        queueTail[priority]->nextPtr = &request;
+    }
+    else
+    {
+        queueHead[priority] = &request;
+    }
+    queueTail[priority] = &request;
+    pthread_cond_signal(&workerCond);
+    while (!request.done)
+    {
+        pthread_cond_wait(&doneCond, &workerMutex);
+    }
+    pthread_mutex_unlock(&workerMutex);
+
+    if (valuePtr)
+    {
+        *valuePtr = request.value;
+    }
+    return request.rc;
+}
+
+static void* workerMain(void* contextPtr)
+{
+    struct _can_param can_param = {"can0", PF_CAN, SOCK_RAW, CAN_RAW};
+    long baudrate = 3;
+    Request_t* requestPtr;
+    BYTE value8;
+    int prio;
+
+    for (;;)
+    {
+        // Take the first request of the highest priority
+        pthread_mutex_lock(&workerMutex);
+        for (;;)
+        {
+            for (prio = 0; prio < PRIORITIES && queueHead[prio] == NULL; prio++)
+                ;
+            if (prio < PRIORITIES)
+            {
+                break;
+            }
+            pthread_cond_wait(&workerCond, &workerMutex);
+        }
+        requestPtr = queueHead[prio];
+        if ((queueHead[prio] = requestPtr->nextPtr) == NULL)
+        {
+            queueTail[prio] = NULL;
+        }
+        pthread_mutex_unlock(&workerMutex);
+
+        // Execute it by the CANopen Master (only in this thread)
+        switch (requestPtr->type)
+        {
+            case REQ_INIT:
+                requestPtr->rc = cop_init(CAN_NETDEV, &can_param, (BYTE)baudrate);
+                break;
+            case REQ_EXIT:
+                requestPtr->rc = cop_exit();
+                break;
+            case REQ_TIMEOUT:
+                sdo_timeout(requestPtr->value);
+                break;
+            case REQ_READ8:
+                value8 = 0;
+                requestPtr->rc = sdo_read_8bit(IOX1_NODE, requestPtr->index, requestPtr->subIndex, &value8);
+                requestPtr->value = value8;
+                break;
+            case REQ_READ16:
+                requestPtr->rc = sdo_read_16bit(IOX1_NODE, requestPtr->index, requestPtr->subIndex, &requestPtr->value);
+                break;
+            case REQ_WRITE8:
+                requestPtr->rc = sdo_write_8bit(IOX1_NODE, requestPtr->index, requestPtr->subIndex, (BYTE)requestPtr->value);
+                break;
+            case REQ_WRITE16:
+                requestPtr->rc = sdo_write_16bit(IOX1_NODE, requestPtr->index, requestPtr->subIndex, requestPtr->value);
+                break;
+        }
+
+        pthread_mutex_lock(&workerMutex);
+        requestPtr->done = true;
+        pthread_cond_broadcast(&doneCond);
+        pthread_mutex_unlock(&workerMutex);
     }
-    rt = (unsigned char)strtol(token, NULL, 0);
+    return NULL;
+}
 
-    return rt;
+static le_result_t sdoResult(long rc, const char* function, unsigned short index, unsigned char subIndex)
+{
+    if (rc == COPERR_NOERROR)
+    {
+        return LE_OK;
+    }
+    if (rc > 0)
+    {
+        // SDO abort code from the module: object not available, etc.
+        LE_ERROR("%s: object 0x%04X:%u aborted with 0x%08lX", function, index, subIndex, (unsigned long)rc);
+        return LE_UNSUPPORTED;
+    }
+    LE_ERROR("%s: object 0x%04X:%u failed with %li", function, index, subIndex, rc);
+    return (rc == COPERR_TIMEOUT) ? LE_TIMEOUT : LE_FAULT;
 }
 
 COMPONENT_INIT
@@ -147,6 +858,21 @@ COMPONENT_INIT
     const int canInitExitCode = WEXITSTATUS(canInitResult);
     LE_FATAL_IF(canInitExitCode != 0, "can-init.sh failed with exit code %d", canInitExitCode);
 
+    handlerPool = le_mem_CreatePool("InputChangeHandler", sizeof(InputChangeHandler_t));
+    le_mem_ExpandPool(handlerPool, HANDLERS);
+    handlerRefMap = le_ref_CreateMap("InputChangeHandler", HANDLERS);
+    outputTimer = le_timer_Create("OutputWindow");
+    LE_ASSERT(le_timer_SetHandler(outputTimer, flushOutputs) == LE_OK);
+    LE_ASSERT(le_timer_SetMsInterval(outputTimer, OUTPUT_WINDOW) == LE_OK);
+
+    // The CANopen worker, and the input poller with a timer of its own
+    mainThread = le_thread_GetCurrent();
+    le_thread_Start(le_thread_Create("CANopenWorker", workerMain, NULL));
+    pollerStarted = le_sem_Create("InputPollerStarted", 0);
+    pollerThread = le_thread_Create("InputPoller", pollerMain, NULL);
+    le_thread_Start(pollerThread);
+    le_sem_Wait(pollerStarted);
 
     mangoh_canOpenIox1_AdvertiseService();
+    le_msg_AddServiceCloseHandler(mangoh_canOpenIox1_GetServiceRef(), closeSession, NULL);
 }
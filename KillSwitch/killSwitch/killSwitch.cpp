@@ -64,6 +64,15 @@ void DemoStateMachine::handleEventCanRead(bool localKillSwitchIsOn, bool overhea
     }
 }
 
+void DemoStateMachine::handleEventCanReadFailed(void)
+{
+    // The local inputs are unknown (e.g. the IOX1 module is unplugged), so
+    // the machine is disabled until they are read again
+    this->_localKillSwitch = BinaryInput::UNKNOWN;
+    this->_overheat = BinaryInput::UNKNOWN;
+    this->disable();
+}
+
 void DemoStateMachine::updateState(void)
 {
     // Make sure that at least one CAN read is complete
@@ -73,16 +82,7 @@ void DemoStateMachine::updateState(void)
         if (this->_localKillSwitch == BinaryInput::ACTIVE ||
             this->_remoteKillSwitch == BinaryInput::ACTIVE)
         {
-            if (this->_state != State::DISABLED)
-            {
-                this->controlRedLed(true);
-                this->controlGreenLed(false);
-                this->controlOverheatLed(false);
-                this->controlFan(false);
-                this->writeOutputs();
-                LE_DEBUG("Changing state: %d->%d", this->_state, State::DISABLED);
-                this->_state = State::DISABLED;
-            }
+            this->disable();
         }
         else if (this->_overheat == BinaryInput::ACTIVE)
         {
@@ -113,6 +113,20 @@ void DemoStateMachine::updateState(void)
     }
 }
 
+void DemoStateMachine::disable(void)
+{
+    if (this->_state != State::DISABLED)
+    {
+        this->controlRedLed(true);
+        this->controlGreenLed(false);
+        this->controlOverheatLed(false);
+        this->controlFan(false);
+        this->writeOutputs();
+        LE_DEBUG("Changing state: %d->%d", this->_state, State::DISABLED);
+        this->_state = State::DISABLED;
+    }
+}
+
 void DemoStateMachine::controlRedLed(bool on)
 {
     const uint8_t bit = 1 << static_cast<int>(OutputPin::LED_RED);
@@ -175,19 +189,22 @@ void DemoStateMachine::writeOutputs(void)
     mangoh_canOpenIox1_DigitalOutput_DO0_DO7(this->_pendingOutput);
 }
 
-static void timerHandler(le_timer_Ref_t timer)
+static void inputChangeHandler(le_result_t result, uint16_t inputs16, uint16_t changed, void* contextPtr)
 {
-    uint8_t inputs[2];
-    inputs[0] = mangoh_canOpenIox1_DigitalInput_DI0_DI7();
-    inputs[1] = mangoh_canOpenIox1_DigitalInput_DI8_DI15();
-    const uint16_t inputs16 = inputs[0] | (inputs[1] << 8);
+    DemoStateMachine* stateMachine = static_cast<DemoStateMachine*>(contextPtr);
+
+    if (result != LE_OK)
+    {
+        LE_WARN("inputChangeHandler: inputs lost (%s), disabling", LE_RESULT_TXT(result));
+        stateMachine->handleEventCanReadFailed();
+        return;
+    }
 
     const bool killSwitchOn = (((inputs16 >> static_cast<int>(InputPin::KILL_SWITCH)) & 1) == 0);
     const bool overheat = ((inputs16 >> static_cast<int>(InputPin::OVERHEAT)) & 1);
 
-    LE_DEBUG("timerHandler read inputs as 0x%04X", inputs16);
+    LE_DEBUG("inputChangeHandler read inputs as 0x%04X (changed 0x%04X)", inputs16, changed);
 
-    DemoStateMachine* stateMachine = static_cast<DemoStateMachine*>(le_timer_GetContextPtr(timer));
     stateMachine->handleEventCanRead(killSwitchOn, overheat);
 }
 
@@ -221,13 +238,11 @@ COMPONENT_INIT
     LE_FATAL_IF(mangoh_canOpenIox1_Init() != LE_OK, "Couldn't initialize CAN");
 
     auto stateMachine = new DemoStateMachine();
-    // Create a 1 second timer that repeats infinitely for polling the CAN inputs
-    le_timer_Ref_t tr = le_timer_Create("killSwitch");
-    LE_ASSERT(le_timer_SetHandler(tr, &timerHandler) == LE_OK);
-    LE_ASSERT(le_timer_SetContextPtr(tr, stateMachine) == LE_OK);
-    LE_ASSERT(le_timer_SetMsInterval(tr, 1000) == LE_OK);
-    LE_ASSERT(le_timer_SetRepeat(tr, 0) == LE_OK);
-    LE_ASSERT(le_timer_Start(tr) == LE_OK);
+    // The CAN inputs are polled by the IOX1 service, which reports their
+    // current state first and then their changes (or that they are lost)
+    const uint16_t inputMask = (1 << static_cast<int>(InputPin::KILL_SWITCH)) |
+                               (1 << static_cast<int>(InputPin::OVERHEAT));
+    LE_ASSERT(mangoh_canOpenIox1_AddInputChangeHandler(inputMask, inputChangeHandler, stateMachine) != NULL);
 
     dataRouter_AddDataUpdateHandler(KEY_POWER_COMMAND, powerUpdateHandler, stateMachine);
 }
@@ -43,9 +43,11 @@ public:
     DemoStateMachine(void);
     void handleEventRemoteKillSwitch(bool killSwitchOn);
     void handleEventCanRead(bool localKillSwitchOn, bool overheatOn);
+    void handleEventCanReadFailed(void);
 
 private:
     void updateState(void);
+    void disable(void);
     void controlRedLed(bool on);
     void controlGreenLed(bool on);
     void controlOverheatLed(bool on);